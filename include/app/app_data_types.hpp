@@ -54,6 +54,9 @@ struct ConsumerCountingResult {
   uint32_t frame_height;
   uint32_t enter_num;
   uint32_t miss_num;
+  // 每个计数线/区域的计数, 按添加顺序
+  std::vector<uint32_t> area_enter_nums;
+  std::vector<uint32_t> area_miss_nums;
   std::shared_ptr<BaseImage> image;
   std::vector<ObjectBoxInfo> object_boxes;
   std::vector<TrackerInfo> track_results;
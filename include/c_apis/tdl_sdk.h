@@ -515,6 +515,154 @@ int32_t TDL_SegMotionDetection(TDLHandle handle, const TDLModel model_id,
                                TDLImage image_handle, uint32_t min_area,
                                TDLObject *obj_meta);
 
+/*******************************************
+ *              BATCH API
+ * 一次传入多张图像，走模型的batch推理路径，
+ * 结果按输入顺序写入结果数组
+ *******************************************/
+
+/**
+ * @brief 批量执行目标检测
+ *
+ * @param handle 已加载模型的 TDLHandle 对象
+ * @param model_id 使用的检测模型类型枚举值
+ * @param image_handles TDLImageHandle 对象数组
+ * @param num_images 图像个数
+ * @param object_metas 输出参数，长度为num_images的结果数组
+ * @return 成功返回 0，失败返回-1
+ */
+int32_t TDL_DetectionBatch(TDLHandle handle, const TDLModel model_id,
+                           TDLImage *image_handles, uint32_t num_images,
+                           TDLObject *object_metas);
+
+/**
+ * @brief 批量执行人脸检测
+ *
+ * @param handle 已加载人脸模型的 TDLHandle 对象
+ * @param model_id 使用的人脸检测模型类型枚举值
+ * @param image_handles TDLImageHandle 对象数组
+ * @param num_images 图像个数
+ * @param face_metas 输出参数，长度为num_images的结果数组
+ * @return 成功返回 0，失败返回-1
+ */
+int32_t TDL_FaceDetectionBatch(TDLHandle handle, const TDLModel model_id,
+                               TDLImage *image_handles, uint32_t num_images,
+                               TDLFace *face_metas);
+
+/**
+ * @brief 批量执行图像分类
+ *
+ * @param handle TDLHandle 对象
+ * @param model_id 指定使用的模型类型枚举值
+ * @param image_handles TDLImageHandle 对象数组
+ * @param num_images 图像个数
+ * @param class_infos 输出参数，长度为num_images的结果数组
+ * @return 成功返回 0，失败返回-1
+ */
+int32_t TDL_ClassificationBatch(TDLHandle handle, const TDLModel model_id,
+                                TDLImage *image_handles, uint32_t num_images,
+                                TDLClassInfo *class_infos);
+
+/**
+ * @brief 批量执行特征提取，如同一帧中裁剪出的多个人脸
+ *
+ * @param handle TDLHandle 对象
+ * @param model_id 指定使用的特征提取模型类型枚举值
+ * @param image_handles TDLImageHandle 对象数组
+ * @param num_images 图像个数
+ * @param feature_metas 输出参数，长度为num_images的结果数组
+ * @return 成功返回 0，失败返回-1
+ */
+int32_t TDL_FeatureExtractionBatch(TDLHandle handle, const TDLModel model_id,
+                                   TDLImage *image_handles,
+                                   uint32_t num_images,
+                                   TDLFeature *feature_metas);
+
+/*******************************************
+ *              ASYNC API
+ * 任务提交到 handle 内部的后台推理线程后立即返回，
+ * 同一 handle 的任务按提交顺序串行执行。
+ * 同一 handle 支持多个线程并发提交和查询异步任务，
+ * 但 TDL_DestroyHandle 不能与其它调用并发。
+ * 提交后可以销毁 TDLImage，但输出结构体在任务完成前必须保持有效；
+ * 任务执行期间不要在同一 handle 上对同一模型调用同步接口。
+ * 传入 callback 时在推理线程中回调结果，否则通过 TDL_AsyncPoll 获取结果
+ *******************************************/
+
+/**
+ * @brief 异步执行目标检测
+ *
+ * @param handle 已加载模型的 TDLHandle 对象
+ * @param model_id 使用的检测模型类型枚举值
+ * @param image_handle TDLImageHandle 对象
+ * @param object_meta 输出目标检测结果元数据
+ * @param callback 完成回调，可以为NULL
+ * @param user_data 传给回调的用户数据
+ * @return 成功返回请求ID(大于0)，失败返回-1
+ */
+int64_t TDL_DetectionAsync(TDLHandle handle, const TDLModel model_id,
+                           TDLImage image_handle, TDLObject *object_meta,
+                           TDLAsyncCallback callback, void *user_data);
+
+/**
+ * @brief 异步执行人脸检测
+ *
+ * @param handle 已加载人脸模型的 TDLHandle 对象
+ * @param model_id 使用的人脸检测模型类型枚举值
+ * @param image_handle TDLImageHandle 对象
+ * @param face_meta 输出人脸检测结果元数据
+ * @param callback 完成回调，可以为NULL
+ * @param user_data 传给回调的用户数据
+ * @return 成功返回请求ID(大于0)，失败返回-1
+ */
+int64_t TDL_FaceDetectionAsync(TDLHandle handle, const TDLModel model_id,
+                               TDLImage image_handle, TDLFace *face_meta,
+                               TDLAsyncCallback callback, void *user_data);
+
+/**
+ * @brief 异步执行图像分类
+ *
+ * @param handle TDLHandle 对象
+ * @param model_id 指定使用的模型类型枚举值
+ * @param image_handle TDLImageHandle 对象
+ * @param class_info 输出参数，存储分类结果
+ * @param callback 完成回调，可以为NULL
+ * @param user_data 传给回调的用户数据
+ * @return 成功返回请求ID(大于0)，失败返回-1
+ */
+int64_t TDL_ClassificationAsync(TDLHandle handle, const TDLModel model_id,
+                                TDLImage image_handle,
+                                TDLClassInfo *class_info,
+                                TDLAsyncCallback callback, void *user_data);
+
+/**
+ * @brief 异步执行特征提取
+ *
+ * @param handle TDLHandle 对象
+ * @param model_id 指定使用的特征提取模型类型枚举值
+ * @param image_handle TDLImageHandle 对象
+ * @param feature_meta 输出参数，存储提取的特征向量
+ * @param callback 完成回调，可以为NULL
+ * @param user_data 传给回调的用户数据
+ * @return 成功返回请求ID(大于0)，失败返回-1
+ */
+int64_t TDL_FeatureExtractionAsync(TDLHandle handle, const TDLModel model_id,
+                                   TDLImage image_handle,
+                                   TDLFeature *feature_meta,
+                                   TDLAsyncCallback callback, void *user_data);
+
+/**
+ * @brief 查询异步任务结果(仅适用于未注册回调的请求)
+ *
+ * @param handle TDLHandle 对象
+ * @param request_id 提交时返回的请求ID
+ * @param timeout_ms 等待时间，0为不等待，小于0为一直等待
+ * @param ret 输出参数，任务完成时存储推理结果
+ * @return 任务完成返回 0，未完成返回 1，失败返回-1
+ */
+int32_t TDL_AsyncPoll(TDLHandle handle, int64_t request_id, int32_t timeout_ms,
+                      int32_t *ret);
+
 #if defined(__CV181X__) || defined(__CV184X__) || defined(__CV186X__)
 /**
  * @brief 执行移动侦测任务
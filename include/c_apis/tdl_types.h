@@ -366,6 +366,16 @@ typedef struct {
   float scale[3];  // Y=X*scale-mean
   bool keep_aspect_ratio;
 } TDLPreprocessParams;
+
+/**
+ * @brief 异步推理完成回调，在后台推理线程中执行
+ *
+ * @param request_id 提交时返回的请求ID
+ * @param ret 推理结果，成功为0
+ * @param user_data 提交时传入的用户数据
+ */
+typedef void (*TDLAsyncCallback)(int64_t request_id, int32_t ret,
+                                 void *user_data);
 #ifdef __cplusplus
 }
 #endif
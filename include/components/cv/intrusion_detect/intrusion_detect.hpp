@@ -40,12 +40,26 @@ class IntrusionDetection {
   int addRegion(const PointsInfo &points, const std::string &region_name = "");
   void getRegion(std::vector<PointsInfo> &region_info);
   bool isIntrusion(const ObjectBoxInfo &bbox);
+  // 一次检测一帧的所有框, intrusions[i] 对应 bboxes[i]
+  void isIntrusion(const std::vector<ObjectBoxInfo> &bboxes,
+                   std::vector<bool> &intrusions);
   void clean();
   void print();
 
  private:
-  bool isSeparatingAxis(const Vertex &axis, const PointsInfo &region_pts,
-                        const ObjectBoxInfo &bbox);
+  // 欧几里得坐标系下的框
+  struct BoxBounds {
+    float min_x, max_x, min_y, max_y;
+  };
+  static BoxBounds toBoxBounds(const ObjectBoxInfo &bbox);
+  // 预计算凸多边形在每条法线上的投影区间及其包围框
+  void compileRegion(const ConvexPolygon &region);
+  // 按区域包围框建立均匀网格, 区域变化后在下一次检测时重建
+  void buildGrid();
+  int gridCol(float x) const;
+  int gridRow(float y) const;
+  bool intersectRegion(size_t region, const BoxBounds &box) const;
+  bool testBox(const BoxBounds &box);
   bool isPointInTriangle(const Vertex &o, const Vertex &v1, const Vertex &v2,
                          const Vertex &v3);
   float getSignedGaussArea(const PointsInfo &points);
@@ -54,5 +68,26 @@ class IntrusionDetection {
   bool partitionIntoConvexPolygons(const PointsInfo &points,
                                    std::vector<std::vector<int>> &convex_idxes);
   std::vector<std::shared_ptr<ConvexPolygon>> regions_;
-  PointsInfo base_points_;
+
+  // 区域 r 的法线为 [axis_offsets_[r], axis_offsets_[r + 1]),
+  // 区域在法线上的投影区间为 [axis_min_, axis_max_]
+  std::vector<size_t> axis_offsets_ = {0};
+  std::vector<float> axis_x_, axis_y_, axis_min_, axis_max_;
+  // 区域包围框, 即在两条基准轴上的投影区间
+  std::vector<float> region_min_x_, region_max_x_;
+  std::vector<float> region_min_y_, region_max_y_;
+
+  // 网格单元 c 中的区域为 cell_regions_[cell_offsets_[c] ..
+  // cell_offsets_[c + 1])
+  bool grid_dirty_ = true;
+  int grid_cols_ = 0;
+  int grid_rows_ = 0;
+  float grid_x0_ = 0, grid_y0_ = 0;
+  float grid_x1_ = 0, grid_y1_ = 0;
+  float inv_cell_w_ = 0, inv_cell_h_ = 0;
+  std::vector<uint32_t> cell_offsets_;
+  std::vector<uint32_t> cell_regions_;
+  // 同一个框跨多个单元时避免重复检测同一区域
+  std::vector<uint32_t> visit_stamps_;
+  uint32_t stamp_ = 0;
 };
@@ -26,8 +26,46 @@ class OcclusionDetector {
   // 重置状态
   void reset();
 
+  // 在整数金字塔第 level 层 (ROI 边长缩小 2^level) 上检测,
+  // -1 为自动选择, 使缩小后的 ROI 长边不超过 320
+  void setPyramidLevel(int level);
+  // 每 interval 帧检测一次, 其余帧直接返回上一次的结果
+  void setDetectInterval(int interval);
+
  private:
-  std::vector<int> occlusionStates_;
+  // ROI 转灰度并缩小到 width_ x height_, 写入 gray_
+  int extractGray(const std::shared_ptr<BaseImage>& image, int roi_x,
+                  int roi_y, int level);
+  // 灰度图 -> |Laplacian| (饱和到 255) -> 闭运算, 结果写入 edge_
+  void computeEdge(int radius);
+  // edge_ 中 <= threshold 的像素 (无纹理) 组成的最大 4 连通域面积
+  int maxFlatArea(int threshold);
+  // 时域投票, 返回投票后的类别
+  int vote(int occ_class, int sensitive_th);
+
+  int pyramid_level_ = -1;
+  int detect_interval_ = 1;
+  uint64_t frame_count_ = 0;
+  float last_score_ = 0;
+  int last_class_ = 0;
+
+  // 最近 sensitive_th 次检测的结果, 环形缓冲
+  std::vector<uint8_t> occlusionStates_;
+  int state_pos_ = 0;
+  int state_num_ = 0;
+  int occluded_num_ = 0;
+
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<uint8_t> gray_;
+  std::vector<uint8_t> edge_;
+  std::vector<uint8_t> tmp_;
+
+  // 逐行游程 (run) 并查集, 合并时累计面积
+  std::vector<int> run_parent_;
+  std::vector<int> run_area_;
+  std::vector<int> run_start_;
+  std::vector<int> run_end_;
 };
 
 #endif  // OCCLUSION_DETECTOR_HPP
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mutex>
 #include <vector>
 #include "image/base_image.hpp"
 
@@ -18,6 +19,7 @@ class ImageEncoder {
  public:
   ImageEncoder(int VeChn = 1);
   ~ImageEncoder();
+  // thread safe, calls on the same encoder are serialized
   bool encodeFrame(const std::shared_ptr<BaseImage>& image,
                    std::vector<uint8_t>& encode_img, int jpg_quality = 90);
 
@@ -26,6 +28,7 @@ class ImageEncoder {
 
  private:
   int encoder_mode_;
+  std::mutex mutex_;
 #if defined(__CV181X__) || defined(__CV180X__) || defined(__CV182X__) || \
     defined(__CV183X__) || defined(__CV184X__) || defined(__CV186X__)
   VENC_CHN VeChn_;
@@ -5,6 +5,7 @@
 #include <memory>
 #include <unordered_set>
 #include "common/model_output_types.hpp"
+#include "components/snapshot/snapshot_encoder.hpp"
 #include "components/tracker/tracker_types.hpp"
 #include "encoder/image_encoder/image_encoder.hpp"
 #include "framework/common/packet.hpp"
@@ -15,7 +16,15 @@
 struct ObjectSnapshotInfo {
   float quality = 0;
   std::shared_ptr<BaseImage> object_image;
-  std::vector<uint8_t> encoded_full_image;
+  // jpeg of the full frame (encoder mode 1), shared by every snapshot taken
+  // from the same frame; set when the snapshot is exported
+  std::shared_ptr<const std::vector<uint8_t>> encoded_full_image;
+  // jpeg of object_image, only if encode_object_image is enabled
+  std::shared_ptr<const std::vector<uint8_t>> encoded_object_image;
+  // encode jobs in flight, released when the snapshot is exported
+  std::shared_ptr<EncodeJob> full_image_job;
+  std::shared_ptr<EncodeJob> object_image_job;
+  size_t object_image_job_index = 0;
   uint64_t snapshot_frame_id = 0;
   uint64_t export_frame_id = 0;
   uint64_t track_id = 0;
@@ -42,6 +51,8 @@ struct SnapshotConfig {
   int jpg_quality;
   bool use_reid;
   float reid_threshold;
+  bool encode_object_image;  // also jpeg encode the cropped object images
+  int encode_workers;        // background jpeg encode threads
 };
 
 // 基类
@@ -76,7 +87,9 @@ class ObjectSnapshot {
                      int img_width, int img_height);
 
   void resetSnapshotInfo(ObjectSnapshotInfo& info, uint64_t frame_id);
+  void createSnapshotEncoder();
   std::shared_ptr<ImageEncoder> image_encoder_;
+  std::shared_ptr<SnapshotEncoder> snapshot_encoder_;
   std::shared_ptr<BaseModel> reid_model_;
 
  protected:
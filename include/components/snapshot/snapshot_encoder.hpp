@@ -0,0 +1,100 @@
+#ifndef TDL_SDK_SNAPSHOT_ENCODER_HPP
+#define TDL_SDK_SNAPSHOT_ENCODER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "encoder/image_encoder/image_encoder.hpp"
+#include "framework/image/base_image.hpp"
+
+// 一次编码任务,可包含一帧全景图或同一帧的多张抓拍小图。
+// 任务由所有引用它的抓拍共享,当所有引用都释放且任务尚未执行时,任务被取消
+class EncodeJob : public std::enable_shared_from_this<EncodeJob> {
+ public:
+  enum class State { PENDING = 0, RUNNING, DONE, FAILED, CANCELLED };
+
+  EncodeJob(uint64_t frame_id,
+            const std::vector<std::shared_ptr<BaseImage>>& images,
+            int jpg_quality);
+
+  uint64_t getFrameId() const { return frame_id_; }
+  size_t size() const { return encoded_.size(); }
+  State getState() const { return state_.load(std::memory_order_acquire); }
+  // DONE, FAILED or CANCELLED
+  bool isFinished() const;
+  // wait until finished, timeout_ms < 0 means wait forever
+  bool wait(int timeout_ms = -1);
+  // jpeg data of the index-th image, shares the ownership of the job;
+  // nullptr if the job is not done or the image failed to encode
+  std::shared_ptr<const std::vector<uint8_t>> getEncoded(size_t index = 0);
+
+ private:
+  friend class SnapshotEncoder;
+  void finish(State state);
+
+  uint64_t frame_id_;
+  int jpg_quality_;
+  // released once encoded so that the frame is not held longer than needed
+  std::vector<std::shared_ptr<BaseImage>> images_;
+  std::vector<std::vector<uint8_t>> encoded_;
+  std::atomic<State> state_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+};
+
+struct SnapshotEncoderStats {
+  uint64_t submitted = 0;
+  uint64_t encoded = 0;
+  uint64_t failed = 0;
+  uint64_t cancelled = 0;  // all references released before running
+  uint64_t dropped = 0;    // evicted because the queue was full
+};
+
+// 后台 JPEG 编码线程池,submit 接口不会阻塞在编码上
+class SnapshotEncoder {
+ public:
+  SnapshotEncoder(std::shared_ptr<ImageEncoder> image_encoder,
+                  int num_workers = 1, size_t max_pending_jobs = 8);
+  ~SnapshotEncoder();
+
+  // queue the encode of a full frame, a frame_id that is still queued or
+  // was just submitted returns the same job
+  std::shared_ptr<EncodeJob> submitFrame(
+      const std::shared_ptr<BaseImage>& image, uint64_t frame_id,
+      int jpg_quality);
+  // queue all crops of a frame as a single job
+  std::shared_ptr<EncodeJob> submitBatch(
+      const std::vector<std::shared_ptr<BaseImage>>& images, uint64_t frame_id,
+      int jpg_quality);
+
+  // wait until every queued job is finished
+  void waitIdle();
+  size_t pendingJobs();
+  SnapshotEncoderStats getStats();
+
+ private:
+  std::shared_ptr<EncodeJob> enqueue(std::shared_ptr<EncodeJob> job);
+  void workerLoop();
+  void runJob(const std::shared_ptr<EncodeJob>& job);
+
+  std::shared_ptr<ImageEncoder> image_encoder_;
+  size_t max_pending_jobs_;
+  // the queue does not own the jobs, a job whose owners are all gone is
+  // skipped by the workers
+  std::deque<std::weak_ptr<EncodeJob>> queue_;
+  std::weak_ptr<EncodeJob> last_frame_job_;
+  size_t running_jobs_ = 0;
+  bool stop_ = false;
+  SnapshotEncoderStats stats_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::condition_variable idle_cond_;
+  std::vector<std::thread> workers_;
+};
+
+#endif /* TDL_SDK_SNAPSHOT_ENCODER_HPP */
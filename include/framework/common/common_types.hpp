@@ -144,6 +144,13 @@ struct NetParam {
   // allocated, and the input tensor memory will be set via
   // setInputTensorFromImage().
   bool skip_input_alloc = false;
+
+  // If true, nets opened from the same model file (or buffer) on the same
+  // device share the loaded weights and instructions, each net still owns
+  // its input/output tensors. Ignored when runtime_mem_addrs is set.
+  // Off by default: on BM168X the nets sharing a model also share its
+  // neuron memory, so their forwards run one at a time.
+  bool share_model = false;
 };
 
 struct TensorInfo {
@@ -163,6 +170,7 @@ struct TensorInfo {
 struct LLMInferParam {
   int max_new_tokens;
   float top_p;
+  int top_k;  // <= 0 disables top-k
   float temperature;
   float repetition_penalty;
   int repetition_last_n;
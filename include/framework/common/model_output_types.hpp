@@ -2,6 +2,7 @@
 #define TDL_FRAMEWORK_COMMON_MODEL_OUTPUT_TYPES_HPP
 
 #include <map>
+#include <memory>
 #include <vector>
 #include "common/common_types.hpp"
 #include "common/object_type_def.hpp"
@@ -226,7 +227,9 @@ class ModelSegmentationInfo : public ModelOutputInfo {
         output_width(0),
         output_height(0),
         class_id(nullptr),
-        class_conf(nullptr) {}
+        class_conf(nullptr),
+        native_width(0),
+        native_height(0) {}
 
   ~ModelSegmentationInfo() {
     if (class_id != nullptr) {
@@ -247,6 +250,25 @@ class ModelSegmentationInfo : public ModelOutputInfo {
   uint32_t output_height;
   uint8_t *class_id;
   uint8_t *class_conf;
+
+  // 模型输出分辨率的类别/置信度图 (native_width x native_height),
+  // lazy upsample 时只填充这两张图, class_id/class_conf 为空,
+  // 需要的区域通过 upsampleRoi 按需上采样
+  uint32_t native_width;
+  uint32_t native_height;
+  std::vector<uint8_t> native_class_id;
+  std::vector<uint8_t> native_class_conf;
+  // 最近邻索引表: 输出行/列 -> native 行/列, 同尺寸的帧之间共享
+  std::shared_ptr<const std::vector<int>> row_index;
+  std::shared_ptr<const std::vector<int>> col_index;
+
+  /*
+   * @brief 取输出图 (output_width x output_height) 中的一块区域
+   * @param roi_class_id/roi_class_conf 输出 roi_w x roi_h, 可以为空
+   * @return 0 成功, -1 区域越界或没有可用的类别图
+   */
+  int32_t upsampleRoi(int roi_x, int roi_y, int roi_w, int roi_h,
+                      uint8_t *roi_class_id, uint8_t *roi_class_conf) const;
 };
 
 class ModelASRInfo : public ModelOutputInfo {
@@ -289,10 +311,18 @@ class ModelVADInfo : public ModelOutputInfo {
 
 class ModelDepthInfo : public ModelOutputInfo {
  public:
-  ModelDepthInfo() : w(0), h(0), logits(nullptr) {}
+  ModelDepthInfo()
+      : w(0),
+        h(0),
+        logits(nullptr),
+        native_type(TDLDataType::FP32),
+        native_scale(1.0f),
+        native_data(nullptr),
+        focal_baseline(0.0f) {}
 
   ~ModelDepthInfo() {
-    if (logits != nullptr) {
+    // 池化内存由 buffer 归还, 只释放 malloc 分配的 logits
+    if (logits != nullptr && buffer == nullptr) {
       free(logits);
       logits = nullptr;
     }
@@ -304,6 +334,34 @@ class ModelDepthInfo : public ModelOutputInfo {
 
   int w;
   int h;
+  // w x h 的 float 结果, focal_baseline > 0 时已转为深度;
+  // native output 时为空, 只填充 native_data
   float *logits;
+
+  // 模型原始输出 (int8/uint8/fp16/bf16/fp32), 值 = native * native_scale
+  TDLDataType native_type;
+  float native_scale;
+  const void *native_data;
+  // > 0 时模型输出为视差, 深度 = focal_baseline / 视差, 视差 <= 0 的点无效
+  float focal_baseline;
+  // logits/native_data 所在的池化内存, 为空时 logits 由 malloc 分配
+  std::shared_ptr<std::vector<uint8_t>> buffer;
+
+  /*
+   * @brief n 个原始输出转为 float: v = src * scale, focal_baseline > 0 时
+   *        再转为深度 focal_baseline / v (v <= 0 时为 0)
+   */
+  static int32_t convertToFloat(const void *src, TDLDataType type, float scale,
+                                float focal_baseline, float *dst, size_t n);
+  // 整帧转为 float 写入 dst (w x h), 与 logits 的含义相同
+  int32_t toFloat(float *dst) const;
+  // (x, y) 处的值, 与 logits 的含义相同
+  float valueAt(int x, int y) const;
+  /*
+   * @brief 区域内有效点 (值 > 0) 的中值, native output 时直接在原始数据上
+   *        统计, 不展开整帧
+   * @return 0 成功, -1 区域越界或没有有效点
+   */
+  int32_t roiMedian(int x, int y, int roi_w, int roi_h, float *median) const;
 };
 #endif
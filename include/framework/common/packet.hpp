@@ -6,25 +6,43 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <typeindex>
 #include <typeinfo>
+#include <utility>
 
 class PacketBase {
  public:
   virtual ~PacketBase() {}
   virtual std::type_index getTypeIndex() const = 0;
   virtual const void* getRawPtr() const = 0;
+  // release the resources held by the value but keep the holder for reuse,
+  // return false if the value type could not be reset in place
+  virtual bool clearValue() = 0;
 };
 
 template <typename T>
 class TypedPacket : public PacketBase {
  public:
   explicit TypedPacket(const T& val) : value_(val) {}
+  explicit TypedPacket(T&& val) : value_(std::move(val)) {}
   std::type_index getTypeIndex() const override { return typeid(T); }
   const void* getRawPtr() const override { return &value_; }
+  bool clearValue() override {
+    return clearValueImpl(
+        std::integral_constant<bool, std::is_default_constructible<T>::value &&
+                                         std::is_move_assignable<T>::value>());
+  }
   const T& get() const { return value_; }
+  T& getMutable() { return value_; }
 
  private:
+  bool clearValueImpl(std::true_type) {
+    value_ = T();
+    return true;
+  }
+  bool clearValueImpl(std::false_type) { return false; }
+
   T value_;
 };
 
@@ -32,10 +50,12 @@ class Packet {
  public:
   Packet() {}
 
+  // rvalues are moved into the packet, lvalues are copied
   template <typename T>
-  static Packet make(const T& value) {
+  static Packet make(T&& value) {
+    typedef typename std::decay<T>::type ValueType;
     Packet pkt;
-    pkt.data_.reset(new TypedPacket<T>(value));
+    pkt.data_.reset(new TypedPacket<ValueType>(std::forward<T>(value)));
     return pkt;
   }
   template <typename T>
@@ -49,6 +69,35 @@ class Packet {
       throw std::runtime_error("Packet type mismatch.");
     return static_cast<const TypedPacket<T>*>(data_.get())->get();
   }
+  // borrow the value for in-place modification, the packet must not be shared
+  // with other readers while doing so
+  template <typename T>
+  T& getMutable() {
+    if (!data_) throw std::runtime_error("Packet is empty.");
+    if (data_->getTypeIndex() != typeid(T))
+      throw std::runtime_error("Packet type mismatch.");
+    return static_cast<TypedPacket<T>*>(data_.get())->getMutable();
+  }
+  // assign a new value, reusing the holder when it has the same type and is
+  // not referenced by other packets
+  template <typename T>
+  void set(T&& value) {
+    typedef typename std::decay<T>::type ValueType;
+    if (data_ && data_.use_count() == 1 && is<ValueType>()) {
+      static_cast<TypedPacket<ValueType>*>(data_.get())->getMutable() =
+          std::forward<T>(value);
+    } else {
+      data_.reset(new TypedPacket<ValueType>(std::forward<T>(value)));
+    }
+  }
+  // drop the value, keeping the holder allocated when possible
+  void clear() {
+    if (data_ && (data_.use_count() != 1 || !data_->clearValue())) {
+      data_.reset();
+    }
+  }
+  void reset() { data_.reset(); }
+  bool empty() const { return data_ == nullptr; }
 
  private:
   std::shared_ptr<PacketBase> data_;
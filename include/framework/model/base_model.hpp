@@ -13,6 +13,7 @@
 #include "preprocess/base_preprocessor.hpp"
 #include "tdl_model_defs.hpp"
 #include "utils/profiler.hpp"
+#include "utils/tracer.hpp"
 
 class BaseModel {
  public:
@@ -75,6 +76,10 @@ class BaseModel {
   virtual int32_t onModelClosed() { return 0; }
 
   ModelType getModelType() const { return model_type_; }
+  // span ids of the preprocess/forward/post stages, valid after modelOpen
+  std::vector<uint32_t> getTraceStageIds() const {
+    return {trace_preprocess_id_, trace_forward_id_, trace_post_id_};
+  }
   void setModelType(ModelType model_type) { model_type_ = model_type; }
 
   void setTypeMapping(const std::map<int, TDLObjectType>& type_mapping);
@@ -87,6 +92,12 @@ class BaseModel {
 
   int32_t setPreprocessParameters(const PreprocessParams& pre_param,
                                   const std::string& input_name = "");
+  // Crop region applied to the source image of an input layer before
+  // resize/normalize, so that the crop is fused into the input tensor.
+  // A zero width or height disables the crop.
+  int32_t setInputCrop(const std::string& input_name, int32_t crop_x,
+                       int32_t crop_y, int32_t crop_width,
+                       int32_t crop_height);
   virtual int32_t setupNetwork(NetParam& net_param);
 
   const std::vector<std::string>& getInputNames() const;
@@ -134,6 +145,10 @@ class BaseModel {
   std::map<int, TDLObjectType> type_mapping_;
 
   Timer model_timer_;
+  // span ids of the inference stages, registered in modelOpen
+  uint32_t trace_preprocess_id_ = Tracer::kMaxNames;
+  uint32_t trace_forward_id_ = Tracer::kMaxNames;
+  uint32_t trace_post_id_ = Tracer::kMaxNames;
 };
 
 #endif  // INCLUDE_BASE_MODEL_H_
@@ -1,6 +1,7 @@
 #ifndef INCLUDE_BASE_NET_H_
 #define INCLUDE_BASE_NET_H_
 
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -93,6 +94,17 @@ class NetFactory {
                                  const uint32_t model_buffer_size,
                                  std::vector<uint64_t>& mem_addrs,
                                  std::vector<uint32_t>& mem_sizes);
+
+  // key of the shared model cache: platform, device and model file path (or
+  // model buffer address and size); empty if the net should not be shared
+  static std::string getSharedModelKey(const NetParam& net_param);
+  // return the loaded model cached under key, or load it with loader and
+  // cache it; created is set if loader was called. The cache only holds
+  // weak references, a model is released with the last net using it
+  static std::shared_ptr<void> getSharedModel(
+      const std::string& key,
+      const std::function<std::shared_ptr<void>()>& loader, bool* created);
+  static size_t getSharedModelNum();
 };
 
 #endif  // INCLUDE_BASE_NET_H_
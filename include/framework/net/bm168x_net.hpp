@@ -3,6 +3,8 @@
 
 #include <bmruntime_interface.h>
 
+#include <mutex>
+
 #include "net/base_net.hpp"
 
 class BM168xNet : public BaseNet {
@@ -33,13 +35,23 @@ class BM168xNet : public BaseNet {
 
   void updateTensorInfo(const std::string& name,
                         const std::shared_ptr<BaseTensor>& tensor);
-  int32_t loadModel();
+  // bmrt instance loaded once and shared by every net opened from the same
+  // bmodel on the same device
+  struct SharedRuntime {
+    ~SharedRuntime();
+    void* p_bmrt = nullptr;
+    // the shared instance also shares its neuron memory
+    std::mutex launch_mutex;
+  };
+
+  int32_t loadModel(void* p_bmrt);
   int32_t updateMemoryInfo(const std::vector<uint64_t>& mem_addrs,
                            const std::vector<uint32_t>& mem_sizes,
                            void* mem_info_ptr);
   bm_handle_t bm_handle_;
   int store_mode_ = 0;
   void* p_bmrt_ = 0;
+  std::shared_ptr<SharedRuntime> shared_runtime_;
   std::string net_name_;
 
   const bm_net_info_t* net_info_;
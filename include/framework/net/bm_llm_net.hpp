@@ -1,10 +1,10 @@
 #ifndef TDL_SDK_NET_BM_LLM_NET_HPP
 #define TDL_SDK_NET_BM_LLM_NET_HPP
 
-#include <random>
 #include "bmruntime_interface.h"
 
 #include "common/common_types.hpp"
+#include "utils/llm_sampler.hpp"
 class BMLLMNet {
  public:
   BMLLMNet();
@@ -29,6 +29,11 @@ class BMLLMNet {
   void headLaunch(const bm_net_info_t *net, bm_device_mem_t &logits_mem);
   int greedySearch(const bm_net_info_t *net, bm_device_mem_t &logits_mem);
   int penaltySample(const bm_net_info_t *net, bm_device_mem_t &logits_mem);
+  // penalty sampling on host, used when the bmodel has no penalty_sample_head
+  int hostSample(const bm_net_info_t *net, bm_device_mem_t &logits_mem);
+  int sampleToken(bm_device_mem_t &logits_mem);
+  void resetHistory(const std::vector<int> &tokens);
+  void updateHistory(int token);
 
  public:
   // 生成参数 - 这些需要保留为公共成员，因为它们可能需要从外部设置
@@ -36,13 +41,22 @@ class BMLLMNet {
 
  private:
   // 保留必要的状态变量
-  std::mt19937 sgen_;
+  LLMSampler sampler_;
   int token_length_;  // 当前token长度，需要在多次调用之间保持
   int SEQLEN_;        // 从bmodel读取的序列长度
   int NUM_LAYERS_;    // 从bmodel读取的层数
   bool io_alone_;     // IO模式标志
   bool is_dynamic_;   // 动态shape标志
   std::vector<int> visited_tokens_;  // 已访问的token历史
+  // 重复惩罚窗口,常驻并按 token 增量更新,io_alone 时设备端只同步变化的部分
+  TokenWindow history_window_;
+  bool history_full_upload_ = true;
+  int history_dirty_slot_ = -1;
+  // 已写入 penalty_sample_head 的采样参数,io_alone 且参数不变时不再拷贝
+  LLMSampleParam uploaded_param_;
+  bool param_uploaded_ = false;
+  std::vector<float> host_logits_;
+  std::vector<uint16_t> host_logits_half_;
 
   // 运行时环境
   std::vector<bm_handle_t> handles_;
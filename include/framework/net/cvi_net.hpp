@@ -22,7 +22,11 @@ class CviNet : public BaseNet {
  private:
   void setupTensorInfo(CVI_TENSOR* cvi_tensor, int32_t num_tensors,
                        std::map<std::string, TensorInfo>& tensor_info);
+  int32_t registerModel(CVI_MODEL_HANDLE* model_handle);
+
   void* model_handle_ = nullptr;
+  // registered model shared by every net opened from the same model
+  std::shared_ptr<void> shared_model_;
   CVI_TENSOR* input_tensors_ = nullptr;
   CVI_TENSOR* output_tensors_ = nullptr;
   std::shared_ptr<BaseMemoryPool> memory_pool_;
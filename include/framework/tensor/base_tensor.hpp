@@ -44,7 +44,17 @@ class BaseTensor {
   void setZero();
 
   int32_t constructImage(std::shared_ptr<BaseImage> image, int batch_idx = -1);
+  // 图像与张量尺寸/数据类型一致时按平面拷贝, 不做转换
   int32_t copyFromImage(std::shared_ptr<BaseImage> image, int batch_idx = -1);
+  // uint8 图像 (GRAY/RGB/BGR, packed 或 planar) 转换后写入第 batch_idx 个
+  // 槽位: packed 转为 planar, 通道顺序按 params.dst_image_format 调整,
+  // 逐通道计算 y = (x * scale - mean) * qscale 再转换为
+  // params.dst_pixdata_type (int8/uint8 就近取整并饱和, bf16/fp16 就近舍入).
+  // 图像尺寸须与张量一致, 不做缩放与裁剪; 模型的预处理参数已乘以 qscale,
+  // 此时 qscale 传 1
+  int32_t copyFromImage(std::shared_ptr<BaseImage> image,
+                        const PreprocessParams& params, int batch_idx,
+                        float qscale = 1.0f);
 
   template <typename T>
   T* getBatchPtr(int batch_idx) {
@@ -1,7 +1,19 @@
 #ifndef FRAME_DUMP_H
 #define FRAME_DUMP_H
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "common/common_types.hpp"
+#include "image/base_image.hpp"
+
+#if defined(__CV181X__) || defined(__CV180X__) || defined(__CV184X__) || \
+    defined(__CV186X__)
 #include "cvi_comm_sys.h"
 #include "cvi_comm_vpss.h"
 #include "cvi_sys.h"
@@ -11,5 +23,133 @@ class FrameDump {
  public:
   static int32_t saveFrame(char *filename, VIDEO_FRAME_INFO_S *pstVideoFrame);
 };
+#endif
+
+// Asynchronous frame dumping for debugging running pipelines.
+//
+// submit() copies the frames picked by the sampling policy into pooled
+// buffers and hands them to a dedicated writer thread through a bounded
+// lock-free queue, the calling thread never touches the file. When no buffer
+// is free the frame is dropped and counted instead of blocking.
+//
+// All frames are appended to one container file:
+//  - Y4M (YUV4MPEG2) for GRAY and YUV420 images, playable with ffplay/mpv;
+//    every frame must have the size and format of the first one.
+//  - RAW for any image: each frame is a FrameDumpRawHeader followed by its
+//    planes, rows packed without stride padding.
+// On Linux the file can be preallocated with fallocate() and written with
+// O_DIRECT, falling back to buffered I/O where O_DIRECT is not supported.
+
+enum class FrameDumpFormat { RAW = 0, Y4M };
+
+struct FrameDumpConfig {
+  std::string file_path;
+  FrameDumpFormat format = FrameDumpFormat::RAW;
+  // frames waiting for the writer, also the number of pooled buffers
+  uint32_t queue_size = 8;
+  // dump every Nth submitted frame, 0 dumps only triggered frames or frames
+  // inside the time window
+  uint32_t every_n = 1;
+  uint32_t fps = 25;  // frame rate written to the Y4M header
+  bool direct_io = false;
+  uint64_t preallocate_bytes = 0;
+};
+
+struct FrameDumpRawHeader {
+  char magic[4];  // "TDLF"
+  uint32_t header_size;
+  uint32_t width;
+  uint32_t height;
+  uint32_t image_format;   // ImageFormat
+  uint32_t pix_data_type;  // TDLDataType
+  uint32_t plane_num;
+  uint32_t plane_bytes[3];
+  uint64_t frame_index;  // index among the submitted frames
+  uint64_t timestamp_ns;  // steady clock, same as Tracer::nowNs()
+};
+
+class FrameDumper {
+ public:
+  FrameDumper();
+  ~FrameDumper();
+
+  int32_t start(const FrameDumpConfig &config);
+  // write the queued frames and close the file
+  int32_t stop();
+
+  // 0: queued, 1: not picked by the sampling policy, -1: dropped or invalid.
+  // May be called from several threads.
+  int32_t submit(const std::shared_ptr<BaseImage> &image);
+
+  // event sampling: also dump the next frame_num submitted frames
+  void trigger(uint32_t frame_num);
+  // also dump every frame submitted in [start_ns, end_ns), steady clock
+  void setTimeWindow(uint64_t start_ns, uint64_t end_ns);
+
+  uint64_t getWrittenFrames() const { return written_frames_.load(); }
+  uint64_t getDroppedFrames() const { return dropped_frames_.load(); }
+
+ private:
+  struct FrameBuffer {
+    FrameDumpRawHeader header;
+    std::vector<uint8_t> data;
+  };
+
+  // Bounded multi-producer multi-consumer queue of buffer indices, every
+  // cell carries a sequence number (Vyukov)
+  class IndexQueue {
+   public:
+    void init(uint32_t capacity);
+    bool push(uint32_t value);
+    bool pop(uint32_t &value);
+
+   private:
+    struct Cell {
+      std::atomic<uint64_t> sequence;
+      uint32_t value;
+    };
+    std::unique_ptr<Cell[]> cells_;
+    uint64_t mask_ = 0;
+    std::atomic<uint64_t> head_{0};
+    std::atomic<uint64_t> tail_{0};
+  };
+
+  bool pickFrame(uint64_t frame_index, uint64_t now_ns);
+  int32_t checkY4mFrame(const FrameDumpRawHeader &header);
+  void writerLoop();
+  int32_t writeFrame(const FrameBuffer &frame);
+  int32_t append(const uint8_t *data, size_t size);
+  int32_t flushStaging(bool final_block);
+
+  FrameDumpConfig config_;
+  std::vector<FrameBuffer> buffers_;
+  IndexQueue free_queue_;
+  IndexQueue ready_queue_;
+
+  std::thread writer_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cond_;
+  std::atomic<bool> running_{false};
+
+  std::atomic<uint64_t> frame_counter_{0};
+  std::atomic<uint32_t> trigger_frames_{0};
+  std::atomic<uint64_t> window_start_ns_{0};
+  std::atomic<uint64_t> window_end_ns_{0};
+  std::atomic<uint64_t> written_frames_{0};
+  std::atomic<uint64_t> dropped_frames_{0};
+
+  // the first frame fixes the Y4M stream geometry
+  std::mutex y4m_mutex_;
+  bool y4m_fixed_ = false;
+  FrameDumpRawHeader y4m_header_;
+
+  // writer thread only
+  int fd_ = -1;
+  bool direct_io_ = false;
+  uint8_t *staging_ = nullptr;
+  size_t staging_size_ = 0;
+  uint64_t file_size_ = 0;
+  std::vector<uint8_t> plane_buffer_;
+};
 
-#endif  // FRAME_DUMP_H
\ No newline at end of file
+#endif  // FRAME_DUMP_H
@@ -23,4 +23,19 @@ int32_t tdl_license_plate_warp_affine(const unsigned char* src_data,
                                       int src_height, unsigned char* dst_data,
                                       unsigned int dst_step, int dst_width,
                                       int dst_height, const float* src_pts4_xy);
+// YUV420SP (NV12/NV21) 输入, 直接从 Y/UV 平面取样并输出 RGB packed,
+// 不需要先把整帧转换为 RGB
+int32_t tdl_face_warp_affine_yuv420sp(
+    const unsigned char* y_data, unsigned int y_step,
+    const unsigned char* uv_data, unsigned int uv_step, bool is_nv21,
+    int src_width, int src_height, unsigned char* dst_data,
+    unsigned int dst_step, int dst_width, int dst_height,
+    const float* src_pts5_xy);
+
+int32_t tdl_license_plate_warp_affine_yuv420sp(
+    const unsigned char* y_data, unsigned int y_step,
+    const unsigned char* uv_data, unsigned int uv_step, bool is_nv21,
+    int src_width, int src_height, unsigned char* dst_data,
+    unsigned int dst_step, int dst_width, int dst_height,
+    const float* src_pts4_xy);
 #endif
@@ -0,0 +1,81 @@
+#ifndef TDL_SDK_UTILS_LLM_SAMPLER_HPP
+#define TDL_SDK_UTILS_LLM_SAMPLER_HPP
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Token sampling for the LLM decoder, independent of the device runtime.
+//
+// TokenWindow keeps the repetition-penalty history in the layout expected by
+// the penalty_sample_head (a fixed size int buffer), updated in place with one
+// slot per generated token. LLMSampler is the host implementation of the
+// head: repetition penalty, temperature, top-k, top-p and sampling on raw
+// logits, used when the bmodel has no penalty_sample_head.
+
+// The last window_size tokens as an unordered set in a buffer of capacity
+// ints. The repetition penalty only cares which tokens are in the window, so
+// token i is stored in slot i % window_size and the slots past the window are
+// padded with a token that is still in it.
+class TokenWindow {
+ public:
+  void reset(int capacity, int window_size, const int *tokens,
+             int num_tokens);
+  // returns true if the padding was rewritten (the whole buffer changed),
+  // otherwise only lastSlot() changed
+  bool push(int token);
+
+  const std::vector<int> &buffer() const { return buffer_; }
+  int lastSlot() const { return last_slot_; }
+  // number of valid (non padding) entries at the front of the buffer
+  int size() const;
+
+ private:
+  void fillPadding(int token);
+
+  std::vector<int> buffer_;
+  int window_size_ = 1;
+  int64_t count_ = 0;
+  int last_slot_ = 0;
+  // the padding token lives in pad_slot_ until that slot is overwritten
+  int pad_slot_ = 0;
+};
+
+struct LLMSampleParam {
+  float temperature = 1.0f;
+  float top_p = 1.0f;
+  int top_k = 0;  // <= 0 disables top-k
+  float repetition_penalty = 1.0f;
+};
+
+class LLMSampler {
+ public:
+  explicit LLMSampler(uint32_t seed = std::random_device()());
+
+  void setSeed(uint32_t seed) { rng_.seed(seed); }
+
+  static int argmax(const float *logits, int num);
+
+  // sample a token id from raw logits, history holds the tokens the
+  // repetition penalty applies to (duplicates are fine). logits is modified
+  // in place by the penalty.
+  int sample(float *logits, int vocab_size, const LLMSampleParam &param,
+             const int *history, int history_len);
+
+  // sample from the candidates produced by the device head
+  int sampleCandidates(const float *probs, const int *tokens, int num);
+
+  // uniform draw in [0, total) and a single prefix-sum scan, weights need not
+  // be normalized; returns the index
+  int sampleIndex(const float *weights, int num, float total);
+
+ private:
+  std::mt19937 rng_;
+  // scratch buffers kept across calls
+  std::vector<int> indices_;
+  std::vector<float> weights_;
+  std::vector<uint32_t> penalty_stamp_;
+  uint32_t stamp_ = 0;
+};
+
+#endif  // TDL_SDK_UTILS_LLM_SAMPLER_HPP
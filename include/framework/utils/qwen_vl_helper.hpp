@@ -21,6 +21,8 @@ class QwenVLHelper {
       const std::string &image_path, const std::map<std::string, int> &args);
   /**
    * @brief 从视频中提取帧
+   * 只解码采样帧:远距离跳转时 seek 到关键帧,其余帧只 grab,
+   * 采样帧较多时分段在多个视频实例上并行解码
    *
    * @param video_path 视频路径
    * @param desired_fps 期望的帧率
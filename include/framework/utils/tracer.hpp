@@ -0,0 +1,118 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Low-overhead latency tracing for model stages and pipeline nodes.
+//
+// Spans are written to a per-thread ring buffer (single writer, no lock) and
+// aggregated into a log-linear (HDR style) histogram per span name. Results
+// can be exported as Prometheus text (file or local http endpoint) and the
+// recent spans dumped as a Chrome trace JSON (chrome://tracing, Perfetto).
+//
+// Tracing is off by default, enable it with TDL_TRACE=1 or
+// Tracer::setEnabled(true). When disabled every trace point costs a relaxed
+// atomic load.
+
+// Latency histogram with ~3% relative precision, values in nanoseconds.
+// record() is lock-free and may be called from several threads.
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  void record(uint64_t value_ns);
+  void reset();
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+  // percentile in [0,100]
+  uint64_t valueAtPercentile(double percentile) const;
+
+  static int bucketIndex(uint64_t value);
+  // representative (middle) value of the bucket
+  static uint64_t bucketValue(int index);
+
+  static constexpr int kSubBucketBits = 5;
+  static constexpr int kSubBucketCount = 1 << kSubBucketBits;
+  static constexpr int kBucketNum =
+      (64 - kSubBucketBits + 1) * kSubBucketCount;
+
+ private:
+  std::atomic<uint64_t> counts_[kBucketNum];
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> max_;
+};
+
+class Tracer {
+ public:
+  static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+  static void setEnabled(bool enabled);
+
+  // map a span name to an id, the same name always gets the same id;
+  // call it at setup time, not per frame
+  static uint32_t registerName(const std::string &name);
+  static std::string getName(uint32_t name_id);
+  // aggregated histogram of a span name, nullptr if the id is not registered
+  static const LatencyHistogram *getHistogram(uint32_t name_id);
+
+  static uint64_t nowNs();
+  // record a finished span, called by the owning thread
+  static void record(uint32_t name_id, uint64_t start_ns, uint64_t end_ns);
+
+  // summary of every span name: count, sum, max and p50/p90/p99
+  static std::string exportPrometheus();
+  static int32_t writePrometheus(const std::string &file_path);
+  // dump the spans still kept in the ring buffers
+  static int32_t dumpChromeTrace(const std::string &file_path);
+
+  // serve exportPrometheus() on http://127.0.0.1:port/metrics
+  static int32_t startMetricsServer(int port);
+  static void stopMetricsServer();
+
+  // clear histograms and ring buffers, registered names are kept
+  static void reset();
+
+  static constexpr uint32_t kMaxNames = 1024;
+  static constexpr uint32_t kRingCapacity = 8192;  // spans kept per thread
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+// Record the lifetime of the scope as a span
+class TraceScope {
+ public:
+  explicit TraceScope(uint32_t name_id)
+      : name_id_(name_id),
+        start_ns_(Tracer::isEnabled() ? Tracer::nowNs() : 0) {}
+  ~TraceScope() {
+    if (start_ns_ != 0) {
+      Tracer::record(name_id_, start_ns_, Tracer::nowNs());
+    }
+  }
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+ private:
+  uint32_t name_id_;
+  uint64_t start_ns_;
+};
+
+// Consecutive stages in the TicToc style: start() then step(id) at the end of
+// each stage, every step records the span since the previous mark
+class TraceSteps {
+ public:
+  void start() { last_ns_ = Tracer::isEnabled() ? Tracer::nowNs() : 0; }
+  void step(uint32_t name_id) {
+    if (last_ns_ != 0) {
+      uint64_t now_ns = Tracer::nowNs();
+      Tracer::record(name_id, last_ns_, now_ns);
+      last_ns_ = now_ns;
+    }
+  }
+
+ private:
+  uint64_t last_ns_ = 0;
+};
@@ -4,6 +4,14 @@
 #include <json.hpp>
 #include "model/base_model.hpp"
 #include "tdl_model_defs.hpp"
+
+struct ModelLoadRequest {
+  ModelType model_type = ModelType::INVALID;
+  // if empty, would use the model path from model_config_file
+  std::string model_path;
+  int device_id = 0;
+};
+
 class TDLModelFactory {
  public:
   /*
@@ -84,6 +92,26 @@ class TDLModelFactory {
       const std::vector<uint32_t> &mem_sizes = {}, const int device_id = 0);
   ModelConfig getModelConfig(const ModelType model_type);
 
+  /*
+   * open several models concurrently, with setModelSharing(true) requests
+   * of the same model file share the loaded weights
+   * @param requests
+   * @param num_threads, <= 0 means min(requests.size(), cpu cores)
+   * @return model instances in the order of requests, nullptr if failed
+   */
+  std::vector<std::shared_ptr<BaseModel>> getModels(
+      const std::vector<ModelLoadRequest> &requests, int num_threads = 0);
+  std::vector<std::shared_ptr<BaseModel>> getModels(
+      const std::vector<ModelType> &model_types, const int device_id = 0);
+
+  /*
+   * models opened from the same model file (or buffer) on the same device
+   * share the loaded weights and instructions, each model instance still
+   * owns its input/output tensors. Disabled by default, on BM168X the
+   * shared models run their forwards one at a time
+   */
+  void setModelSharing(bool enable) { share_model_ = enable; }
+
   /*
    * Get model instance without opening it. This allows configuring NetParam
    * (e.g., skip_input_alloc) before calling modelOpen().
@@ -175,5 +203,6 @@ class TDLModelFactory {
   std::map<std::string, nlohmann::json> model_config_map_;
   InferencePlatform platform_;
   std::vector<std::string> coco_types_;
+  bool share_model_ = false;
 };
 #endif
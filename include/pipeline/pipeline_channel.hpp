@@ -13,6 +13,8 @@ class PipelineChannel {
   // to get the frame processed by last node
   PtrFrameInfo getProcessedFrame(int wait_ms = 5);
   PtrFrameInfo getFreeFrame(int wait_ms = 5);
+  // to get a frame for external input, reuse the free frame if there is one
+  PtrFrameInfo acquireFrame();
   // to add the frame to first node
   int32_t addFreeFrame(PtrFrameInfo frame_info);
   std::string getNodeName(size_t index);
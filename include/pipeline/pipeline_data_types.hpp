@@ -1,17 +1,94 @@
 #ifndef FILE_DATA_TYPES_HPP
 #define FILE_DATA_TYPES_HPP
 
+#include <array>
+#include <bitset>
 #include <map>
+#include <memory>
 #include "framework/common/packet.hpp"
 
+// Per-frame node outputs stored in a flat array of typed slots. Slot indices
+// are interned from names once (PipelineFrameInfo::getSlotIndex) when the
+// pipeline is built, so per-frame access is an array index instead of a
+// string-keyed lookup. Cleared slots keep their holder so that a pooled
+// PipelineFrameInfo does not reallocate it for the next frame.
+class NodeDataSlots {
+ public:
+  static constexpr int kMaxSlots = 64;
+
+  // move-in when value is an rvalue
+  template <typename T>
+  void set(int slot, T &&value) {
+    checkSlot(slot);
+    slots_[slot].set(std::forward<T>(value));
+    valid_.set(slot);
+  }
+  // borrow-out, the reference is valid until the slot is set or cleared
+  template <typename T>
+  const T &get(int slot) const {
+    if (!contains(slot)) {
+      throw std::runtime_error("node data slot " + std::to_string(slot) +
+                               " is empty.");
+    }
+    return slots_[slot].get<T>();
+  }
+  template <typename T>
+  T &getMutable(int slot) {
+    if (!contains(slot)) {
+      throw std::runtime_error("node data slot " + std::to_string(slot) +
+                               " is empty.");
+    }
+    return slots_[slot].getMutable<T>();
+  }
+  // move the value out, used when handing results over to the caller
+  template <typename T>
+  T take(int slot) {
+    T value = std::move(getMutable<T>(slot));
+    erase(slot);
+    return value;
+  }
+  bool contains(int slot) const {
+    return slot >= 0 && slot < kMaxSlots && valid_.test(slot);
+  }
+  void erase(int slot) {
+    checkSlot(slot);
+    slots_[slot].clear();
+    valid_.reset(slot);
+  }
+  // clear all slots except keep_slot (-1 to clear all)
+  void clear(int keep_slot = -1) {
+    for (int i = 0; i < kMaxSlots; i++) {
+      if (i != keep_slot && valid_.test(i)) {
+        erase(i);
+      }
+    }
+  }
+
+ private:
+  void checkSlot(int slot) const {
+    if (slot < 0 || slot >= kMaxSlots) {
+      throw std::out_of_range("node data slot out of range: " +
+                              std::to_string(slot));
+    }
+  }
+
+  std::array<Packet, kMaxSlots> slots_;
+  std::bitset<kMaxSlots> valid_;
+};
+
 class PipelineFrameInfo {
  public:
   PipelineFrameInfo() {}
   ~PipelineFrameInfo() {}
+  // map a node data name to its slot index, the same name always gets the same
+  // index; call it when building the pipeline, not per frame
+  static int getSlotIndex(const std::string &name);
+
   uint64_t frame_id_;
   uint32_t frame_width;
   uint32_t frame_height;
-  std::map<std::string, Packet> node_data_;  // generated by node
+  NodeDataSlots node_data_;  // generated by node
+  uint64_t trace_enqueue_ns_ = 0;  // set when queued to a node with tracing
 };
 
 typedef std::unique_ptr<PipelineFrameInfo> PtrFrameInfo;
@@ -6,6 +6,7 @@
 #include "framework/common/blocking_queue.hpp"
 #include "framework/model/base_model.hpp"
 #include "pipeline/pipeline_data_types.hpp"
+#include "utils/tracer.hpp"
 class PipelineChannel;
 
 class PipelineNode {
@@ -45,6 +46,10 @@ class PipelineNode {
   bool is_running_ = false;
   bool is_frist_node_ = false;
   std::function<int32_t(PtrFrameInfo &, Packet &)> process_func_ = nullptr;
+  // span ids, registered in setName
+  uint32_t trace_wait_id_ = Tracer::kMaxNames;
+  uint32_t trace_process_id_ = Tracer::kMaxNames;
+  uint32_t trace_handoff_id_ = Tracer::kMaxNames;
 };
 
 class NodeFactory {
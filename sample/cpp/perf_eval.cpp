@@ -1,51 +1,476 @@
+#include <getopt.h>
+
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <json.hpp>
+#include <sstream>
+#include <thread>
+#include <vector>
+
 #include "tdl_model_factory.hpp"
+#include "utils/tdl_log.hpp"
+#include "utils/tracer.hpp"
 
-int main(int argc, char **argv) {
-  if (argc != 5) {
-    printf("Usage: %s <model_id_name> <model_dir> <image_path> <loop_num>\n",
-           argv[0]);
-    printf("model_id_name:\n");
-    for (auto &item : kAllModelTypes) {
-      printf("%s\n", modelTypeToString(item).c_str());
+// Load generator for any TDLModelFactory model.
+//
+// Every (threads, batch) combination of the sweep runs a warmup phase and a
+// measured phase. Each worker thread owns its own model handle and calls
+// inference() with `batch` images per request. End-to-end latency is
+// measured per request, stage latency (preprocess/forward/post) comes from
+// the model spans of the Tracer and is measured per forward batch.
+//
+// The model id "STAND_IN" runs a host stand-in model instead: the real
+// preprocessor of the platform, a busy loop of --forward_us for the
+// forward pass and a trivial output parse. It needs no device and no model
+// file, which makes the harness itself testable off-device.
+
+namespace {
+
+const std::string kStandInModelId = "STAND_IN";
+
+struct EvalOptions {
+  std::string model_id_name;
+  std::string model_dir;
+  std::string model_path;
+  std::string image_path;
+  int warmup = 10;         // requests per worker before measuring
+  int count = 0;           // total measured requests, 0 means use duration
+  double duration_s = 10;  // measured time if count is 0
+  std::vector<int> threads = {1};
+  std::vector<int> batches = {1};
+  int stand_in_forward_us = 5000;
+  std::string json_path;
+  std::string csv_path;
+};
+
+struct StageStats {
+  std::string name;
+  uint64_t count = 0;
+  double mean_ms = 0;
+  double p50_ms = 0;
+  double p90_ms = 0;
+  double p99_ms = 0;
+  double max_ms = 0;
+};
+
+struct EvalResult {
+  int threads = 0;
+  int batch = 0;
+  uint64_t requests = 0;
+  uint64_t failed = 0;
+  double elapsed_s = 0;
+  double requests_per_s = 0;
+  double images_per_s = 0;
+  // end to end first, then preprocess/forward/post
+  std::vector<StageStats> stages;
+};
+
+class StandInModel : public BaseModel {
+ public:
+  explicit StandInModel(int forward_us) : forward_us_(forward_us) {
+    preprocessor_ =
+        PreprocessorFactory::createPreprocessor(InferencePlatform::AUTOMATIC);
+    memset(&stand_in_params_, 0, sizeof(PreprocessParams));
+    stand_in_params_.dst_width = 640;
+    stand_in_params_.dst_height = 640;
+    stand_in_params_.dst_image_format = ImageFormat::RGB_PLANAR;
+    stand_in_params_.dst_pixdata_type = TDLDataType::UINT8;
+    stand_in_params_.keep_aspect_ratio = true;
+    for (int i = 0; i < 3; i++) {
+      stand_in_params_.scale[i] = 1;
+    }
+    trace_preprocess_id_ = Tracer::registerName("model/stand_in/preprocess");
+    trace_forward_id_ = Tracer::registerName("model/stand_in/forward");
+    trace_post_id_ = Tracer::registerName("model/stand_in/post");
+  }
+
+  int32_t inference(const std::vector<std::shared_ptr<BaseImage>> &images,
+                    std::vector<std::shared_ptr<ModelOutputInfo>> &out_datas,
+                    const std::map<std::string, float> &parameters) override {
+    if (preprocessor_ == nullptr) {
+      LOGE("no preprocessor on this platform");
+      return -1;
+    }
+    TraceSteps trace_steps;
+    trace_steps.start();
+    for (auto &image : images) {
+      if (preprocessor_->preprocess(image, stand_in_params_, nullptr) ==
+          nullptr) {
+        return -1;
+      }
+    }
+    trace_steps.step(trace_preprocess_id_);
+
+    uint64_t end_ns = Tracer::nowNs() + forward_us_ * 1000ULL;
+    while (Tracer::nowNs() < end_ns) {
+    }
+    trace_steps.step(trace_forward_id_);
+
+    for (auto &image : images) {
+      std::shared_ptr<ModelBoxInfo> box_info =
+          std::make_shared<ModelBoxInfo>();
+      box_info->image_width = image->getWidth();
+      box_info->image_height = image->getHeight();
+      box_info->bboxes.emplace_back(0, 0.9f, 10, 10, 100, 100);
+      out_datas.push_back(box_info);
+    }
+    trace_steps.step(trace_post_id_);
+    return 0;
+  }
+
+ private:
+  int forward_us_;
+  PreprocessParams stand_in_params_;
+};
+
+std::vector<int> parseIntList(const std::string &str) {
+  std::vector<int> values;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    int value = atoi(item.c_str());
+    if (value > 0) {
+      values.push_back(value);
     }
+  }
+  return values;
+}
+
+StageStats toStageStats(const std::string &name,
+                        const LatencyHistogram *histogram) {
+  StageStats stats;
+  stats.name = name;
+  if (histogram == nullptr || histogram->count() == 0) {
+    return stats;
+  }
+  stats.count = histogram->count();
+  stats.mean_ms = histogram->sum() / 1e6 / stats.count;
+  stats.p50_ms = histogram->valueAtPercentile(50) / 1e6;
+  stats.p90_ms = histogram->valueAtPercentile(90) / 1e6;
+  stats.p99_ms = histogram->valueAtPercentile(99) / 1e6;
+  stats.max_ms = histogram->max() / 1e6;
+  return stats;
+}
+
+std::shared_ptr<BaseModel> createModel(const EvalOptions &options) {
+  if (options.model_id_name == kStandInModelId) {
+    return std::make_shared<StandInModel>(options.stand_in_forward_us);
+  }
+  TDLModelFactory &model_factory = TDLModelFactory::getInstance();
+  if (!options.model_path.empty()) {
+    return model_factory.getModel(options.model_id_name, options.model_path);
+  }
+  return model_factory.getModel(options.model_id_name);
+}
+
+EvalResult runConfig(const EvalOptions &options,
+                     std::vector<std::shared_ptr<BaseModel>> &models,
+                     const std::shared_ptr<BaseImage> &image, int num_threads,
+                     int batch) {
+  std::vector<std::shared_ptr<BaseImage>> input_images(batch, image);
+
+  // warmup, then drop everything recorded so far
+  std::vector<std::thread> workers;
+  for (int t = 0; t < num_threads; t++) {
+    workers.emplace_back([&, t]() {
+      std::vector<std::shared_ptr<ModelOutputInfo>> out_datas;
+      for (int i = 0; i < options.warmup; i++) {
+        out_datas.clear();
+        models[t]->inference(input_images, out_datas);
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+  Tracer::reset();
+
+  LatencyHistogram e2e_histogram;
+  std::atomic<int64_t> issued(0);
+  std::atomic<uint64_t> failed(0);
+  uint64_t start_ns = Tracer::nowNs();
+  uint64_t deadline_ns =
+      start_ns + static_cast<uint64_t>(options.duration_s * 1e9);
+  for (int t = 0; t < num_threads; t++) {
+    workers.emplace_back([&, t]() {
+      std::vector<std::shared_ptr<ModelOutputInfo>> out_datas;
+      while (true) {
+        if (options.count > 0) {
+          if (issued.fetch_add(1) >= options.count) {
+            break;
+          }
+        } else if (Tracer::nowNs() >= deadline_ns) {
+          break;
+        }
+        out_datas.clear();
+        uint64_t request_start_ns = Tracer::nowNs();
+        int32_t ret = models[t]->inference(input_images, out_datas);
+        e2e_histogram.record(Tracer::nowNs() - request_start_ns);
+        if (ret != 0) {
+          failed.fetch_add(1);
+        }
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  EvalResult result;
+  result.threads = num_threads;
+  result.batch = batch;
+  result.elapsed_s = (Tracer::nowNs() - start_ns) / 1e9;
+  result.requests = e2e_histogram.count();
+  result.failed = failed.load();
+  result.requests_per_s = result.requests / result.elapsed_s;
+  result.images_per_s = result.requests_per_s * batch;
+  result.stages.push_back(toStageStats("e2e", &e2e_histogram));
+  // all handles of the same model share the stage span names
+  std::vector<uint32_t> stage_ids = models[0]->getTraceStageIds();
+  const char *stage_names[] = {"preprocess", "forward", "post"};
+  for (size_t i = 0; i < stage_ids.size(); i++) {
+    result.stages.push_back(
+        toStageStats(stage_names[i], Tracer::getHistogram(stage_ids[i])));
+  }
+  return result;
+}
+
+void printResult(const EvalResult &result) {
+  printf("threads:%d batch:%d requests:%lu failed:%lu elapsed:%.2fs "
+         "throughput:%.2f req/s %.2f img/s\n",
+         result.threads, result.batch, (unsigned long)result.requests,
+         (unsigned long)result.failed, result.elapsed_s, result.requests_per_s,
+         result.images_per_s);
+  printf("  %-10s %10s %10s %10s %10s %10s %10s\n", "stage(ms)", "count",
+         "mean", "p50", "p90", "p99", "max");
+  for (auto &stage : result.stages) {
+    printf("  %-10s %10lu %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+           stage.name.c_str(), (unsigned long)stage.count, stage.mean_ms,
+           stage.p50_ms, stage.p90_ms, stage.p99_ms, stage.max_ms);
+  }
+}
+
+int32_t writeJson(const std::string &file_path, const EvalOptions &options,
+                  const std::vector<EvalResult> &results) {
+  nlohmann::json root;
+  root["model"] = options.model_id_name;
+  root["results"] = nlohmann::json::array();
+  for (auto &result : results) {
+    nlohmann::json item;
+    item["threads"] = result.threads;
+    item["batch"] = result.batch;
+    item["requests"] = result.requests;
+    item["failed"] = result.failed;
+    item["elapsed_s"] = result.elapsed_s;
+    item["requests_per_s"] = result.requests_per_s;
+    item["images_per_s"] = result.images_per_s;
+    for (auto &stage : result.stages) {
+      nlohmann::json stage_item;
+      stage_item["count"] = stage.count;
+      stage_item["mean_ms"] = stage.mean_ms;
+      stage_item["p50_ms"] = stage.p50_ms;
+      stage_item["p90_ms"] = stage.p90_ms;
+      stage_item["p99_ms"] = stage.p99_ms;
+      stage_item["max_ms"] = stage.max_ms;
+      item["stages"][stage.name] = stage_item;
+    }
+    root["results"].push_back(item);
+  }
+  std::ofstream ofs(file_path);
+  if (!ofs.is_open()) {
+    printf("open %s failed\n", file_path.c_str());
     return -1;
   }
+  ofs << root.dump(2) << std::endl;
+  return 0;
+}
 
-  std::string model_id_name = argv[1];
-  std::string model_dir = argv[2];
-  std::string image_path = argv[3];
+int32_t writeCsv(const std::string &file_path,
+                 const std::vector<EvalResult> &results) {
+  std::ofstream ofs(file_path);
+  if (!ofs.is_open()) {
+    printf("open %s failed\n", file_path.c_str());
+    return -1;
+  }
+  ofs << "threads,batch,requests,failed,elapsed_s,requests_per_s,"
+         "images_per_s,stage,count,mean_ms,p50_ms,p90_ms,p99_ms,max_ms\n";
+  for (auto &result : results) {
+    for (auto &stage : result.stages) {
+      ofs << result.threads << "," << result.batch << "," << result.requests
+          << "," << result.failed << "," << result.elapsed_s << ","
+          << result.requests_per_s << "," << result.images_per_s << ","
+          << stage.name << "," << stage.count << "," << stage.mean_ms << ","
+          << stage.p50_ms << "," << stage.p90_ms << "," << stage.p99_ms << ","
+          << stage.max_ms << "\n";
+    }
+  }
+  return 0;
+}
 
-  int loop_num = atoi(argv[4]);
-  if (loop_num <= 100) {
-    std::cerr << "Invalid loop_num: " << argv[4]
-              << ". loop_num must be greater than 100." << std::endl;
+void printUsage(const char *prog) {
+  printf("Usage: %s -m <model_id_name> [options]\n", prog);
+  printf("  %s <model_id_name> <model_dir> <image_path> <loop_num>\n\n", prog);
+  printf("Options:\n");
+  printf("  -m, --model         model id name, or %s for the host stand-in\n",
+         kStandInModelId.c_str());
+  printf("  -d, --model_dir     model dir, used with the model config\n");
+  printf("  -p, --model_path    model file, overrides --model_dir\n");
+  printf("  -i, --image         input image, random 1920x1080 if not set\n");
+  printf("  -w, --warmup        warmup requests per thread (10)\n");
+  printf("  -n, --count         total measured requests per config\n");
+  printf("  -s, --duration      seconds per config when no count (10)\n");
+  printf("  -t, --threads       thread/handle counts to sweep, e.g. 1,2,4\n");
+  printf("  -b, --batch         images per request to sweep, e.g. 1,4,8\n");
+  printf("  -f, --forward_us    forward time of the host stand-in (5000)\n");
+  printf("  -j, --json          write the results as json\n");
+  printf("  -c, --csv           write the results as csv\n");
+  printf("  -h, --help          show this help message\n");
+  printf("model_id_name:\n");
+  for (auto &item : kAllModelTypes) {
+    printf("%s\n", modelTypeToString(item).c_str());
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  EvalOptions options;
+  if (argc == 5 && argv[1][0] != '-') {
+    // legacy usage: <model_id_name> <model_dir> <image_path> <loop_num>
+    options.model_id_name = argv[1];
+    options.model_dir = argv[2];
+    options.image_path = argv[3];
+    options.count = atoi(argv[4]);
+  } else {
+    struct option long_options[] = {{"model", required_argument, 0, 'm'},
+                                    {"model_dir", required_argument, 0, 'd'},
+                                    {"model_path", required_argument, 0, 'p'},
+                                    {"image", required_argument, 0, 'i'},
+                                    {"warmup", required_argument, 0, 'w'},
+                                    {"count", required_argument, 0, 'n'},
+                                    {"duration", required_argument, 0, 's'},
+                                    {"threads", required_argument, 0, 't'},
+                                    {"batch", required_argument, 0, 'b'},
+                                    {"forward_us", required_argument, 0, 'f'},
+                                    {"json", required_argument, 0, 'j'},
+                                    {"csv", required_argument, 0, 'c'},
+                                    {"help", no_argument, 0, 'h'},
+                                    {NULL, 0, NULL, 0}};
+    int opt;
+    while ((opt = getopt_long(argc, argv, "m:d:p:i:w:n:s:t:b:f:j:c:h",
+                              long_options, NULL)) != -1) {
+      switch (opt) {
+        case 'm':
+          options.model_id_name = optarg;
+          break;
+        case 'd':
+          options.model_dir = optarg;
+          break;
+        case 'p':
+          options.model_path = optarg;
+          break;
+        case 'i':
+          options.image_path = optarg;
+          break;
+        case 'w':
+          options.warmup = atoi(optarg);
+          break;
+        case 'n':
+          options.count = atoi(optarg);
+          break;
+        case 's':
+          options.duration_s = atof(optarg);
+          break;
+        case 't':
+          options.threads = parseIntList(optarg);
+          break;
+        case 'b':
+          options.batches = parseIntList(optarg);
+          break;
+        case 'f':
+          options.stand_in_forward_us = atoi(optarg);
+          break;
+        case 'j':
+          options.json_path = optarg;
+          break;
+        case 'c':
+          options.csv_path = optarg;
+          break;
+        case 'h':
+          printUsage(argv[0]);
+          return 0;
+        default:
+          printUsage(argv[0]);
+          return -1;
+      }
+    }
+  }
+  if (options.model_id_name.empty() || options.threads.empty() ||
+      options.batches.empty() || options.warmup < 0 || options.count < 0 ||
+      (options.count == 0 && options.duration_s <= 0)) {
+    printUsage(argv[0]);
     return -1;
   }
 
-  std::shared_ptr<BaseImage> image = ImageFactory::readImage(image_path);
+  std::shared_ptr<BaseImage> image;
+  if (!options.image_path.empty()) {
+    image = ImageFactory::readImage(options.image_path);
+  } else {
+    image = ImageFactory::createImage(1920, 1080, ImageFormat::BGR_PACKED,
+                                      TDLDataType::UINT8, true);
+    if (image) {
+      image->randomFill();
+    }
+  }
   if (!image) {
     printf("Failed to create image\n");
     return -1;
   }
 
-  TDLModelFactory &model_factory = TDLModelFactory::getInstance();
-  model_factory.loadModelConfig();
-  model_factory.setModelDir(model_dir);
-  std::shared_ptr<BaseModel> model = model_factory.getModel(model_id_name);
-  if (!model) {
-    printf("Failed to create model\n");
-    return -1;
+  if (options.model_id_name != kStandInModelId) {
+    TDLModelFactory &model_factory = TDLModelFactory::getInstance();
+    model_factory.loadModelConfig();
+    if (!options.model_dir.empty()) {
+      model_factory.setModelDir(options.model_dir);
+    }
   }
 
-  std::vector<std::shared_ptr<ModelOutputInfo>> out_datas;
-  std::vector<std::shared_ptr<BaseImage>> input_images = {image};
+  // stage latency comes from the model spans
+  Tracer::setEnabled(true);
 
-  for (int i = 0; i < loop_num; i++) {
-    out_datas.clear();
-    model->inference(input_images, out_datas);
+  int max_threads = *std::max_element(options.threads.begin(),
+                                      options.threads.end());
+  std::vector<std::shared_ptr<BaseModel>> models;
+  for (int t = 0; t < max_threads; t++) {
+    std::shared_ptr<BaseModel> model = createModel(options);
+    if (!model) {
+      printf("Failed to create model\n");
+      return -1;
+    }
+    models.push_back(model);
+  }
+
+  std::vector<EvalResult> results;
+  for (int num_threads : options.threads) {
+    for (int batch : options.batches) {
+      EvalResult result =
+          runConfig(options, models, image, num_threads, batch);
+      printResult(result);
+      results.push_back(result);
+    }
   }
 
+  if (!options.json_path.empty() &&
+      writeJson(options.json_path, options, results) != 0) {
+    return -1;
+  }
+  if (!options.csv_path.empty() && writeCsv(options.csv_path, results) != 0) {
+    return -1;
+  }
   return 0;
 }
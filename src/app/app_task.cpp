@@ -3,6 +3,12 @@
 #include <iostream>
 #include "framework/utils/tdl_log.hpp"
 #include "nn/tdl_model_factory.hpp"
+
+namespace {
+// node data slots of the frame info, interned once at load time
+const int kImageSlot = PipelineFrameInfo::getSlotIndex("image");
+}  // namespace
+
 AppTask::AppTask(const std::string &task_name,
                  const std::string &json_config_file, bool skip_input_alloc) {
   task_name_ = task_name;
@@ -55,8 +61,8 @@ int32_t AppTask::removeChannel(const std::string &channel_name) {
 int32_t AppTask::setFrame(const std::string &pipeline_name,
                           std::shared_ptr<BaseImage> image, uint64_t frame_id) {
   if (pipeline_channels_.count(pipeline_name) != 0) {
-    PtrFrameInfo frame_info = std::make_unique<PipelineFrameInfo>();
-    frame_info->node_data_["image"] = Packet::make(image);
+    PtrFrameInfo frame_info = pipeline_channels_[pipeline_name]->acquireFrame();
+    frame_info->node_data_.set(kImageSlot, std::move(image));
     frame_info->frame_id_ = frame_id;
     return pipeline_channels_[pipeline_name]->setPipelineFrame(
         std::move(frame_info));
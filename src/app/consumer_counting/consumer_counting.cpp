@@ -1,4 +1,5 @@
 #include "consumer_counting.hpp"
+#include <algorithm>
 #include <cstdio>
 #include <json.hpp>
 #include "app/app_data_types.hpp"
@@ -11,317 +12,408 @@ ConsumerCounting::ConsumerCounting(int A_x, int A_y, int B_x, int B_y, int mode,
   set_counting_line(A_x, A_y, B_x, B_y, mode);
 }
 
-uint32_t ConsumerCounting::set_counting_line(int A_x, int A_y, int B_x, int B_y,
-                                             int mode) {
-  A_x_ = A_x;
-  A_y_ = A_y;
-  B_x_ = B_x;
-  B_y_ = B_y;
-  mode_ = mode;
+uint32_t ConsumerCounting::get_enter_num() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return enter_num_;
+}
 
-  // 对于竖直线，从左到右为进入，对于非竖直线，从上到下为进入
+uint32_t ConsumerCounting::get_miss_num() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return miss_num_;
+}
 
-  assert(mode == 0 || mode == 1 || mode == 2);
-  if (mode == 2) {
-    mode = 0;
-  }
+std::vector<CountingArea> ConsumerCounting::get_counting_areas() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return areas_;
+}
 
-  int dx = B_x_ - A_x_;
-  int dy = B_y_ - A_y_;
+void ConsumerCounting::init_area(CountingArea &area) {
+  if (area.is_region) {
+    return;
+  }
+  // 对于竖直线，从左到右为进入，对于非竖直线，从上到下为进入
+  int mode = area.mode == 2 ? 0 : area.mode;
+  float dx = area.xs[1] - area.xs[0];
+  float dy = area.ys[1] - area.ys[0];
 
   if (dx == 0) {
-    if (mode == 0) {
-      normal_vector_x_ = 1.0;
-      normal_vector_y_ = 0;
-    } else {
-      normal_vector_x_ = -1.0;
-      normal_vector_y_ = 0;
-    }
+    area.normal_x = mode == 0 ? 1.0 : -1.0;
+    area.normal_y = 0;
+  } else if ((dx > 0 && mode == 0) || (dx < 0 && mode == 1)) {
+    area.normal_x = -dy;
+    area.normal_y = dx;
   } else {
-    if ((dx > 0 && mode == 0) || (dx < 0 && mode == 1)) {
-      normal_vector_x_ = (float)-dy;
-      normal_vector_y_ = (float)dx;
-    } else {
-      normal_vector_x_ = (float)dy;
-      normal_vector_y_ = (float)-dx;
-    }
+    area.normal_x = dy;
+    area.normal_y = -dx;
   }
+  LOGI("normal_vector: x: %f. y: %f\n", area.normal_x, area.normal_y);
+}
 
-  LOGI("normal_vector: x: %f. y: %f\n", normal_vector_x_, normal_vector_y_);
-
+uint32_t ConsumerCounting::set_counting_line(int A_x, int A_y, int B_x, int B_y,
+                                             int mode) {
+  assert(mode == 0 || mode == 1 || mode == 2);
+  std::lock_guard<std::mutex> lock(mutex_);
+  CountingArea line;
+  line.xs = {(float)A_x, (float)B_x};
+  line.ys = {(float)A_y, (float)B_y};
+  line.mode = mode;
+  init_area(line);
+
+  // the first line is replaced, its counts are kept
+  if (!areas_.empty() && !areas_[0].is_region) {
+    line.enter_num = areas_[0].enter_num;
+    line.miss_num = areas_[0].miss_num;
+    areas_[0] = line;
+  } else {
+    areas_.insert(areas_.begin(), line);
+  }
+  reset_area_states();
   return 0;
 }
 
 uint32_t ConsumerCounting::get_counting_line(std::vector<int> &counting_line) {
-  counting_line.push_back(A_x_);
-  counting_line.push_back(A_y_);
-  counting_line.push_back(B_x_);
-  counting_line.push_back(B_y_);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const CountingArea &area : areas_) {
+    if (!area.is_region) {
+      counting_line.push_back(area.xs[0]);
+      counting_line.push_back(area.ys[0]);
+      counting_line.push_back(area.xs[1]);
+      counting_line.push_back(area.ys[1]);
+      break;
+    }
+  }
   return 0;
 }
 
-float ConsumerCounting::crossProduct(float A_x, float A_y, float B_x, float B_y,
-                                     float C_x, float C_y) {
-  return (B_x - A_x) * (C_y - A_y) - (B_y - A_y) * (C_x - A_x);
+int32_t ConsumerCounting::add_counting_line(int A_x, int A_y, int B_x, int B_y,
+                                            int mode) {
+  if (mode < 0 || mode > 2) {
+    LOGE("invalid counting line mode: %d\n", mode);
+    return -1;
+  }
+  CountingArea line;
+  line.xs = {(float)A_x, (float)B_x};
+  line.ys = {(float)A_y, (float)B_y};
+  line.mode = mode;
+  init_area(line);
+  std::lock_guard<std::mutex> lock(mutex_);
+  areas_.push_back(line);
+  reset_area_states();
+  return areas_.size() - 1;
 }
 
-bool ConsumerCounting::isLineIntersect(float old_x, float old_y, float cur_x,
-                                       float cur_y) {
-  double cp1 = crossProduct(A_x_, A_y_, B_x_, B_y_, old_x, old_y);
-  double cp2 = crossProduct(A_x_, A_y_, B_x_, B_y_, cur_x, cur_y);
+int32_t ConsumerCounting::add_counting_region(
+    const std::vector<std::pair<int, int>> &points, int mode) {
+  if (mode < 0 || mode > 2 || points.size() < 3) {
+    LOGE("invalid counting region, mode: %d, points: %zu\n", mode,
+         points.size());
+    return -1;
+  }
+  CountingArea region;
+  region.is_region = true;
+  region.mode = mode;
+  for (const auto &point : points) {
+    region.xs.push_back(point.first);
+    region.ys.push_back(point.second);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  areas_.push_back(region);
+  reset_area_states();
+  return areas_.size() - 1;
+}
 
-  double cp3 = crossProduct(old_x, old_y, cur_x, cur_y, A_x_, A_y_);
-  double cp4 = crossProduct(old_x, old_y, cur_x, cur_y, B_x_, B_y_);
-  // positive and negative symbols
-  if ((cp1 * cp2 <= 0) && (cp3 * cp4 <= 0)) return true;
-  return false;
+void ConsumerCounting::clear_counting_areas() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  areas_.clear();
+  reset_area_states();
 }
 
-int32_t ConsumerCounting::consumer_counting(float old_x, float old_y,
-                                            float cur_x, float cur_y,
-                                            Consumer &it) {
-  if (isLineIntersect(old_x, old_y, cur_x, cur_y)) {
-    float tmp_x = cur_x - old_x;
-    float tmp_y = cur_y - old_y;
-    if ((tmp_x * normal_vector_x_ + tmp_y * normal_vector_y_ < 0) &&
-        it.counting_gap == counting_gap_ && !it.miss) {
-      miss_num_++;
-      it.miss = true;
-    } else if ((tmp_x * normal_vector_x_ + tmp_y * normal_vector_y_ > 0) &&
-               it.counting_gap == counting_gap_ && !it.enter) {
-      enter_num_++;
-      it.enter = true;
-    }
+int ConsumerCounting::add_track(uint64_t track_id, float x, float y) {
+  int slot = track_ids_.size();
+  track_ids_.push_back(track_id);
+  slot_index_[track_id] = slot;
+  old_x_.push_back(x);
+  old_y_.push_back(y);
+  new_x_.push_back(x);
+  new_y_.push_back(y);
+  unmatched_times_.push_back(0);
+  gaps_.push_back(0);
+  matched_.push_back(-1);
+
+  size_t num_areas = areas_.size();
+  entered_.resize(track_ids_.size() * num_areas, 0);
+  missed_.resize(track_ids_.size() * num_areas, 0);
+  inside_.resize(track_ids_.size() * num_areas, 0);
+  for (size_t a = 0; a < num_areas; a++) {
+    inside_[slot * num_areas + a] = point_in_region(areas_[a], x, y);
   }
-
-  it.counting_gap = 0;
-
-  return 0;
+  return slot;
 }
 
-bool ConsumerCounting::object_cross(float old_x, float old_y, float cur_x,
-                                    float cur_y, Consumer &it) {
-  bool is_cross = false;
-  if (isLineIntersect(old_x, old_y, cur_x, cur_y)) {
-    float tmp_x = cur_x - old_x;
-    float tmp_y = cur_y - old_y;
-
-    if ((tmp_x * normal_vector_x_ + tmp_y * normal_vector_y_ > 0) &&
-        !it.is_cross) {
-      is_cross = true;
-    } else if (mode_ == 2 &&
-               (tmp_x * normal_vector_x_ + tmp_y * normal_vector_y_ < 0) &&
-               !it.is_cross) {
-      is_cross = true;
+void ConsumerCounting::remove_track(int slot) {
+  int last = track_ids_.size() - 1;
+  size_t num_areas = areas_.size();
+  slot_index_.erase(track_ids_[slot]);
+  if (slot != last) {
+    track_ids_[slot] = track_ids_[last];
+    slot_index_[track_ids_[slot]] = slot;
+    old_x_[slot] = old_x_[last];
+    old_y_[slot] = old_y_[last];
+    new_x_[slot] = new_x_[last];
+    new_y_[slot] = new_y_[last];
+    unmatched_times_[slot] = unmatched_times_[last];
+    gaps_[slot] = gaps_[last];
+    matched_[slot] = matched_[last];
+    for (std::vector<uint8_t> *flags : {&entered_, &missed_, &inside_}) {
+      std::copy_n(flags->begin() + last * num_areas, num_areas,
+                  flags->begin() + slot * num_areas);
     }
   }
-  it.counting_gap = 0;
-
-  return is_cross;
+  track_ids_.pop_back();
+  old_x_.pop_back();
+  old_y_.pop_back();
+  new_x_.pop_back();
+  new_y_.pop_back();
+  unmatched_times_.pop_back();
+  gaps_.pop_back();
+  matched_.pop_back();
+  entered_.resize(track_ids_.size() * num_areas);
+  missed_.resize(track_ids_.size() * num_areas);
+  inside_.resize(track_ids_.size() * num_areas);
 }
 
-int32_t ConsumerCounting::update_consumer_counting_state(
-    const std::vector<TrackerInfo> &track_results, bool force_all) {
-  if (force_all) {  // for evaluation
-    printf("force_all!");
-    for (auto it = heads_.begin(); it != heads_.end();) {
-      consumer_counting(it->second.old_x, it->second.old_y, it->second.new_x,
-                        it->second.new_y, it->second);
-      LOGI(
-          "to count heads, track id: %ld, old_x: %.2f, old_y: %.2f, cur_x: "
-          "%.2f, cur_y: %.2f, enter: %d, miss: %d\n",
-          it->first, it->second.old_x, it->second.old_y, it->second.new_x,
-          it->second.new_y, it->second.enter, it->second.miss);
-      it++;
+void ConsumerCounting::reset_area_states() {
+  size_t size = track_ids_.size() * areas_.size();
+  entered_.assign(size, 0);
+  missed_.assign(size, 0);
+  inside_.assign(size, 0);
+  for (size_t slot = 0; slot < track_ids_.size(); slot++) {
+    for (size_t a = 0; a < areas_.size(); a++) {
+      inside_[slot * areas_.size() + a] =
+          point_in_region(areas_[a], old_x_[slot], old_y_[slot]);
     }
-    return 0;
   }
+}
 
-  std::map<uint64_t, int> head_index;
-  std::map<uint64_t, int> person_index;
-  std::vector<uint64_t> head_found_id;
-  std::vector<uint64_t> person_found_id;
-
-  for (size_t i = 0; i < track_results.size(); i++) {
-    const TrackerInfo &t = track_results[i];
+bool ConsumerCounting::point_in_region(const CountingArea &area, float x,
+                                       float y) {
+  if (!area.is_region) {
+    return false;
+  }
+  bool inside = false;
+  size_t num_points = area.xs.size();
+  for (size_t e = 0, p = num_points - 1; e < num_points; p = e++) {
+    const float ex = area.xs[e], ey = area.ys[e];
+    const float px = area.xs[p], py = area.ys[p];
+    const float slope = ey != py ? (px - ex) / (py - ey) : 0.0f;
+    if (((ey > y) != (py > y)) && x < (y - ey) * slope + ex) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
 
-    uint64_t track_id = t.track_id_;
+void ConsumerCounting::cross_all_areas() {
+  const size_t num = tests_.size();
+  directions_.assign(num * areas_.size(), 0);
+  point_inside_.resize(num);
+  const float *x0 = test_x0_.data();
+  const float *y0 = test_y0_.data();
+  const float *x1 = test_x1_.data();
+  const float *y1 = test_y1_.data();
+
+  for (size_t a = 0; a < areas_.size(); a++) {
+    const CountingArea &area = areas_[a];
+    int8_t *dirs = &directions_[a * num];
+    if (!area.is_region) {
+      const float ax = area.xs[0], ay = area.ys[0];
+      const float bx = area.xs[1], by = area.ys[1];
+      const float nx = area.normal_x, ny = area.normal_y;
+      // segment intersection of the moves with the line, branch free
+      for (size_t i = 0; i < num; i++) {
+        float mx = x1[i] - x0[i];
+        float my = y1[i] - y0[i];
+        float cp1 = (bx - ax) * (y0[i] - ay) - (by - ay) * (x0[i] - ax);
+        float cp2 = (bx - ax) * (y1[i] - ay) - (by - ay) * (x1[i] - ax);
+        float cp3 = mx * (ay - y0[i]) - my * (ax - x0[i]);
+        float cp4 = mx * (by - y0[i]) - my * (bx - x0[i]);
+        bool hit = (cp1 * cp2 <= 0) & (cp3 * cp4 <= 0);
+        float dot = mx * nx + my * ny;
+        dirs[i] = hit ? (int8_t)((dot > 0) - (dot < 0)) : 0;
+      }
+      continue;
+    }
 
-    if (t.box_info_.object_type == TDLObjectType::OBJECT_TYPE_HEAD) {
-      head_index[track_id] = i;
-    } else {
-      if (t.box_info_.object_type != TDLObjectType::OBJECT_TYPE_PERSON) {
-        LOGE("unexpected object_type: %d\n", t.box_info_.object_type);
-        assert(false);
-        return -1;
+    // crossing number of the new positions, one pass per polygon edge
+    uint8_t *inside = point_inside_.data();
+    std::fill(inside, inside + num, 0);
+    size_t num_points = area.xs.size();
+    for (size_t e = 0, p = num_points - 1; e < num_points; p = e++) {
+      const float ex = area.xs[e], ey = area.ys[e];
+      const float px = area.xs[p], py = area.ys[p];
+      const float slope = ey != py ? (px - ex) / (py - ey) : 0.0f;
+      for (size_t i = 0; i < num; i++) {
+        bool straddle = (ey > y1[i]) != (py > y1[i]);
+        bool left = x1[i] < (y1[i] - ey) * slope + ex;
+        inside[i] ^= straddle & left;
       }
-      person_index[track_id] = i;
+    }
+    int sign = area.mode == 1 ? -1 : 1;
+    for (size_t i = 0; i < num; i++) {
+      uint8_t &was_inside = inside_[tests_[i] * areas_.size() + a];
+      dirs[i] = (int8_t)(sign * (int(inside[i]) - int(was_inside)));
+      was_inside = inside[i];
     }
   }
+}
 
-  LOGI("head index size: %d, person index size: %d\n", head_index.size(),
-       person_index.size());
-
-  LOGI("heads_ size: %d\n", heads_.size());
-  for (auto it = heads_.begin(); it != heads_.end();) {
-    if (head_index.count(it->first) == 0) {
-      LOGI("track id: %ld, it->second.unmatched_times: %d\n", it->first,
-           it->second.unmatched_times);
-      it->second.unmatched_times += 1;
-      it->second.counting_gap =
-          std::min(counting_gap_, it->second.counting_gap + 1);
-
-      if (it->second.unmatched_times == MAX_UNMATCHED_TIME) {
-        consumer_counting(it->second.old_x, it->second.old_y, it->second.new_x,
-                          it->second.new_y, it->second);
-        LOGI(
-            "to count heads before erasing, track id: %ld, old_x: %.2f, old_y: "
-            "%.2f, cur_x: "
-            "%.2f, cur_y: %.2f, enter: %d, miss: %d\n",
-            it->first, it->second.old_x, it->second.old_y, it->second.new_x,
-            it->second.new_y, it->second.enter, it->second.miss);
-
-        LOGI("erase head track id: %ld\n", it->first);
+int32_t ConsumerCounting::update_state(
+    const std::vector<TrackerInfo> &track_results, bool cross_detection,
+    bool force_all, std::vector<uint64_t> *cross_id) {
+  const size_t num_areas = areas_.size();
+  tests_.clear();
+  test_x0_.clear();
+  test_y0_.clear();
+  test_x1_.clear();
+  test_y1_.clear();
+  auto add_test = [this](int slot, float x, float y) {
+    tests_.push_back(slot);
+    test_x0_.push_back(old_x_[slot]);
+    test_y0_.push_back(old_y_[slot]);
+    test_x1_.push_back(x);
+    test_y1_.push_back(y);
+  };
 
-        it = heads_.erase(it);
+  if (force_all) {  // for evaluation
+    for (size_t slot = 0; slot < track_ids_.size(); slot++) {
+      if (gaps_[slot] == counting_gap_) {
+        add_test(slot, new_x_[slot], new_y_[slot]);
+      }
+      gaps_[slot] = 0;
+    }
+  } else {
+    std::fill(matched_.begin(), matched_.end(), -1);
+    new_results_.clear();
+    for (size_t i = 0; i < track_results.size(); i++) {
+      const TrackerInfo &t = track_results[i];
+      if (!cross_detection &&
+          t.box_info_.object_type != TDLObjectType::OBJECT_TYPE_HEAD) {
+        if (t.box_info_.object_type != TDLObjectType::OBJECT_TYPE_PERSON) {
+          LOGE("unexpected object_type: %d\n", t.box_info_.object_type);
+          assert(false);
+          return -1;
+        }
+        continue;
+      }
+      auto it = slot_index_.find(t.track_id_);
+      if (it != slot_index_.end()) {
+        matched_[it->second] = i;
       } else {
-        it++;
+        new_results_.push_back(i);
       }
+    }
 
-    } else {
-      const TrackerInfo &track_info = track_results[head_index[it->first]];
-      uint64_t pair_id = track_info.pair_track_idx_;
-
-      ObjectBoxInfo box_info = track_info.box_info_;
-      float cur_x = (box_info.x1 + box_info.x2) / 2.0;
-      float cur_y = (box_info.y1 + box_info.y2) / 2.0;
-      it->second.new_x = cur_x;
-      it->second.new_y = cur_y;
-
-      if (it->second.enter && it->second.miss) {
-        LOGI("track id %ld has been counted\n", it->first);
-      } else if (it->second.counting_gap == counting_gap_) {
-        consumer_counting(it->second.old_x, it->second.old_y, cur_x, cur_y,
-                          it->second);
-        LOGI(
-            "to count heads, track id: %ld, old_x: %.2f, old_y: %.2f, cur_x: "
-            "%.2f, cur_y: %.2f, enter: %d, miss: %d\n",
-            it->first, it->second.old_x, it->second.old_y, cur_x, cur_y,
-            it->second.enter, it->second.miss);
-        it->second.old_x = cur_x;
-        it->second.old_y = cur_y;
+    for (size_t slot = 0; slot < track_ids_.size(); slot++) {
+      if (matched_[slot] < 0) {
+        unmatched_times_[slot] += 1;
+        gaps_[slot] = std::min(counting_gap_, gaps_[slot] + 1);
+        // a head is counted a last time before it is erased
+        if (!cross_detection && unmatched_times_[slot] == MAX_UNMATCHED_TIME &&
+            gaps_[slot] == counting_gap_) {
+          add_test(slot, new_x_[slot], new_y_[slot]);
+        }
+        continue;
+      }
+      const TrackerInfo &t = track_results[matched_[slot]];
+      float cur_x = (t.box_info_.x1 + t.box_info_.x2) / 2.0;
+      float cur_y = (t.box_info_.y1 + t.box_info_.y2) / 2.0;
+      unmatched_times_[slot] = 0;
+      if (cross_detection) {
+        if (gaps_[slot] == counting_gap_ && t.obj_idx_ != -1) {
+          add_test(slot, cur_x, cur_y);
+        }
+        continue;
+      }
+      new_x_[slot] = cur_x;
+      new_y_[slot] = cur_y;
+      bool counted = true;  // entered and missed every area
+      for (size_t a = 0; a < num_areas; a++) {
+        size_t index = slot * num_areas + a;
+        counted = counted && entered_[index] && missed_[index];
+      }
+      if (gaps_[slot] == counting_gap_ && !counted) {
+        add_test(slot, cur_x, cur_y);
       }
-
-      it->second.unmatched_times = 0;
-      it->second.counting_gap =
-          std::min(counting_gap_, it->second.counting_gap + 1);
-
-      head_found_id.push_back(it->first);
-      it++;
     }
   }
 
-  for (auto it = head_index.begin(); it != head_index.end();) {
-    if (std::find(head_found_id.begin(), head_found_id.end(), it->first) ==
-        head_found_id.end()) {
-      const TrackerInfo &t = track_results[it->second];
-      ObjectBoxInfo box_info = t.box_info_;
-
-      uint64_t track_id = t.track_id_;
-
-      Consumer new_consumer = {0};
-      new_consumer.old_x = (box_info.x1 + box_info.x2) / 2.0;
-      new_consumer.old_y = (box_info.y1 + box_info.y2) / 2.0;
+  cross_all_areas();
+  for (size_t i = 0; i < tests_.size(); i++) {
+    int slot = tests_[i];
+    bool is_cross = false;
+    for (size_t a = 0; a < num_areas; a++) {
+      int8_t dir = direction(i, a);
+      if (cross_detection) {
+        is_cross = is_cross || dir > 0 || (dir < 0 && areas_[a].mode == 2);
+        continue;
+      }
+      size_t index = slot * num_areas + a;
+      if (dir < 0 && !missed_[index]) {
+        areas_[a].miss_num++;
+        miss_num_++;
+        missed_[index] = 1;
+      } else if (dir > 0 && !entered_[index]) {
+        areas_[a].enter_num++;
+        enter_num_++;
+        entered_[index] = 1;
+      }
+    }
+    if (is_cross) {
+      cross_id->push_back(track_ids_[slot]);
+    }
+    if (!force_all) {
+      old_x_[slot] = test_x1_[i];
+      old_y_[slot] = test_y1_[i];
+    }
+    gaps_[slot] = 0;
+  }
+  if (force_all) {
+    return 0;
+  }
 
-      LOGI("new head track id: %ld, old_x: %.2f, old_y: %.2f\n", track_id,
-           new_consumer.old_x, new_consumer.old_y);
-      heads_[track_id] = new_consumer;
+  for (int slot = int(track_ids_.size()) - 1; slot >= 0; slot--) {
+    if (unmatched_times_[slot] == MAX_UNMATCHED_TIME) {
+      LOGI("erase track id: %ld\n", track_ids_[slot]);
+      remove_track(slot);
+    } else if (matched_[slot] >= 0) {
+      gaps_[slot] = std::min(counting_gap_, gaps_[slot] + 1);
     }
-    it++;
   }
 
+  // new tracks start from their first position
+  for (int i : new_results_) {
+    const TrackerInfo &t = track_results[i];
+    if (slot_index_.count(t.track_id_) != 0) {
+      continue;
+    }
+    float x = (t.box_info_.x1 + t.box_info_.x2) / 2.0;
+    float y = (t.box_info_.y1 + t.box_info_.y2) / 2.0;
+    LOGI("new track id: %ld, old_x: %.2f, old_y: %.2f\n", t.track_id_, x, y);
+    add_track(t.track_id_, x, y);
+  }
   return 0;
 }
 
+int32_t ConsumerCounting::update_consumer_counting_state(
+    const std::vector<TrackerInfo> &track_results, bool force_all) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return update_state(track_results, false, force_all, nullptr);
+}
+
 int32_t ConsumerCounting::update_cross_detection_state(
     const std::vector<TrackerInfo> &track_results,
     std::vector<uint64_t> &cross_id) {
   cross_id.clear();
-  std::map<uint64_t, int> object_index;
-  std::vector<uint64_t> found_id;
-
-  for (size_t i = 0; i < track_results.size(); i++) {
-    const TrackerInfo &t = track_results[i];
-
-    uint64_t track_id = t.track_id_;
-    object_index[track_id] = i;
-  }
-
-  for (auto it = objects_.begin(); it != objects_.end();) {
-    if (object_index.count(it->first) == 0) {
-      LOGI("track id: %ld, it->second.unmatched_times: %d\n", it->first,
-           it->second.unmatched_times);
-      it->second.unmatched_times += 1;
-      it->second.counting_gap =
-          std::min(counting_gap_, it->second.counting_gap + 1);
-
-      if (it->second.unmatched_times == MAX_UNMATCHED_TIME) {
-        LOGI("erase head track id: %ld\n", it->first);
-        it = objects_.erase(it);
-      }
-
-    } else {
-      const TrackerInfo &track_info = track_results[object_index[it->first]];
-      uint64_t pair_id = track_info.pair_track_idx_;
-
-      if (it->second.counting_gap == counting_gap_ &&
-          track_info.obj_idx_ != -1) {
-        ObjectBoxInfo box_info = track_info.box_info_;
-        float cur_x = (box_info.x1 + box_info.x2) / 2.0;
-        float cur_y = (box_info.y1 + box_info.y2) / 2.0;
-
-        bool is_cross = object_cross(it->second.old_x, it->second.old_y, cur_x,
-                                     cur_y, it->second);
-
-        LOGI(
-            "to detect, track id: %ld, old_x: %.2f, old_y: %.2f, cur_x: "
-            "%.2f, cur_y: %.2f, is_cross: %d\n",
-            it->first, it->second.old_x, it->second.old_y, cur_x, cur_y,
-            is_cross);
-        it->second.old_x = cur_x;
-        it->second.old_y = cur_y;
-        if (is_cross) {
-          cross_id.push_back(it->first);
-        }
-      }
-
-      it->second.unmatched_times = 0;
-      it->second.counting_gap =
-          std::min(counting_gap_, it->second.counting_gap + 1);
-
-      found_id.push_back(it->first);
-      it++;
-    }
-  }
-
-  for (auto it = object_index.begin(); it != object_index.end();) {
-    if (std::find(found_id.begin(), found_id.end(), it->first) ==
-        found_id.end()) {
-      const TrackerInfo &t = track_results[it->second];
-      ObjectBoxInfo box_info = t.box_info_;
-
-      uint64_t track_id = t.track_id_;
-
-      Consumer new_consumer = {0};
-      new_consumer.old_x = (box_info.x1 + box_info.x2) / 2.0;
-      new_consumer.old_y = (box_info.y1 + box_info.y2) / 2.0;
-
-      LOGI("new track id: %ld, old_x: %.2f, old_y: %.2f\n", track_id,
-           new_consumer.old_x, new_consumer.old_y);
-      objects_[track_id] = new_consumer;
-    }
-    it++;
-  }
-
-  return 0;
-}
\ No newline at end of file
+  std::lock_guard<std::mutex> lock(mutex_);
+  return update_state(track_results, true, false, &cross_id);
+}
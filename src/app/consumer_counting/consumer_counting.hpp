@@ -1,22 +1,30 @@
 #ifndef CONSUMER_COUNTING_HPP
 #define CONSUMER_COUNTING_HPP
 
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "components/tracker/tracker_types.hpp"
 #include "nn/tdl_model_factory.hpp"
 
-typedef struct {
-  float old_x;
-  float old_y;
-  float new_x;
-  float new_y;
-  int unmatched_times;
-  int counting_gap;
-  bool enter;
-  bool miss;
-  bool is_cross;
-
-} Consumer;
+// 计数区域: 计数线 (两个端点) 或多边形区域 (至少三个顶点).
+// 计数线 mode 为 0 时, 对于竖直线从左到右为进入, 对于非竖直线从上到下为
+// 进入, mode 为 1 相反; 多边形 mode 为 0 时从外到内为进入, mode 为 1 相反.
+// mode 为 2 时按 mode 0 计数, 越线检测时两个方向都算越线.
+struct CountingArea {
+  std::vector<float> xs;
+  std::vector<float> ys;
+  int mode = 0;
+  bool is_region = false;
+  // 计数线的进入方向
+  float normal_x = 0;
+  float normal_y = 0;
+  uint32_t enter_num = 0;
+  uint32_t miss_num = 0;
+};
 
+// 计数区域可以在调用方线程中修改, 与 pipeline 线程中的状态更新互斥
 class ConsumerCounting {
  public:
   ConsumerCounting(int A_x, int A_y, int B_x, int B_y, int mode,
@@ -29,37 +37,68 @@ class ConsumerCounting {
   int32_t update_cross_detection_state(
       const std::vector<TrackerInfo> &track_results,
       std::vector<uint64_t> &cross_id);
-  uint32_t get_enter_num() { return enter_num_; };
-  uint32_t get_miss_num() { return miss_num_; };
+  // 所有计数区域的总数
+  uint32_t get_enter_num();
+  uint32_t get_miss_num();
 
+  // 第一条计数线
   uint32_t get_counting_line(std::vector<int> &counting_line);
-
   uint32_t set_counting_line(int A_x, int A_y, int B_x, int B_y, int mode);
 
-  int32_t consumer_counting(float old_x, float old_y, float cur_x, float cur_y,
-                            Consumer &it);
-  bool object_cross(float old_x, float old_y, float cur_x, float cur_y,
-                    Consumer &it);
-  bool isLineIntersect(float old_x, float old_y, float cur_x, float cur_y);
-  float crossProduct(float A_x, float A_y, float B_x, float B_y, float C_x,
-                     float C_y);
+  // 追加计数线/多边形区域, 返回区域序号, 失败返回 -1
+  int32_t add_counting_line(int A_x, int A_y, int B_x, int B_y, int mode);
+  int32_t add_counting_region(const std::vector<std::pair<int, int>> &points,
+                              int mode);
+  void clear_counting_areas();
+  std::vector<CountingArea> get_counting_areas();
 
  private:
-  int mode_;
-  int A_x_, A_y_, B_x_, B_y_;
+  // 以下私有函数均在持有 mutex_ 时调用
+  int32_t update_state(const std::vector<TrackerInfo> &track_results,
+                       bool cross_detection, bool force_all,
+                       std::vector<uint64_t> *cross_id);
+  void init_area(CountingArea &area);
+  int add_track(uint64_t track_id, float x, float y);
+  void remove_track(int slot);
+  // 区域变化后重置每个 track 的区域状态
+  void reset_area_states();
+  static bool point_in_region(const CountingArea &area, float x, float y);
+  // tests_ 的 (old, new) 位移与所有区域的相交方向, 写入 directions_:
+  // 1 进入方向, -1 反方向, 0 未越过; 同时更新多边形内外状态
+  void cross_all_areas();
+  // directions_ 中第 i 个位移对区域 a 的结果
+  int8_t &direction(size_t i, size_t a) {
+    return directions_[a * tests_.size() + i];
+  }
+
   int buffer_width_ = 20;
   int counting_gap_ = 50;
   int MAX_UNMATCHED_TIME = 15;
 
+  std::mutex mutex_;
+
   uint32_t enter_num_ = 0;
   uint32_t miss_num_ = 0;
 
-  float normal_vector_x_;
-  float normal_vector_y_;
+  std::vector<CountingArea> areas_;
+
+  // track 状态, 以槽位存放; 槽位 t 对区域 a 的标记位于 t * areas_.size() + a
+  std::vector<uint64_t> track_ids_;
+  std::unordered_map<uint64_t, int> slot_index_;
+  std::vector<float> old_x_, old_y_, new_x_, new_y_;
+  std::vector<int> unmatched_times_;
+  std::vector<int> gaps_;
+  std::vector<int> matched_;  // 本帧匹配的 track_results 序号, -1 未匹配
+  std::vector<uint8_t> entered_;
+  std::vector<uint8_t> missed_;
+  std::vector<uint8_t> inside_;
 
-  std::map<uint64_t, Consumer> persons_;
-  std::map<uint64_t, Consumer> heads_;
-  std::map<uint64_t, Consumer> objects_;
+  // 本帧需要检测的 track 槽位及其位移
+  std::vector<int> tests_;
+  std::vector<float> test_x0_, test_y0_, test_x1_, test_y1_;
+  std::vector<int8_t> directions_;
+  std::vector<int> new_results_;
+  std::vector<uint8_t> point_inside_;
 };
 
 #endif
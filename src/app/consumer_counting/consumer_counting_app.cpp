@@ -8,13 +8,83 @@
 #include "consumer_counting.hpp"
 #include "utils/tdl_log.hpp"
 
+namespace {
+// node data slots of the frame info, interned once at load time
+const int kCountingLineSlot = PipelineFrameInfo::getSlotIndex("counting_line");
+const int kCountingResultSlot =
+    PipelineFrameInfo::getSlotIndex("counting_result");
+const int kCrossIdSlot = PipelineFrameInfo::getSlotIndex("cross_id");
+const int kImageSlot = PipelineFrameInfo::getSlotIndex("image");
+const int kObjectMetaSlot = PipelineFrameInfo::getSlotIndex("object_meta");
+const int kTrackResultsSlot = PipelineFrameInfo::getSlotIndex("track_results");
+}  // namespace
+
 template <typename T>
-T getNodeData(const std::string &node_name, PtrFrameInfo &frame_info) {
-  if (frame_info->node_data_.find(node_name) == frame_info->node_data_.end()) {
-    printf("node %s not found\n", node_name.c_str());
+T getNodeData(int slot, PtrFrameInfo &frame_info) {
+  if (!frame_info->node_data_.contains(slot)) {
+    printf("node data slot %d not found\n", slot);
     assert(false);
   }
-  return frame_info->node_data_[node_name].get<T>();
+  // the frame is done after getResult, move the value out instead of copying
+  return frame_info->node_data_.take<T>(slot);
+}
+
+// 计数器: x1/y1/x2/y2/mode 为第一条计数线, 可选 "lines":
+// [[x1, y1, x2, y2, mode], ...] 与 "regions": [{"points": [[x, y], ...],
+// "mode": 0}, ...] 追加更多计数线和多边形区域
+static std::shared_ptr<ConsumerCounting> createCounter(
+    const nlohmann::json &node_config) {
+  int mode = node_config["mode"];
+  int x1 = node_config["x1"];
+  int y1 = node_config["y1"];
+  int x2 = node_config["x2"];
+  int y2 = node_config["y2"];
+  int counting_gap = node_config["counting_gap"];
+
+  std::shared_ptr<ConsumerCounting> counter =
+      std::make_shared<ConsumerCounting>(x1, y1, x2, y2, mode, counting_gap);
+  if (node_config.contains("lines")) {
+    for (const auto &line : node_config.at("lines")) {
+      int line_mode = line.size() > 4 ? (int)line[4] : 0;
+      counter->add_counting_line(line.at(0), line.at(1), line.at(2),
+                                 line.at(3), line_mode);
+    }
+  }
+  if (node_config.contains("regions")) {
+    for (const auto &region : node_config.at("regions")) {
+      std::vector<std::pair<int, int>> points;
+      for (const auto &point : region.at("points")) {
+        points.emplace_back(point.at(0), point.at(1));
+      }
+      counter->add_counting_region(points, region.value("mode", 0));
+    }
+  }
+  return counter;
+}
+
+// [enter_num, miss_num, 区域 0 enter, 区域 0 miss, ...]
+static std::vector<uint32_t> getCountingResult(
+    const std::shared_ptr<ConsumerCounting> &counter) {
+  std::vector<uint32_t> counting_result;
+  counting_result.push_back(counter->get_enter_num());
+  counting_result.push_back(counter->get_miss_num());
+  for (const CountingArea &area : counter->get_counting_areas()) {
+    counting_result.push_back(area.enter_num);
+    counting_result.push_back(area.miss_num);
+  }
+  return counting_result;
+}
+
+static void setCountingResult(const std::vector<uint32_t> &counting_result,
+                              ConsumerCountingResult &result) {
+  result.enter_num = counting_result[0];
+  result.miss_num = counting_result[1];
+  result.area_enter_nums.clear();
+  result.area_miss_nums.clear();
+  for (size_t i = 2; i + 1 < counting_result.size(); i += 2) {
+    result.area_enter_nums.push_back(counting_result[i]);
+    result.area_miss_nums.push_back(counting_result[i + 1]);
+  }
 }
 
 ConsumerCountingAPP::ConsumerCountingAPP(const std::string &task_name,
@@ -58,6 +128,34 @@ int32_t ConsumerCountingAPP::setLine(const std::string &pipeline_name,
   return 0;
 }
 
+int32_t ConsumerCountingAPP::addLine(const std::string &pipeline_name,
+                                     const std::string &node_name, int x1,
+                                     int y1, int x2, int y2, int mode) {
+  std::shared_ptr<PipelineNode> node =
+      pipeline_channels_[pipeline_name]->getNode(node_name);
+
+  Packet *packet = node->getWorker();
+
+  std::shared_ptr<ConsumerCounting> consumer_counting =
+      packet->get<std::shared_ptr<ConsumerCounting>>();
+
+  return consumer_counting->add_counting_line(x1, y1, x2, y2, mode);
+}
+
+int32_t ConsumerCountingAPP::addRegion(
+    const std::string &pipeline_name, const std::string &node_name,
+    const std::vector<std::pair<int, int>> &points, int mode) {
+  std::shared_ptr<PipelineNode> node =
+      pipeline_channels_[pipeline_name]->getNode(node_name);
+
+  Packet *packet = node->getWorker();
+
+  std::shared_ptr<ConsumerCounting> consumer_counting =
+      packet->get<std::shared_ptr<ConsumerCounting>>();
+
+  return consumer_counting->add_counting_region(points, mode);
+}
+
 int32_t ConsumerCountingAPP::addPipeline(const std::string &pipeline_name,
                                          int32_t frame_buffer_size,
                                          const nlohmann::json &nodes_cfg) {
@@ -97,14 +195,7 @@ int32_t ConsumerCountingAPP::addPipeline(const std::string &pipeline_name,
   auto lambda_clear_func = [](PtrFrameInfo &frame_info) {
     frame_info->frame_id_ = 0;
     // TO
-    auto iter = frame_info->node_data_.begin();
-    while (iter != frame_info->node_data_.end()) {
-      if (iter->first != "image") {
-        iter = frame_info->node_data_.erase(iter);
-      } else {
-        iter++;
-      }
-    }
+    frame_info->node_data_.clear(kImageSlot);
   };
   consumer_counting_channel->setClearFrameFunc(lambda_clear_func);
   LOGI("add pipeline %s", pipeline_name.c_str());
@@ -119,15 +210,13 @@ int32_t ConsumerCountingAPP::getResult(const std::string &pipeline_name,
       pipeline_channels_[pipeline_name]->getProcessedFrame(0);
 
   auto image =
-      frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+      frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
   if (image == nullptr) {
     std::cout << "image is nullptr" << std::endl;
-    if (frame_info->node_data_.find("counting_result") !=
-        frame_info->node_data_.end()) {
-      std::vector<uint32_t> counting_result =
-          getNodeData<std::vector<uint32_t>>("counting_result", frame_info);
-      consumer_counting_result->enter_num = counting_result[0];
-      consumer_counting_result->miss_num = counting_result[1];
+    if (frame_info->node_data_.contains(kCountingResultSlot)) {
+      setCountingResult(
+          getNodeData<std::vector<uint32_t>>(kCountingResultSlot, frame_info),
+          *consumer_counting_result);
     }
     result = Packet::make(consumer_counting_result);
     return -1;
@@ -137,28 +226,25 @@ int32_t ConsumerCountingAPP::getResult(const std::string &pipeline_name,
   consumer_counting_result->frame_width = image->getWidth();
   consumer_counting_result->frame_height = image->getHeight();
   consumer_counting_result->object_boxes =
-      getNodeData<std::vector<ObjectBoxInfo>>("object_meta", frame_info);
+      getNodeData<std::vector<ObjectBoxInfo>>(kObjectMetaSlot, frame_info);
   consumer_counting_result->track_results =
-      getNodeData<std::vector<TrackerInfo>>("track_results", frame_info);
+      getNodeData<std::vector<TrackerInfo>>(kTrackResultsSlot, frame_info);
   consumer_counting_result->counting_line =
-      getNodeData<std::vector<int>>("counting_line", frame_info);
-
-  if (frame_info->node_data_.find("counting_result") !=
-      frame_info->node_data_.end()) {
-    std::vector<uint32_t> counting_result =
-        getNodeData<std::vector<uint32_t>>("counting_result", frame_info);
-    consumer_counting_result->enter_num = counting_result[0];
-    consumer_counting_result->miss_num = counting_result[1];
+      getNodeData<std::vector<int>>(kCountingLineSlot, frame_info);
+
+  if (frame_info->node_data_.contains(kCountingResultSlot)) {
+    setCountingResult(
+        getNodeData<std::vector<uint32_t>>(kCountingResultSlot, frame_info),
+        *consumer_counting_result);
   }
 
-  if (frame_info->node_data_.find("cross_id") != frame_info->node_data_.end()) {
+  if (frame_info->node_data_.contains(kCrossIdSlot)) {
     consumer_counting_result->cross_id =
-        getNodeData<std::vector<uint64_t>>("cross_id", frame_info);
+        getNodeData<std::vector<uint64_t>>(kCrossIdSlot, frame_info);
   }
 
-  if (getChannelNodeName(pipeline_name, 0) == "video_node") {
-    pipeline_channels_[pipeline_name]->addFreeFrame(std::move(frame_info));
-  }
+  // external frames are recycled too, so that setFrame reuses the slots
+  pipeline_channels_[pipeline_name]->addFreeFrame(std::move(frame_info));
   result = Packet::make(consumer_counting_result);
   return 0;
 }
@@ -207,7 +293,7 @@ std::shared_ptr<PipelineNode> ConsumerCountingAPP::getVideoNode(
       std::cout << "video_decoder read failed" << std::endl;
       // assert(false);
     }
-    frame_info->node_data_["image"] = Packet::make(image);
+    frame_info->node_data_.set(kImageSlot, std::move(image));
     frame_info->frame_id_ = video_decoder->getFrameId();
     return 0;
   };
@@ -260,7 +346,7 @@ std::shared_ptr<PipelineNode> ConsumerCountingAPP::getObjectDetectionNode(
     std::shared_ptr<BaseModel> object_detection_model =
         packet.get<std::shared_ptr<BaseModel>>();
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -273,9 +359,9 @@ std::shared_ptr<PipelineNode> ConsumerCountingAPP::getObjectDetectionNode(
     }
     std::shared_ptr<ModelBoxInfo> object_meta =
         std::dynamic_pointer_cast<ModelBoxInfo>(out_data);
-    frame_info->node_data_["object_meta"] = Packet::make(object_meta->bboxes);
     LOGI("frame id:%d, detecte object size: %d\n", frame_info->frame_id_,
          object_meta->bboxes.size());
+    frame_info->node_data_.set(kObjectMetaSlot, std::move(object_meta->bboxes));
     return 0;
   };
   object_detection_node->setProcessFunc(lambda_func);
@@ -301,7 +387,7 @@ std::shared_ptr<PipelineNode> ConsumerCountingAPP::getTrackNode(
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -310,7 +396,7 @@ std::shared_ptr<PipelineNode> ConsumerCountingAPP::getTrackNode(
     tracker->setImgSize(image->getWidth(), image->getHeight());
 
     const std::vector<ObjectBoxInfo> &object_infos =
-        frame_info->node_data_["object_meta"].get<std::vector<ObjectBoxInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectBoxInfo>>(kObjectMetaSlot);
 
     std::vector<ObjectBoxInfo> bbox_infos;
     for (auto &obj_info : object_infos) {
@@ -318,9 +404,9 @@ std::shared_ptr<PipelineNode> ConsumerCountingAPP::getTrackNode(
     }
     std::vector<TrackerInfo> track_results;
     tracker->track(bbox_infos, frame_info->frame_id_, track_results);
-    frame_info->node_data_["track_results"] = Packet::make(track_results);
     LOGI("frame id:%d, track size: %d\n", frame_info->frame_id_,
          track_results.size());
+    frame_info->node_data_.set(kTrackResultsSlot, std::move(track_results));
     return 0;
   };
   track_node->setProcessFunc(lambda_func);
@@ -330,15 +416,8 @@ std::shared_ptr<PipelineNode> ConsumerCountingAPP::getTrackNode(
 
 std::shared_ptr<PipelineNode> ConsumerCountingAPP::ConsumerCountingNode(
     const nlohmann::json &node_config) {
-  int mode = node_config["mode"];
-  int x1 = node_config["x1"];
-  int y1 = node_config["y1"];
-  int x2 = node_config["x2"];
-  int y2 = node_config["y2"];
-  int counting_gap = node_config["counting_gap"];
-
   std::shared_ptr<ConsumerCounting> consumer_counting =
-      std::make_shared<ConsumerCounting>(x1, y1, x2, y2, mode, counting_gap);
+      createCounter(node_config);
 
   std::shared_ptr<PipelineNode> consumer_counting_node =
       std::make_shared<PipelineNode>(Packet::make(consumer_counting));
@@ -346,7 +425,7 @@ std::shared_ptr<PipelineNode> ConsumerCountingAPP::ConsumerCountingNode(
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
 
     std::shared_ptr<ConsumerCounting> consumer_counting =
         packet.get<std::shared_ptr<ConsumerCounting>>();
@@ -355,32 +434,25 @@ std::shared_ptr<PipelineNode> ConsumerCountingAPP::ConsumerCountingNode(
       std::cout << "image is nullptr" << std::endl;
       consumer_counting->update_consumer_counting_state(
           std::vector<TrackerInfo>(), true);
-      std::vector<uint32_t> counting_result;
-
-      counting_result.push_back(consumer_counting->get_enter_num());
-      counting_result.push_back(consumer_counting->get_miss_num());
-      frame_info->node_data_["counting_result"] = Packet::make(counting_result);
+      frame_info->node_data_.set(kCountingResultSlot,
+                                 getCountingResult(consumer_counting));
       return -1;
     }
 
     const std::vector<TrackerInfo> &track_results =
-        frame_info->node_data_["track_results"].get<std::vector<TrackerInfo>>();
+        frame_info->node_data_.get<std::vector<TrackerInfo>>(kTrackResultsSlot);
 
     std::vector<int> counting_line;
     consumer_counting->get_counting_line(counting_line);
-    frame_info->node_data_["counting_line"] = Packet::make(counting_line);
+    frame_info->node_data_.set(kCountingLineSlot, std::move(counting_line));
 
     consumer_counting->update_consumer_counting_state(track_results);
 
-    std::vector<uint32_t> counting_result;
-
-    counting_result.push_back(consumer_counting->get_enter_num());
-    counting_result.push_back(consumer_counting->get_miss_num());
-
     LOGI("frame id:%d, enter num: %d, miss num: %d\n", frame_info->frame_id_,
          consumer_counting->get_enter_num(), consumer_counting->get_miss_num());
 
-    frame_info->node_data_["counting_result"] = Packet::make(counting_result);
+    frame_info->node_data_.set(kCountingResultSlot,
+                               getCountingResult(consumer_counting));
 
     return 0;
   };
@@ -390,15 +462,8 @@ std::shared_ptr<PipelineNode> ConsumerCountingAPP::ConsumerCountingNode(
 
 std::shared_ptr<PipelineNode> ConsumerCountingAPP::CrossDetectionNode(
     const nlohmann::json &node_config) {
-  int mode = node_config["mode"];
-  int x1 = node_config["x1"];
-  int y1 = node_config["y1"];
-  int x2 = node_config["x2"];
-  int y2 = node_config["y2"];
-  int counting_gap = node_config["counting_gap"];
-
   std::shared_ptr<ConsumerCounting> cross_detection =
-      std::make_shared<ConsumerCounting>(x1, y1, x2, y2, mode, counting_gap);
+      createCounter(node_config);
 
   std::shared_ptr<PipelineNode> cross_detection_node =
       std::make_shared<PipelineNode>(Packet::make(cross_detection));
@@ -406,26 +471,26 @@ std::shared_ptr<PipelineNode> ConsumerCountingAPP::CrossDetectionNode(
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
     }
 
     const std::vector<TrackerInfo> &track_results =
-        frame_info->node_data_["track_results"].get<std::vector<TrackerInfo>>();
+        frame_info->node_data_.get<std::vector<TrackerInfo>>(kTrackResultsSlot);
 
     std::shared_ptr<ConsumerCounting> cross_detection =
         packet.get<std::shared_ptr<ConsumerCounting>>();
     std::vector<int> counting_line;
     cross_detection->get_counting_line(counting_line);
-    frame_info->node_data_["counting_line"] = Packet::make(counting_line);
+    frame_info->node_data_.set(kCountingLineSlot, std::move(counting_line));
 
     std::vector<uint64_t> cross_id;
     cross_detection->update_cross_detection_state(track_results, cross_id);
     LOGI("frame id:%d, cross_id size: %d\n", frame_info->frame_id_,
          cross_id.size());
-    frame_info->node_data_["cross_id"] = Packet::make(cross_id);
+    frame_info->node_data_.set(kCrossIdSlot, std::move(cross_id));
 
     return 0;
   };
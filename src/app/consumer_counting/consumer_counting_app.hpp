@@ -20,6 +20,13 @@ class ConsumerCountingAPP : public AppTask {
   int32_t setLine(const std::string &pipeline_name,
                   const std::string &node_name, int x1, int y1, int x2, int y2,
                   int mode);
+  // 追加计数线/多边形区域, 返回区域序号, 失败返回 -1
+  int32_t addLine(const std::string &pipeline_name,
+                  const std::string &node_name, int x1, int y1, int x2, int y2,
+                  int mode);
+  int32_t addRegion(const std::string &pipeline_name,
+                    const std::string &node_name,
+                    const std::vector<std::pair<int, int>> &points, int mode);
   int32_t init() override;
   int32_t release() override;
 
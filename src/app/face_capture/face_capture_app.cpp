@@ -9,13 +9,28 @@
 #include "components/video_decoder/video_decoder_type.hpp"
 #include "utils/tdl_log.hpp"
 
+namespace {
+// node data slots of the frame info, interned once at load time
+const int kCropFaceImgsSlot = PipelineFrameInfo::getSlotIndex("crop_face_imgs");
+const int kFaceMetaSlot = PipelineFrameInfo::getSlotIndex("face_meta");
+const int kFaceQaulityScoresSlot =
+    PipelineFrameInfo::getSlotIndex("face_qaulity_scores");
+const int kImageSlot = PipelineFrameInfo::getSlotIndex("image");
+const int kPersonMetaSlot = PipelineFrameInfo::getSlotIndex("person_meta");
+const int kRescaleFaceMetaSlot =
+    PipelineFrameInfo::getSlotIndex("rescale_face_meta");
+const int kSnapshotsSlot = PipelineFrameInfo::getSlotIndex("snapshots");
+const int kTrackResultsSlot = PipelineFrameInfo::getSlotIndex("track_results");
+}  // namespace
+
 template <typename T>
-T getNodeData(const std::string &node_name, PtrFrameInfo &frame_info) {
-  if (frame_info->node_data_.find(node_name) == frame_info->node_data_.end()) {
-    printf("node %s not found\n", node_name.c_str());
+T getNodeData(int slot, PtrFrameInfo &frame_info) {
+  if (!frame_info->node_data_.contains(slot)) {
+    printf("node data slot %d not found\n", slot);
     assert(false);
   }
-  return frame_info->node_data_[node_name].get<T>();
+  // the frame is done after getResult, move the value out instead of copying
+  return frame_info->node_data_.take<T>(slot);
 }
 
 FaceCaptureApp::FaceCaptureApp(const std::string &task_name,
@@ -80,14 +95,7 @@ int32_t FaceCaptureApp::addPipeline(const std::string &pipeline_name,
   auto lambda_clear_func = [](PtrFrameInfo &frame_info) {
     frame_info->frame_id_ = 0;
     // TO
-    auto iter = frame_info->node_data_.begin();
-    while (iter != frame_info->node_data_.end()) {
-      if (iter->first != "image") {
-        iter = frame_info->node_data_.erase(iter);
-      } else {
-        iter++;
-      }
-    }
+    frame_info->node_data_.clear(kImageSlot);
   };
   face_capture_channel->setClearFrameFunc(lambda_clear_func);
   LOGI("add pipeline %s", pipeline_name.c_str());
@@ -102,26 +110,26 @@ int32_t FaceCaptureApp::getResult(const std::string &pipeline_name,
       pipeline_channels_[pipeline_name]->getProcessedFrame(0);
 
   auto image =
-      frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+      frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
   face_capture_result->image = image;
   face_capture_result->frame_id = frame_info->frame_id_;
   face_capture_result->frame_width = frame_info->frame_width;
   face_capture_result->frame_height = frame_info->frame_height;
   face_capture_result->face_snapshots =
-      getNodeData<std::vector<ObjectSnapshotInfo>>("snapshots", frame_info);
+      getNodeData<std::vector<ObjectSnapshotInfo>>(kSnapshotsSlot, frame_info);
   if (image == nullptr) {
     result = Packet::make(face_capture_result);
     return -1;  // return here, for final force all snapshots
   }
   face_capture_result->face_boxes =
-      getNodeData<std::vector<ObjectBoxLandmarkInfo>>("face_meta", frame_info);
+      getNodeData<std::vector<ObjectBoxLandmarkInfo>>(
+          kFaceMetaSlot, frame_info);
   face_capture_result->person_boxes =
-      getNodeData<std::vector<ObjectBoxInfo>>("person_meta", frame_info);
+      getNodeData<std::vector<ObjectBoxInfo>>(kPersonMetaSlot, frame_info);
   face_capture_result->track_results =
-      getNodeData<std::vector<TrackerInfo>>("track_results", frame_info);
-  if (getChannelNodeName(pipeline_name, 0) == "video_node") {
-    pipeline_channels_[pipeline_name]->addFreeFrame(std::move(frame_info));
-  }
+      getNodeData<std::vector<TrackerInfo>>(kTrackResultsSlot, frame_info);
+  // external frames are recycled too, so that setFrame reuses the slots
+  pipeline_channels_[pipeline_name]->addFreeFrame(std::move(frame_info));
   result = Packet::make(face_capture_result);
   return 0;
 }
@@ -190,12 +198,12 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getVideoNode(
       std::cout << "video_decoder read failed" << std::endl;
       // assert(false);
     }
-    frame_info->node_data_["image"] = Packet::make(image);
     frame_info->frame_id_ = video_decoder->getFrameId();
     if (frame_info->frame_id_ == 0) {
       frame_info->frame_width = image->getWidth();
       frame_info->frame_height = image->getHeight();
     }
+    frame_info->node_data_.set(kImageSlot, std::move(image));
     return 0;
   };
   video_node->setProcessFunc(lambda_func);
@@ -223,7 +231,7 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getFaceDetectionNode(
     std::shared_ptr<BaseModel> face_detection_model =
         packet.get<std::shared_ptr<BaseModel>>();
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -236,7 +244,8 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getFaceDetectionNode(
     }
     std::shared_ptr<ModelBoxLandmarkInfo> facemeta =
         std::dynamic_pointer_cast<ModelBoxLandmarkInfo>(out_data);
-    frame_info->node_data_["face_meta"] = Packet::make(facemeta->box_landmarks);
+    frame_info->node_data_.set(kFaceMetaSlot,
+                               std::move(facemeta->box_landmarks));
     return 0;
   };
   face_detection_node->setProcessFunc(lambda_func);
@@ -267,7 +276,7 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getPersonDetectionNode(
     std::shared_ptr<BaseModel> person_detection_model =
         packet.get<std::shared_ptr<BaseModel>>();
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -280,7 +289,8 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getPersonDetectionNode(
     }
     std::shared_ptr<ModelBoxInfo> person_meta =
         std::dynamic_pointer_cast<ModelBoxInfo>(out_data);
-    frame_info->node_data_["person_meta"] = Packet::make(person_meta->bboxes);
+    frame_info->node_data_.set(kPersonMetaSlot,
+                               std::move(person_meta->bboxes));
     return 0;
   };
   person_detection_node->setProcessFunc(lambda_func);
@@ -306,7 +316,7 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getTrackNode(
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -314,10 +324,10 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getTrackNode(
     std::shared_ptr<Tracker> tracker = packet.get<std::shared_ptr<Tracker>>();
     tracker->setImgSize(image->getWidth(), image->getHeight());
     const std::vector<ObjectBoxLandmarkInfo> &face_infos =
-        frame_info->node_data_["face_meta"]
-            .get<std::vector<ObjectBoxLandmarkInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectBoxLandmarkInfo>>(
+            kFaceMetaSlot);
     const std::vector<ObjectBoxInfo> &person_infos =
-        frame_info->node_data_["person_meta"].get<std::vector<ObjectBoxInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectBoxInfo>>(kPersonMetaSlot);
 
     std::vector<ObjectBoxInfo> bbox_infos;
     for (auto &face_info : face_infos) {
@@ -331,7 +341,7 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getTrackNode(
     }
     std::vector<TrackerInfo> track_results;
     tracker->track(bbox_infos, frame_info->frame_id_, track_results);
-    frame_info->node_data_["track_results"] = Packet::make(track_results);
+    frame_info->node_data_.set(kTrackResultsSlot, std::move(track_results));
     return 0;
   };
   track_node->setProcessFunc(lambda_func);
@@ -357,22 +367,22 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getLandmarkDetectionNode(
     std::shared_ptr<BaseModel> landmark_detection_model =
         packet.get<std::shared_ptr<BaseModel>>();
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
     }
 
+    // track_results and face_meta are updated and written back below
     std::vector<TrackerInfo> track_results =
-        frame_info->node_data_["track_results"].get<std::vector<TrackerInfo>>();
+        frame_info->node_data_.take<std::vector<TrackerInfo>>(
+            kTrackResultsSlot);
 
     std::vector<ObjectBoxLandmarkInfo> face_infos =
-        frame_info->node_data_["face_meta"]
-            .get<std::vector<ObjectBoxLandmarkInfo>>();
+        frame_info->node_data_.take<std::vector<ObjectBoxLandmarkInfo>>(
+            kFaceMetaSlot);
 
-    std::vector<ObjectBoxLandmarkInfo> rescale_face_infos =
-        frame_info->node_data_["face_meta"]
-            .get<std::vector<ObjectBoxLandmarkInfo>>();
+    std::vector<ObjectBoxLandmarkInfo> rescale_face_infos = face_infos;
 
     int img_width = (int)image->getWidth();
     int img_height = (int)image->getHeight();
@@ -499,17 +509,16 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getLandmarkDetectionNode(
       }
     }
 
-    frame_info->node_data_["track_results"] =
-        Packet::make(track_results);  // to update track_results (blurness)
-    frame_info->node_data_["rescale_face_meta"] =
-        Packet::make(rescale_face_infos);
-    frame_info->node_data_["face_meta"] = Packet::make(face_infos);
-    frame_info->node_data_["crop_face_imgs"] = Packet::make(crop_face_imgs);
-    frame_info->node_data_["face_qaulity_scores"] =
-        Packet::make(face_qaulity_scores);
-
+    // to update track_results (blurness)
+    frame_info->node_data_.set(kTrackResultsSlot, std::move(track_results));
+    frame_info->node_data_.set(kRescaleFaceMetaSlot,
+                               std::move(rescale_face_infos));
+    frame_info->node_data_.set(kFaceMetaSlot, std::move(face_infos));
     LOGI("frame id:%d, crop_face_imgs size: %d\n", frame_info->frame_id_,
          crop_face_imgs.size());
+    frame_info->node_data_.set(kCropFaceImgsSlot, std::move(crop_face_imgs));
+    frame_info->node_data_.set(kFaceQaulityScoresSlot,
+                               std::move(face_qaulity_scores));
     return 0;
   };
   landmark_detection_node->setProcessFunc(lambda_func);
@@ -538,14 +547,14 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getSnapshotNode(
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     std::shared_ptr<ObjectSnapshot> snapshot =
         packet.get<std::shared_ptr<ObjectSnapshot>>();
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       std::vector<ObjectSnapshotInfo> snapshots;
       snapshot->getSnapshotData(snapshots, true);
-      frame_info->node_data_["snapshots"] = Packet::make(snapshots);
+      frame_info->node_data_.set(kSnapshotsSlot, std::move(snapshots));
       return -1;
     }
     std::map<uint64_t, ObjectBoxInfo> face_track_boxes;
@@ -553,18 +562,19 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getSnapshotNode(
     std::map<uint64_t, float> face_qaulity_scores;
     std::vector<float> face_landmarks;
     const std::vector<ObjectBoxLandmarkInfo> &face_infos =
-        frame_info->node_data_["face_meta"]
-            .get<std::vector<ObjectBoxLandmarkInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectBoxLandmarkInfo>>(
+            kFaceMetaSlot);
     const std::vector<ObjectBoxLandmarkInfo> &rescale_face_infos =
-        frame_info->node_data_["rescale_face_meta"]
-            .get<std::vector<ObjectBoxLandmarkInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectBoxLandmarkInfo>>(
+            kRescaleFaceMetaSlot);
     const std::map<uint64_t, std::shared_ptr<BaseImage>> &crop_face_imgs =
-        frame_info->node_data_["crop_face_imgs"]
-            .get<std::map<uint64_t, std::shared_ptr<BaseImage>>>();
+        frame_info->node_data_
+            .get<std::map<uint64_t, std::shared_ptr<BaseImage>>>(
+                kCropFaceImgsSlot);
     const std::vector<TrackerInfo> &track_results =
-        frame_info->node_data_["track_results"].get<std::vector<TrackerInfo>>();
+        frame_info->node_data_.get<std::vector<TrackerInfo>>(kTrackResultsSlot);
     const std::vector<float> &fq_scores =
-        frame_info->node_data_["face_qaulity_scores"].get<std::vector<float>>();
+        frame_info->node_data_.get<std::vector<float>>(kFaceQaulityScoresSlot);
 
     for (auto &t : track_results) {
       if (t.box_info_.object_type == OBJECT_TYPE_FACE) {
@@ -596,9 +606,9 @@ std::shared_ptr<PipelineNode> FaceCaptureApp::getSnapshotNode(
       LOGI("snapshot_node,frame_id:%lu,track_id:%lu,quality:%f",
            snapshot.snapshot_frame_id, snapshot.track_id, snapshot.quality);
     }
-    frame_info->node_data_["snapshots"] = Packet::make(snapshots);
     LOGI("snapshot_node,frame_id:%lu,snapshots.size:%zu update done",
          frame_info->frame_id_, snapshots.size());
+    frame_info->node_data_.set(kSnapshotsSlot, std::move(snapshots));
     return 0;
   };
   snapshot_node->setProcessFunc(lambda_func);
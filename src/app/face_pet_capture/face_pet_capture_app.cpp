@@ -8,6 +8,30 @@
 #include "components/video_decoder/video_decoder_type.hpp"
 #include "utils/tdl_log.hpp"
 
+namespace {
+// node data slots of the frame info, interned once at load time
+const int kAlignFacesSlot = PipelineFrameInfo::getSlotIndex("align_faces");
+const int kCropFaceImgsSlot = PipelineFrameInfo::getSlotIndex("crop_face_imgs");
+const int kFaceAttributesSlot =
+    PipelineFrameInfo::getSlotIndex("face_attributes");
+const int kFaceHeadQualitySlot =
+    PipelineFrameInfo::getSlotIndex("face_head_quality");
+const int kFaceMetaSlot = PipelineFrameInfo::getSlotIndex("face_meta");
+const int kFaceSnapshotsIndexSlot =
+    PipelineFrameInfo::getSlotIndex("face_snapshots_index");
+const int kFeaturesSlot = PipelineFrameInfo::getSlotIndex("features");
+const int kImageSlot = PipelineFrameInfo::getSlotIndex("image");
+const int kObjectMetaSlot = PipelineFrameInfo::getSlotIndex("object_meta");
+const int kPersonMetaSlot = PipelineFrameInfo::getSlotIndex("person_meta");
+const int kPetMetaSlot = PipelineFrameInfo::getSlotIndex("pet_meta");
+const int kRescaleFaceMetaSlot =
+    PipelineFrameInfo::getSlotIndex("rescale_face_meta");
+const int kSnapshotsSlot = PipelineFrameInfo::getSlotIndex("snapshots");
+const int kSourceHeightSlot = PipelineFrameInfo::getSlotIndex("source_height");
+const int kSourceWidthSlot = PipelineFrameInfo::getSlotIndex("source_width");
+const int kTrackResultsSlot = PipelineFrameInfo::getSlotIndex("track_results");
+}  // namespace
+
 typedef enum {
   OBJECT_FACE = 0,
   OBJECT_HEAD = 1,
@@ -16,12 +40,13 @@ typedef enum {
 } FaceCapObjectClass;
 
 template <typename T>
-T getNodeData(const std::string &node_name, PtrFrameInfo &frame_info) {
-  if (frame_info->node_data_.find(node_name) == frame_info->node_data_.end()) {
-    printf("node %s not found\n", node_name.c_str());
+T getNodeData(int slot, PtrFrameInfo &frame_info) {
+  if (!frame_info->node_data_.contains(slot)) {
+    printf("node data slot %d not found\n", slot);
     assert(false);
   }
-  return frame_info->node_data_[node_name].get<T>();
+  // the frame is done after getResult, move the value out instead of copying
+  return frame_info->node_data_.take<T>(slot);
 }
 
 FacePetCaptureApp::FacePetCaptureApp(const std::string &task_name,
@@ -99,14 +124,7 @@ int32_t FacePetCaptureApp::addPipeline(const std::string &pipeline_name,
   auto lambda_clear_func = [](PtrFrameInfo &frame_info) {
     frame_info->frame_id_ = 0;
     // TO
-    auto iter = frame_info->node_data_.begin();
-    while (iter != frame_info->node_data_.end()) {
-      if (iter->first != "image") {
-        iter = frame_info->node_data_.erase(iter);
-      } else {
-        iter++;
-      }
-    }
+    frame_info->node_data_.clear(kImageSlot);
   };
   face_capture_channel->setClearFrameFunc(lambda_clear_func);
   LOGI("add pipeline %s\n", pipeline_name.c_str());
@@ -125,55 +143,54 @@ int32_t FacePetCaptureApp::getResult(const std::string &pipeline_name,
     return 0;
   }
 
-  if (frame_info->node_data_.find("image") == frame_info->node_data_.end()) {
+  if (!frame_info->node_data_.contains(kImageSlot)) {
     LOGE("image node not found in frame_info for pipeline %s\n",
          pipeline_name.c_str());
     result = Packet::make(face_pet_capture_result);
     return -1;
   }
   auto image =
-      frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+      frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
 
   face_pet_capture_result->image = image;
   face_pet_capture_result->frame_id = frame_info->frame_id_;
   face_pet_capture_result->frame_width = frame_info->frame_width;
   face_pet_capture_result->frame_height = frame_info->frame_height;
 
-  if (frame_info->node_data_.find("source_width") !=
-      frame_info->node_data_.end()) {
+  if (frame_info->node_data_.contains(kSourceWidthSlot)) {
     face_pet_capture_result->source_width =
-        frame_info->node_data_["source_width"].get<uint32_t>();
+        frame_info->node_data_.get<uint32_t>(kSourceWidthSlot);
     face_pet_capture_result->source_height =
-        frame_info->node_data_["source_height"].get<uint32_t>();
+        frame_info->node_data_.get<uint32_t>(kSourceHeightSlot);
   } else {
     face_pet_capture_result->source_width = frame_info->frame_width;
     face_pet_capture_result->source_height = frame_info->frame_height;
   }
 
   face_pet_capture_result->face_snapshots =
-      getNodeData<std::vector<ObjectSnapshotInfo>>("snapshots", frame_info);
+      getNodeData<std::vector<ObjectSnapshotInfo>>(kSnapshotsSlot, frame_info);
   face_pet_capture_result->features =
-      getNodeData<std::map<uint64_t, std::vector<float>>>("features",
-                                                          frame_info);
+      getNodeData<std::map<uint64_t, std::vector<float>>>(kFeaturesSlot,
+                                                           frame_info);
   face_pet_capture_result->face_attributes =
       getNodeData<std::map<uint64_t, std::map<TDLObjectAttributeType, float>>>(
-          "face_attributes", frame_info);
+          kFaceAttributesSlot, frame_info);
   if (image == nullptr) {
     result = Packet::make(face_pet_capture_result);
     return -1;  // return here, for final force all snapshots
   }
   face_pet_capture_result->face_boxes =
-      getNodeData<std::vector<ObjectBoxLandmarkInfo>>("face_meta", frame_info);
+      getNodeData<std::vector<ObjectBoxLandmarkInfo>>(
+          kFaceMetaSlot, frame_info);
   face_pet_capture_result->person_boxes =
-      getNodeData<std::vector<ObjectBoxInfo>>("person_meta", frame_info);
+      getNodeData<std::vector<ObjectBoxInfo>>(kPersonMetaSlot, frame_info);
   face_pet_capture_result->pet_boxes =
-      getNodeData<std::vector<ObjectBoxInfo>>("pet_meta", frame_info);
+      getNodeData<std::vector<ObjectBoxInfo>>(kPetMetaSlot, frame_info);
   face_pet_capture_result->track_results =
-      getNodeData<std::vector<TrackerInfo>>("track_results", frame_info);
+      getNodeData<std::vector<TrackerInfo>>(kTrackResultsSlot, frame_info);
 
-  if (getChannelNodeName(pipeline_name, 0) == "video_node") {
-    pipeline_channels_[pipeline_name]->addFreeFrame(std::move(frame_info));
-  }
+  // external frames are recycled too, so that setFrame reuses the slots
+  pipeline_channels_[pipeline_name]->addFreeFrame(std::move(frame_info));
   result = Packet::make(face_pet_capture_result);
   return 0;
 }
@@ -247,12 +264,12 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getVideoNode(
       std::cout << "video_decoder read failed" << std::endl;
       // assert(false);
     }
-    frame_info->node_data_["image"] = Packet::make(image);
     frame_info->frame_id_ = video_decoder->getFrameId();
     if (frame_info->frame_id_ == 0) {
       frame_info->frame_width = image->getWidth();
       frame_info->frame_height = image->getHeight();
     }
+    frame_info->node_data_.set(kImageSlot, std::move(image));
     return 0;
   };
   video_node->setProcessFunc(lambda_func);
@@ -280,7 +297,7 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getObjectDetectionNode(
     std::shared_ptr<BaseModel> object_detection_model =
         packet.get<std::shared_ptr<BaseModel>>();
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -296,10 +313,9 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getObjectDetectionNode(
     std::shared_ptr<ModelBoxInfo> object_meta =
         std::dynamic_pointer_cast<ModelBoxInfo>(out_data);
 
-    frame_info->node_data_["object_meta"] = Packet::make(object_meta->bboxes);
-
     LOGI("frame id:%" PRIu64 ", detecte object size: %d\n",
          frame_info->frame_id_, object_meta->bboxes.size());
+    frame_info->node_data_.set(kObjectMetaSlot, std::move(object_meta->bboxes));
 
     return 0;
   };
@@ -326,7 +342,7 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getTrackNode(
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -334,7 +350,7 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getTrackNode(
     std::shared_ptr<Tracker> tracker = packet.get<std::shared_ptr<Tracker>>();
     tracker->setImgSize(image->getWidth(), image->getHeight());
     std::vector<ObjectBoxInfo> object_infos =
-        frame_info->node_data_["object_meta"].get<std::vector<ObjectBoxInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectBoxInfo>>(kObjectMetaSlot);
 
     std::vector<ObjectBoxInfo> bbox_infos;
     std::vector<ObjectBoxLandmarkInfo> face_landmark_bbox;
@@ -379,19 +395,18 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getTrackNode(
     ObjectQualityHelper::getFaceQuality(face_bbox, head_bbox,
                                         face_head_quality);
 
-    frame_info->node_data_["face_head_quality"] =
-        Packet::make(face_head_quality);
-    frame_info->node_data_["face_meta"] =
-        Packet::make(face_landmark_bbox);  // face_meta without landmarks
-    frame_info->node_data_["person_meta"] = Packet::make(person_bbox);
-    frame_info->node_data_["pet_meta"] = Packet::make(pet_bbox);
+    frame_info->node_data_.set(kFaceHeadQualitySlot,
+                               std::move(face_head_quality));
+    // face_meta without landmarks
+    frame_info->node_data_.set(kFaceMetaSlot, std::move(face_landmark_bbox));
+    frame_info->node_data_.set(kPersonMetaSlot, std::move(person_bbox));
+    frame_info->node_data_.set(kPetMetaSlot, std::move(pet_bbox));
 
     std::vector<TrackerInfo> track_results;
     tracker->track(bbox_infos, frame_info->frame_id_, track_results);
-    frame_info->node_data_["track_results"] = Packet::make(track_results);
-
     LOGI("frame id:%" PRIu64 ", track size: %d\n", frame_info->frame_id_,
          track_results.size());
+    frame_info->node_data_.set(kTrackResultsSlot, std::move(track_results));
 
     return 0;
   };
@@ -418,25 +433,25 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getLandmarkDetectionNode(
     std::shared_ptr<BaseModel> landmark_detection_model =
         packet.get<std::shared_ptr<BaseModel>>();
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
     }
 
+    // track_results and face_meta are updated and written back below
     std::vector<TrackerInfo> track_results =
-        frame_info->node_data_["track_results"].get<std::vector<TrackerInfo>>();
+        frame_info->node_data_.take<std::vector<TrackerInfo>>(
+            kTrackResultsSlot);
 
     std::vector<ObjectBoxLandmarkInfo> face_infos =
-        frame_info->node_data_["face_meta"]
-            .get<std::vector<ObjectBoxLandmarkInfo>>();
+        frame_info->node_data_.take<std::vector<ObjectBoxLandmarkInfo>>(
+            kFaceMetaSlot);
 
-    std::vector<ObjectBoxLandmarkInfo> rescale_face_infos =
-        frame_info->node_data_["face_meta"]
-            .get<std::vector<ObjectBoxLandmarkInfo>>();
+    std::vector<ObjectBoxLandmarkInfo> rescale_face_infos = face_infos;
 
     const std::vector<float> &face_head_quality =
-        frame_info->node_data_["face_head_quality"].get<std::vector<float>>();
+        frame_info->node_data_.get<std::vector<float>>(kFaceHeadQualitySlot);
 
     if (face_head_quality.size() != face_infos.size()) {
       std::cout << "face_head_quality.size() != face_infos.size()" << std::endl;
@@ -544,15 +559,14 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getLandmarkDetectionNode(
       }
     }
 
-    frame_info->node_data_["track_results"] =
-        Packet::make(track_results);  // to update track_results (blurness)
-    frame_info->node_data_["rescale_face_meta"] =
-        Packet::make(rescale_face_infos);
-    frame_info->node_data_["face_meta"] = Packet::make(face_infos);
-    frame_info->node_data_["crop_face_imgs"] = Packet::make(crop_face_imgs);
-
+    // to update track_results (blurness)
+    frame_info->node_data_.set(kTrackResultsSlot, std::move(track_results));
+    frame_info->node_data_.set(kRescaleFaceMetaSlot,
+                               std::move(rescale_face_infos));
+    frame_info->node_data_.set(kFaceMetaSlot, std::move(face_infos));
     LOGI("frame id:%" PRIu64 ", crop_face_imgs size: %d\n",
          frame_info->frame_id_, crop_face_imgs.size());
+    frame_info->node_data_.set(kCropFaceImgsSlot, std::move(crop_face_imgs));
     return 0;
   };
   landmark_detection_node->setProcessFunc(lambda_func);
@@ -582,14 +596,14 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getSnapshotNode(
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     std::shared_ptr<ObjectSnapshot> snapshot =
         packet.get<std::shared_ptr<ObjectSnapshot>>();
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       std::vector<ObjectSnapshotInfo> snapshots;
       snapshot->getSnapshotData(snapshots, true);
-      frame_info->node_data_["snapshots"] = Packet::make(snapshots);
+      frame_info->node_data_.set(kSnapshotsSlot, std::move(snapshots));
       return -1;
     }
 
@@ -598,19 +612,19 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getSnapshotNode(
     std::map<uint64_t, float> qaulity_scores;
     std::vector<float> face_landmarks;
     const std::vector<ObjectBoxLandmarkInfo> &rescale_face_infos =
-        frame_info->node_data_["rescale_face_meta"]
-            .get<std::vector<ObjectBoxLandmarkInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectBoxLandmarkInfo>>(
+            kRescaleFaceMetaSlot);
     const std::vector<ObjectBoxLandmarkInfo> &face_infos =
-        frame_info->node_data_["face_meta"]
-            .get<std::vector<ObjectBoxLandmarkInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectBoxLandmarkInfo>>(
+            kFaceMetaSlot);
 
     const std::vector<ObjectBoxInfo> &person_infos =
-        frame_info->node_data_["person_meta"].get<std::vector<ObjectBoxInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectBoxInfo>>(kPersonMetaSlot);
 
     const std::vector<TrackerInfo> &track_results =
-        frame_info->node_data_["track_results"].get<std::vector<TrackerInfo>>();
+        frame_info->node_data_.get<std::vector<TrackerInfo>>(kTrackResultsSlot);
     const std::vector<float> &face_head_quality =
-        frame_info->node_data_["face_head_quality"].get<std::vector<float>>();
+        frame_info->node_data_.get<std::vector<float>>(kFaceHeadQualitySlot);
 
     for (auto &t : track_results) {
       if (t.box_info_.object_type == OBJECT_TYPE_FACE) {
@@ -655,8 +669,9 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getSnapshotNode(
     }
 
     const std::map<uint64_t, std::shared_ptr<BaseImage>> &crop_face_imgs =
-        frame_info->node_data_["crop_face_imgs"]
-            .get<std::map<uint64_t, std::shared_ptr<BaseImage>>>();
+        frame_info->node_data_
+            .get<std::map<uint64_t, std::shared_ptr<BaseImage>>>(
+                kCropFaceImgsSlot);
 
     std::map<std::string, Packet> other_info;
     other_info["face_landmark"] = Packet::make(rescale_face_infos);
@@ -677,10 +692,9 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getSnapshotNode(
            snapshot.snapshot_frame_id, snapshot.track_id, snapshot.quality);
     }
 
-    frame_info->node_data_["snapshots"] = Packet::make(snapshots);
-
     LOGI("snapshot_node,frame_id:%" PRIu64 ",snapshots.size:%d update done\n",
          frame_info->frame_id_, snapshots.size());
+    frame_info->node_data_.set(kSnapshotsSlot, std::move(snapshots));
     return 0;
   };
   snapshot_node->setProcessFunc(lambda_func);
@@ -706,8 +720,8 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getFeatureExtractionNode(
         packet.get<std::shared_ptr<BaseModel>>();
 
     const std::vector<ObjectSnapshotInfo> &snapshots_data =
-        frame_info->node_data_["snapshots"]
-            .get<std::vector<ObjectSnapshotInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectSnapshotInfo>>(
+            kSnapshotsSlot);
 
     std::vector<std::shared_ptr<BaseImage>> images = {};
     std::vector<size_t> face_snapshots_index;
@@ -742,9 +756,6 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getFeatureExtractionNode(
       images.push_back(face_crop);
     }
 
-    frame_info->node_data_["align_faces"] = Packet::make(images);
-    frame_info->node_data_["face_snapshots_index"] =
-        Packet::make(face_snapshots_index);
 
     std::vector<std::shared_ptr<ModelOutputInfo>> out_data;
     if (images.size() > 0) {
@@ -794,9 +805,12 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getFeatureExtractionNode(
       features[snapshot_data.track_id] = feature_vec;
     }
 
-    frame_info->node_data_["features"] = Packet::make(features);
     LOGI("frame_id:%" PRIu64 ",features size:%d\n", frame_info->frame_id_,
          features.size());
+    frame_info->node_data_.set(kAlignFacesSlot, std::move(images));
+    frame_info->node_data_.set(kFaceSnapshotsIndexSlot,
+                               std::move(face_snapshots_index));
+    frame_info->node_data_.set(kFeaturesSlot, std::move(features));
 
     return 0;
   };
@@ -827,16 +841,17 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getFaceAttributeNode(
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
     std::shared_ptr<BaseModel> face_attribute_model =
         packet.get<std::shared_ptr<BaseModel>>();
-    auto images = frame_info->node_data_["align_faces"]
-                      .get<std::vector<std::shared_ptr<BaseImage>>>();
+    const std::vector<std::shared_ptr<BaseImage>> &images =
+        frame_info->node_data_.get<std::vector<std::shared_ptr<BaseImage>>>(
+            kAlignFacesSlot);
 
     const std::vector<ObjectSnapshotInfo> &snapshots_data =
-        frame_info->node_data_["snapshots"]
-            .get<std::vector<ObjectSnapshotInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectSnapshotInfo>>(
+            kSnapshotsSlot);
 
     const std::vector<size_t> &face_snapshots_index =
-        frame_info->node_data_["face_snapshots_index"]
-            .get<std::vector<size_t>>();
+        frame_info->node_data_.get<std::vector<size_t>>(
+            kFaceSnapshotsIndexSlot);
 
     std::vector<std::shared_ptr<ModelOutputInfo>> out_data;
     if (images.size() > 0) {
@@ -857,7 +872,7 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getFaceAttributeNode(
           face_att_meta->attributes;
     }
 
-    frame_info->node_data_["face_attributes"] = Packet::make(face_attributes);
+    frame_info->node_data_.set(kFaceAttributesSlot, std::move(face_attributes));
     return 0;
   };
 
@@ -889,8 +904,8 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getClipImageFeatureNode(
     std::shared_ptr<BaseModel> image_feature_model =
         packet.get<std::shared_ptr<BaseModel>>();
     const std::vector<ObjectSnapshotInfo> &snapshots_data =
-        frame_info->node_data_["snapshots"]
-            .get<std::vector<ObjectSnapshotInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectSnapshotInfo>>(
+            kSnapshotsSlot);
 
     std::vector<std::shared_ptr<BaseImage>> images;
     std::vector<size_t> person_snapshots_index;
@@ -916,8 +931,9 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getClipImageFeatureNode(
     }
 
     // 获取现有特征字典并添加人物特征
-    auto features = frame_info->node_data_["features"]
-                        .get<std::map<uint64_t, std::vector<float>>>();
+    std::map<uint64_t, std::vector<float>> &features =
+        frame_info->node_data_
+            .getMutable<std::map<uint64_t, std::vector<float>>>(kFeaturesSlot);
 
     for (size_t i = 0; i < out_data.size(); ++i) {
       auto feature_meta =
@@ -953,7 +969,6 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getClipImageFeatureNode(
       features[track_id] = feature_vec;
     }
 
-    frame_info->node_data_["features"] = Packet::make(features);
     LOGI("frame_id:%" PRIu64 ",features size:%d\n", frame_info->frame_id_,
          features.size());
 
@@ -994,7 +1009,7 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getResizeImageNode(
   auto lambda_func = [resize_width, resize_height](PtrFrameInfo &frame_info,
                                                    Packet &packet) -> int32_t {
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -1020,9 +1035,9 @@ std::shared_ptr<PipelineNode> FacePetCaptureApp::getResizeImageNode(
         );
 
     // 更新frame_info中的图像
-    frame_info->node_data_["image"] = Packet::make(resized_image);
-    frame_info->node_data_["source_width"] = Packet::make(image->getWidth());
-    frame_info->node_data_["source_height"] = Packet::make(image->getHeight());
+    frame_info->node_data_.set(kImageSlot, std::move(resized_image));
+    frame_info->node_data_.set(kSourceWidthSlot, image->getWidth());
+    frame_info->node_data_.set(kSourceHeightSlot, image->getHeight());
     frame_info->frame_width = resize_width;
     frame_info->frame_height = resize_height;
 
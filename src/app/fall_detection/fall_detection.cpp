@@ -7,227 +7,198 @@
 #define SCORE_THRESHOLD 0.4
 #define FRAME_GAP 1.0
 
-void print_kps(std::vector<std::pair<float, float>> &kps, int index) {
-  for (uint32_t i = 0; i < kps.size(); i++) {
-    printf("[%d] %d: %.2f, %.2f\n", index, i, kps[i].first, kps[i].second);
-  }
-}
-
-FallDet::FallDet(uint64_t id) {
-  uid = id;
-  for (int i = 0; i < 4; i++) {
-    valid_list.push(0);
-  }
-
-  for (int i = 0; i < 3; i++) {
-    speed_caches.push(0);
-  }
+namespace {
+const uint8_t kValidMask = 0xF;    // 4 frames
+const uint8_t kSpeedMask = 0x7;    // 3 frames
+const uint8_t kStatusMask = 0x3F;  // 6 frames
 
-  for (int i = 0; i < 6; i++) {
-    statuses_cache.push(0);
+inline int bitCount(uint8_t bits) {
+  int num = 0;
+  for (; bits != 0; bits &= bits - 1) {
+    num++;
   }
+  return num;
 }
 
-int FallDet::elem_count(std::queue<int> &q) {
-  int num = 0;
-  int q_size = q.size();
+inline float distance(const ObjectBoxLandmarkInfo &meta, int a, int b) {
+  float dx = meta.landmarks_x[a] - meta.landmarks_x[b];
+  float dy = meta.landmarks_y[a] - meta.landmarks_y[b];
+  return std::sqrt(dx * dx + dy * dy);
+}
 
-  for (int i = 0; i < q_size; i++) {
-    int val = q.front();
-    q.pop();
+// keypoints (joint, middle, end) of a limb and its scale to the body height
+struct Limb {
+  int a, b, c;
+  float scale;
+};
+const Limb kLimbs[] = {
+    {12, 14, 16, 2.4f},  // left leg
+    {11, 13, 15, 2.4f},  // right leg
+    {6, 8, 10, 3.4f},    // left arm
+    {5, 7, 9, 3.4f},     // right arm
+};
+}  // namespace
+
+FallDetStore::FallDetStore() {}
+
+int FallDetStore::addTrack(uint64_t uid) {
+  int slot = uids_.size();
+  uids_.push_back(uid);
+  slot_index_[uid] = slot;
+  unmatched_times_.push_back(0);
+  seen_.push_back(0);
+  valid_bits_.push_back(0);
+  speed_bits_.push_back(0);
+  status_bits_.push_back(0);
+  size_t size = uids_.size() * kHistorySize;
+  neck_x_.resize(size, 0.0f);
+  neck_y_.resize(size, 0.0f);
+  hip_x_.resize(size, 0.0f);
+  hip_y_.resize(size, 0.0f);
+  history_head_.push_back(kHistorySize - 1);
+  return slot;
+}
 
-    num += val;
-    q.push(val);
+void FallDetStore::removeTrack(int slot) {
+  int last = uids_.size() - 1;
+  slot_index_.erase(uids_[slot]);
+  if (slot != last) {
+    uids_[slot] = uids_[last];
+    slot_index_[uids_[slot]] = slot;
+    unmatched_times_[slot] = unmatched_times_[last];
+    seen_[slot] = seen_[last];
+    valid_bits_[slot] = valid_bits_[last];
+    speed_bits_[slot] = speed_bits_[last];
+    status_bits_[slot] = status_bits_[last];
+    for (std::vector<float> *history : {&neck_x_, &neck_y_, &hip_x_, &hip_y_}) {
+      std::copy_n(history->begin() + last * kHistorySize, kHistorySize,
+                  history->begin() + slot * kHistorySize);
+    }
+    history_head_[slot] = history_head_[last];
   }
-
-  return num;
+  uids_.pop_back();
+  unmatched_times_.pop_back();
+  seen_.pop_back();
+  valid_bits_.pop_back();
+  speed_bits_.pop_back();
+  status_bits_.pop_back();
+  history_head_.pop_back();
+  size_t size = uids_.size() * kHistorySize;
+  neck_x_.resize(size);
+  neck_y_.resize(size);
+  hip_x_.resize(size);
+  hip_y_.resize(size);
 }
 
-bool FallDet::keypoints_useful(const ObjectBoxLandmarkInfo &person_meta) {
-  if (history_neck.size() == FRAME_GAP + 3) {
-    history_neck.erase(history_neck.begin());
-    history_hip.erase(history_hip.begin());
-  }
+bool FallDetStore::keypointsUseful(int slot,
+                                   const ObjectBoxLandmarkInfo &person_meta) {
+  int head = (history_head_[slot] + 1) % kHistorySize;
+  history_head_[slot] = head;
+  size_t index = size_t(slot) * kHistorySize + head;
 
   if (person_meta.landmarks_score[5] > SCORE_THRESHOLD &&
       person_meta.landmarks_score[6] > SCORE_THRESHOLD &&
       person_meta.landmarks_score[11] > SCORE_THRESHOLD &&
       person_meta.landmarks_score[12] > SCORE_THRESHOLD) {
-    float neck_x =
+    neck_x_[index] =
         (person_meta.landmarks_x[5] + person_meta.landmarks_x[6]) / 2.0f;
-    float neck_y =
+    neck_y_[index] =
         (person_meta.landmarks_y[5] + person_meta.landmarks_y[6]) / 2.0f;
-    float hip_x =
+    hip_x_[index] =
         (person_meta.landmarks_x[11] + person_meta.landmarks_x[12]) / 2.0f;
-    float hip_y =
+    hip_y_[index] =
         (person_meta.landmarks_y[11] + person_meta.landmarks_y[12]) / 2.0f;
-
-    std::pair<float, float> neck = std::make_pair(neck_x, neck_y);
-    std::pair<float, float> hip = std::make_pair(hip_x, hip_y);
-
-    history_neck.push_back(neck);
-    history_hip.push_back(hip);
-
     return true;
-
-  } else {
-    history_neck.push_back(std::make_pair(0, 0));
-    history_hip.push_back(std::make_pair(0, 0));
-
-    return false;
-  }
-}
-
-void FallDet::get_kps(std::vector<std::pair<float, float>> &val_list, int index,
-                      float *x, float *y) {
-  float tmp_x = 0;
-  float tmp_y = 0;
-
-  for (int i = index; i < index + 3; i++) {
-    tmp_x += val_list[i].first;
-    tmp_y += val_list[i].second;
   }
-
-  *x = tmp_x / 3.0f;
-  *y = tmp_y / 3.0f;
+  neck_x_[index] = 0;
+  neck_y_[index] = 0;
+  hip_x_[index] = 0;
+  hip_y_[index] = 0;
+  return false;
 }
 
-float FallDet::human_orientation() {
-  float neck_x, neck_y, hip_x, hip_y;
-
-  get_kps(history_neck, FRAME_GAP, &neck_x, &neck_y);
-  get_kps(history_hip, FRAME_GAP, &hip_x, &hip_y);
-
-  float human_angle =
-      atan2(hip_y - neck_y, hip_x - neck_x) * 180.0 / M_PI - 90.0;
-
-  return human_angle;
-}
-
-float FallDet::body_box_calculation(const ObjectBoxLandmarkInfo &person_meta) {
-  return (person_meta.x2 - person_meta.x1) / (person_meta.y2 - person_meta.y1);
-}
-
-void FallDet::update_queue(std::queue<int> &q, int val) {
-  q.pop();
-  q.push(val);
-}
-
-float FallDet::speed_detection(const ObjectBoxLandmarkInfo &person_meta,
-                               float fps) {
-  float neck_x_before, neck_y_before, neck_x_cur, neck_y_cur;
-
-  get_kps(history_neck, 0, &neck_x_before, &neck_y_before);
-  get_kps(history_neck, FRAME_GAP, &neck_x_cur, &neck_y_cur);
-
-  float delta_position = sqrt(pow(neck_x_before - neck_x_cur, 2) +
-                              pow(neck_y_before - neck_y_cur, 2));
-
-  if (neck_y_cur < neck_y_before) {
-    delta_position = -delta_position;
-  }
-
-  std::vector<float> delta_val;
-
-  float box_w = person_meta.x2 - person_meta.x1;
-  float box_h = person_meta.y2 - person_meta.y1;
-
-  if (person_meta.landmarks_score[13] < SCORE_THRESHOLD &&
-      person_meta.landmarks_score[14] < SCORE_THRESHOLD &&
-      person_meta.landmarks_score[15] < SCORE_THRESHOLD &&
-      person_meta.landmarks_score[16] < SCORE_THRESHOLD) {
-    box_h *= 1.8;
-  } else if (person_meta.landmarks_score[15] < SCORE_THRESHOLD &&
-             person_meta.landmarks_score[16] < SCORE_THRESHOLD) {
-    box_h *= 1.3;
-  }
-
-  float delta_body = sqrt(pow(box_w, 2) + pow(box_h, 2));
-
-  delta_val.push_back(delta_body);
-
-  if (person_meta.landmarks_score[12] > SCORE_THRESHOLD &&
-      person_meta.landmarks_score[14] > SCORE_THRESHOLD &&
-      person_meta.landmarks_score[16] > SCORE_THRESHOLD) {
-    float left_leg_up =
-        sqrt(pow(person_meta.landmarks_x[12] - person_meta.landmarks_x[14], 2) +
-             pow(person_meta.landmarks_y[12] - person_meta.landmarks_y[14], 2));
-    float left_leg_bottom =
-        sqrt(pow(person_meta.landmarks_x[16] - person_meta.landmarks_x[14], 2) +
-             pow(person_meta.landmarks_y[16] - person_meta.landmarks_y[14], 2));
-    float left_leg = (left_leg_up + left_leg_bottom) * 2.4;
-
-    delta_val.push_back(left_leg);
-  }
-
-  if (person_meta.landmarks_score[11] > SCORE_THRESHOLD &&
-      person_meta.landmarks_score[13] > SCORE_THRESHOLD &&
-      person_meta.landmarks_score[15] > SCORE_THRESHOLD) {
-    float right_leg_up =
-        sqrt(pow(person_meta.landmarks_x[11] - person_meta.landmarks_x[13], 2) +
-             pow(person_meta.landmarks_y[11] - person_meta.landmarks_y[13], 2));
-    float right_leg_bottom =
-        sqrt(pow(person_meta.landmarks_x[13] - person_meta.landmarks_x[15], 2) +
-             pow(person_meta.landmarks_y[13] - person_meta.landmarks_y[15], 2));
-    float right_leg = (right_leg_up + right_leg_bottom) * 2.4;
-
-    delta_val.push_back(right_leg);
-  }
-
-  if (person_meta.landmarks_score[6] > SCORE_THRESHOLD &&
-      person_meta.landmarks_score[8] > SCORE_THRESHOLD &&
-      person_meta.landmarks_score[10] > SCORE_THRESHOLD) {
-    float left_arm_up =
-        sqrt(pow(person_meta.landmarks_x[6] - person_meta.landmarks_x[8], 2) +
-             pow(person_meta.landmarks_y[6] - person_meta.landmarks_y[8], 2));
-    float left_arm_bottom =
-        sqrt(pow(person_meta.landmarks_x[8] - person_meta.landmarks_x[10], 2) +
-             pow(person_meta.landmarks_y[8] - person_meta.landmarks_y[10], 2));
-    float left_arm = (left_arm_up + left_arm_bottom) * 3.4;
-
-    delta_val.push_back(left_arm);
-  }
-
-  if (person_meta.landmarks_score[5] > SCORE_THRESHOLD &&
-      person_meta.landmarks_score[7] > SCORE_THRESHOLD &&
-      person_meta.landmarks_score[9] > SCORE_THRESHOLD) {
-    float right_arm_up =
-        sqrt(pow(person_meta.landmarks_x[5] - person_meta.landmarks_x[7], 2) +
-             pow(person_meta.landmarks_y[5] - person_meta.landmarks_y[7], 2));
-    float right_arm_bottom =
-        sqrt(pow(person_meta.landmarks_x[7] - person_meta.landmarks_x[9], 2) +
-             pow(person_meta.landmarks_y[7] - person_meta.landmarks_y[9], 2));
-    float right_arm = (right_arm_up + right_arm_bottom) * 3.4;
-
-    delta_val.push_back(right_arm);
+void FallDetStore::computeFeatures(float fps) {
+  size_t num = ready_.size();
+  angles_.resize(num);
+  aspect_ratios_.resize(num);
+  speeds_.resize(num);
+  limb_sums_.resize(num);
+  limb_counts_.resize(num);
+
+  // neck/hip averaged over frames [0, 3) ("before") and [1, 4) ("current"),
+  // frame 0 being the oldest of the history
+  for (size_t r = 0; r < num; r++) {
+    int slot = ready_[r];
+    size_t base = size_t(slot) * kHistorySize;
+    int oldest = history_head_[slot] + 1;
+    float nx[kHistorySize], ny[kHistorySize], hx[kHistorySize],
+        hy[kHistorySize];
+    for (int f = 0; f < kHistorySize; f++) {
+      size_t index = base + (oldest + f) % kHistorySize;
+      nx[f] = neck_x_[index];
+      ny[f] = neck_y_[index];
+      hx[f] = hip_x_[index];
+      hy[f] = hip_y_[index];
+    }
+    float neck_x_before = (nx[0] + nx[1] + nx[2]) / 3.0f;
+    float neck_y_before = (ny[0] + ny[1] + ny[2]) / 3.0f;
+    float neck_x_cur = (nx[1] + nx[2] + nx[3]) / 3.0f;
+    float neck_y_cur = (ny[1] + ny[2] + ny[3]) / 3.0f;
+    float hip_x = (hx[1] + hx[2] + hx[3]) / 3.0f;
+    float hip_y = (hy[1] + hy[2] + hy[3]) / 3.0f;
+
+    angles_[r] = std::atan2(hip_y - neck_y_cur, hip_x - neck_x_cur) * 180.0f /
+                     (float)M_PI -
+                 90.0f;
+
+    float dx = neck_x_before - neck_x_cur;
+    float dy = neck_y_before - neck_y_cur;
+    float delta_position = std::sqrt(dx * dx + dy * dy);
+    speeds_[r] = neck_y_cur < neck_y_before ? -delta_position : delta_position;
   }
 
-  double delta_sum = 0.0;
-
-  for (uint32_t i = 0; i < delta_val.size(); i++) {
-    delta_sum += delta_val[i];
+  // body diagonal, the box misses the legs when the lower keypoints are lost
+  for (size_t r = 0; r < num; r++) {
+    const ObjectBoxLandmarkInfo &meta = *ready_persons_[r];
+    const std::vector<float> &score = meta.landmarks_score;
+    float box_w = meta.x2 - meta.x1;
+    float box_h = meta.y2 - meta.y1;
+    aspect_ratios_[r] = box_w / box_h;
+    if (score[13] < SCORE_THRESHOLD && score[14] < SCORE_THRESHOLD &&
+        score[15] < SCORE_THRESHOLD && score[16] < SCORE_THRESHOLD) {
+      box_h *= 1.8f;
+    } else if (score[15] < SCORE_THRESHOLD && score[16] < SCORE_THRESHOLD) {
+      box_h *= 1.3f;
+    }
+    limb_sums_[r] = std::sqrt(box_w * box_w + box_h * box_h);
+    limb_counts_[r] = 1.0f;
   }
-  double delta_mean = delta_sum / (float)delta_val.size();
-
-  float speed = 100.0 * delta_position / (delta_mean * (FRAME_GAP / fps));
 
-  if (speed > SPEED_THRESHOLD) {
-    update_queue(speed_caches, 1);
-  } else {
-    update_queue(speed_caches, 0);
+  // limb lengths scaled to the body height, only with reliable keypoints
+  for (const Limb &limb : kLimbs) {
+    for (size_t r = 0; r < num; r++) {
+      const ObjectBoxLandmarkInfo &meta = *ready_persons_[r];
+      const std::vector<float> &score = meta.landmarks_score;
+      bool valid = score[limb.a] > SCORE_THRESHOLD &&
+                   score[limb.b] > SCORE_THRESHOLD &&
+                   score[limb.c] > SCORE_THRESHOLD;
+      float length =
+          (distance(meta, limb.a, limb.b) + distance(meta, limb.b, limb.c)) *
+          limb.scale;
+      limb_sums_[r] += valid ? length : 0.0f;
+      limb_counts_[r] += valid ? 1.0f : 0.0f;
+    }
   }
 
-  if (elem_count(speed_caches) >= 2) {
-    is_moving = true;
-  } else {
-    is_moving = false;
+  const float frame_time = FRAME_GAP / fps;
+  for (size_t r = 0; r < num; r++) {
+    float delta_mean = limb_sums_[r] / limb_counts_[r];
+    speeds_[r] = 100.0f * speeds_[r] / (delta_mean * frame_time);
   }
-
-  return speed;
 }
 
-int FallDet::action_analysis(float human_angle, float aspect_ratio,
-                             float moving_speed) {
+int FallDetStore::actionAnalysis(float human_angle, float aspect_ratio,
+                                 float moving_speed, bool is_moving) const {
   /*
   state_list[0]: Stand_still
   state_list[1]: Stand_walking
@@ -282,36 +253,65 @@ int FallDet::action_analysis(float human_angle, float aspect_ratio,
   return max_position;
 }
 
-bool FallDet::alert_decision(int status) {
-  update_queue(statuses_cache, status);
-
-  if (elem_count(statuses_cache) >= 3) {
-    return true;
-  } else {
-    return false;
+void FallDetStore::detect(
+    const std::vector<uint64_t> &uids,
+    const std::vector<const ObjectBoxLandmarkInfo *> &persons, float fps,
+    std::vector<int> &falls) {
+  falls.assign(uids.size(), 0);
+  if (uids.size() != persons.size()) {
+    LOGE("uids size %zu != persons size %zu", uids.size(), persons.size());
+    return;
+  }
+  std::fill(seen_.begin(), seen_.end(), 0);
+  ready_.clear();
+  ready_persons_.clear();
+  ready_index_.clear();
+
+  for (size_t i = 0; i < uids.size(); i++) {
+    auto it = slot_index_.find(uids[i]);
+    int slot = it == slot_index_.end() ? addTrack(uids[i]) : it->second;
+    seen_[slot] = 1;
+    unmatched_times_[slot] = 0;
+    if (persons[i]->landmarks_score.size() < 17 ||
+        persons[i]->landmarks_x.size() < 17 ||
+        persons[i]->landmarks_y.size() < 17) {
+      LOGE("person keypoints size is less than 17");
+      valid_bits_[slot] = (valid_bits_[slot] << 1) & kValidMask;
+      continue;
+    }
+    bool useful = keypointsUseful(slot, *persons[i]);
+    valid_bits_[slot] = ((valid_bits_[slot] << 1) | useful) & kValidMask;
+    if (valid_bits_[slot] == kValidMask) {
+      ready_.push_back(slot);
+      ready_persons_.push_back(persons[i]);
+      ready_index_.push_back(i);
+    }
   }
-}
-
-int FallDet::detect(const ObjectBoxLandmarkInfo &person_meta, float fps) {
-  int falling = 0;
-  if (keypoints_useful(person_meta)) {
-    update_queue(valid_list, 1);
-
-    if (elem_count(valid_list) == 4) {
-      float human_angle = human_orientation();
-      float aspect_ratio = body_box_calculation(person_meta);
-      float speed = speed_detection(person_meta, fps);
-      int status = action_analysis(human_angle, aspect_ratio, speed);
 
-      int is_fall = status == 2 ? 1 : 0;
+  computeFeatures(fps);
+  for (size_t r = 0; r < ready_.size(); r++) {
+    int slot = ready_[r];
+    bool fast = speeds_[r] > SPEED_THRESHOLD;
+    speed_bits_[slot] = ((speed_bits_[slot] << 1) | fast) & kSpeedMask;
+    bool is_moving = bitCount(speed_bits_[slot]) >= 2;
+
+    int status =
+        actionAnalysis(angles_[r], aspect_ratios_[r], speeds_[r], is_moving);
+    status_bits_[slot] =
+        ((status_bits_[slot] << 1) | (status == 2)) & kStatusMask;
+    falls[ready_index_[r]] = bitCount(status_bits_[slot]) >= 3 ? 1 : 0;
+  }
 
-      if (alert_decision(is_fall)) {
-        falling = 1;
-      }
+  // from the back, so that the track moved into a removed slot is done
+  for (int slot = int(uids_.size()) - 1; slot >= 0; slot--) {
+    if (seen_[slot]) {
+      continue;
+    }
+    unmatched_times_[slot] += 1;
+    if (unmatched_times_[slot] == MAX_UNMATCHED_TIME) {
+      removeTrack(slot);
+    } else {
+      valid_bits_[slot] = (valid_bits_[slot] << 1) & kValidMask;
     }
-  } else {
-    update_queue(valid_list, 0);
   }
-
-  return falling;
 }
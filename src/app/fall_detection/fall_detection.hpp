@@ -4,40 +4,57 @@
 #include "common/model_output_types.hpp"
 
 #include <iostream>
-#include <queue>
+#include <unordered_map>
+#include <vector>
 
-class FallDet {
+// 多目标跌倒检测. 每个 track 的状态按槽位以 SoA 方式存放: 颈部/髋部
+// 位置为定长环形历史, 各类计数队列为位掩码; 每帧先收集历史已满的 track,
+// 再对它们批量计算朝向/宽高比/速度特征.
+class FallDetStore {
  public:
-  FallDet(uint64_t id);
-  int detect(const ObjectBoxLandmarkInfo& person_meta, float fps);
-  void update_queue(std::queue<int>& q, int val);
-  std::queue<int> valid_list;
+  FallDetStore();
+
+  // persons[i] 为 track uids[i] 当前帧的关键点, falls[i] 输出是否跌倒;
+  // 不在 uids 中的 track 累计丢失帧数, 达到 MAX_UNMATCHED_TIME 后移除
+  void detect(const std::vector<uint64_t>& uids,
+              const std::vector<const ObjectBoxLandmarkInfo*>& persons,
+              float fps, std::vector<int>& falls);
+  size_t size() const { return uids_.size(); }
 
-  uint64_t uid;
-  int unmatched_times = 0;
   int MAX_UNMATCHED_TIME = 30;
 
  private:
-  void get_kps(std::vector<std::pair<float, float>>& val_list, int index,
-               float* x, float* y);
-  float human_orientation();
-  bool keypoints_useful(const ObjectBoxLandmarkInfo& person_meta);
-  float body_box_calculation(const ObjectBoxLandmarkInfo& person_meta);
-  float speed_detection(const ObjectBoxLandmarkInfo& person_meta, float fps);
-  int elem_count(std::queue<int>& q);
-
-  int action_analysis(float human_angle, float aspect_ratio,
-                      float moving_speed);
-  bool alert_decision(int status);
-
-  std::vector<std::pair<float, float>> history_neck;
-  std::vector<std::pair<float, float>> history_hip;
-  std::queue<int> speed_caches;
-  std::queue<int> statuses_cache;
-
-  bool is_moving;
-  float SPEED_THRESHOLD = 95.0;
+  static constexpr int kHistorySize = 4;  // FRAME_GAP + 3
+
+  int addTrack(uint64_t uid);
+  void removeTrack(int slot);
+  // push neck/hip of the person, false if the torso keypoints are not reliable
+  bool keypointsUseful(int slot, const ObjectBoxLandmarkInfo& person_meta);
+  // human angle, aspect ratio and speed of every ready track
+  void computeFeatures(float fps);
+  int actionAnalysis(float human_angle, float aspect_ratio, float moving_speed,
+                     bool is_moving) const;
+
+  std::vector<uint64_t> uids_;
+  std::unordered_map<uint64_t, int> slot_index_;
+  std::vector<int> unmatched_times_;
+  std::vector<uint8_t> seen_;
+  // 最近 4/3/6 帧的有效/速度/跌倒标记, 最低位为最新帧
+  std::vector<uint8_t> valid_bits_;
+  std::vector<uint8_t> speed_bits_;
+  std::vector<uint8_t> status_bits_;
+  // 环形历史: 槽位 t 第 f 帧位于 t * kHistorySize + f
+  std::vector<float> neck_x_, neck_y_, hip_x_, hip_y_;
+  std::vector<int> history_head_;
+
+  // 本帧历史已满的 track 与其特征, 按 ready_ 顺序存放
+  std::vector<int> ready_;
+  std::vector<const ObjectBoxLandmarkInfo*> ready_persons_;
+  std::vector<size_t> ready_index_;  // index into uids of detect
+  std::vector<float> angles_, aspect_ratios_, speeds_;
+  std::vector<float> limb_sums_, limb_counts_;
 
+  float SPEED_THRESHOLD = 95.0;
   float HUMAN_ANGLE_THRESHOLD = 25.0;
   float ASPECT_RATIO_THRESHOLD = 0.6;
 };
@@ -5,13 +5,22 @@
 #include "components/video_decoder/video_decoder_type.hpp"
 #include "utils/tdl_log.hpp"
 
+namespace {
+// node data slots of the frame info, interned once at load time
+const int kImageSlot = PipelineFrameInfo::getSlotIndex("image");
+const int kPersonBoxesKeypointsMetaSlot =
+    PipelineFrameInfo::getSlotIndex("person_boxes_keypoints_meta");
+const int kTrackResultsSlot = PipelineFrameInfo::getSlotIndex("track_results");
+}  // namespace
+
 template <typename T>
-T getNodeData(const std::string &node_name, PtrFrameInfo &frame_info) {
-  if (frame_info->node_data_.find(node_name) == frame_info->node_data_.end()) {
-    printf("node %s not found\n", node_name.c_str());
+T getNodeData(int slot, PtrFrameInfo &frame_info) {
+  if (!frame_info->node_data_.contains(slot)) {
+    printf("node data slot %d not found\n", slot);
     assert(false);
   }
-  return frame_info->node_data_[node_name].get<T>();
+  // the frame is done after getResult, move the value out instead of copying
+  return frame_info->node_data_.take<T>(slot);
 }
 
 FallDetectionApp::FallDetectionApp(const std::string &task_name,
@@ -76,14 +85,7 @@ int32_t FallDetectionApp::addPipeline(const std::string &pipeline_name,
   auto lambda_clear_func = [](PtrFrameInfo &frame_info) {
     frame_info->frame_id_ = 0;
 
-    auto iter = frame_info->node_data_.begin();
-    while (iter != frame_info->node_data_.end()) {
-      if (iter->first != "image") {
-        iter = frame_info->node_data_.erase(iter);
-      } else {
-        iter++;
-      }
-    }
+    frame_info->node_data_.clear(kImageSlot);
   };
   fall_detection_channel->setClearFrameFunc(lambda_clear_func);
   LOGI("add pipeline %s", pipeline_name.c_str());
@@ -136,7 +138,7 @@ std::shared_ptr<PipelineNode> FallDetectionApp::getVideoNode(
       std::cout << "video_decoder read failed" << std::endl;
       // assert(false);
     }
-    frame_info->node_data_["image"] = Packet::make(image);
+    frame_info->node_data_.set(kImageSlot, std::move(image));
     frame_info->frame_id_ = video_decoder->getFrameId();
     return 0;
   };
@@ -165,7 +167,7 @@ std::shared_ptr<PipelineNode> FallDetectionApp::getKeypointDetectionNode(
     std::shared_ptr<BaseModel> keypoint_detection_model =
         packet.get<std::shared_ptr<BaseModel>>();
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -178,8 +180,8 @@ std::shared_ptr<PipelineNode> FallDetectionApp::getKeypointDetectionNode(
     }
     std::shared_ptr<ModelBoxLandmarkInfo> keypointmeta =
         std::dynamic_pointer_cast<ModelBoxLandmarkInfo>(out_data);
-    frame_info->node_data_["person_boxes_keypoints_meta"] =
-        Packet::make(keypointmeta->box_landmarks);
+    frame_info->node_data_.set(kPersonBoxesKeypointsMetaSlot,
+                               std::move(keypointmeta->box_landmarks));
     return 0;
   };
   keypoint_detection_node->setProcessFunc(lambda_func);
@@ -202,7 +204,7 @@ std::shared_ptr<PipelineNode> FallDetectionApp::getTrackNode(
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -210,8 +212,8 @@ std::shared_ptr<PipelineNode> FallDetectionApp::getTrackNode(
     std::shared_ptr<Tracker> tracker = packet.get<std::shared_ptr<Tracker>>();
     tracker->setImgSize(image->getWidth(), image->getHeight());
     const std::vector<ObjectBoxLandmarkInfo> &person_infos =
-        frame_info->node_data_["person_boxes_keypoints_meta"]
-            .get<std::vector<ObjectBoxLandmarkInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectBoxLandmarkInfo>>(
+            kPersonBoxesKeypointsMetaSlot);
 
     std::vector<ObjectBoxInfo> bbox_infos;
     for (auto &person_info : person_infos) {
@@ -224,7 +226,7 @@ std::shared_ptr<PipelineNode> FallDetectionApp::getTrackNode(
 
     std::vector<TrackerInfo> track_results;
     tracker->track(bbox_infos, frame_info->frame_id_, track_results);
-    frame_info->node_data_["track_results"] = Packet::make(track_results);
+    frame_info->node_data_.set(kTrackResultsSlot, std::move(track_results));
     return 0;
   };
   track_node->setProcessFunc(lambda_func);
@@ -237,49 +239,18 @@ int32_t FallDetectionApp::detect(
     std::vector<TrackerInfo> &track_results,
     std::map<uint64_t, int> &det_results) {
   det_results.clear();
-  std::map<uint64_t, int> track_index;
-  std::vector<int> new_index;
-
-  for (size_t i = 0; i < track_results.size(); i++) {
-    TrackerInfo &t = track_results[i];
-
+  std::vector<uint64_t> uids;
+  std::vector<const ObjectBoxLandmarkInfo *> persons;
+  for (const TrackerInfo &t : track_results) {
     if (t.obj_idx_ != -1) {
-      uint64_t track_id = t.track_id_;
-
-      if (t.status_ == TrackStatus::NEW) {
-        new_index.push_back(i);
-      } else {
-        track_index[track_id] = t.obj_idx_;
-      }
-    }
-  }
-
-  for (auto it = muti_person.begin(); it != muti_person.end();) {
-    if (track_index.count(it->uid) == 0) {
-      it->unmatched_times += 1;
-
-      if (it->unmatched_times == it->MAX_UNMATCHED_TIME) {
-        it = muti_person.erase(it);
-      } else {
-        it->update_queue(it->valid_list, 0);
-        it++;
-      }
-
-    } else {
-      det_results[it->uid] =
-          it->detect(person_infos[track_index[it->uid]], FPS);
-      it->unmatched_times = 0;
-      it++;
+      uids.push_back(t.track_id_);
+      persons.push_back(&person_infos[t.obj_idx_]);
     }
   }
-
-  for (uint32_t i = 0; i < new_index.size(); i++) {
-    FallDet person(track_results[new_index[i]].track_id_);
-
-    det_results[person.uid] =
-        person.detect(person_infos[track_results[new_index[i]].obj_idx_], FPS);
-
-    muti_person.push_back(person);
+  std::vector<int> falls;
+  fall_det_store_.detect(uids, persons, FPS, falls);
+  for (size_t i = 0; i < uids.size(); i++) {
+    det_results[uids[i]] = falls[i];
   }
 
   return 0;
@@ -293,7 +264,7 @@ int32_t FallDetectionApp::getResult(const std::string &pipeline_name,
       pipeline_channels_[pipeline_name]->getProcessedFrame(0);
 
   auto image =
-      frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+      frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
   if (image == nullptr) {
     std::cout << "image is nullptr" << std::endl;
     return -1;
@@ -304,17 +275,16 @@ int32_t FallDetectionApp::getResult(const std::string &pipeline_name,
   fall_detection_result->frame_height = image->getHeight();
   fall_detection_result->person_boxes_keypoints =
       getNodeData<std::vector<ObjectBoxLandmarkInfo>>(
-          "person_boxes_keypoints_meta", frame_info);
+          kPersonBoxesKeypointsMetaSlot, frame_info);
   fall_detection_result->track_results =
-      getNodeData<std::vector<TrackerInfo>>("track_results", frame_info);
+      getNodeData<std::vector<TrackerInfo>>(kTrackResultsSlot, frame_info);
 
   detect(fall_detection_result->person_boxes_keypoints,
          fall_detection_result->track_results,
          fall_detection_result->det_results);
 
-  if (getChannelNodeName(pipeline_name, 0) == "video_node") {
-    pipeline_channels_[pipeline_name]->addFreeFrame(std::move(frame_info));
-  }
+  // external frames are recycled too, so that setFrame reuses the slots
+  pipeline_channels_[pipeline_name]->addFreeFrame(std::move(frame_info));
   result = Packet::make(fall_detection_result);
   return 0;
 }
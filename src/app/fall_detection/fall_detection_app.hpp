@@ -35,7 +35,7 @@ class FallDetectionApp : public AppTask {
   std::map<std::string, std::shared_ptr<BaseModel>> model_map_;
 
   NodeFactory node_factory_;
-  std::vector<FallDet> muti_person;
+  FallDetStore fall_det_store_;
   float FPS = 21.0;
 };
 
@@ -1,235 +1,247 @@
 #include "human_pose_smooth.hpp"
 #include <algorithm>
 #include <cmath>
-
-std::pair<float, float> operator+(const std::pair<float, float>& p1,
-                                  const std::pair<float, float>& p2) {
-  return {p1.first + p2.first, p1.second + p2.second};
-}
-
-std::pair<float, float> operator+(const std::pair<float, float>& p, float num) {
-  return {p.first + num, p.second + num};
-}
-
-std::pair<float, float> operator-(float minuend,
-                                  const std::pair<float, float>& p) {
-  return {minuend - p.first, minuend - p.second};
-}
-
-std::pair<float, float> operator-(const std::pair<float, float>& p1,
-                                  const std::pair<float, float>& p2) {
-  return {p1.first - p2.first, p1.second - p2.second};
-}
-
-std::pair<float, float> operator*(const std::pair<float, float>& p,
-                                  float scalar) {
-  return {p.first * scalar, p.second * scalar};
-}
-
-std::pair<float, float> operator*(const std::pair<float, float>& p1,
-                                  const std::pair<float, float>& p2) {
-  return {p1.first * p2.first, p1.second * p2.second};
-}
-
-std::pair<float, float> operator/(const std::pair<float, float>& p1,
-                                  const std::pair<float, float>& p2) {
-  if (p2.first == 0.0f || p2.second == 0.0f) {
-    throw std::invalid_argument("Division by zero is not allowed.");
+#include <cstring>
+
+PoseSmoothStore::PoseSmoothStore(const SmoothAlgParam &smooth_param)
+    : param_(smooth_param) {
+  history_size_ = std::max(param_.smooth_frames, 1);
+  float r = 2 * M_PI * param_.fc_d * param_.te;
+  alpha_ = r / (r + 1.0f);
+
+  // weights of n history frames, the newest frame gets the largest weight
+  weights_.resize(history_size_ + 1);
+  for (int n = 2; n <= history_size_; n++) {
+    float a1 = 1.0f / (2.0f * n);
+    float d = 1.0f / (float)(n * (n - 1));
+    for (int i = 0; i < n; i++) {
+      weights_[n].push_back(a1 + i * d);
+    }
   }
-  return {p1.first / p2.first, p1.second / p2.second};
 }
 
-std::pair<float, float> operator/(const std::pair<float, float>& p,
-                                  float divisor) {
-  if (divisor == 0.0f) {
-    throw std::invalid_argument("Division by zero is not allowed.");
+void PoseSmoothStore::setImageSize(uint32_t image_width,
+                                   uint32_t image_height) {
+  param_.image_width = image_width;
+  param_.image_height = image_height;
+}
+
+int PoseSmoothStore::addTrack(uint64_t uid) {
+  int slot = uids_.size();
+  uids_.push_back(uid);
+  slot_index_[uid] = slot;
+  unmatched_times_.push_back(0);
+  seen_.push_back(0);
+
+  size_t size = uids_.size() * kNumKeypoints;
+  matched_.resize(size, 0);
+  cur_x_.resize(size, 0.0f);
+  cur_y_.resize(size, 0.0f);
+  x_prev_hat_.resize(size, 0.0f);
+  y_prev_hat_.resize(size, 0.0f);
+  dx_prev_hat_.resize(size, 0.0f);
+  dy_prev_hat_.resize(size, 0.0f);
+  for (int k = 0; k < kNumKeypoints; k++) {
+    keypoint_thres_.push_back((k < 5 ? 0.005 : 0.01) * param_.thres_mult);
+  }
+  history_x_.resize(size * history_size_, 0.0f);
+  history_y_.resize(size * history_size_, 0.0f);
+  history_head_.push_back(history_size_ - 1);
+  history_count_.push_back(0);
+  return slot;
+}
+
+void PoseSmoothStore::removeTrack(int slot) {
+  int last = uids_.size() - 1;
+  slot_index_.erase(uids_[slot]);
+  if (slot != last) {
+    // move the last track into the hole, the stores stay dense
+    auto move_rows = [slot, last](std::vector<float> &rows, size_t row_size) {
+      memcpy(rows.data() + slot * row_size, rows.data() + last * row_size,
+             row_size * sizeof(float));
+    };
+    uids_[slot] = uids_[last];
+    slot_index_[uids_[slot]] = slot;
+    unmatched_times_[slot] = unmatched_times_[last];
+    seen_[slot] = seen_[last];
+    move_rows(cur_x_, kNumKeypoints);
+    move_rows(cur_y_, kNumKeypoints);
+    move_rows(x_prev_hat_, kNumKeypoints);
+    move_rows(y_prev_hat_, kNumKeypoints);
+    move_rows(dx_prev_hat_, kNumKeypoints);
+    move_rows(dy_prev_hat_, kNumKeypoints);
+    move_rows(history_x_, kNumKeypoints * history_size_);
+    move_rows(history_y_, kNumKeypoints * history_size_);
+    history_head_[slot] = history_head_[last];
+    history_count_[slot] = history_count_[last];
   }
-  return {p.first / divisor, p.second / divisor};
-}
 
-HumanKeypoints::HumanKeypoints(int id, SmoothAlgParam smooth_param) {
-  uid = id;
-
-  image_width = smooth_param.image_width;
-  image_height = smooth_param.image_height;
-  fc_d = smooth_param.fc_d;
-  fc_min = smooth_param.fc_min;
-  beta = smooth_param.beta;
-  thres_mult = smooth_param.thres_mult;
-  te = smooth_param.te;
-  smooth_frames = smooth_param.smooth_frames;
-  smooth_type = smooth_param.smooth_type;
-
-  if (smooth_type == 0) {
-    weight_list = gen_weights(smooth_frames);
-
-  } else if (smooth_type == 1) {
-    gen_weights();
-    init_alpha();
+  uids_.pop_back();
+  unmatched_times_.pop_back();
+  seen_.pop_back();
+  history_head_.pop_back();
+  history_count_.pop_back();
+  size_t size = uids_.size() * kNumKeypoints;
+  matched_.resize(size);
+  cur_x_.resize(size);
+  cur_y_.resize(size);
+  x_prev_hat_.resize(size);
+  y_prev_hat_.resize(size);
+  dx_prev_hat_.resize(size);
+  dy_prev_hat_.resize(size);
+  keypoint_thres_.resize(size);
+  history_x_.resize(size * history_size_);
+  history_y_.resize(size * history_size_);
+}
+
+void PoseSmoothStore::smooth(
+    const std::vector<uint64_t> &uids,
+    const std::vector<ObjectBoxLandmarkInfo *> &persons) {
+  if (uids.size() != persons.size()) {
+    LOGE("uids size %zu != persons size %zu", uids.size(), persons.size());
+    return;
   }
-}
+  active_.clear();
+  std::fill(matched_.begin(), matched_.end(), 0);
+  std::fill(seen_.begin(), seen_.end(), 0);
+
+  for (size_t i = 0; i < uids.size(); i++) {
+    ObjectBoxLandmarkInfo *person = persons[i];
+    auto it = slot_index_.find(uids[i]);
+    int slot = it == slot_index_.end() ? addTrack(uids[i]) : it->second;
+    seen_[slot] = 1;
+    unmatched_times_[slot] = 0;
+    if (person->landmarks_x.size() != kNumKeypoints ||
+        person->landmarks_y.size() != kNumKeypoints) {
+      LOGE("landmarks_x or landmarks_y size is not 17");
+      continue;
+    }
 
-void HumanKeypoints::gen_weights() {
-  for (int i = 0; i < 17; i++) {
-    if (i < 5) {
-      weight_list.push_back(0.005 * thres_mult);
+    size_t offset = size_t(slot) * kNumKeypoints;
+    if (param_.smooth_type == 0) {
+      int head = (history_head_[slot] + 1) % history_size_;
+      size_t frame = (size_t(slot) * history_size_ + head) * kNumKeypoints;
+      memcpy(&history_x_[frame], person->landmarks_x.data(),
+             kNumKeypoints * sizeof(float));
+      memcpy(&history_y_[frame], person->landmarks_y.data(),
+             kNumKeypoints * sizeof(float));
+      history_head_[slot] = head;
+      history_count_[slot] =
+          std::min(history_count_[slot] + 1, history_size_);
+      active_.emplace_back(slot, person);
+    } else if (history_count_[slot] == 0) {
+      // the first frame only initializes the filter
+      memcpy(&x_prev_hat_[offset], person->landmarks_x.data(),
+             kNumKeypoints * sizeof(float));
+      memcpy(&y_prev_hat_[offset], person->landmarks_y.data(),
+             kNumKeypoints * sizeof(float));
+      history_count_[slot] = 1;
     } else {
-      weight_list.push_back(0.01 * thres_mult);
+      memcpy(&cur_x_[offset], person->landmarks_x.data(),
+             kNumKeypoints * sizeof(float));
+      memcpy(&cur_y_[offset], person->landmarks_y.data(),
+             kNumKeypoints * sizeof(float));
+      memset(&matched_[offset], 1, kNumKeypoints);
+      active_.emplace_back(slot, person);
     }
   }
-}
-
-std::vector<float> HumanKeypoints::gen_weights(int n) {
-  float a1 = 1.0f / (2.0f * n);
-  float d = 1.0f / (float)(n * (n - 1));
-
-  std::vector<float> weights;
-  for (int i = 0; i < n; i++) {
-    weights.push_back(a1 + i * d);
-    // weights.push_back(1.0f/(float)n);
-  }
-  return weights;
-}
-
-void HumanKeypoints::init_alpha() {
-  float r = 2 * M_PI * fc_d * te;
-  alpha = r / (r + 1.0f);
-}
-
-std::pair<float, float> HumanKeypoints::abs_pair(std::pair<float, float> pair) {
-  float first = pair.first > 0 ? pair.first : -pair.first;
-  float second = pair.second > 0 ? pair.second : -pair.second;
-  return std::make_pair(first, second);
-}
-
-std::pair<float, float> HumanKeypoints::smoothing_factor(
-    std::pair<float, float> fc_pair) {
-  std::pair<float, float> r = fc_pair * 2.0f * M_PI * te;
-  return r / (r + 1.0f);
-}
-
-std::pair<float, float> HumanKeypoints::exponential_smoothing(
-    std::pair<float, float> x_cur, std::pair<float, float> x_pre,
-    bool use_pair) {
-  if (use_pair) {
-    return x_cur * alpha_pair + x_pre * (1.0f - alpha_pair);
-  } else {
-    return x_cur * alpha + x_pre * (1.0f - alpha);
-  }
-}
-
-std::pair<float, float> HumanKeypoints::smooth(
-    std::pair<float, float> current_keypoint, float threshold, int index) {
-  float deta_x =
-      (current_keypoint.first - x_prev_hat[index].first) / (float)image_width;
-  float deta_y = (current_keypoint.second - x_prev_hat[index].second) /
-                 (float)image_height;
-
-  float distance = pow(deta_x * deta_x + deta_y * deta_y, 0.5);
 
-  // printf("index:%d, distance: %f, threshold: %f, image_width:%d,
-  // image_height:%d \n", index, distance, threshold, image_width,image_height
-  // );
-
-  std::pair<float, float> result;
-  if (distance < threshold) {
-    result = x_prev_hat[index];
+  if (param_.smooth_type == 0) {
+    weightAddPass();
   } else {
-    result = one_euro_filter(current_keypoint, x_prev_hat[index], index);
-  }
-
-  // printf("result: %f, %f\n", result.first, result.second);
-
-  return result;
-}
-
-void HumanKeypoints::smooth_keypoints(ObjectBoxLandmarkInfo* kps_meta) {
-  if (kps_meta->landmarks_x.size() != 17 ||
-      kps_meta->landmarks_y.size() != 17) {
-    LOGE("landmarks_x or landmarks_y size is not 17");
-    return;
-  }
-  if (smooth_type == 0) {
-    weight_add(kps_meta);
-    return;
+    oneEuroPass();
+    for (auto &active : active_) {
+      size_t offset = size_t(active.first) * kNumKeypoints;
+      memcpy(active.second->landmarks_x.data(), &x_prev_hat_[offset],
+             kNumKeypoints * sizeof(float));
+      memcpy(active.second->landmarks_y.data(), &y_prev_hat_[offset],
+             kNumKeypoints * sizeof(float));
+    }
   }
 
-  if (first_time) {
-    for (int i = 0; i < 17; i++) {
-      x_prev_hat[i] =
-          std::make_pair(kps_meta->landmarks_x[i], kps_meta->landmarks_y[i]);
+  // from the back, so that the track moved into a removed slot is done
+  for (int slot = int(uids_.size()) - 1; slot >= 0; slot--) {
+    if (seen_[slot]) {
+      continue;
     }
-    first_time = false;
-  } else {
-    for (int i = 0; i < 17; i++) {
-      std::pair<float, float> cur_keypoint =
-          std::make_pair(kps_meta->landmarks_x[i], kps_meta->landmarks_y[i]);
-      std::pair<float, float> smooth_keypoint =
-          smooth(cur_keypoint, weight_list[i], i);
-
-      kps_meta->landmarks_x[i] = smooth_keypoint.first;
-      kps_meta->landmarks_y[i] = smooth_keypoint.second;
+    unmatched_times_[slot] += 1;
+    if (unmatched_times_[slot] == MAX_UNMATCHED_TIME) {
+      removeTrack(slot);
     }
   }
 }
 
-void HumanKeypoints::weight_add(ObjectBoxLandmarkInfo* kps_meta) {
-  ObjectBoxLandmarkInfo kps = *kps_meta;
-
-  history_keypoints.push_back(kps);
-  size_t q_size = history_keypoints.size();
-
-  if (q_size < 2) {
-    return;
-  } else if ((int)q_size > smooth_frames) {
-    history_keypoints.pop_front();
-  }
-
-  q_size = history_keypoints.size();
-
-  std::vector<float> dst_weights;
-
-  if ((int)q_size < smooth_frames) {
-    dst_weights = gen_weights(q_size);
-  } else {
-    dst_weights = weight_list;
+void PoseSmoothStore::oneEuroPass() {
+  const size_t size = uids_.size() * kNumKeypoints;
+  const float alpha = alpha_;
+  const float te = param_.te;
+  const float beta = param_.beta;
+  const float fc_min = param_.fc_min;
+  const float width = (float)param_.image_width;
+  const float height = (float)param_.image_height;
+  const uint8_t *matched = matched_.data();
+  const float *thres = keypoint_thres_.data();
+  const float *cur_x = cur_x_.data();
+  const float *cur_y = cur_y_.data();
+  float *x_prev = x_prev_hat_.data();
+  float *y_prev = y_prev_hat_.data();
+  float *dx_prev = dx_prev_hat_.data();
+  float *dy_prev = dy_prev_hat_.data();
+
+  // branch free so that the loop runs over all tracks at once; keypoints
+  // that move less than their threshold (or are not matched) keep the state
+  for (size_t i = 0; i < size; i++) {
+    float x = cur_x[i];
+    float y = cur_y[i];
+    float deta_x = (x - x_prev[i]) / width;
+    float deta_y = (y - y_prev[i]) / height;
+    float distance = std::sqrt(deta_x * deta_x + deta_y * deta_y);
+    bool update = matched[i] != 0 && !(distance < thres[i]);
+
+    float dx_hat =
+        (x - x_prev[i]) / te * alpha + dx_prev[i] * (1.0f - alpha);
+    float dy_hat =
+        (y - y_prev[i]) / te * alpha + dy_prev[i] * (1.0f - alpha);
+    float rx = (std::fabs(dx_hat) * beta + fc_min) * 2.0f * (float)M_PI * te;
+    float ry = (std::fabs(dy_hat) * beta + fc_min) * 2.0f * (float)M_PI * te;
+    float ax = rx / (rx + 1.0f);
+    float ay = ry / (ry + 1.0f);
+    float x_hat = x * ax + x_prev[i] * (1.0f - ax);
+    float y_hat = y * ay + y_prev[i] * (1.0f - ay);
+
+    x_prev[i] = update ? x_hat : x_prev[i];
+    y_prev[i] = update ? y_hat : y_prev[i];
+    dx_prev[i] = update ? dx_hat : dx_prev[i];
+    dy_prev[i] = update ? dy_hat : dy_prev[i];
   }
+}
 
-  for (size_t i = 0; i < q_size; ++i) {
-    for (size_t j = 0; j < 17; ++j) {
-      if (i == 0) {
-        kps_meta->landmarks_x[j] =
-            history_keypoints[i].landmarks_x[j] * dst_weights[i];
-        kps_meta->landmarks_y[j] =
-            history_keypoints[i].landmarks_y[j] * dst_weights[i];
-      } else {
-        kps_meta->landmarks_x[j] +=
-            history_keypoints[i].landmarks_x[j] * dst_weights[i];
-        kps_meta->landmarks_y[j] +=
-            history_keypoints[i].landmarks_y[j] * dst_weights[i];
+void PoseSmoothStore::weightAddPass() {
+  float sum_x[kNumKeypoints];
+  float sum_y[kNumKeypoints];
+  for (auto &active : active_) {
+    int slot = active.first;
+    int count = history_count_[slot];
+    if (count < 2) {
+      continue;
+    }
+    const std::vector<float> &weights = weights_[count];
+    int oldest = history_head_[slot] - count + 1 + history_size_;
+    std::fill(sum_x, sum_x + kNumKeypoints, 0.0f);
+    std::fill(sum_y, sum_y + kNumKeypoints, 0.0f);
+    for (int i = 0; i < count; i++) {
+      size_t frame =
+          (size_t(slot) * history_size_ + (oldest + i) % history_size_) *
+          kNumKeypoints;
+      const float *hx = &history_x_[frame];
+      const float *hy = &history_y_[frame];
+      float w = weights[i];
+      for (int k = 0; k < kNumKeypoints; k++) {
+        sum_x[k] += hx[k] * w;
+        sum_y[k] += hy[k] * w;
       }
     }
+    memcpy(active.second->landmarks_x.data(), sum_x, sizeof(sum_x));
+    memcpy(active.second->landmarks_y.data(), sum_y, sizeof(sum_y));
   }
 }
-
-std::pair<float, float> HumanKeypoints::one_euro_filter(
-    std::pair<float, float> x_cur, std::pair<float, float> x_pre, int index) {
-  std::pair<float, float> dx_cur = (x_cur - x_pre) / te;
-  std::pair<float, float> dx_cur_hat =
-      exponential_smoothing(dx_cur, dx_prev_hat[index], false);
-
-  // printf("dx_cur: %f, %f\n", dx_cur.first, dx_cur.second);
-  // printf("dx_cur_hat: %f, %f\n", dx_cur_hat.first, dx_cur_hat.second);
-
-  std::pair<float, float> fc = abs_pair(dx_cur_hat) * beta + fc_min;
-
-  alpha_pair = smoothing_factor(fc);
-  // printf("alpha_pair: %f, %f\n", alpha_pair.first, alpha_pair.second);
-
-  std::pair<float, float> x_cur_hat = exponential_smoothing(x_cur, x_pre, true);
-  // printf("x_cur_hat: %f, %f\n", x_cur_hat.first, x_cur_hat.second);
-
-  dx_prev_hat[index] = dx_cur_hat;
-  x_prev_hat[index] = x_cur_hat;
-  return x_cur_hat;
-}
@@ -1,7 +1,7 @@
 #pragma once
 
-#include <deque>
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 #include "nn/tdl_model_factory.hpp"
 #include "utils/tdl_log.hpp"
@@ -19,50 +19,53 @@ typedef struct {
   int smooth_type = 1;
 } SmoothAlgParam;
 
-class HumanKeypoints {
+// 多目标关键点平滑 (smooth_type 0: 历史帧加权平均, 1: OneEuro 滤波).
+// 所有 track 的状态按槽位以 SoA 方式连续存放, 历史帧为定长环形缓存,
+// 每帧对全部 track 的全部关键点做一次批量计算.
+class PoseSmoothStore {
  public:
-  HumanKeypoints(int id, SmoothAlgParam smooth_param);
-  void init_alpha();
-  std::pair<float, float> abs_pair(std::pair<float, float> pair);
-  std::pair<float, float> smoothing_factor(std::pair<float, float> fc_pair);
-  std::pair<float, float> exponential_smoothing(std::pair<float, float> x_cur,
-                                                std::pair<float, float> x_pre,
-                                                bool use_pair);
-  std::pair<float, float> one_euro_filter(std::pair<float, float> x_cur,
-                                          std::pair<float, float> x_pre,
-                                          int index);
-  std::pair<float, float> smooth(std::pair<float, float> current_keypoint,
-                                 float threshold, int index);
-  void smooth_keypoints(ObjectBoxLandmarkInfo* kps_meta);
-  void weight_add(ObjectBoxLandmarkInfo* kps_meta);
+  static constexpr int kNumKeypoints = 17;
+
+  explicit PoseSmoothStore(const SmoothAlgParam &smooth_param);
+  void setImageSize(uint32_t image_width, uint32_t image_height);
+
+  // persons[i] 为 track uids[i] 当前帧的关键点, 原地平滑;
+  // 不在 uids 中的 track 累计丢失帧数, 达到 MAX_UNMATCHED_TIME 后移除
+  void smooth(const std::vector<uint64_t> &uids,
+              const std::vector<ObjectBoxLandmarkInfo *> &persons);
+  size_t size() const { return uids_.size(); }
 
-  uint64_t uid;
   int MAX_UNMATCHED_TIME = 30;
-  int unmatched_times = 0;
 
  private:
-  std::vector<float> weight_list;
+  int addTrack(uint64_t uid);
+  void removeTrack(int slot);
+  void oneEuroPass();
+  void weightAddPass();
 
-  // Weight add
-  std::vector<float> gen_weights(int n);
-  std::deque<ObjectBoxLandmarkInfo> history_keypoints;
+  SmoothAlgParam param_;
+  int history_size_;
+  float alpha_;
+  // 每个关键点的静止阈值, 按槽位展开以便整段计算
+  std::vector<float> keypoint_thres_;
+  // weights_[n]: 历史帧数为 n 时的加权系数, 旧帧在前
+  std::vector<std::vector<float>> weights_;
 
-  // OneEuro filter
-  void gen_weights();
-  std::vector<std::pair<float, float>> dx_prev_hat =
-      std::vector<std::pair<float, float>>(17, std::make_pair(0.0f, 0.0f));
-  std::vector<std::pair<float, float>> x_prev_hat =
-      std::vector<std::pair<float, float>>(17, std::make_pair(0.0f, 0.0f));
-  uint32_t image_width;
-  uint32_t image_height;
-  int smooth_frames = 5;
-  int smooth_type;
-  float alpha;
-  float fc_d;
-  float fc_min;
-  float beta;
-  float thres_mult;
-  float te;
-  std::pair<float, float> alpha_pair;
-  bool first_time = true;
-};
\ No newline at end of file
+  // track 状态, 槽位 t 的关键点 k 位于 t * kNumKeypoints + k
+  std::vector<uint64_t> uids_;
+  std::unordered_map<uint64_t, int> slot_index_;
+  std::vector<int> unmatched_times_;
+  std::vector<uint8_t> seen_;     // 本帧出现的 track
+  std::vector<uint8_t> matched_;  // 本帧参与滤波的关键点
+  std::vector<float> cur_x_, cur_y_;
+  std::vector<float> x_prev_hat_, y_prev_hat_;
+  std::vector<float> dx_prev_hat_, dy_prev_hat_;
+  // 加权平均的环形历史: 槽位 t 第 f 帧位于 (t * history_size_ + f) * 17
+  std::vector<float> history_x_, history_y_;
+  std::vector<int> history_head_;
+  // 历史帧数, OneEuro 模式下非 0 表示滤波器已初始化
+  std::vector<int> history_count_;
+
+  // 本帧需要输出的 (槽位, 关键点信息)
+  std::vector<std::pair<int, ObjectBoxLandmarkInfo *>> active_;
+};
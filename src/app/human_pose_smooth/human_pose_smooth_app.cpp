@@ -5,13 +5,22 @@
 #include "components/video_decoder/video_decoder_type.hpp"
 #include "utils/tdl_log.hpp"
 
+namespace {
+// node data slots of the frame info, interned once at load time
+const int kImageSlot = PipelineFrameInfo::getSlotIndex("image");
+const int kPersonBoxesKeypointsMetaSlot =
+    PipelineFrameInfo::getSlotIndex("person_boxes_keypoints_meta");
+const int kTrackResultsSlot = PipelineFrameInfo::getSlotIndex("track_results");
+}  // namespace
+
 template <typename T>
-T getNodeData(const std::string &node_name, PtrFrameInfo &frame_info) {
-  if (frame_info->node_data_.find(node_name) == frame_info->node_data_.end()) {
-    printf("node %s not found\n", node_name.c_str());
+T getNodeData(int slot, PtrFrameInfo &frame_info) {
+  if (!frame_info->node_data_.contains(slot)) {
+    printf("node data slot %d not found\n", slot);
     assert(false);
   }
-  return frame_info->node_data_[node_name].get<T>();
+  // the frame is done after getResult, move the value out instead of copying
+  return frame_info->node_data_.take<T>(slot);
 }
 
 HumanPoseSmoothApp::HumanPoseSmoothApp(const std::string &task_name,
@@ -91,14 +100,7 @@ int32_t HumanPoseSmoothApp::addPipeline(const std::string &pipeline_name,
   auto lambda_clear_func = [](PtrFrameInfo &frame_info) {
     frame_info->frame_id_ = 0;
 
-    auto iter = frame_info->node_data_.begin();
-    while (iter != frame_info->node_data_.end()) {
-      if (iter->first != "image") {
-        iter = frame_info->node_data_.erase(iter);
-      } else {
-        iter++;
-      }
-    }
+    frame_info->node_data_.clear(kImageSlot);
   };
   fall_detection_channel->setClearFrameFunc(lambda_clear_func);
   LOGI("add pipeline %s", pipeline_name.c_str());
@@ -150,7 +152,7 @@ std::shared_ptr<PipelineNode> HumanPoseSmoothApp::getVideoNode(
       std::cout << "video_decoder read failed" << std::endl;
       // assert(false);
     }
-    frame_info->node_data_["image"] = Packet::make(image);
+    frame_info->node_data_.set(kImageSlot, std::move(image));
     frame_info->frame_id_ = video_decoder->getFrameId();
     return 0;
   };
@@ -179,7 +181,7 @@ std::shared_ptr<PipelineNode> HumanPoseSmoothApp::getKeypointDetectionNode(
     std::shared_ptr<BaseModel> keypoint_detection_model =
         packet.get<std::shared_ptr<BaseModel>>();
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -192,8 +194,8 @@ std::shared_ptr<PipelineNode> HumanPoseSmoothApp::getKeypointDetectionNode(
     }
     std::shared_ptr<ModelBoxLandmarkInfo> keypointmeta =
         std::dynamic_pointer_cast<ModelBoxLandmarkInfo>(out_data);
-    frame_info->node_data_["person_boxes_keypoints_meta"] =
-        Packet::make(keypointmeta->box_landmarks);
+    frame_info->node_data_.set(kPersonBoxesKeypointsMetaSlot,
+                               std::move(keypointmeta->box_landmarks));
     return 0;
   };
   keypoint_detection_node->setProcessFunc(lambda_func);
@@ -216,7 +218,7 @@ std::shared_ptr<PipelineNode> HumanPoseSmoothApp::getTrackNode(
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -224,8 +226,8 @@ std::shared_ptr<PipelineNode> HumanPoseSmoothApp::getTrackNode(
     std::shared_ptr<Tracker> tracker = packet.get<std::shared_ptr<Tracker>>();
     tracker->setImgSize(image->getWidth(), image->getHeight());
     const std::vector<ObjectBoxLandmarkInfo> &person_infos =
-        frame_info->node_data_["person_boxes_keypoints_meta"]
-            .get<std::vector<ObjectBoxLandmarkInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectBoxLandmarkInfo>>(
+            kPersonBoxesKeypointsMetaSlot);
 
     std::vector<ObjectBoxInfo> bbox_infos;
     for (auto &person_info : person_infos) {
@@ -238,7 +240,7 @@ std::shared_ptr<PipelineNode> HumanPoseSmoothApp::getTrackNode(
 
     std::vector<TrackerInfo> track_results;
     tracker->track(bbox_infos, frame_info->frame_id_, track_results);
-    frame_info->node_data_["track_results"] = Packet::make(track_results);
+    frame_info->node_data_.set(kTrackResultsSlot, std::move(track_results));
     return 0;
   };
   track_node->setProcessFunc(lambda_func);
@@ -249,47 +251,18 @@ std::shared_ptr<PipelineNode> HumanPoseSmoothApp::getTrackNode(
 int32_t HumanPoseSmoothApp::smooth(
     std::vector<ObjectBoxLandmarkInfo> &person_infos,
     std::vector<TrackerInfo> &track_results) {
-  std::map<uint64_t, int> track_index;
-  std::vector<int> new_index;
-
-  for (size_t i = 0; i < track_results.size(); i++) {
-    TrackerInfo &t = track_results[i];
-
-    if (t.obj_idx_ != -1) {
-      uint64_t track_id = t.track_id_;
-
-      if (t.status_ == TrackStatus::NEW) {
-        new_index.push_back(i);
-      } else {
-        track_index[track_id] = t.obj_idx_;
-      }
-    }
+  if (pose_smooth_store_ == nullptr) {
+    pose_smooth_store_.reset(new PoseSmoothStore(smooth_param_));
   }
-
-  for (auto it = muti_keypoints.begin(); it != muti_keypoints.end();) {
-    if (track_index.count(it->uid) == 0) {
-      it->unmatched_times += 1;
-
-      if (it->unmatched_times == it->MAX_UNMATCHED_TIME) {
-        it = muti_keypoints.erase(it);
-      } else {
-        it++;
-      }
-
-    } else {
-      it->smooth_keypoints(&person_infos[track_index[it->uid]]);
-      it->unmatched_times = 0;
-      it++;
+  std::vector<uint64_t> uids;
+  std::vector<ObjectBoxLandmarkInfo *> persons;
+  for (const TrackerInfo &t : track_results) {
+    if (t.obj_idx_ != -1) {
+      uids.push_back(t.track_id_);
+      persons.push_back(&person_infos[t.obj_idx_]);
     }
   }
-
-  for (uint32_t i = 0; i < new_index.size(); i++) {
-    HumanKeypoints hk(track_results[new_index[i]].track_id_, smooth_param_);
-
-    hk.smooth_keypoints(&person_infos[new_index[i]]);
-
-    muti_keypoints.push_back(hk);
-  }
+  pose_smooth_store_->smooth(uids, persons);
 
   return 0;
 }
@@ -302,7 +275,7 @@ int32_t HumanPoseSmoothApp::getResult(const std::string &pipeline_name,
       pipeline_channels_[pipeline_name]->getProcessedFrame(0);
 
   auto image =
-      frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+      frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
   if (image == nullptr) {
     std::cout << "image is nullptr" << std::endl;
     return -1;
@@ -313,14 +286,18 @@ int32_t HumanPoseSmoothApp::getResult(const std::string &pipeline_name,
   fall_detection_result->frame_height = image->getHeight();
   fall_detection_result->person_boxes_keypoints =
       getNodeData<std::vector<ObjectBoxLandmarkInfo>>(
-          "person_boxes_keypoints_meta", frame_info);
+          kPersonBoxesKeypointsMetaSlot, frame_info);
   fall_detection_result->track_results =
-      getNodeData<std::vector<TrackerInfo>>("track_results", frame_info);
+      getNodeData<std::vector<TrackerInfo>>(kTrackResultsSlot, frame_info);
 
   if (smooth_param_.image_width != image->getWidth() ||
       smooth_param_.image_height != image->getHeight()) {
     smooth_param_.image_width = image->getWidth();
     smooth_param_.image_height = image->getHeight();
+    if (pose_smooth_store_ != nullptr) {
+      pose_smooth_store_->setImageSize(smooth_param_.image_width,
+                                       smooth_param_.image_height);
+    }
   }
 
   if (enable_smooth_) {
@@ -328,9 +305,8 @@ int32_t HumanPoseSmoothApp::getResult(const std::string &pipeline_name,
            fall_detection_result->track_results);
   }
 
-  if (getChannelNodeName(pipeline_name, 0) == "video_node") {
-    pipeline_channels_[pipeline_name]->addFreeFrame(std::move(frame_info));
-  }
+  // external frames are recycled too, so that setFrame reuses the slots
+  pipeline_channels_[pipeline_name]->addFreeFrame(std::move(frame_info));
   result = Packet::make(fall_detection_result);
   return 0;
 }
@@ -35,8 +35,8 @@ class HumanPoseSmoothApp : public AppTask {
   std::map<std::string, std::shared_ptr<BaseModel>> model_map_;
 
   NodeFactory node_factory_;
-  std::vector<HumanKeypoints> muti_keypoints;
   SmoothAlgParam smooth_param_;
+  std::unique_ptr<PoseSmoothStore> pose_smooth_store_;
   bool enable_smooth_ = true;
 };
 
@@ -7,13 +7,24 @@
 #include "components/video_decoder/video_decoder_type.hpp"
 #include "utils/tdl_log.hpp"
 
+namespace {
+// node data slots of the frame info, interned once at load time
+const int kAdasResultsSlot = PipelineFrameInfo::getSlotIndex("adas_results");
+const int kImageSlot = PipelineFrameInfo::getSlotIndex("image");
+const int kLaneMetaSlot = PipelineFrameInfo::getSlotIndex("lane_meta");
+const int kLaneStateSlot = PipelineFrameInfo::getSlotIndex("lane_state");
+const int kObjectMetaSlot = PipelineFrameInfo::getSlotIndex("object_meta");
+const int kTrackResultsSlot = PipelineFrameInfo::getSlotIndex("track_results");
+}  // namespace
+
 template <typename T>
-T getNodeData(const std::string &node_name, PtrFrameInfo &frame_info) {
-  if (frame_info->node_data_.find(node_name) == frame_info->node_data_.end()) {
-    printf("node %s not found\n", node_name.c_str());
+T getNodeData(int slot, PtrFrameInfo &frame_info) {
+  if (!frame_info->node_data_.contains(slot)) {
+    printf("node data slot %d not found\n", slot);
     assert(false);
   }
-  return frame_info->node_data_[node_name].get<T>();
+  // the frame is done after getResult, move the value out instead of copying
+  return frame_info->node_data_.take<T>(slot);
 }
 
 VehicleAdasApp::VehicleAdasApp(const std::string &task_name,
@@ -76,14 +87,7 @@ int32_t VehicleAdasApp::addPipeline(const std::string &pipeline_name,
 
   auto lambda_clear_func = [](PtrFrameInfo &frame_info) {
     frame_info->frame_id_ = 0;
-    auto iter = frame_info->node_data_.begin();
-    while (iter != frame_info->node_data_.end()) {
-      if (iter->first != "image") {
-        iter = frame_info->node_data_.erase(iter);
-      } else {
-        iter++;
-      }
-    }
+    frame_info->node_data_.clear(kImageSlot);
   };
   adas_channel->setClearFrameFunc(lambda_clear_func);
   LOGI("add pipeline %s\n", pipeline_name.c_str());
@@ -102,14 +106,14 @@ int32_t VehicleAdasApp::getResult(const std::string &pipeline_name,
     return 0;
   }
 
-  if (frame_info->node_data_.find("image") == frame_info->node_data_.end()) {
+  if (!frame_info->node_data_.contains(kImageSlot)) {
     LOGE("image node not found in frame_info for pipeline %s\n",
          pipeline_name.c_str());
     result = Packet::make(adas_result);
     return -1;
   }
   auto image =
-      frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+      frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
 
   adas_result->image = image;
   adas_result->frame_id = frame_info->frame_id_;
@@ -121,22 +125,20 @@ int32_t VehicleAdasApp::getResult(const std::string &pipeline_name,
     return -1;
   }
 
-  if (frame_info->node_data_.find("adas_results") !=
-      frame_info->node_data_.end()) {
+  if (frame_info->node_data_.contains(kAdasResultsSlot)) {
     adas_result->objects = getNodeData<std::vector<VehicleAdasObjectResult>>(
-        "adas_results", frame_info);
+        kAdasResultsSlot, frame_info);
   }
 
-  if (frame_info->node_data_.find("lane_state") !=
-      frame_info->node_data_.end()) {
+  if (frame_info->node_data_.contains(kLaneStateSlot)) {
     adas_result->lane_state =
-        getNodeData<VehicleAdasLaneState>("lane_state", frame_info);
+        getNodeData<VehicleAdasLaneState>(kLaneStateSlot, frame_info);
   }
 
-  if (frame_info->node_data_.find("lane_meta") !=
-      frame_info->node_data_.end()) {
-    auto lane_meta = frame_info->node_data_["lane_meta"]
-                         .get<std::shared_ptr<ModelBoxLandmarkInfo>>();
+  if (frame_info->node_data_.contains(kLaneMetaSlot)) {
+    const std::shared_ptr<ModelBoxLandmarkInfo> &lane_meta =
+        frame_info->node_data_.get<std::shared_ptr<ModelBoxLandmarkInfo>>(
+            kLaneMetaSlot);
     if (lane_meta) {
       for (auto &box : lane_meta->box_landmarks) {
         VehicleAdasLaneLine line;
@@ -150,11 +152,10 @@ int32_t VehicleAdasApp::getResult(const std::string &pipeline_name,
   }
 
   adas_result->track_results =
-      getNodeData<std::vector<TrackerInfo>>("track_results", frame_info);
+      getNodeData<std::vector<TrackerInfo>>(kTrackResultsSlot, frame_info);
 
-  if (getChannelNodeName(pipeline_name, 0) == "video_node") {
-    pipeline_channels_[pipeline_name]->addFreeFrame(std::move(frame_info));
-  }
+  // external frames are recycled too, so that setFrame reuses the slots
+  pipeline_channels_[pipeline_name]->addFreeFrame(std::move(frame_info));
   result = Packet::make(adas_result);
   return 0;
 }
@@ -203,10 +204,9 @@ std::shared_ptr<PipelineNode> VehicleAdasApp::getVideoNode(
     std::shared_ptr<BaseImage> image = nullptr;
 
     int ret = video_decoder->read(image);
-    frame_info->node_data_["image"] = Packet::make(image);
-
     if (ret != 0) {
       std::cout << "video_decoder read failed" << std::endl;
+      frame_info->node_data_.set(kImageSlot, std::move(image));
       return -1;
     }
     frame_info->frame_id_ = video_decoder->getFrameId();
@@ -214,6 +214,7 @@ std::shared_ptr<PipelineNode> VehicleAdasApp::getVideoNode(
       frame_info->frame_width = image->getWidth();
       frame_info->frame_height = image->getHeight();
     }
+    frame_info->node_data_.set(kImageSlot, std::move(image));
     return 0;
   };
   video_node->setProcessFunc(lambda_func);
@@ -238,13 +239,13 @@ std::shared_ptr<PipelineNode> VehicleAdasApp::getObjectDetectionNode(
   object_detection_node->setName("object_detection_node");
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
-    if (frame_info->node_data_.find("image") == frame_info->node_data_.end()) {
+    if (!frame_info->node_data_.contains(kImageSlot)) {
       return -1;
     }
     std::shared_ptr<BaseModel> object_detection_model =
         packet.get<std::shared_ptr<BaseModel>>();
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -269,10 +270,9 @@ std::shared_ptr<PipelineNode> VehicleAdasApp::getObjectDetectionNode(
       }
     }
 
-    frame_info->node_data_["object_meta"] = Packet::make(filtered_bboxes);
-
     LOGI("frame id:%" PRIu64 ", detect object size: %zu\n",
          frame_info->frame_id_, filtered_bboxes.size());
+    frame_info->node_data_.set(kObjectMetaSlot, std::move(filtered_bboxes));
 
     return 0;
   };
@@ -295,13 +295,12 @@ std::shared_ptr<PipelineNode> VehicleAdasApp::getTrackNode(
   track_node->setName("track_node");
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
-    if (frame_info->node_data_.find("image") == frame_info->node_data_.end() ||
-        frame_info->node_data_.find("object_meta") ==
-            frame_info->node_data_.end()) {
+    if (!frame_info->node_data_.contains(kImageSlot) ||
+        !frame_info->node_data_.contains(kObjectMetaSlot)) {
       return -1;
     }
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -309,14 +308,13 @@ std::shared_ptr<PipelineNode> VehicleAdasApp::getTrackNode(
     std::shared_ptr<Tracker> tracker = packet.get<std::shared_ptr<Tracker>>();
     tracker->setImgSize(image->getWidth(), image->getHeight());
     std::vector<ObjectBoxInfo> object_infos =
-        frame_info->node_data_["object_meta"].get<std::vector<ObjectBoxInfo>>();
+        frame_info->node_data_.get<std::vector<ObjectBoxInfo>>(kObjectMetaSlot);
 
     std::vector<TrackerInfo> track_results;
     tracker->track(object_infos, frame_info->frame_id_, track_results);
-    frame_info->node_data_["track_results"] = Packet::make(track_results);
-
     LOGI("frame id:%" PRIu64 ", track size: %zu\n", frame_info->frame_id_,
          track_results.size());
+    frame_info->node_data_.set(kTrackResultsSlot, std::move(track_results));
 
     return 0;
   };
@@ -340,13 +338,13 @@ std::shared_ptr<PipelineNode> VehicleAdasApp::getLaneDetectionNode(
   lane_detection_node->setName("lane_detection_node");
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
-    if (frame_info->node_data_.find("image") == frame_info->node_data_.end()) {
+    if (!frame_info->node_data_.contains(kImageSlot)) {
       return -1;
     }
     std::shared_ptr<BaseModel> lane_detection_model =
         packet.get<std::shared_ptr<BaseModel>>();
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     if (image == nullptr) {
       std::cout << "image is nullptr" << std::endl;
       return -1;
@@ -362,10 +360,9 @@ std::shared_ptr<PipelineNode> VehicleAdasApp::getLaneDetectionNode(
     std::shared_ptr<ModelBoxLandmarkInfo> lane_meta =
         std::dynamic_pointer_cast<ModelBoxLandmarkInfo>(out_data);
 
-    frame_info->node_data_["lane_meta"] = Packet::make(lane_meta);
-
     LOGI("frame id:%" PRIu64 ", detect lane size: %zu\n", frame_info->frame_id_,
          lane_meta->box_landmarks.size());
+    frame_info->node_data_.set(kLaneMetaSlot, std::move(lane_meta));
 
     return 0;
   };
@@ -393,30 +390,28 @@ std::shared_ptr<PipelineNode> VehicleAdasApp::getAdasNode(
   adas_node->setName("adas_node");
 
   auto lambda_func = [](PtrFrameInfo &frame_info, Packet &packet) -> int32_t {
-    if (frame_info->node_data_.find("image") == frame_info->node_data_.end() ||
-        frame_info->node_data_.find("object_meta") ==
-            frame_info->node_data_.end() ||
-        frame_info->node_data_.find("track_results") ==
-            frame_info->node_data_.end()) {
+    if (!frame_info->node_data_.contains(kImageSlot) ||
+        !frame_info->node_data_.contains(kObjectMetaSlot) ||
+        !frame_info->node_data_.contains(kTrackResultsSlot)) {
       return -1;
     }
 
     auto image =
-        frame_info->node_data_["image"].get<std::shared_ptr<BaseImage>>();
+        frame_info->node_data_.get<std::shared_ptr<BaseImage>>(kImageSlot);
     std::shared_ptr<VehicleAdas> vehicle_adas =
         packet.get<std::shared_ptr<VehicleAdas>>();
 
-    std::vector<ObjectBoxInfo> object_infos =
-        frame_info->node_data_["object_meta"].get<std::vector<ObjectBoxInfo>>();
+    const std::vector<ObjectBoxInfo> &object_infos =
+        frame_info->node_data_.get<std::vector<ObjectBoxInfo>>(kObjectMetaSlot);
 
-    std::vector<TrackerInfo> track_results =
-        frame_info->node_data_["track_results"].get<std::vector<TrackerInfo>>();
+    const std::vector<TrackerInfo> &track_results =
+        frame_info->node_data_.get<std::vector<TrackerInfo>>(kTrackResultsSlot);
 
     std::shared_ptr<ModelBoxLandmarkInfo> lane_meta = nullptr;
-    if (frame_info->node_data_.find("lane_meta") !=
-        frame_info->node_data_.end()) {
-      lane_meta = frame_info->node_data_["lane_meta"]
-                      .get<std::shared_ptr<ModelBoxLandmarkInfo>>();
+    if (frame_info->node_data_.contains(kLaneMetaSlot)) {
+      lane_meta =
+          frame_info->node_data_.get<std::shared_ptr<ModelBoxLandmarkInfo>>(
+              kLaneMetaSlot);
     }
 
     uint32_t frame_width = frame_info->frame_width;
@@ -432,13 +427,11 @@ std::shared_ptr<PipelineNode> VehicleAdasApp::getAdasNode(
     std::vector<VehicleAdasObjectResult> adas_results;
     vehicle_adas->getResults(adas_results);
 
-    frame_info->node_data_["adas_results"] = Packet::make(adas_results);
-    frame_info->node_data_["lane_state"] =
-        Packet::make(vehicle_adas->getLaneState());
-
     LOGI("frame id:%" PRIu64 ", adas results: %zu, lane_state: %d\n",
          frame_info->frame_id_, adas_results.size(),
          vehicle_adas->getLaneState().lane_state);
+    frame_info->node_data_.set(kAdasResultsSlot, std::move(adas_results));
+    frame_info->node_data_.set(kLaneStateSlot, vehicle_adas->getLaneState());
 
     return 0;
   };
@@ -0,0 +1,58 @@
+#ifndef TDL_ASYNC_WORKER_HPP
+#define TDL_ASYNC_WORKER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "tdl_types.h"
+
+// 每个 TDLHandle 对应一个后台推理线程，任务按提交顺序串行执行，
+// 以保证同一个模型实例不会被并发调用
+class TDLAsyncWorker {
+ public:
+  explicit TDLAsyncWorker(size_t max_pending = 16);
+  ~TDLAsyncWorker();
+
+  // 提交任务，队列满时阻塞等待；返回请求ID，失败返回-1
+  int64_t submit(std::function<int32_t()> task, TDLAsyncCallback callback,
+                 void *user_data);
+
+  // 返回0表示任务已完成(ret为任务返回值)，1表示超时未完成，-1表示请求ID无效
+  int32_t poll(int64_t request_id, int32_t timeout_ms, int32_t *ret);
+
+  // 执行完队列中剩余任务后退出线程
+  void stop();
+
+ private:
+  struct AsyncTask {
+    int64_t request_id;
+    std::function<int32_t()> task;
+    TDLAsyncCallback callback;
+    void *user_data;
+  };
+
+  void run();
+
+  size_t max_pending_;
+  bool stop_ = false;
+  int64_t next_request_id_ = 1;
+
+  std::mutex mutex_;
+  std::condition_variable task_cond_;
+  std::condition_variable space_cond_;
+  std::condition_variable done_cond_;
+  std::deque<AsyncTask> tasks_;
+  // 未完成的请求
+  std::unordered_set<int64_t> pending_ids_;
+  // 已完成但还未被poll取走的结果(注册了回调的请求不保存)
+  std::unordered_map<int64_t, int32_t> finished_results_;
+
+  std::thread worker_thread_;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define TDL_TYPE_INTERNAL_HPP
 
 #include <map>
+#include <mutex>
 #include "app/app_task.hpp"
 #include "components/snapshot/object_snapshot.hpp"
 #include "cv/intrusion_detect/intrusion_detect.hpp"
@@ -9,6 +10,7 @@
 #include "encoder/image_encoder/image_encoder.hpp"
 #include "encoder/vi_encoder/vi_encoder.hpp"
 #include "model/base_model.hpp"
+#include "tdl_async_worker.hpp"
 #include "tdl_model_def.h"
 #include "tdl_model_defs.hpp"
 #include "tdl_model_factory.hpp"
@@ -30,6 +32,8 @@ typedef struct {
   std::shared_ptr<Tracker> tracker;
   std::shared_ptr<ModelASRInfo> asr_meta;
   std::shared_ptr<ObjectSnapshot> snapshot_comp;
+  std::shared_ptr<TDLAsyncWorker> async_worker;
+  std::mutex async_mutex;  // 保护 async_worker 的懒创建
 } TDLContext;
 
 typedef struct {
@@ -0,0 +1,102 @@
+#include "tdl_async_worker.hpp"
+
+#include <chrono>
+
+#include "utils/tdl_log.hpp"
+
+TDLAsyncWorker::TDLAsyncWorker(size_t max_pending)
+    : max_pending_(max_pending == 0 ? 1 : max_pending) {
+  worker_thread_ = std::thread(&TDLAsyncWorker::run, this);
+}
+
+TDLAsyncWorker::~TDLAsyncWorker() { stop(); }
+
+int64_t TDLAsyncWorker::submit(std::function<int32_t()> task,
+                               TDLAsyncCallback callback, void *user_data) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  space_cond_.wait(lock,
+                   [this] { return stop_ || tasks_.size() < max_pending_; });
+  if (stop_) {
+    LOGE("async worker has been stopped");
+    return -1;
+  }
+  int64_t request_id = next_request_id_++;
+  tasks_.push_back({request_id, std::move(task), callback, user_data});
+  pending_ids_.insert(request_id);
+  task_cond_.notify_one();
+  return request_id;
+}
+
+int32_t TDLAsyncWorker::poll(int64_t request_id, int32_t timeout_ms,
+                             int32_t *ret) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto is_done = [this, request_id] {
+    return pending_ids_.count(request_id) == 0;
+  };
+  if (!is_done() && timeout_ms != 0) {
+    if (timeout_ms < 0) {
+      done_cond_.wait(lock, is_done);
+    } else {
+      done_cond_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                          is_done);
+    }
+  }
+  if (!is_done()) {
+    return 1;
+  }
+  auto iter = finished_results_.find(request_id);
+  if (iter == finished_results_.end()) {
+    LOGW("request %ld not found", (long)request_id);
+    return -1;
+  }
+  if (ret != nullptr) {
+    *ret = iter->second;
+  }
+  finished_results_.erase(iter);
+  return 0;
+}
+
+void TDLAsyncWorker::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_ && !worker_thread_.joinable()) {
+      return;
+    }
+    stop_ = true;
+  }
+  task_cond_.notify_all();
+  space_cond_.notify_all();
+  if (worker_thread_.joinable()) {
+    worker_thread_.join();
+  }
+}
+
+void TDLAsyncWorker::run() {
+  while (true) {
+    AsyncTask async_task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_cond_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        break;
+      }
+      async_task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    space_cond_.notify_one();
+
+    int32_t ret = async_task.task();
+    if (async_task.callback != nullptr) {
+      async_task.callback(async_task.request_id, ret, async_task.user_data);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_ids_.erase(async_task.request_id);
+      if (async_task.callback == nullptr) {
+        finished_results_[async_task.request_id] = ret;
+      }
+    }
+    done_cond_.notify_all();
+  }
+}
@@ -41,6 +41,10 @@ int32_t TDL_DestroyHandle(TDLHandle handle) {
   if (context == nullptr) {
     return -1;
   }
+  if (context->async_worker) {
+    context->async_worker->stop();
+    context->async_worker.reset();
+  }
   context->models.clear();
   if (context->app_task) {
     context->app_task->release();
@@ -309,23 +313,9 @@ int32_t TDL_CloseModel(TDLHandle handle, const TDLModel model_id) {
   return 0;
 }
 
-int32_t TDL_Detection(TDLHandle handle, const TDLModel model_id,
-                      TDLImage image_handle, TDLObject *object_meta) {
-  std::shared_ptr<BaseModel> model = get_model(handle, model_id);
-  if (model == nullptr) {
-    return -1;
-  }
-  std::vector<std::shared_ptr<BaseImage>> images;
-  TDLImageContext *image_context = (TDLImageContext *)image_handle;
-  images.push_back(image_context->image);
-
-  std::vector<std::shared_ptr<ModelOutputInfo>> outputs;
-  int32_t ret = model->inference(images, outputs);
-  if (ret != 0) {
-    return ret;
-  }
-
-  std::shared_ptr<ModelOutputInfo> output = outputs[0];
+static int32_t fill_object_meta(const std::shared_ptr<ModelOutputInfo> &output,
+                                const std::shared_ptr<BaseImage> &image,
+                                TDLObject *object_meta) {
   if (output->getType() == ModelOutputType::OBJECT_DETECTION_WITH_LANDMARKS) {
     ModelBoxLandmarkInfo *object_Landmark_output =
         (ModelBoxLandmarkInfo *)output.get();
@@ -375,14 +365,14 @@ int32_t TDL_Detection(TDLHandle handle, const TDLModel model_id,
          static_cast<int>(output->getType()));
     return -1;
   }
-  object_meta->width = image_context->image->getWidth();
-  object_meta->height = image_context->image->getHeight();
+  object_meta->width = image->getWidth();
+  object_meta->height = image->getHeight();
 
   return 0;
 }
 
-int32_t TDL_FaceDetection(TDLHandle handle, const TDLModel model_id,
-                          TDLImage image_handle, TDLFace *face_meta) {
+int32_t TDL_Detection(TDLHandle handle, const TDLModel model_id,
+                      TDLImage image_handle, TDLObject *object_meta) {
   std::shared_ptr<BaseModel> model = get_model(handle, model_id);
   if (model == nullptr) {
     return -1;
@@ -390,12 +380,17 @@ int32_t TDL_FaceDetection(TDLHandle handle, const TDLModel model_id,
   std::vector<std::shared_ptr<BaseImage>> images;
   TDLImageContext *image_context = (TDLImageContext *)image_handle;
   images.push_back(image_context->image);
+
   std::vector<std::shared_ptr<ModelOutputInfo>> outputs;
   int32_t ret = model->inference(images, outputs);
   if (ret != 0) {
     return ret;
   }
-  std::shared_ptr<ModelOutputInfo> output = outputs[0];
+  return fill_object_meta(outputs[0], image_context->image, object_meta);
+}
+
+static int32_t fill_face_meta(const std::shared_ptr<ModelOutputInfo> &output,
+                              TDLFace *face_meta) {
   if (output->getType() == ModelOutputType::OBJECT_DETECTION_WITH_LANDMARKS) {
     ModelBoxLandmarkInfo *box_landmark_output =
         (ModelBoxLandmarkInfo *)output.get();
@@ -452,8 +447,8 @@ int32_t TDL_FaceDetection(TDLHandle handle, const TDLModel model_id,
   return 0;
 }
 
-int32_t TDL_Classification(TDLHandle handle, const TDLModel model_id,
-                           TDLImage image_handle, TDLClassInfo *class_info) {
+int32_t TDL_FaceDetection(TDLHandle handle, const TDLModel model_id,
+                          TDLImage image_handle, TDLFace *face_meta) {
   std::shared_ptr<BaseModel> model = get_model(handle, model_id);
   if (model == nullptr) {
     return -1;
@@ -466,7 +461,11 @@ int32_t TDL_Classification(TDLHandle handle, const TDLModel model_id,
   if (ret != 0) {
     return ret;
   }
-  std::shared_ptr<ModelOutputInfo> output = outputs[0];
+  return fill_face_meta(outputs[0], face_meta);
+}
+
+static int32_t fill_class_info(const std::shared_ptr<ModelOutputInfo> &output,
+                               TDLClassInfo *class_info) {
   if (output->getType() == ModelOutputType::CLASSIFICATION) {
     ModelClassificationInfo *classification_output =
         (ModelClassificationInfo *)output.get();
@@ -480,6 +479,23 @@ int32_t TDL_Classification(TDLHandle handle, const TDLModel model_id,
   return 0;
 }
 
+int32_t TDL_Classification(TDLHandle handle, const TDLModel model_id,
+                           TDLImage image_handle, TDLClassInfo *class_info) {
+  std::shared_ptr<BaseModel> model = get_model(handle, model_id);
+  if (model == nullptr) {
+    return -1;
+  }
+  std::vector<std::shared_ptr<BaseImage>> images;
+  TDLImageContext *image_context = (TDLImageContext *)image_handle;
+  images.push_back(image_context->image);
+  std::vector<std::shared_ptr<ModelOutputInfo>> outputs;
+  int32_t ret = model->inference(images, outputs);
+  if (ret != 0) {
+    return ret;
+  }
+  return fill_class_info(outputs[0], class_info);
+}
+
 int32_t TDL_ObjectClassification(TDLHandle handle, const TDLModel model_id,
                                  TDLImage image_handle, TDLObject *object_meta,
                                  TDLClass *class_info) {
@@ -961,21 +977,8 @@ int32_t TDL_InstanceSegmentation(TDLHandle handle, const TDLModel model_id,
   return 0;
 }
 
-int32_t TDL_FeatureExtraction(TDLHandle handle, const TDLModel model_id,
-                              TDLImage image_handle, TDLFeature *feature_meta) {
-  std::shared_ptr<BaseModel> model = get_model(handle, model_id);
-  if (model == nullptr) {
-    return -1;
-  }
-  std::vector<std::shared_ptr<BaseImage>> images;
-  TDLImageContext *image_context = (TDLImageContext *)image_handle;
-  images.push_back(image_context->image);
-  std::vector<std::shared_ptr<ModelOutputInfo>> outputs;
-  int32_t ret = model->inference(images, outputs);
-  if (ret != 0) {
-    return ret;
-  }
-  std::shared_ptr<ModelOutputInfo> output = outputs[0];
+static int32_t fill_feature_meta(const std::shared_ptr<ModelOutputInfo> &output,
+                                 TDLFeature *feature_meta) {
   memset(feature_meta, 0, sizeof(TDLFeature));
   if (output->getType() == ModelOutputType::FEATURE_EMBEDDING) {
     ModelFeatureInfo *feature_output = (ModelFeatureInfo *)output.get();
@@ -993,6 +996,23 @@ int32_t TDL_FeatureExtraction(TDLHandle handle, const TDLModel model_id,
   return 0;
 }
 
+int32_t TDL_FeatureExtraction(TDLHandle handle, const TDLModel model_id,
+                              TDLImage image_handle, TDLFeature *feature_meta) {
+  std::shared_ptr<BaseModel> model = get_model(handle, model_id);
+  if (model == nullptr) {
+    return -1;
+  }
+  std::vector<std::shared_ptr<BaseImage>> images;
+  TDLImageContext *image_context = (TDLImageContext *)image_handle;
+  images.push_back(image_context->image);
+  std::vector<std::shared_ptr<ModelOutputInfo>> outputs;
+  int32_t ret = model->inference(images, outputs);
+  if (ret != 0) {
+    return ret;
+  }
+  return fill_feature_meta(outputs[0], feature_meta);
+}
+
 int32_t TDL_ClipText(TDLHandle handle, const TDLModel model_id,
                      const char *txt_dir, float **feature_out,
                      int *numSentences, int *embedding_num) {
@@ -1565,8 +1585,9 @@ int32_t TDL_DepthStereo(TDLHandle handle, const TDLModel model_id,
   stereo_pair.push_back(right_image_context->image);
   input_images.push_back(stereo_pair);
 
+  // keep the raw output and convert it once into the caller's buffer
   std::vector<std::shared_ptr<ModelOutputInfo>> outputs;
-  int32_t ret = model->inference(input_images, outputs);
+  int32_t ret = model->inference(input_images, outputs, {{"native_output", 1}});
   if (ret != 0) {
     return ret;
   }
@@ -1581,9 +1602,15 @@ int32_t TDL_DepthStereo(TDLHandle handle, const TDLModel model_id,
     ModelDepthInfo *depth_output = (ModelDepthInfo *)output.get();
     depth_logist->w = depth_output->w;
     depth_logist->h = depth_output->h;
-    depth_logist->logits = depth_output->logits;
-    // Transfer ownership to depth_logist
-    depth_output->logits = nullptr;
+    size_t size = size_t(depth_output->w) * depth_output->h * sizeof(float);
+    depth_logist->logits = (float *)malloc(size);
+    if (depth_logist->logits == nullptr ||
+        depth_output->toFloat(depth_logist->logits) != 0) {
+      free(depth_logist->logits);
+      depth_logist->logits = nullptr;
+      LOGE("Failed to convert depth output");
+      return -1;
+    }
   } else {
     LOGE("Unsupported model output type: %d",
          static_cast<int>(output->getType()));
@@ -1663,6 +1690,240 @@ int32_t TDL_SegMotionDetection(TDLHandle handle, const TDLModel model_id,
   return 0;
 }
 
+static int32_t batch_inference(
+    TDLHandle handle, const TDLModel model_id, TDLImage *image_handles,
+    uint32_t num_images, std::vector<std::shared_ptr<BaseImage>> &images,
+    std::vector<std::shared_ptr<ModelOutputInfo>> &outputs) {
+  std::shared_ptr<BaseModel> model = get_model(handle, model_id);
+  if (model == nullptr) {
+    return -1;
+  }
+  if (image_handles == nullptr || num_images == 0) {
+    LOGE("image_handles is null or num_images is 0");
+    return -1;
+  }
+  images.reserve(num_images);
+  for (uint32_t i = 0; i < num_images; i++) {
+    TDLImageContext *image_context = (TDLImageContext *)image_handles[i];
+    if (image_context == nullptr || image_context->image == nullptr) {
+      LOGE("image %u is null", i);
+      return -1;
+    }
+    images.push_back(image_context->image);
+  }
+  // BaseModel::inference会按模型支持的batch size拆分输入
+  int32_t ret = model->inference(images, outputs);
+  if (ret != 0) {
+    return ret;
+  }
+  if (outputs.size() != num_images) {
+    LOGE("output size %zu not equal to input size %u", outputs.size(),
+         num_images);
+    return -1;
+  }
+  return 0;
+}
+
+int32_t TDL_DetectionBatch(TDLHandle handle, const TDLModel model_id,
+                           TDLImage *image_handles, uint32_t num_images,
+                           TDLObject *object_metas) {
+  if (object_metas == nullptr) {
+    return -1;
+  }
+  std::vector<std::shared_ptr<BaseImage>> images;
+  std::vector<std::shared_ptr<ModelOutputInfo>> outputs;
+  int32_t ret = batch_inference(handle, model_id, image_handles, num_images,
+                                images, outputs);
+  if (ret != 0) {
+    return ret;
+  }
+  for (uint32_t i = 0; i < num_images; i++) {
+    if (fill_object_meta(outputs[i], images[i], &object_metas[i]) != 0) {
+      ret = -1;
+    }
+  }
+  return ret;
+}
+
+int32_t TDL_FaceDetectionBatch(TDLHandle handle, const TDLModel model_id,
+                               TDLImage *image_handles, uint32_t num_images,
+                               TDLFace *face_metas) {
+  if (face_metas == nullptr) {
+    return -1;
+  }
+  std::vector<std::shared_ptr<BaseImage>> images;
+  std::vector<std::shared_ptr<ModelOutputInfo>> outputs;
+  int32_t ret = batch_inference(handle, model_id, image_handles, num_images,
+                                images, outputs);
+  if (ret != 0) {
+    return ret;
+  }
+  for (uint32_t i = 0; i < num_images; i++) {
+    if (fill_face_meta(outputs[i], &face_metas[i]) != 0) {
+      ret = -1;
+    }
+  }
+  return ret;
+}
+
+int32_t TDL_ClassificationBatch(TDLHandle handle, const TDLModel model_id,
+                                TDLImage *image_handles, uint32_t num_images,
+                                TDLClassInfo *class_infos) {
+  if (class_infos == nullptr) {
+    return -1;
+  }
+  std::vector<std::shared_ptr<BaseImage>> images;
+  std::vector<std::shared_ptr<ModelOutputInfo>> outputs;
+  int32_t ret = batch_inference(handle, model_id, image_handles, num_images,
+                                images, outputs);
+  if (ret != 0) {
+    return ret;
+  }
+  for (uint32_t i = 0; i < num_images; i++) {
+    if (fill_class_info(outputs[i], &class_infos[i]) != 0) {
+      ret = -1;
+    }
+  }
+  return ret;
+}
+
+int32_t TDL_FeatureExtractionBatch(TDLHandle handle, const TDLModel model_id,
+                                   TDLImage *image_handles,
+                                   uint32_t num_images,
+                                   TDLFeature *feature_metas) {
+  if (feature_metas == nullptr) {
+    return -1;
+  }
+  std::vector<std::shared_ptr<BaseImage>> images;
+  std::vector<std::shared_ptr<ModelOutputInfo>> outputs;
+  int32_t ret = batch_inference(handle, model_id, image_handles, num_images,
+                                images, outputs);
+  if (ret != 0) {
+    return ret;
+  }
+  for (uint32_t i = 0; i < num_images; i++) {
+    if (fill_feature_meta(outputs[i], &feature_metas[i]) != 0) {
+      ret = -1;
+    }
+  }
+  return ret;
+}
+
+// 后台推理线程在第一次提交时创建，多个线程并发提交时只创建一次
+static std::shared_ptr<TDLAsyncWorker> get_async_worker(TDLContext *context,
+                                                        bool create) {
+  std::lock_guard<std::mutex> lock(context->async_mutex);
+  if (context->async_worker == nullptr && create) {
+    context->async_worker = std::make_shared<TDLAsyncWorker>();
+  }
+  return context->async_worker;
+}
+
+// 提交异步任务，任务持有模型和图像的引用，提交后允许关闭模型或销毁图像
+static int64_t submit_async(
+    TDLHandle handle, const TDLModel model_id, TDLImage image_handle,
+    std::function<int32_t(const std::shared_ptr<ModelOutputInfo> &,
+                          const std::shared_ptr<BaseImage> &)>
+        fill_func,
+    TDLAsyncCallback callback, void *user_data) {
+  TDLContext *context = (TDLContext *)handle;
+  std::shared_ptr<BaseModel> model = get_model(handle, model_id);
+  if (model == nullptr) {
+    return -1;
+  }
+  TDLImageContext *image_context = (TDLImageContext *)image_handle;
+  if (image_context == nullptr || image_context->image == nullptr) {
+    LOGE("image_handle is null");
+    return -1;
+  }
+  std::shared_ptr<TDLAsyncWorker> async_worker =
+      get_async_worker(context, true);
+  std::shared_ptr<BaseImage> image = image_context->image;
+  auto task = [model, image, fill_func]() -> int32_t {
+    std::vector<std::shared_ptr<BaseImage>> images = {image};
+    std::vector<std::shared_ptr<ModelOutputInfo>> outputs;
+    int32_t ret = model->inference(images, outputs);
+    if (ret != 0) {
+      return ret;
+    }
+    return fill_func(outputs[0], image);
+  };
+  return async_worker->submit(task, callback, user_data);
+}
+
+int64_t TDL_DetectionAsync(TDLHandle handle, const TDLModel model_id,
+                           TDLImage image_handle, TDLObject *object_meta,
+                           TDLAsyncCallback callback, void *user_data) {
+  if (object_meta == nullptr) {
+    return -1;
+  }
+  auto fill_func = [object_meta](const std::shared_ptr<ModelOutputInfo> &output,
+                                 const std::shared_ptr<BaseImage> &image) {
+    return fill_object_meta(output, image, object_meta);
+  };
+  return submit_async(handle, model_id, image_handle, fill_func, callback,
+                      user_data);
+}
+
+int64_t TDL_FaceDetectionAsync(TDLHandle handle, const TDLModel model_id,
+                               TDLImage image_handle, TDLFace *face_meta,
+                               TDLAsyncCallback callback, void *user_data) {
+  if (face_meta == nullptr) {
+    return -1;
+  }
+  auto fill_func = [face_meta](const std::shared_ptr<ModelOutputInfo> &output,
+                               const std::shared_ptr<BaseImage> &image) {
+    return fill_face_meta(output, face_meta);
+  };
+  return submit_async(handle, model_id, image_handle, fill_func, callback,
+                      user_data);
+}
+
+int64_t TDL_ClassificationAsync(TDLHandle handle, const TDLModel model_id,
+                                TDLImage image_handle,
+                                TDLClassInfo *class_info,
+                                TDLAsyncCallback callback, void *user_data) {
+  if (class_info == nullptr) {
+    return -1;
+  }
+  auto fill_func = [class_info](const std::shared_ptr<ModelOutputInfo> &output,
+                                const std::shared_ptr<BaseImage> &image) {
+    return fill_class_info(output, class_info);
+  };
+  return submit_async(handle, model_id, image_handle, fill_func, callback,
+                      user_data);
+}
+
+int64_t TDL_FeatureExtractionAsync(TDLHandle handle, const TDLModel model_id,
+                                   TDLImage image_handle,
+                                   TDLFeature *feature_meta,
+                                   TDLAsyncCallback callback, void *user_data) {
+  if (feature_meta == nullptr) {
+    return -1;
+  }
+  auto fill_func = [feature_meta](
+                       const std::shared_ptr<ModelOutputInfo> &output,
+                       const std::shared_ptr<BaseImage> &image) {
+    return fill_feature_meta(output, feature_meta);
+  };
+  return submit_async(handle, model_id, image_handle, fill_func, callback,
+                      user_data);
+}
+
+int32_t TDL_AsyncPoll(TDLHandle handle, int64_t request_id, int32_t timeout_ms,
+                      int32_t *ret) {
+  TDLContext *context = (TDLContext *)handle;
+  if (context == nullptr) {
+    return -1;
+  }
+  std::shared_ptr<TDLAsyncWorker> async_worker =
+      get_async_worker(context, false);
+  if (async_worker == nullptr) {
+    return -1;
+  }
+  return async_worker->poll(request_id, timeout_ms, ret);
+}
+
 #if defined(__CV181X__) || defined(__CV184X__) || defined(__CV186X__)
 
 int32_t TDL_MotionDetection(TDLHandle handle, TDLImage background,
@@ -2059,19 +2320,18 @@ int32_t TDL_APP_Capture(TDLHandle handle, const char *channel_name,
           capture_info->snapshot_info[i].ori_box.y2 =
               ori_capture_info->face_snapshots[i].object_box_info.y2;
 
-          if (ori_capture_info->face_snapshots[i].encoded_full_image.size()) {
+          const auto &encoded_full_image =
+              ori_capture_info->face_snapshots[i].encoded_full_image;
+          if (encoded_full_image && encoded_full_image->size()) {
             if (!capture_info->snapshot_info[i].encoded_full_image) {
               capture_info->snapshot_info[i].encoded_full_image =
-                  (uint8_t *)malloc(ori_capture_info->face_snapshots[i]
-                                        .encoded_full_image.size() *
+                  (uint8_t *)malloc(encoded_full_image->size() *
                                     sizeof(uint8_t));
             }
-            memcpy(
-                capture_info->snapshot_info[i].encoded_full_image,
-                ori_capture_info->face_snapshots[i].encoded_full_image.data(),
-                ori_capture_info->face_snapshots[i].encoded_full_image.size());
+            memcpy(capture_info->snapshot_info[i].encoded_full_image,
+                   encoded_full_image->data(), encoded_full_image->size());
             capture_info->snapshot_info[i].full_length =
-                ori_capture_info->face_snapshots[i].encoded_full_image.size();
+                encoded_full_image->size();
           }
 
           capture_info->snapshot_info[i].object_type =
@@ -2217,18 +2477,17 @@ int32_t TDL_APP_Capture(TDLHandle handle, const char *channel_name,
         capture_info->snapshot_info[i].ori_box.y2 =
             ori_capture_info->face_snapshots[i].object_box_info.y2;
 
-        if (ori_capture_info->face_snapshots[i].encoded_full_image.size()) {
+        const auto &encoded_full_image =
+            ori_capture_info->face_snapshots[i].encoded_full_image;
+        if (encoded_full_image && encoded_full_image->size()) {
           if (!capture_info->snapshot_info[i].encoded_full_image) {
             capture_info->snapshot_info[i].encoded_full_image =
-                (uint8_t *)malloc(ori_capture_info->face_snapshots[i]
-                                      .encoded_full_image.size() *
-                                  sizeof(uint8_t));
+                (uint8_t *)malloc(encoded_full_image->size() * sizeof(uint8_t));
           }
           memcpy(capture_info->snapshot_info[i].encoded_full_image,
-                 ori_capture_info->face_snapshots[i].encoded_full_image.data(),
-                 ori_capture_info->face_snapshots[i].encoded_full_image.size());
+                 encoded_full_image->data(), encoded_full_image->size());
           capture_info->snapshot_info[i].full_length =
-              ori_capture_info->face_snapshots[i].encoded_full_image.size();
+              encoded_full_image->size();
         }
 
         if (ori_capture_info->face_snapshots[i].object_box_info.object_type !=
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
@@ -59,10 +60,7 @@ bool ConvexPolygon::setVertices(const PointsInfo &points) {
   return true;
 }
 
-IntrusionDetection::IntrusionDetection() {
-  base_points_.x = {1., 0.};
-  base_points_.y = {0., 1.};
-}
+IntrusionDetection::IntrusionDetection() {}
 
 IntrusionDetection::~IntrusionDetection() {}
 
@@ -90,6 +88,7 @@ int IntrusionDetection::addRegion(const PointsInfo &points,
   if (new_region->setVertices(new_pts)) {
     new_region->region_name_ = region_name;
     regions_.push_back(new_region);
+    compileRegion(*new_region);
     return 0;
   }
 
@@ -115,6 +114,7 @@ int IntrusionDetection::addRegion(const PointsInfo &points,
     // 对于分解后的凸多边形，添加序号后缀
     new_region->region_name_ = region_name + "_part" + std::to_string(i + 1);
     regions_.push_back(new_region);
+    compileRegion(*new_region);
   }
 
   return 0;
@@ -138,75 +138,189 @@ void IntrusionDetection::getRegion(std::vector<PointsInfo> &region_info) {
   }
 }
 
-void IntrusionDetection::clean() { this->regions_.clear(); }
+void IntrusionDetection::clean() {
+  this->regions_.clear();
+  axis_offsets_.assign(1, 0);
+  axis_x_.clear();
+  axis_y_.clear();
+  axis_min_.clear();
+  axis_max_.clear();
+  region_min_x_.clear();
+  region_max_x_.clear();
+  region_min_y_.clear();
+  region_max_y_.clear();
+  grid_dirty_ = true;
+}
 
-bool IntrusionDetection::isIntrusion(const ObjectBoxInfo &bbox) {
-  /* 将坐标系从图像坐标系转换到欧几里得坐标系 */
-  ObjectBoxInfo t_bbox = bbox;
-  t_bbox.y1 *= -1;
-  t_bbox.y2 *= -1;
-  for (size_t i = 0; i < regions_.size(); i++) {
-    bool separating = false;
-    for (size_t j = 0; j < regions_[i]->normal_points_.x.size(); j++) {
-      Vertex o;
-      o.x = regions_[i]->normal_points_.x[j];
-      o.y = regions_[i]->normal_points_.y[j];
-      if (isSeparatingAxis(o, regions_[i]->points_, t_bbox)) {
-        separating = true;
-        break;
-      }
+void IntrusionDetection::compileRegion(const ConvexPolygon &region) {
+  const PointsInfo &pts = region.points_;
+  const PointsInfo &normals = region.normal_points_;
+  for (size_t j = 0; j < normals.x.size(); j++) {
+    float min_proj = std::numeric_limits<float>::max();
+    float max_proj = -std::numeric_limits<float>::max();
+    for (size_t i = 0; i < pts.x.size(); i++) {
+      float proj = normals.x[j] * pts.x[i] + normals.y[j] * pts.y[i];
+      min_proj = MIN(min_proj, proj);
+      max_proj = MAX(max_proj, proj);
     }
-    if (separating) {
-      continue;
+    axis_x_.push_back(normals.x[j]);
+    axis_y_.push_back(normals.y[j]);
+    axis_min_.push_back(min_proj);
+    axis_max_.push_back(max_proj);
+  }
+  axis_offsets_.push_back(axis_x_.size());
+
+  /* 基准轴 (1,0), (0,1) 上的投影区间即包围框 */
+  region_min_x_.push_back(*std::min_element(pts.x.begin(), pts.x.end()));
+  region_max_x_.push_back(*std::max_element(pts.x.begin(), pts.x.end()));
+  region_min_y_.push_back(*std::min_element(pts.y.begin(), pts.y.end()));
+  region_max_y_.push_back(*std::max_element(pts.y.begin(), pts.y.end()));
+  grid_dirty_ = true;
+}
+
+void IntrusionDetection::buildGrid() {
+  grid_dirty_ = false;
+  const size_t num_regions = region_min_x_.size();
+  cell_offsets_.clear();
+  cell_regions_.clear();
+  visit_stamps_.assign(num_regions, 0);
+  stamp_ = 0;
+  if (num_regions == 0) {
+    grid_cols_ = grid_rows_ = 0;
+    return;
+  }
+
+  grid_x0_ = *std::min_element(region_min_x_.begin(), region_min_x_.end());
+  grid_x1_ = *std::max_element(region_max_x_.begin(), region_max_x_.end());
+  grid_y0_ = *std::min_element(region_min_y_.begin(), region_min_y_.end());
+  grid_y1_ = *std::max_element(region_max_y_.begin(), region_max_y_.end());
+
+  /* 每个方向约 2*sqrt(区域数) 个单元 */
+  int cells = (int)std::ceil(2 * std::sqrt((float)num_regions));
+  cells = std::min(std::max(cells, 1), 64);
+  grid_cols_ = (grid_x1_ > grid_x0_) ? cells : 1;
+  grid_rows_ = (grid_y1_ > grid_y0_) ? cells : 1;
+  inv_cell_w_ =
+      (grid_x1_ > grid_x0_) ? grid_cols_ / (grid_x1_ - grid_x0_) : 0.0f;
+  inv_cell_h_ =
+      (grid_y1_ > grid_y0_) ? grid_rows_ / (grid_y1_ - grid_y0_) : 0.0f;
+
+  /* 先统计每个单元的区域数, 再按偏移写入 */
+  std::vector<uint32_t> counts(grid_cols_ * grid_rows_ + 1, 0);
+  for (int pass = 0; pass < 2; pass++) {
+    for (size_t r = 0; r < num_regions; r++) {
+      int c0 = gridCol(region_min_x_[r]), c1 = gridCol(region_max_x_[r]);
+      int r0 = gridRow(region_min_y_[r]), r1 = gridRow(region_max_y_[r]);
+      for (int row = r0; row <= r1; row++) {
+        for (int col = c0; col <= c1; col++) {
+          int cell = row * grid_cols_ + col;
+          if (pass == 0) {
+            counts[cell + 1]++;
+          } else {
+            cell_regions_[counts[cell]++] = (uint32_t)r;
+          }
+        }
+      }
     }
-    for (size_t j = 0; j < base_points_.x.size(); j++) {
-      Vertex o;
-      o.x = base_points_.x[j];
-      o.y = base_points_.y[j];
-      if (isSeparatingAxis(o, regions_[i]->points_, t_bbox)) {
-        separating = true;
-        break;
+    if (pass == 0) {
+      for (size_t c = 1; c < counts.size(); c++) {
+        counts[c] += counts[c - 1];
       }
+      cell_offsets_ = counts;
+      cell_regions_.resize(counts.back());
     }
-    if (separating) {
-      continue;
-    } else {
-      return true;
+  }
+}
+
+int IntrusionDetection::gridCol(float x) const {
+  int col = (int)std::floor((x - grid_x0_) * inv_cell_w_);
+  return std::min(std::max(col, 0), grid_cols_ - 1);
+}
+
+int IntrusionDetection::gridRow(float y) const {
+  int row = (int)std::floor((y - grid_y0_) * inv_cell_h_);
+  return std::min(std::max(row, 0), grid_rows_ - 1);
+}
+
+IntrusionDetection::BoxBounds IntrusionDetection::toBoxBounds(
+    const ObjectBoxInfo &bbox) {
+  /* 将坐标系从图像坐标系转换到欧几里得坐标系 */
+  BoxBounds box;
+  box.min_x = MIN(bbox.x1, bbox.x2);
+  box.max_x = MAX(bbox.x1, bbox.x2);
+  box.min_y = -MAX(bbox.y1, bbox.y2);
+  box.max_y = -MIN(bbox.y1, bbox.y2);
+  return box;
+}
+
+bool IntrusionDetection::intersectRegion(size_t region,
+                                         const BoxBounds &box) const {
+  /* 基准轴 */
+  if (region_max_x_[region] < box.min_x || box.max_x < region_min_x_[region] ||
+      region_max_y_[region] < box.min_y || box.max_y < region_min_y_[region]) {
+    return false;
+  }
+  /* 法线轴: 框在轴上的投影区间由对应角点给出, 无分支以便向量化 */
+  const float *ax = axis_x_.data();
+  const float *ay = axis_y_.data();
+  const float *amin = axis_min_.data();
+  const float *amax = axis_max_.data();
+  int separated = 0;
+  for (size_t k = axis_offsets_[region]; k < axis_offsets_[region + 1]; k++) {
+    float px0 = ax[k] * box.min_x, px1 = ax[k] * box.max_x;
+    float py0 = ay[k] * box.min_y, py1 = ay[k] * box.max_y;
+    float box_min = MIN(px0, px1) + MIN(py0, py1);
+    float box_max = MAX(px0, px1) + MAX(py0, py1);
+    separated |= (int)(amax[k] < box_min) | (int)(box_max < amin[k]);
+  }
+  return separated == 0;
+}
+
+bool IntrusionDetection::testBox(const BoxBounds &box) {
+  if (grid_cols_ == 0 || box.max_x < grid_x0_ || box.min_x > grid_x1_ ||
+      box.max_y < grid_y0_ || box.min_y > grid_y1_) {
+    return false;
+  }
+  if (++stamp_ == 0) {
+    std::fill(visit_stamps_.begin(), visit_stamps_.end(), 0);
+    stamp_ = 1;
+  }
+  int c0 = gridCol(box.min_x), c1 = gridCol(box.max_x);
+  int r0 = gridRow(box.min_y), r1 = gridRow(box.max_y);
+  for (int row = r0; row <= r1; row++) {
+    for (int col = c0; col <= c1; col++) {
+      int cell = row * grid_cols_ + col;
+      for (uint32_t k = cell_offsets_[cell]; k < cell_offsets_[cell + 1];
+           k++) {
+        uint32_t region = cell_regions_[k];
+        if (visit_stamps_[region] == stamp_) {
+          continue;
+        }
+        visit_stamps_[region] = stamp_;
+        if (intersectRegion(region, box)) {
+          return true;
+        }
+      }
     }
   }
   return false;
 }
 
-bool IntrusionDetection::isSeparatingAxis(const Vertex &axis,
-                                          const PointsInfo &region_pts,
-                                          const ObjectBoxInfo &bbox) {
-  float min_1 = std::numeric_limits<float>::max();
-  float max_1 = -std::numeric_limits<float>::max();
-  float min_2 = std::numeric_limits<float>::max();
-  float max_2 = -std::numeric_limits<float>::max();
-  float proj;
-  for (size_t i = 0; i < region_pts.x.size(); i++) {
-    proj = axis.x * region_pts.x[i] + axis.y * region_pts.y[i];
-    min_1 = MIN(min_1, proj);
-    max_1 = MAX(max_1, proj);
-  }
-  proj = axis.x * bbox.x1 + axis.y * bbox.y1;
-  min_2 = MIN(min_2, proj);
-  max_2 = MAX(max_2, proj);
-  proj = axis.x * bbox.x2 + axis.y * bbox.y1;
-  min_2 = MIN(min_2, proj);
-  max_2 = MAX(max_2, proj);
-  proj = axis.x * bbox.x2 + axis.y * bbox.y2;
-  min_2 = MIN(min_2, proj);
-  max_2 = MAX(max_2, proj);
-  proj = axis.x * bbox.x1 + axis.y * bbox.y2;
-  min_2 = MIN(min_2, proj);
-  max_2 = MAX(max_2, proj);
-
-  if ((max_1 >= min_2) && (max_2 >= min_1)) {
-    return false;
-  } else {
-    return true;
+bool IntrusionDetection::isIntrusion(const ObjectBoxInfo &bbox) {
+  if (grid_dirty_) {
+    buildGrid();
+  }
+  return testBox(toBoxBounds(bbox));
+}
+
+void IntrusionDetection::isIntrusion(const std::vector<ObjectBoxInfo> &bboxes,
+                                     std::vector<bool> &intrusions) {
+  if (grid_dirty_) {
+    buildGrid();
+  }
+  intrusions.assign(bboxes.size(), false);
+  for (size_t i = 0; i < bboxes.size(); i++) {
+    intrusions[i] = testBox(toBoxBounds(bboxes[i]));
   }
 }
 
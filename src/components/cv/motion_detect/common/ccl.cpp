@@ -7,143 +7,202 @@
 
 #include "ccl.hpp"
 #include "utils/tdl_log.hpp"
-#define CC_MAX_NUM_LABELS 200
-#define MAX_CC_OBJECTS 200
 
 #define CC_SUPER_PIXEL_H 2
 #define CC_SUPER_PIXEL_W 2
-#define CC_SCAN_WINDOW_H 2
-#define CC_SCAN_WINDOW_W 2
 #define CC_FG_SUPER_PIX_THD 3
 #define BLOCK_SIZE 2
 
+// 超像素前景图按行打包为 64 位字, 以行内游程 (run) 为单位做并查集;
+// 合并时同步累计每个连通域的超像素数与包围框.
 typedef struct CCTag {
-  int maskWidth;
-  int maskHeight;
-  int ccSuperPixelSize;
-  int superPixMapW;
-  int superPixMapH;
-
-  int numTotalObj;
-
-  int maxID;
-
-  unsigned char *dataSuperPixMap;
-  unsigned char *dataSuperPixFG;
-  unsigned char *eqCCLabelArray;
-
-  int numObjects;
-  int *boundingBoxesTmp;
-  int *boundingBoxes;
-
+  int maskWidth = 0;
+  int maskHeight = 0;
+  int superPixMapW = 0;
+  int superPixMapH = 0;
+  int wordsPerRow = 0;
+
+  // 逐行流式处理, 只保留相邻两行的超像素计数与扫描窗口结果
+  std::vector<unsigned char> superPixFG[2];  // 每个超像素的前景像素数
+  std::vector<uint64_t> scanBits[2];  // 2x2 扫描窗口是否为前景, 按位打包
+  std::vector<uint64_t> fgBits;       // 当前行超像素前景, 按位打包
+
+  // runs, 同一行的 run 连续存放
+  std::vector<int> runParent;
+  std::vector<int> runSize;
+  std::vector<int> runR0, runC0, runR1, runC1;
+  std::vector<int> runStart, runEnd;
+
+  std::vector<int> boundingBoxes;
 } CCLType;
 
-void *createConnectInstance() {
-  CCLType *p_inst = new CCLType();
-  memset(p_inst, 0, sizeof(CCLType));
-  return p_inst;
-}
-
-void initConnectedComponent(CCLType *ccGst, int width, int height) {
-  int superPixMapW, superPixMapH;
+void *createConnectInstance() { return new CCLType(); }
 
+static void initConnectedComponent(CCLType *ccGst, int width, int height) {
   ccGst->maskWidth = width;
   ccGst->maskHeight = height;
 
   ccGst->superPixMapW = width / CC_SUPER_PIXEL_W;
   ccGst->superPixMapH = height / CC_SUPER_PIXEL_H;
+  ccGst->wordsPerRow = (ccGst->superPixMapW + 63) / 64;
 
-  superPixMapW = ccGst->superPixMapW;
-  superPixMapH = ccGst->superPixMapH;
-
-  ccGst->dataSuperPixMap = new unsigned char[superPixMapW * superPixMapH];
-
-  memset(ccGst->dataSuperPixMap, 0, superPixMapH * superPixMapW);
-
-  ccGst->dataSuperPixFG = new unsigned char[superPixMapH * superPixMapW];
-  memset(ccGst->dataSuperPixFG, 0, superPixMapH * superPixMapW);
-
-  ccGst->eqCCLabelArray = new unsigned char[CC_MAX_NUM_LABELS + 1];
-
-  ccGst->boundingBoxesTmp = new int[MAX_CC_OBJECTS * 5];
-  ccGst->boundingBoxes = new int[MAX_CC_OBJECTS * 5];
+  // 计数行按 64 对齐并多留 8 字节, 便于按 8 字节整块读取
+  size_t padded_w = (size_t)ccGst->wordsPerRow * 64 + 8;
+  for (int i = 0; i < 2; i++) {
+    ccGst->superPixFG[i].assign(padded_w, 0);
+    ccGst->scanBits[i].assign(ccGst->wordsPerRow, 0);
+  }
+  ccGst->fgBits.assign(ccGst->wordsPerRow, 0);
 }
 
-void releaseConnectedComponent(CCLType *ccGst) {
-  if (ccGst->maskWidth > 0 && ccGst->maskHeight > 0) {
-    delete[] ccGst->dataSuperPixMap;
-    delete[] ccGst->dataSuperPixFG;
-    delete[] ccGst->eqCCLabelArray;
-    delete[] ccGst->boundingBoxesTmp;
-    delete[] ccGst->boundingBoxes;
+static int findRoot(std::vector<int> &parent, int i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
   }
-
-  memset(ccGst, 0, sizeof(CCLType));
+  return i;
 }
 
-bool clusterBox(int *p_boxes, int ci, int i) {
-  // check if intersect
-  int inter_R0 = std::max(p_boxes[5 * i + 1], p_boxes[5 * ci + 1]);
-  int inter_C0 = std::max(p_boxes[5 * i + 2], p_boxes[5 * ci + 2]);
-
-  int inter_R1 = std::min(p_boxes[5 * i + 3], p_boxes[5 * ci + 3]);
-  int inter_C1 = std::min(p_boxes[5 * i + 4], p_boxes[5 * ci + 4]);
-
-  int interw = inter_C1 - inter_C0;
-  int interh = inter_R1 - inter_R0;
-
-  if (interw <= 0 || interh <= 0) return false;
-
-  int out_R0 = std::min(p_boxes[5 * i + 1], p_boxes[5 * ci + 1]);
-  int out_C0 = std::min(p_boxes[5 * i + 2], p_boxes[5 * ci + 2]);
+// 合并两个 run 所在的连通域, 序号小的作为根, 包围框与面积累加到根上
+static void unionRuns(CCLType *ccGst, int a, int b) {
+  int ra = findRoot(ccGst->runParent, a);
+  int rb = findRoot(ccGst->runParent, b);
+  if (ra == rb) return;
+  int root = std::min(ra, rb), child = std::max(ra, rb);
+  ccGst->runParent[child] = root;
+  ccGst->runSize[root] += ccGst->runSize[child];
+  ccGst->runR0[root] = std::min(ccGst->runR0[root], ccGst->runR0[child]);
+  ccGst->runC0[root] = std::min(ccGst->runC0[root], ccGst->runC0[child]);
+  ccGst->runR1[root] = std::max(ccGst->runR1[root], ccGst->runR1[child]);
+  ccGst->runC1[root] = std::max(ccGst->runC1[root], ccGst->runC1[child]);
+}
 
-  int out_R1 = std::max(p_boxes[5 * i + 3], p_boxes[5 * ci + 3]);
-  int out_C1 = std::max(p_boxes[5 * i + 4], p_boxes[5 * ci + 4]);
-  p_boxes[5 * ci + 1] = out_R0;
-  p_boxes[5 * ci + 2] = out_C0;
-  p_boxes[5 * ci + 3] = out_R1;
-  p_boxes[5 * ci + 4] = out_C1;
-  return true;
+// 从 from 开始查找第一个置位 (set) 或清零的位, 找不到时返回 words * 64
+static int findBit(const uint64_t *row, int words, int from, bool set) {
+  int w = from >> 6;
+  if (w >= words) return words * 64;
+  uint64_t cur = (set ? row[w] : ~row[w]) & (~0ULL << (from & 63));
+  while (cur == 0) {
+    if (++w >= words) return words * 64;
+    cur = set ? row[w] : ~row[w];
+  }
+  return (w << 6) + __builtin_ctzll(cur);
 }
-int filterInsideBoxes(int *p_boxes, int num_src) {
-  // sort with box area
-  struct area_info {
-    int area;
-    int index;
-  };
-  std::vector<area_info> box_areas;
-  for (int i = 0; i < num_src; i++) {
-    int R0 = p_boxes[5 * i + 1];
-    int C0 = p_boxes[5 * i + 2];
-    int R1 = p_boxes[5 * i + 3];
-    int C1 = p_boxes[5 * i + 4];
-    int area = (R1 - R0) * (C1 - C0);
-    area_info a_info;
-    a_info.area = area;
-    a_info.index = i;
-    box_areas.push_back(a_info);
+
+// 统计超像素行 rBlk 中每个超像素的前景像素数
+static void countSuperPixelRow(const unsigned char *p_fg_mask, int wstride,
+                               int rBlk, int superPixMapW,
+                               unsigned char *dst) {
+  const unsigned char *p0 =
+      p_fg_mask + (size_t)rBlk * CC_SUPER_PIXEL_H * wstride;
+  const unsigned char *p1 = p0 + wstride;
+  const uint64_t kLow7 = 0x7f7f7f7f7f7f7f7fULL;
+  const uint64_t kOnes = 0x0101010101010101ULL;
+  const uint64_t kEven = 0x00ff00ff00ff00ffULL;
+  int c = 0;
+  /* 每次处理 8 个像素 (4 个超像素): 非零字节置 1, 两行相加后相邻字节相加 */
+  for (; c + 4 <= superPixMapW; c += 4) {
+    uint64_t a, b;
+    memcpy(&a, p0 + 2 * c, sizeof(a));
+    memcpy(&b, p1 + 2 * c, sizeof(b));
+    a = ((((a & kLow7) + kLow7) | a) >> 7) & kOnes;
+    b = ((((b & kLow7) + kLow7) | b) >> 7) & kOnes;
+    uint64_t sum = a + b;
+    sum = (sum & kEven) + ((sum >> 8) & kEven);
+    dst[c] = (unsigned char)sum;
+    dst[c + 1] = (unsigned char)(sum >> 16);
+    dst[c + 2] = (unsigned char)(sum >> 32);
+    dst[c + 3] = (unsigned char)(sum >> 48);
+  }
+  for (; c < superPixMapW; c++) {
+    dst[c] = (p0[2 * c] != 0) + (p0[2 * c + 1] != 0) + (p1[2 * c] != 0) +
+             (p1[2 * c + 1] != 0);
   }
+}
 
-  std::sort(
-      box_areas.begin(), box_areas.end(),
-      [](const area_info &a, const area_info &b) { return a.area > b.area; });
+// 扫描窗口左上角为 (r, c) 时, 窗口内前景像素数 cnt0[c] + cnt0[c + 1] +
+// cnt1[c] + cnt1[c + 1] 超过阈值即为前景, c < W - 2; 每次处理 8 列,
+// 结果按位写入 scan_bits
+static void scanSuperPixelRow(const unsigned char *cnt0,
+                              const unsigned char *cnt1, int superPixMapW,
+                              int words, uint64_t *scan_bits) {
+  const uint64_t kOnes = 0x0101010101010101ULL;
+  // 每字节加上 128 - (阈值 + 1), 最高位即为 "超过阈值"
+  const uint64_t kBias = kOnes * (128 - (CC_FG_SUPER_PIX_THD + 1));
+  // 8 个 0/1 字节打包为 8 位, 第 i 个字节对应第 i 位 (小端)
+  const uint64_t kPack = 0x0102040810204080ULL;
+  for (int w = 0; w < words; w++) {
+    uint64_t word = 0;
+    for (int b = 0; b < 8; b++) {
+      int c = w * 64 + b * 8;
+      uint64_t a0, a1, b0, b1;
+      memcpy(&a0, cnt0 + c, sizeof(a0));
+      memcpy(&a1, cnt0 + c + 1, sizeof(a1));
+      memcpy(&b0, cnt1 + c, sizeof(b0));
+      memcpy(&b1, cnt1 + c + 1, sizeof(b1));
+      uint64_t fg = (((a0 + a1 + b0 + b1 + kBias) >> 7) & kOnes);
+      word |= ((fg * kPack) >> 56) << (b * 8);
+    }
+    scan_bits[w] = word;
+  }
+  // 窗口不能越过最后两列
+  int valid = std::max(superPixMapW - 2, 0);
+  for (int w = 0; w < words; w++) {
+    int lo = w * 64;
+    if (valid <= lo) {
+      scan_bits[w] = 0;
+    } else if (valid < lo + 64) {
+      scan_bits[w] &= (1ULL << (valid - lo)) - 1;
+    }
+  }
+}
 
-  for (size_t i = 1; i < box_areas.size(); i++) {
-    int indi = box_areas[i].index;
-    // std::cout<<"indi:"<<indi<<",area:"<<box_areas[i].area<<std::endl;
-    for (size_t c = 0; c < i; c++) {
-      int indc = box_areas[c].index;
-      if (p_boxes[5 * indc] < 0) continue;
-      if (clusterBox(p_boxes, indc, indi)) {
-        p_boxes[5 * indi] = -1;
+// 合并相交的框, 直到任意两个输出框都不相交; 合并后框的面积为两者之和.
+// 每一轮按左边界排序后扫描, 只与右边界超过当前左边界的框比较.
+int filterInsideBoxes(int *p_boxes, int num_src) {
+  std::vector<int> order(num_src);
+  std::vector<int> active;
+  bool merged = num_src > 1;
+  while (merged) {
+    merged = false;
+    order.clear();
+    for (int i = 0; i < num_src; i++) {
+      if (p_boxes[5 * i] > 0) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [p_boxes](int a, int b) {
+      return p_boxes[5 * a + 2] < p_boxes[5 * b + 2];
+    });
+    active.clear();
+    for (int i : order) {
+      int *bi = p_boxes + 5 * i;
+      active.erase(std::remove_if(active.begin(), active.end(),
+                                  [p_boxes, bi](int a) {
+                                    return p_boxes[5 * a + 4] <= bi[2];
+                                  }),
+                   active.end());
+      bool absorbed = false;
+      for (int a : active) {
+        int *ba = p_boxes + 5 * a;
+        int interw = std::min(ba[4], bi[4]) - bi[2];
+        int interh = std::min(ba[3], bi[3]) - std::max(ba[1], bi[1]);
+        if (interw <= 0 || interh <= 0) continue;
+        ba[0] += bi[0];
+        ba[1] = std::min(ba[1], bi[1]);
+        ba[3] = std::max(ba[3], bi[3]);
+        ba[4] = std::max(ba[4], bi[4]);
+        bi[0] = -1;
+        absorbed = true;
+        merged = true;
         break;
       }
+      if (!absorbed) active.push_back(i);
     }
   }
+
   int ctFinal = 0;
   for (int i = 0; i < num_src; i++) {
     if (p_boxes[5 * i] > 0) {
-      memcpy(p_boxes + 5 * ctFinal, p_boxes + 5 * i, 5 * sizeof(int));
+      memmove(p_boxes + 5 * ctFinal, p_boxes + 5 * i, 5 * sizeof(int));
       ctFinal++;
     }
   }
@@ -177,301 +236,116 @@ int dumpIveImageFrame(const std::string &filepath, uint8_t *ptr_img, int w,
 int *extractConnectedComponent(unsigned char *p_fg_mask, int width, int height,
                                int wstride, int area_thresh, void *p_cc_inst,
                                int *p_num_boxes) {
-  int r, c, i, j, rBlk, cBlk;
-  int xA, xB, xC, xD;
-  int cumulatedBlkSum, superPixMapW, superPixMapH;
-  int ctFGPixels, imgDataWStep;
-  int lbVal, currLabel, R0, C0, R1, C1, objectSize;
-  int tmpMaxLabel;
-
-  unsigned char *ptrImgData;
-  unsigned char *ptrImgData0;
-  unsigned char *ptrSuperPixMap;
-  unsigned char *ptrSuperPixMap0;
-  unsigned char *ptrSuperPixFG;
-  unsigned char *ptrSuperPixFG0;
-  unsigned char *ptrLabelMap;
-  unsigned char *ptrLabelMap0;
-  unsigned char *eqLabelArray;
-  unsigned char *ptrUCHAR;
-
-  int *boundingBoxes;
-  int *boundingBoxesFinal;
-  int ctFinal;
-
   CCLType *ccGst = (CCLType *)p_cc_inst;
   if (ccGst->maskWidth != width || ccGst->maskHeight != height) {
     LOGI("allocate ccl,w:%d,h:%d\n", width, height);
-
-    releaseConnectedComponent(ccGst);
     initConnectedComponent(ccGst, width, height);
-    // std::cout<<"to allocate
-    // ccl,w:"<<width<<",height:"<<height<<",maskw:"<<ccGst->maskWidth<<std::endl;
-  }
-
-  // imgW = ccGst->maskWidth;
-  superPixMapW = ccGst->superPixMapW;
-  superPixMapH = ccGst->superPixMapH;
-
-  ptrSuperPixMap0 = ccGst->dataSuperPixMap;
-  ptrSuperPixFG0 = ccGst->dataSuperPixFG;
-  eqLabelArray = ccGst->eqCCLabelArray;
-
-  ptrImgData0 = p_fg_mask;
-
-  tmpMaxLabel = 0;
-
-  /* reset foreground super pixels.*/
-  memset(ccGst->dataSuperPixMap, 0,
-         superPixMapH * superPixMapW * sizeof(unsigned char));
-  memset(ccGst->dataSuperPixFG, 0,
-         superPixMapH * superPixMapW * sizeof(unsigned char));
-
-  ptrUCHAR = ccGst->eqCCLabelArray;
-
-  for (i = 0; i < (CC_MAX_NUM_LABELS + 1); i += 1) {
-    *ptrUCHAR = i;
-    ptrUCHAR += 1;
-  }
-
-  ccGst->numTotalObj = 0;
-
-  /***********************************************/
-  /*	Sum up foreground count within suer pixels.*/
-  imgDataWStep = (CC_SUPER_PIXEL_H * wstride);
-
-  for (rBlk = 0; rBlk < superPixMapH; rBlk += 1) {
-    for (cBlk = 0; cBlk < superPixMapW; cBlk += 1) {
-      ptrImgData =
-          ptrImgData0 + (rBlk * imgDataWStep) + (cBlk * CC_SUPER_PIXEL_W);
-
-      cumulatedBlkSum = 0;
-
-      for (r = 0; r < CC_SUPER_PIXEL_H; r += 1) {
-        for (c = 0; c < CC_SUPER_PIXEL_W; c += 1) {
-          if ((*ptrImgData) > 0) cumulatedBlkSum += 1;
-
-          ptrImgData += 1;
-        } /* c */
-
-        ptrImgData += (wstride - CC_SUPER_PIXEL_W);
-      } /* r */
-
-      *(ptrSuperPixFG0 + (rBlk * superPixMapW) + cBlk) = cumulatedBlkSum;
-    } /*end of: for ( cBlk )*/
-  }   /*end of: for ( rBlk )*/
-
-  /**************************/
-  /* Scan image for objects */
-  /**************************/
-
-  for (r = 0; r < (superPixMapH - CC_SCAN_WINDOW_H); r += 1) {
-    for (c = 0; c < (superPixMapW - CC_SCAN_WINDOW_W); c += 1) {
-      /* sum up pixel in scanning window.*/
-
-      ctFGPixels = 0;
-
-      ptrSuperPixFG = ptrSuperPixFG0 + (r * superPixMapW) + c;
-
-      for (i = 0; i < CC_SCAN_WINDOW_H; i += 1) {
-        for (j = 0; j < CC_SCAN_WINDOW_W; j += 1) {
-          ctFGPixels += (*ptrSuperPixFG);
-          ptrSuperPixFG += 1;
-
-        } /* col: j */
-
-        ptrSuperPixFG += (superPixMapW - CC_SCAN_WINDOW_W);
-      } /* row: i */
-
-      /* mark foreground.*/
-
-      if (ctFGPixels > CC_FG_SUPER_PIX_THD) {
-        ptrSuperPixMap = ptrSuperPixMap0 + (r * superPixMapW) + c;
-
-        for (i = 0; i < CC_SCAN_WINDOW_H; i += 1) {
-          for (j = 0; j < CC_SCAN_WINDOW_W; j += 1) {
-            *(ptrSuperPixMap) = 255;
-            ptrSuperPixMap += 1;
-          }
-
-          ptrSuperPixMap += (superPixMapW - CC_SCAN_WINDOW_W);
-        }
-
-      } /*end of: mark foreground.*/
-
-    } /*end of: for ( c )*/
-  }   /*end of: for ( r )*/
-
-  // now the map is saved in ptrSuperPixMap
-  /*	Connected component labeling.*/
-
-  currLabel = 1;
-  // dump_ive_image_frame("/mnt/data/admin1_data/alios_test/md/fg.bin",ptrSuperPixMap0,ccGst->superPixMapW,ccGst->superPixMapH,ccGst->superPixMapW);
-  /* put label in [*ptrSuperPixFG].*/
-  memset(ccGst->dataSuperPixFG, 0,
-         superPixMapH * superPixMapW * sizeof(unsigned char));
-  ptrLabelMap0 = ccGst->dataSuperPixFG;
-
-  /* the 1st pass for setting label and flooding label.*/
-  for (r = 1; r < superPixMapH; r += 1) {
-    ptrSuperPixMap = ptrSuperPixMap0 + (r * superPixMapW) + 1;
-    ptrLabelMap = ptrLabelMap0 + (r * superPixMapW) + 1;
-
-    for (c = 1; c < superPixMapW; c += 1) {
-      if ((*ptrSuperPixMap) > 0) {
-        /*	xB	xC	xD	*/
-        /*	xA	x		*/
-        xA = *(ptrLabelMap - 1);
-        xB = *(ptrLabelMap - 1 - superPixMapW);
-        xC = *(ptrLabelMap - superPixMapW);
-        xD = *(ptrLabelMap - superPixMapW + 1);
-
-        lbVal = CC_MAX_NUM_LABELS;
-
-        if (xA > 0) lbVal = xA;
-        if ((xB > 0) && (xB < lbVal)) lbVal = xB;
-        if ((xC > 0) && (xC < lbVal)) lbVal = xC;
-        if ((xD > 0) && (xD < lbVal)) lbVal = xD;
-
-        if (lbVal < CC_MAX_NUM_LABELS) {
-          /* make connection and flood label.*/
-          if (xA > lbVal) {
-            *(eqLabelArray + xA) = *(eqLabelArray + lbVal);
-          }
-          if (xB > lbVal) {
-            *(eqLabelArray + xB) = *(eqLabelArray + lbVal);
-          }
-          if (xC > lbVal) {
-            *(eqLabelArray + xC) = *(eqLabelArray + lbVal);
-          }
-          if (xD > lbVal) {
-            *(eqLabelArray + xD) = *(eqLabelArray + lbVal);
-          }
-        } else {
-          /* new label.*/
-          lbVal = currLabel;
-          if (currLabel <
-              (CC_MAX_NUM_LABELS -
-               1)) {  // the maximum label would be CC_MAX_NUM_LABELS-1
-            currLabel += 1;
-          }
-        }
-
-        /* save label for this pixel.*/
-        *(ptrLabelMap) = lbVal;
-
-      } /*end of: if foreground.*/
-
-      ptrSuperPixMap += 1;
-      ptrLabelMap += 1;
-    } /* col */
-  }   /* row */
-
-  /* the 2nd pass to flush with equivalent labels.*/
-  for (r = 1; r < superPixMapH; r += 1) {
-    ptrLabelMap = ptrLabelMap0 + (r * superPixMapW) + 1;
-
-    for (c = 1; c < superPixMapW; c += 1) {
-      lbVal = (*ptrLabelMap);
-
-      if (lbVal > 0) {
-        /* equivalent label.*/
-        lbVal = *(eqLabelArray + lbVal);
-        *ptrLabelMap = lbVal;
-
-        // find the maximal label.
-        if (lbVal > tmpMaxLabel) {
-          tmpMaxLabel = lbVal;
-        }
-
-        // display only:
-        *(ccGst->dataSuperPixMap + (r * superPixMapW) + c) = lbVal;
-
-      } /*end of: if foreground.*/
-
-      ptrLabelMap += 1;
-    } /* col */
-  }   /* row */
-
-  // this would not happen
-  if (tmpMaxLabel > CC_MAX_NUM_LABELS) {
-    printf("ccl error maxlable:%d\n", tmpMaxLabel);
-    *p_num_boxes = 0;
-    return ccGst->boundingBoxes;
-  }
-  ccGst->maxID = tmpMaxLabel;
-
-  if (tmpMaxLabel > 0) {
-    tmpMaxLabel = tmpMaxLabel;
   }
 
-  // determine the bounding boxes of each object
-  boundingBoxes = ccGst->boundingBoxesTmp;
-  for (i = 0; i <= ccGst->maxID; i++) {
-    boundingBoxes[5 * i + 0] = 0;
-    boundingBoxes[5 * i + 1] = 10000;
-    boundingBoxes[5 * i + 2] = 10000;
-    boundingBoxes[5 * i + 3] = -10000;
-    boundingBoxes[5 * i + 4] = -10000;
+  const int superPixMapW = ccGst->superPixMapW;
+  const int superPixMapH = ccGst->superPixMapH;
+  const int words = ccGst->wordsPerRow;
+  ccGst->boundingBoxes.clear();
+  *p_num_boxes = 0;
+  if (superPixMapW <= 0 || superPixMapH <= 0) {
+    return ccGst->boundingBoxes.data();
   }
 
-  for (r = 1; r < superPixMapH; r += 1) {
-    ptrLabelMap = ccGst->dataSuperPixMap + (r * superPixMapW) + 1;
-
-    for (c = 1; c < superPixMapW; c += 1) {
-      lbVal = *ptrLabelMap;
-      ptrLabelMap++;
-
-      if (lbVal >= 1) {
-        if (lbVal > (CC_MAX_NUM_LABELS - 1)) lbVal = CC_MAX_NUM_LABELS - 1;
-
-        lbVal = lbVal - 1;
-        boundingBoxes[5 * lbVal] = boundingBoxes[5 * lbVal] + 1;
+  ccGst->runParent.clear();
+  ccGst->runSize.clear();
+  ccGst->runR0.clear();
+  ccGst->runC0.clear();
+  ccGst->runR1.clear();
+  ccGst->runC1.clear();
+  ccGst->runStart.clear();
+  ccGst->runEnd.clear();
+
+  /* 逐行处理:
+   * 1. 统计超像素中的前景像素数;
+   * 2. 2x2 超像素扫描窗口的前景像素数超过阈值时整个窗口为前景,
+   *    窗口左上角 (r, c) 满足 r < H - 2, c < W - 2;
+   * 3. 超像素 (r, c) 被左上角为 (r-1..r, c-1..c) 的任一前景窗口覆盖即为
+   *    前景, 第 0 行和第 0 列不参与标记;
+   * 4. 前景按位打包后提取 run, 与上一行 8 邻接的 run 合并. */
+  unsigned char *cnt0 = ccGst->superPixFG[0].data();
+  unsigned char *cnt1 = ccGst->superPixFG[1].data();
+  uint64_t *scanPrev = ccGst->scanBits[0].data();
+  uint64_t *scanCur = ccGst->scanBits[1].data();
+  uint64_t *bits = ccGst->fgBits.data();
+  memset(scanPrev, 0, words * sizeof(uint64_t));
+  countSuperPixelRow(p_fg_mask, wstride, 0, superPixMapW, cnt0);
+  int prevBegin = 0, prevEnd = 0;
+  for (int r = 0; r < superPixMapH; r++) {
+    if (r < superPixMapH - 2) {
+      countSuperPixelRow(p_fg_mask, wstride, r + 1, superPixMapW, cnt1);
+      scanSuperPixelRow(cnt0, cnt1, superPixMapW, words, scanCur);
+      std::swap(cnt0, cnt1);
+    } else {
+      memset(scanCur, 0, words * sizeof(uint64_t));
+    }
+    if (r == 0) {
+      std::swap(scanPrev, scanCur);
+      continue;
+    }
 
-        if (r < boundingBoxes[5 * lbVal + 1]) boundingBoxes[5 * lbVal + 1] = r;
-        if (c < boundingBoxes[5 * lbVal + 2]) boundingBoxes[5 * lbVal + 2] = c;
-        if (r > boundingBoxes[5 * lbVal + 3]) boundingBoxes[5 * lbVal + 3] = r;
-        if (c > boundingBoxes[5 * lbVal + 4]) boundingBoxes[5 * lbVal + 4] = c;
+    uint64_t carry = 0;
+    for (int w = 0; w < words; w++) {
+      uint64_t covered = scanPrev[w] | scanCur[w];
+      bits[w] = covered | (covered << 1) | carry;
+      carry = covered >> 63;
+    }
+    bits[0] &= ~1ULL;
+    std::swap(scanPrev, scanCur);
+
+    int curBegin = (int)ccGst->runParent.size();
+    int j = prevBegin;
+    int c = findBit(bits, words, 0, true);
+    while (c < superPixMapW) {
+      int end = findBit(bits, words, c, false) - 1;
+      int id = (int)ccGst->runParent.size();
+      ccGst->runParent.push_back(id);
+      ccGst->runSize.push_back(end - c + 1);
+      ccGst->runR0.push_back(r);
+      ccGst->runC0.push_back(c);
+      ccGst->runR1.push_back(r);
+      ccGst->runC1.push_back(end);
+      ccGst->runStart.push_back(c);
+      ccGst->runEnd.push_back(end);
+
+      while (j < prevEnd && ccGst->runEnd[j] < c - 1) j++;
+      for (int k = j; k < prevEnd && ccGst->runStart[k] <= end + 1; k++) {
+        unionRuns(ccGst, id, k);
       }
+      c = findBit(bits, words, end + 1, true);
     }
+    prevBegin = curBegin;
+    prevEnd = (int)ccGst->runParent.size();
   }
 
-  // clean up: remove small ones and remove overlap
-  boundingBoxes = ccGst->boundingBoxesTmp;
-  boundingBoxesFinal = ccGst->boundingBoxes;
-  ctFinal = 0;
-
-  // remove overlapped boxes
+  /* 根 run 即连通域, 去掉过小的 */
   int area_super_thresh = area_thresh / BLOCK_SIZE / BLOCK_SIZE;
-  for (i = 0; i < tmpMaxLabel; i++) {
-    objectSize = boundingBoxes[5 * i + 0];
-    if (objectSize > area_super_thresh) {
-      R0 = boundingBoxes[5 * i + 1] * BLOCK_SIZE;
-      C0 = boundingBoxes[5 * i + 2] * BLOCK_SIZE;
-      R1 = boundingBoxes[5 * i + 3] * BLOCK_SIZE;
-      C1 = boundingBoxes[5 * i + 4] * BLOCK_SIZE;
-      int area = (C1 - C0) * (R1 - R0);
-      if (area < area_thresh) continue;
-      boundingBoxesFinal[5 * ctFinal + 0] = objectSize;
-      boundingBoxesFinal[5 * ctFinal + 1] = R0;
-      boundingBoxesFinal[5 * ctFinal + 2] = C0;
-      boundingBoxesFinal[5 * ctFinal + 3] = R1;
-      boundingBoxesFinal[5 * ctFinal + 4] = C1;
-      ctFinal++;
-    }
+  std::vector<int> &boundingBoxes = ccGst->boundingBoxes;
+  for (size_t i = 0; i < ccGst->runParent.size(); i++) {
+    if (ccGst->runParent[i] != (int)i) continue;
+    int objectSize = ccGst->runSize[i];
+    if (objectSize <= area_super_thresh) continue;
+    int R0 = ccGst->runR0[i] * BLOCK_SIZE;
+    int C0 = ccGst->runC0[i] * BLOCK_SIZE;
+    int R1 = ccGst->runR1[i] * BLOCK_SIZE;
+    int C1 = ccGst->runC1[i] * BLOCK_SIZE;
+    int area = (C1 - C0) * (R1 - R0);
+    if (area < area_thresh) continue;
+    boundingBoxes.insert(boundingBoxes.end(), {objectSize, R0, C0, R1, C1});
   }
 
-  ctFinal = filterInsideBoxes(boundingBoxesFinal, ctFinal);
-  ctFinal = filterInsideBoxes(boundingBoxesFinal, ctFinal);
-  ccGst->maxID = ctFinal;
-  ccGst->numObjects = ctFinal;
-  *p_num_boxes = ccGst->numObjects;
-  return ccGst->boundingBoxes;
+  int ctFinal = filterInsideBoxes(boundingBoxes.data(),
+                                  (int)boundingBoxes.size() / 5);
+  boundingBoxes.resize(ctFinal * 5);
+  *p_num_boxes = ctFinal;
+  return boundingBoxes.data();
 } /*end of: void extractConnectedComponent() | connected component labeling.*/
 
 void destroyConnectedComponent(void *ccGst) {
   if (ccGst == NULL) return;
-  CCLType *p_inst = (CCLType *)ccGst;
-  releaseConnectedComponent(p_inst);
-  delete p_inst;
+  delete (CCLType *)ccGst;
 }
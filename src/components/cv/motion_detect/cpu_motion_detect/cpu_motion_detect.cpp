@@ -0,0 +1,295 @@
+#include "cpu_motion_detect.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "common/ccl.hpp"
+#include "utils/tdl_log.hpp"
+
+namespace {
+
+struct MinOp {
+  uint8_t operator()(uint8_t a, uint8_t b) const { return std::min(a, b); }
+};
+
+struct MaxOp {
+  uint8_t operator()(uint8_t a, uint8_t b) const { return std::max(a, b); }
+};
+
+// 可分离的 3x3 最小/最大值滤波, 边界按复制处理
+template <typename Op>
+void morph3x3(const uint8_t *src, uint8_t *dst, uint8_t *tmp, int w, int h) {
+  Op op;
+  for (int y = 0; y < h; y++) {
+    const uint8_t *s = src + y * w;
+    uint8_t *t = tmp + y * w;
+    if (w == 1) {
+      t[0] = s[0];
+      continue;
+    }
+    t[0] = op(s[0], s[1]);
+    for (int x = 1; x < w - 1; x++) {
+      t[x] = op(op(s[x - 1], s[x]), s[x + 1]);
+    }
+    t[w - 1] = op(s[w - 2], s[w - 1]);
+  }
+  for (int y = 0; y < h; y++) {
+    const uint8_t *t0 = tmp + std::max(y - 1, 0) * w;
+    const uint8_t *t1 = tmp + y * w;
+    const uint8_t *t2 = tmp + std::min(y + 1, h - 1) * w;
+    uint8_t *d = dst + y * w;
+    for (int x = 0; x < w; x++) {
+      d[x] = op(op(t0[x], t1[x]), t2[x]);
+    }
+  }
+}
+
+bool hasLumaPlane(ImageFormat format) {
+  switch (format) {
+    case ImageFormat::GRAY:
+    case ImageFormat::YUV420SP_UV:
+    case ImageFormat::YUV420SP_VU:
+    case ImageFormat::YUV420P_UV:
+    case ImageFormat::YUV420P_VU:
+    case ImageFormat::YUV422P_UV:
+    case ImageFormat::YUV422P_VU:
+    case ImageFormat::YUV422SP_UV:
+    case ImageFormat::YUV422SP_VU:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+constexpr int CpuMotionDetection::kDownsample;
+constexpr int CpuMotionDetection::kMinLabelCells;
+
+CpuMotionDetection::CpuMotionDetection() : ccl_instance_(nullptr) {
+  // 创建连通域标记实例
+  ccl_instance_ = createConnectInstance();
+}
+
+CpuMotionDetection::~CpuMotionDetection() {
+  // 释放连通域标记实例
+  destroyConnectedComponent(ccl_instance_);
+}
+
+int32_t CpuMotionDetection::downsample(
+    const std::shared_ptr<BaseImage> &image) {
+  if (!hasLumaPlane(image->getImageFormat())) {
+    LOGE("Image format should be GRAY or YUV, got %d\n",
+         static_cast<int>(image->getImageFormat()));
+    return -1;
+  }
+  uint32_t width = image->getWidth();
+  uint32_t height = image->getHeight();
+  if (width < kDownsample || height < kDownsample) {
+    LOGE("Image is too small, width: %u, height: %u\n", width, height);
+    return -1;
+  }
+  if (width != im_width_ || height != im_height_) {
+    im_width_ = width;
+    im_height_ = height;
+    grid_w_ = width / kDownsample;
+    grid_h_ = height / kDownsample;
+    size_t grid_size = (size_t)grid_w_ * grid_h_;
+    grid_.resize(grid_size);
+    background_.resize(grid_size);
+    mask_.resize(grid_size);
+    eroded_.resize(grid_size);
+    morph_temp_.resize(grid_size);
+    has_background_ = false;
+  }
+
+  image->invalidateCache();
+  const uint8_t *luma = image->getVirtualAddress()[0];
+  const uint32_t stride = image->getStrides()[0];
+  for (int y = 0; y < grid_h_; y++) {
+    const uint8_t *r0 = luma + (size_t)(y * kDownsample) * stride;
+    const uint8_t *r1 = r0 + stride;
+    uint8_t *dst = grid_.data() + (size_t)y * grid_w_;
+    for (int x = 0; x < grid_w_; x++) {
+      dst[x] = (uint8_t)((r0[2 * x] + r0[2 * x + 1] + r1[2 * x] +
+                          r1[2 * x + 1] + 2) >>
+                         2);
+    }
+  }
+  return 0;
+}
+
+int32_t CpuMotionDetection::setBackground(
+    const std::shared_ptr<BaseImage> &background_image) {
+  if (!background_image) {
+    LOGE("Background image is null\n");
+    return -1;
+  }
+  if (downsample(background_image) != 0) {
+    return -1;
+  }
+  for (size_t i = 0; i < grid_.size(); i++) {
+    background_[i] = (uint16_t)(grid_[i] << 8);
+  }
+  has_background_ = true;
+  return 0;
+}
+
+int32_t CpuMotionDetection::setROI(const std::vector<ObjectBoxInfo> &_roi_s) {
+  if (_roi_s.empty()) {
+    LOGE("ROI list is empty\n");
+    return -1;
+  }
+
+  // 确保背景图像已设置
+  if (!has_background_) {
+    LOGE("Background image is not set\n");
+    return -1;
+  }
+
+  int imw = im_width_;
+  int imh = im_height_;
+
+  // 验证ROI区域有效性
+  for (size_t i = 0; i < _roi_s.size(); i++) {
+    auto p = _roi_s[i];
+    if (p.x2 < p.x1 || p.x1 < 0 || p.x2 >= imw) {
+      LOGE("roi[%zu] x overflow, x1:%.2f, x2:%.2f, imgw:%d\n", i, p.x1, p.x2,
+           imw);
+      use_roi_ = false;
+      return -1;
+    }
+    if (p.y2 < p.y1 || p.y1 < 0 || p.y2 >= imh) {
+      LOGE("roi[%zu] y overflow, y1:%.2f, y2:%.2f, imgh:%d\n", i, p.y1, p.y2,
+           imh);
+      use_roi_ = false;
+      return -1;
+    }
+  }
+
+  // 设置ROI区域
+  roi_s_ = _roi_s;
+  use_roi_ = true;
+
+  return 0;
+}
+
+void CpuMotionDetection::updateBackground(uint8_t threshold) {
+  const int bg_shift = background_learn_shift_;
+  const int fg_shift = foreground_learn_shift_;
+  const uint8_t *cur = grid_.data();
+  uint16_t *bg = background_.data();
+  uint8_t *mask = mask_.data();
+  const size_t n = grid_.size();
+  for (size_t i = 0; i < n; i++) {
+    int value = cur[i];
+    int model = bg[i];
+    int is_fg = std::abs(value - (model >> 8)) > threshold;
+    mask[i] = (uint8_t)(-is_fg);
+    int delta = (value << 8) - model;
+    int step = is_fg ? (delta >> fg_shift) : (delta >> bg_shift);
+    bg[i] = (uint16_t)(model + step);
+  }
+}
+
+void CpuMotionDetection::openMask() {
+  morph3x3<MinOp>(mask_.data(), eroded_.data(), morph_temp_.data(), grid_w_,
+                  grid_h_);
+  morph3x3<MaxOp>(eroded_.data(), mask_.data(), morph_temp_.data(), grid_w_,
+                  grid_h_);
+}
+
+void CpuMotionDetection::extractBoxes(int grid_x, int grid_y, int grid_w,
+                                      int grid_h, double min_area,
+                                      std::vector<ObjectBoxInfo> &objs) {
+  int num_boxes = 0;
+  int grid_area = (int)(min_area / (kDownsample * kDownsample));
+  uint8_t *vir_addr = mask_.data() + (size_t)grid_y * grid_w_ + grid_x;
+  int *p_boxes = extractConnectedComponent(
+      vir_addr, grid_w, grid_h, grid_w_, grid_area, ccl_instance_, &num_boxes);
+
+  const float max_x = im_width_ - 1;
+  const float max_y = im_height_ - 1;
+  for (int j = 0; j < num_boxes; ++j) {
+    ObjectBoxInfo box;
+    box.x1 = (p_boxes[j * 5 + 2] + grid_x) * kDownsample;
+    box.y1 = (p_boxes[j * 5 + 1] + grid_y) * kDownsample;
+    box.x2 =
+        std::min((float)(p_boxes[j * 5 + 4] + grid_x) * kDownsample, max_x);
+    box.y2 =
+        std::min((float)(p_boxes[j * 5 + 3] + grid_y) * kDownsample, max_y);
+    objs.push_back(box);
+  }
+}
+
+void CpuMotionDetection::checkSmallRoi(const ObjectBoxInfo &roi, int grid_x,
+                                       int grid_y, int grid_w, int grid_h,
+                                       double min_area,
+                                       std::vector<ObjectBoxInfo> &objs) {
+  int fg_cells = 0;
+  for (int y = grid_y; y < grid_y + grid_h; y++) {
+    const uint8_t *mask = mask_.data() + (size_t)y * grid_w_ + grid_x;
+    for (int x = 0; x < grid_w; x++) {
+      fg_cells += mask[x] != 0;
+    }
+  }
+  if (fg_cells > 0 && fg_cells * kDownsample * kDownsample >= min_area) {
+    objs.push_back(roi);
+  }
+}
+
+int32_t CpuMotionDetection::detect(const std::shared_ptr<BaseImage> &image,
+                                   uint8_t threshold, double min_area,
+                                   std::vector<ObjectBoxInfo> &objs) {
+  objs.clear();
+  if (!image) {
+    LOGE("Input image is null\n");
+    return -1;
+  }
+  if (has_background_ &&
+      (image->getHeight() != im_height_ || image->getWidth() != im_width_)) {
+    LOGE(
+        "Height and width of image isn't equal to background image in "
+        "CpuMotionDetection\n");
+    return -1;
+  }
+  if (downsample(image) != 0) {
+    return -1;
+  }
+  // 未设置背景时以第一帧作为背景
+  if (!has_background_) {
+    for (size_t i = 0; i < grid_.size(); i++) {
+      background_[i] = (uint16_t)(grid_[i] << 8);
+    }
+    has_background_ = true;
+    return 0;
+  }
+
+  updateBackground(threshold);
+  openMask();
+
+  // 提取连通域
+  if (use_roi_) {
+    for (size_t i = 0; i < roi_s_.size(); i++) {
+      const ObjectBoxInfo &roi = roi_s_[i];
+      // ROI 覆盖的网格 (含两端), 奇数宽高时最后一行/列归入最后一格
+      int gx2 = std::min((int)roi.x2 / kDownsample, grid_w_ - 1);
+      int gy2 = std::min((int)roi.y2 / kDownsample, grid_h_ - 1);
+      int gx1 = std::min((int)roi.x1 / kDownsample, gx2);
+      int gy1 = std::min((int)roi.y1 / kDownsample, gy2);
+      int roi_w = gx2 - gx1 + 1;
+      int roi_h = gy2 - gy1 + 1;
+      if (roi_w < kMinLabelCells || roi_h < kMinLabelCells) {
+        checkSmallRoi(roi, gx1, gy1, roi_w, roi_h, min_area, objs);
+        continue;
+      }
+      extractBoxes(gx1, gy1, roi_w, roi_h, min_area, objs);
+    }
+  } else {
+    // 对整个图像进行处理
+    extractBoxes(0, 0, grid_w_, grid_h_, min_area, objs);
+  }
+  return 0;
+}
+
+bool CpuMotionDetection::isROIEmpty() { return roi_s_.empty(); }
@@ -0,0 +1,59 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "common/model_output_types.hpp"
+#include "cv/motion_detect/motion_detect.hpp"
+#include "image/base_image.hpp"
+
+// 纯 CPU 运动检测, 不依赖平台 IVE/BMCV.
+// 在 kDownsample 倍下采样的网格上维护逐像素的滑动平均背景 (Q8 定点),
+// 每帧增量更新背景, 然后做帧差, 阈值, 开运算, 最后送入连通域标记.
+class CpuMotionDetection : public MotionDetection {
+ public:
+  CpuMotionDetection();
+  ~CpuMotionDetection();
+
+  int32_t setBackground(
+      const std::shared_ptr<BaseImage> &background_image) override;
+  int32_t setROI(const std::vector<ObjectBoxInfo> &_roi_s) override;
+  int32_t detect(const std::shared_ptr<BaseImage> &image, uint8_t threshold,
+                 double min_area, std::vector<ObjectBoxInfo> &objs) override;
+  bool isROIEmpty() override;
+
+  static constexpr int kDownsample = 2;
+  // 连通域标记按 2x2 超像素窗口扫描, 宽或高小于该网格数的 ROI 标记不出
+  // 连通域, 改为统计其中的前景格子, 有前景时输出整个 ROI
+  static constexpr int kMinLabelCells = 8;
+  // 背景学习率 1/2^shift; 前景像素学习更慢, 避免运动目标很快融入背景
+  int background_learn_shift_ = 5;
+  int foreground_learn_shift_ = 8;
+
+ private:
+  // 取亮度平面并 2x2 平均下采样到 grid_
+  int32_t downsample(const std::shared_ptr<BaseImage> &image);
+  // 帧差/阈值并更新背景, 结果写入 mask_
+  void updateBackground(uint8_t threshold);
+  // 3x3 开运算 (先腐蚀后膨胀)
+  void openMask();
+  void extractBoxes(int grid_x, int grid_y, int grid_w, int grid_h,
+                    double min_area, std::vector<ObjectBoxInfo> &objs);
+  void checkSmallRoi(const ObjectBoxInfo &roi, int grid_x, int grid_y,
+                     int grid_w, int grid_h, double min_area,
+                     std::vector<ObjectBoxInfo> &objs);
+
+  std::vector<ObjectBoxInfo> roi_s_;
+  void *ccl_instance_;
+  bool use_roi_ = false;
+  bool has_background_ = false;
+  uint32_t im_width_ = 0;   // 图像宽度
+  uint32_t im_height_ = 0;  // 图像高度
+  int grid_w_ = 0;
+  int grid_h_ = 0;
+
+  std::vector<uint8_t> grid_;         // 下采样后的当前帧
+  std::vector<uint16_t> background_;  // Q8 背景
+  std::vector<uint8_t> mask_;         // 前景掩码
+  std::vector<uint8_t> eroded_;
+  std::vector<uint8_t> morph_temp_;
+};
@@ -3,6 +3,8 @@
 #include "cvi_motion_detect/cvi_motion_detect.hpp"
 #elif defined(__CV184X__) || defined(__CMODEL_CV184X__)
 #include "bm_motion_detect/bm_motion_detect.hpp"
+#else
+#include "cpu_motion_detect/cpu_motion_detect.hpp"
 #endif
 #include "utils/tdl_log.hpp"
 
@@ -16,7 +18,6 @@ std::shared_ptr<MotionDetection> MotionDetection::getMotionDetection() {
 #elif defined(__CV180X__) || defined(__CV181X__) || defined(__CV186X__)
   return std::make_shared<CviMotionDetection>();
 #else
-  throw std::invalid_argument(
-      "Only support SOPHON, CV184X and CV181X motion detection");
+  return std::make_shared<CpuMotionDetection>();
 #endif
 }
@@ -1,89 +1,397 @@
 #include "cv/occlusion_detect/occlusion_detect.hpp"
-#include <numeric>
-#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
 #include <vector>
 
-OcclusionDetector::OcclusionDetector() = default;
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
-int OcclusionDetector::detect(std::shared_ptr<BaseImage> image,
-                              cvtdl_occlusion_meta_t* meta) {
-  if (!image || !meta) {
-    std::cerr << "Invalid input" << std::endl;
-    return -1;
+namespace {
+
+// 自动选择金字塔层时缩小后 ROI 长边的上限
+constexpr int kAutoMaxSide = 320;
+constexpr int kMaxPyramidLevel = 6;
+// 原分辨率下闭运算核的半径 (7x7)
+constexpr int kCloseRadius = 3;
+
+// BGR -> 灰度的 14 位定点系数, 与 cv::COLOR_BGR2GRAY 相同
+constexpr int kB2Y = 1868;
+constexpr int kG2Y = 9617;
+constexpr int kR2Y = 4899;
+
+// BORDER_REFLECT_101 的越界下标
+inline int reflect101(int i, int n) {
+  if (n == 1) return 0;
+  if (i < 0) return -i;
+  if (i >= n) return 2 * n - 2 - i;
+  return i;
+}
+
+// 相邻行 (上 up, 本行 mid, 下 down) 的 |Laplacian|, 饱和到 255
+void laplacianAbsRow(const uint8_t* up, const uint8_t* mid,
+                     const uint8_t* down, int w, uint8_t* dst) {
+  auto pixel = [&](int x) {
+    int l = mid[reflect101(x - 1, w)], r = mid[reflect101(x + 1, w)];
+    int v = up[x] + down[x] + l + r - 4 * mid[x];
+    return (uint8_t)std::min(255, std::abs(v));
+  };
+  if (w < 3) {
+    for (int x = 0; x < w; x++) dst[x] = pixel(x);
+    return;
+  }
+  dst[0] = pixel(0);
+  int x = 1;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  for (; x + 8 <= w - 1; x += 8) {
+    auto load = [&](const uint8_t* p) {
+      return _mm_unpacklo_epi8(
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+    };
+    __m128i sum = _mm_add_epi16(_mm_add_epi16(load(up + x), load(down + x)),
+                                _mm_add_epi16(load(mid + x - 1),
+                                              load(mid + x + 1)));
+    __m128i v = _mm_sub_epi16(sum, _mm_slli_epi16(load(mid + x), 2));
+    v = _mm_max_epi16(v, _mm_sub_epi16(zero, v));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x),
+                     _mm_packus_epi16(v, v));
+  }
+#elif defined(__ARM_NEON)
+  for (; x + 8 <= w - 1; x += 8) {
+    int16x8_t sum = vreinterpretq_s16_u16(
+        vaddq_u16(vaddl_u8(vld1_u8(up + x), vld1_u8(down + x)),
+                  vaddl_u8(vld1_u8(mid + x - 1), vld1_u8(mid + x + 1))));
+    int16x8_t center = vreinterpretq_s16_u16(vshll_n_u8(vld1_u8(mid + x), 2));
+    vst1_u8(dst + x, vqmovun_s16(vabsq_s16(vsubq_s16(sum, center))));
   }
+#endif
+  for (; x < w; x++) dst[x] = pixel(x);
+}
 
-  int width = image->getWidth();
-  int height = image->getHeight();
-  auto strides = image->getStrides();
-  auto virAddrs = image->getVirtualAddress();
+// 按字节取最大/最小
+template <bool kMax>
+inline uint8_t pick(uint8_t a, uint8_t b) {
+  return kMax ? std::max(a, b) : std::min(a, b);
+}
 
-  if (strides.empty() || virAddrs.empty()) {
-    std::cerr << "Empty strides or virtual addresses" << std::endl;
-    return -1;
+// 水平方向 [x - r, x + r] 的最大/最小值, 窗口在图像内截断
+// (与 cv::morphologyEx 默认边界一致)
+template <bool kMax>
+void morphRow(const uint8_t* src, int w, int r, uint8_t* dst) {
+  int x = 0;
+  for (; x < std::min(r, w); x++) {
+    uint8_t v = src[x];
+    for (int k = std::max(0, x - r); k <= std::min(w - 1, x + r); k++) {
+      v = pick<kMax>(v, src[k]);
+    }
+    dst[x] = v;
+  }
+#if defined(__SSE2__)
+  for (; x + r + 16 <= w; x += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+    for (int k = -r; k <= r; k++) {
+      __m128i s =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x + k));
+      v = kMax ? _mm_max_epu8(v, s) : _mm_min_epu8(v, s);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), v);
+  }
+#elif defined(__ARM_NEON)
+  for (; x + r + 16 <= w; x += 16) {
+    uint8x16_t v = vld1q_u8(src + x);
+    for (int k = -r; k <= r; k++) {
+      uint8x16_t s = vld1q_u8(src + x + k);
+      v = kMax ? vmaxq_u8(v, s) : vminq_u8(v, s);
+    }
+    vst1q_u8(dst + x, v);
   }
+#endif
+  for (; x < w; x++) {
+    uint8_t v = src[x];
+    for (int k = std::max(0, x - r); k <= std::min(w - 1, x + r); k++) {
+      v = pick<kMax>(v, src[k]);
+    }
+    dst[x] = v;
+  }
+}
 
-  uint8_t* data_ptr = virAddrs[0];
-  uint32_t stride = strides[0];
+// 竖直方向 [y - r, y + r] 的最大/最小值
+template <bool kMax>
+void morphColumns(const uint8_t* src, int w, int h, int r, uint8_t* dst) {
+  for (int y = 0; y < h; y++) {
+    int y0 = std::max(0, y - r), y1 = std::min(h - 1, y + r);
+    uint8_t* out = dst + (size_t)y * w;
+    std::copy(src + (size_t)y0 * w, src + (size_t)(y0 + 1) * w, out);
+    for (int k = y0 + 1; k <= y1; k++) {
+      const uint8_t* in = src + (size_t)k * w;
+      int x = 0;
+#if defined(__SSE2__)
+      for (; x + 16 <= w; x += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x),
+                         kMax ? _mm_max_epu8(a, b) : _mm_min_epu8(a, b));
+      }
+#elif defined(__ARM_NEON)
+      for (; x + 16 <= w; x += 16) {
+        uint8x16_t a = vld1q_u8(out + x), b = vld1q_u8(in + x);
+        vst1q_u8(out + x, kMax ? vmaxq_u8(a, b) : vminq_u8(a, b));
+      }
+#endif
+      for (; x < w; x++) out[x] = pick<kMax>(out[x], in[x]);
+    }
+  }
+}
 
-  cv::Mat frame(height, width, CV_8UC3, data_ptr, stride);
+int findRoot(std::vector<int>& parent, int i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
 
-  int frame_h = frame.rows;
-  int frame_w = frame.cols;
-  cv::Rect roi(int(meta->crop_bbox.x1 * frame_w),
-               int(meta->crop_bbox.y1 * frame_h),
-               int((meta->crop_bbox.x2 - meta->crop_bbox.x1) * frame_w),
-               int((meta->crop_bbox.y2 - meta->crop_bbox.y1) * frame_h));
-  cv::Mat sub_frame = frame(roi);
+}  // namespace
 
-  cv::Mat gray;
-  cv::cvtColor(sub_frame, gray, cv::COLOR_BGR2GRAY);
+OcclusionDetector::OcclusionDetector() = default;
 
-  cv::Mat laplacian;
-  cv::Laplacian(gray, laplacian, CV_64F);
+void OcclusionDetector::setPyramidLevel(int level) {
+  pyramid_level_ = std::min(level, kMaxPyramidLevel);
+}
 
-  cv::Mat laplacianAbs;
-  cv::threshold(laplacian, laplacianAbs, 0, 0, cv::THRESH_TRUNC);
-  laplacianAbs = laplacian - 2 * laplacianAbs;
+void OcclusionDetector::setDetectInterval(int interval) {
+  detect_interval_ = std::max(1, interval);
+}
 
-  cv::Mat laplacian_8u;
-  cv::convertScaleAbs(laplacianAbs, laplacian_8u);
+int OcclusionDetector::extractGray(const std::shared_ptr<BaseImage>& image,
+                                   int roi_x, int roi_y, int level) {
+  auto strides = image->getStrides();
+  auto virAddrs = image->getVirtualAddress();
+  ImageFormat format = image->getImageFormat();
 
-  cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(7, 7));
-  cv::Mat closed;
-  cv::morphologyEx(laplacian_8u, closed, cv::MORPH_CLOSE, kernel);
+  // 每个通道的起始地址, 行跨度与像素步长; 灰度与 YUV 只用第一个平面
+  const uint8_t* ptrs[3];
+  uint32_t rowStrides[3];
+  int step = 1;
+  bool color = true;
+  if (format == ImageFormat::BGR_PACKED || format == ImageFormat::RGB_PACKED) {
+    for (int c = 0; c < 3; c++) {
+      ptrs[c] = virAddrs[0] + c;
+      rowStrides[c] = strides[0];
+    }
+    step = 3;
+  } else if (format == ImageFormat::BGR_PLANAR ||
+             format == ImageFormat::RGB_PLANAR) {
+    if (virAddrs.size() < 3 || strides.size() < 3) {
+      std::cerr << "Planar image needs 3 planes" << std::endl;
+      return -1;
+    }
+    for (int c = 0; c < 3; c++) {
+      ptrs[c] = virAddrs[c];
+      rowStrides[c] = strides[c];
+    }
+  } else {
+    ptrs[0] = virAddrs[0];
+    rowStrides[0] = strides[0];
+    color = false;
+  }
+  if (format == ImageFormat::RGB_PACKED || format == ImageFormat::RGB_PLANAR) {
+    std::swap(ptrs[0], ptrs[2]);
+    std::swap(rowStrides[0], rowStrides[2]);
+  }
 
-  cv::Mat binary;
-  cv::threshold(closed, binary, meta->laplacian_th, 255, cv::THRESH_BINARY);
+  // 第 level 层取每个 2^level 块中心的 2x2 像素平均, level 0 直接取像素
+  int block = 1 << level;
+  int offset = level > 0 ? block / 2 - 1 : 0;
+  int taps = level > 0 ? 2 : 1;
+  int shift = level > 0 ? 2 : 0;
+  gray_.resize((size_t)width_ * height_);
+  for (int y = 0; y < height_; y++) {
+    int sy = roi_y + y * block + offset;
+    uint8_t* out = gray_.data() + (size_t)y * width_;
+    for (int x = 0; x < width_; x++) {
+      int sx = (roi_x + x * block + offset) * step;
+      int sum[3] = {0, 0, 0};
+      for (int c = 0; c < (color ? 3 : 1); c++) {
+        for (int dy = 0; dy < taps; dy++) {
+          const uint8_t* p = ptrs[c] + (size_t)(sy + dy) * rowStrides[c] + sx;
+          sum[c] += p[0];
+          if (taps > 1) sum[c] += p[step];
+        }
+      }
+      if (color) {
+        int round = 1 << (13 + shift);
+        out[x] = (uint8_t)((sum[0] * kB2Y + sum[1] * kG2Y + sum[2] * kR2Y +
+                            round) >>
+                           (14 + shift));
+      } else {
+        out[x] = (uint8_t)((sum[0] + (shift ? 2 : 0)) >> shift);
+      }
+    }
+  }
+  return 0;
+}
 
-  cv::Mat binary_not;
-  cv::bitwise_not(binary, binary_not);
-  cv::Mat labels;
-  int num_labels = cv::connectedComponents(binary_not, labels, 4);
+void OcclusionDetector::computeEdge(int radius) {
+  size_t size = (size_t)width_ * height_;
+  edge_.resize(size);
+  tmp_.resize(size);
+  // |Laplacian| 写入 tmp_
+  for (int y = 0; y < height_; y++) {
+    const uint8_t* up =
+        gray_.data() + (size_t)reflect101(y - 1, height_) * width_;
+    const uint8_t* down =
+        gray_.data() + (size_t)reflect101(y + 1, height_) * width_;
+    laplacianAbsRow(up, gray_.data() + (size_t)y * width_, down, width_,
+                    tmp_.data() + (size_t)y * width_);
+  }
+  // 闭运算: 先膨胀再腐蚀, 矩形核拆成水平与竖直两次
+  for (int y = 0; y < height_; y++) {
+    morphRow<true>(tmp_.data() + (size_t)y * width_, width_, radius,
+                   edge_.data() + (size_t)y * width_);
+  }
+  morphColumns<true>(edge_.data(), width_, height_, radius, tmp_.data());
+  for (int y = 0; y < height_; y++) {
+    morphRow<false>(tmp_.data() + (size_t)y * width_, width_, radius,
+                    edge_.data() + (size_t)y * width_);
+  }
+  morphColumns<false>(edge_.data(), width_, height_, radius, tmp_.data());
+  edge_.swap(tmp_);
+}
 
-  std::vector<int> sizes(num_labels, 0);
-  for (int i = 0; i < labels.rows; i++) {
-    for (int j = 0; j < labels.cols; j++) {
-      sizes[labels.at<int>(i, j)]++;
+int OcclusionDetector::maxFlatArea(int threshold) {
+  run_parent_.clear();
+  run_area_.clear();
+  run_start_.clear();
+  run_end_.clear();
+  int prev_begin = 0, prev_end = 0;
+  for (int y = 0; y < height_; y++) {
+    const uint8_t* row = edge_.data() + (size_t)y * width_;
+    int cur_begin = (int)run_start_.size();
+    int p = prev_begin;
+    for (int x = 0; x < width_;) {
+      while (x < width_ && row[x] > threshold) x++;
+      if (x >= width_) break;
+      int start = x;
+      while (x < width_ && row[x] <= threshold) x++;
+      int id = (int)run_start_.size();
+      run_start_.push_back(start);
+      run_end_.push_back(x);
+      run_parent_.push_back(id);
+      run_area_.push_back(x - start);
+      // 上一行与 [start, x) 有列重叠的 run 属于同一个 4 连通域
+      while (p < prev_end && run_end_[p] <= start) p++;
+      for (int q = p; q < prev_end && run_start_[q] < x; q++) {
+        int a = findRoot(run_parent_, q), b = findRoot(run_parent_, id);
+        if (a == b) continue;
+        int root = std::min(a, b), child = std::max(a, b);
+        run_parent_[child] = root;
+        run_area_[root] += run_area_[child];
+      }
+      // 末尾的 run 可能还与当前行下一个 run 重叠
+      if (p < prev_end && run_end_[p] <= x) p++;
     }
+    prev_begin = cur_begin;
+    prev_end = (int)run_start_.size();
+  }
+  int max_area = 0;
+  for (size_t i = 0; i < run_parent_.size(); i++) {
+    if (run_parent_[i] == (int)i) max_area = std::max(max_area, run_area_[i]);
   }
-  int max_area =
-      (num_labels > 1) ? *std::max_element(sizes.begin() + 1, sizes.end()) : 0;
-  int total_pixels = labels.rows * labels.cols;
-  float occ_ratio = static_cast<float>(max_area) / total_pixels;
+  return max_area;
+}
 
-  meta->occ_score = occ_ratio;
-  meta->occ_class = (occ_ratio >= meta->occ_ratio_th) ? 1 : 0;
+int OcclusionDetector::vote(int occ_class, int sensitive_th) {
+  // 与原实现一致: 窗口为空, 按空窗口的多数决定 (sensitive_th 为 0 时恒为 0)
+  if (sensitive_th <= 0) return 0 > sensitive_th / 2 ? 1 : 0;
+  if ((int)occlusionStates_.size() != sensitive_th) {
+    occlusionStates_.assign(sensitive_th, 0);
+    state_pos_ = 0;
+    state_num_ = 0;
+    occluded_num_ = 0;
+  }
+  occluded_num_ += occ_class - occlusionStates_[state_pos_];
+  occlusionStates_[state_pos_] = (uint8_t)occ_class;
+  state_pos_ = (state_pos_ + 1) % sensitive_th;
+  // 累计超过 sensitive_th 次后, 按最近 sensitive_th 次的多数决定类别
+  if (state_num_ <= sensitive_th) state_num_++;
+  if (state_num_ <= sensitive_th) return occ_class;
+  return occluded_num_ > sensitive_th / 2 ? 1 : 0;
+}
+
+int OcclusionDetector::detect(std::shared_ptr<BaseImage> image,
+                              cvtdl_occlusion_meta_t* meta) {
+  if (!image || !meta) {
+    std::cerr << "Invalid input" << std::endl;
+    return -1;
+  }
+  if (frame_count_++ % detect_interval_ != 0) {
+    meta->occ_score = last_score_;
+    meta->occ_class = last_class_;
+    return 0;
+  }
 
-  occlusionStates_.push_back(meta->occ_class);
-  if ((int)occlusionStates_.size() > meta->sensitive_th) {
-    occlusionStates_.erase(occlusionStates_.begin());
-    int occludedCount =
-        std::accumulate(occlusionStates_.begin(), occlusionStates_.end(), 0);
-    int pre_class = (occludedCount > meta->sensitive_th / 2) ? 1 : 0;
-    meta->occ_class = pre_class;
+  int frame_w = image->getWidth();
+  int frame_h = image->getHeight();
+  if (image->getStrides().empty() || image->getVirtualAddress().empty()) {
+    std::cerr << "Empty strides or virtual addresses" << std::endl;
+    return -1;
   }
 
+  int roi_x = std::max(0, int(meta->crop_bbox.x1 * frame_w));
+  int roi_y = std::max(0, int(meta->crop_bbox.y1 * frame_h));
+  int roi_w = std::min(
+      frame_w - roi_x,
+      int((meta->crop_bbox.x2 - meta->crop_bbox.x1) * frame_w));
+  int roi_h = std::min(
+      frame_h - roi_y,
+      int((meta->crop_bbox.y2 - meta->crop_bbox.y1) * frame_h));
+  if (roi_w <= 0 || roi_h <= 0) {
+    std::cerr << "Invalid crop bbox" << std::endl;
+    return -1;
+  }
+
+  int level = pyramid_level_;
+  if (level < 0) {
+    level = 0;
+    while (level < kMaxPyramidLevel &&
+           std::max(roi_w, roi_h) >> level > kAutoMaxSide) {
+      level++;
+    }
+  }
+  // 缩小后每边至少保留 2 个像素
+  while (level > 0 && std::min(roi_w, roi_h) >> level < 2) level--;
+  width_ = roi_w >> level;
+  height_ = roi_h >> level;
+
+  if (extractGray(image, roi_x, roi_y, level) != 0) {
+    return -1;
+  }
+  computeEdge(std::max(1, kCloseRadius >> level));
+  // cv::threshold 对 8 位图像的阈值向下取整
+  int threshold =
+      (int)std::min(255.0, std::max(-1.0, std::floor(meta->laplacian_th)));
+  int max_area = maxFlatArea(threshold);
+  float occ_ratio = static_cast<float>(max_area) / (width_ * height_);
+
+  meta->occ_score = occ_ratio;
+  meta->occ_class = vote(occ_ratio >= meta->occ_ratio_th ? 1 : 0,
+                         meta->sensitive_th);
+  last_score_ = meta->occ_score;
+  last_class_ = meta->occ_class;
   return 0;
 }
 
-void OcclusionDetector::reset() { occlusionStates_.clear(); }
+void OcclusionDetector::reset() {
+  occlusionStates_.clear();
+  state_pos_ = 0;
+  state_num_ = 0;
+  occluded_num_ = 0;
+  frame_count_ = 0;
+  last_score_ = 0;
+  last_class_ = 0;
+}
@@ -69,6 +69,8 @@ bool ImageEncoder::encodeFrame(const std::shared_ptr<BaseImage>& image,
     std::cerr << "[ImageEncoder] Error: input image is nullptr.\n";
     return false;
   }
+  // the venc channel (and its attributes) is shared by every caller
+  std::lock_guard<std::mutex> lock(mutex_);
 
 #if defined(__CV181X__) || defined(__CV180X__) || defined(__CV182X__) || \
     defined(__CV183X__) || defined(__CV184X__) || defined(__CV186X__)
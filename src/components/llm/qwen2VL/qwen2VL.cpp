@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "qwen2VL.hpp"
+#include "utils/tdl_log.hpp"
 inline uint16_t fp32_to_fp16_bits(float f) {
   uint32_t x = *((uint32_t *)&f);
   uint16_t h = ((x >> 16) & 0x8000) |
@@ -120,9 +121,38 @@ void Qwen2VL::init(int dev_id, std::string model_path) {
 
   mask_value =
       fp32_to_uint16(QWEN2VL_ATTENTION_MASK, net_blocks[0]->input_dtypes[0]);
+  init_prefill_staging();
+}
+
+void Qwen2VL::init_prefill_staging() {
+  io_alone = net_vit->addr_mode == 1 && net_blocks[0]->addr_mode == 1;
+  input_ids_staging.assign(SEQLEN, 0);
+  input_ids_dirty = 0;
+
+  // row i attends to columns [0, i], the same for every request
+  prefill_mask.assign((size_t)SEQLEN * SEQLEN, mask_value);
+  for (int i = 0; i < SEQLEN; i++) {
+    std::fill_n(prefill_mask.begin() + (size_t)i * SEQLEN, i + 1,
+                (uint16_t)0);
+  }
+  prefill_mask_dirty_rows = SEQLEN;
+
+  pixel_values_staging.assign((size_t)MAX_PIXELS * VIT_DIMS, 0);
+  pixel_values_dirty = pixel_values_staging.size();
+  vit_mask_staging.assign((size_t)MAX_PIXELS * MAX_PIXELS, 0);
+  vit_mask_dirty = MAX_PIXELS;
+
+  auto vit_out_size =
+      bm_mem_get_device_size(net_vit->stages[0].output_mems[0]);
+  vit_out_fp32.resize(vit_out_size / sizeof(float));
+  vit_out_bf16.resize(vit_out_size / sizeof(float));
+  bm_status_t status =
+      bm_malloc_device_byte(bm_handle, &vit_bf16_buffer, vit_out_size / 2);
+  assert(BM_SUCCESS == status);
 }
 
 void Qwen2VL::deinit() {
+  bm_free_device(bm_handle, vit_bf16_buffer);
   bm_free_device(bm_handle, dev_buffer);
   bmrt_destroy(p_bmrt);
   bm_dev_free(bm_handle);
@@ -209,88 +239,64 @@ int Qwen2VL::forward_first(std::vector<int> &tokens,
                            std::vector<int> &posids,
                            std::vector<float> &attnmask, int img_offset,
                            int pixel_num) {
-  std::cout << "[DEBUG] Enter forward_first\n";
-  std::cout << "[DEBUG] tokens.size() = " << tokens.size() << "\n";
-  std::cout << "[DEBUG] position_ids.size() = " << position_ids.size() << "\n";
-  std::cout << "[DEBUG] pixel_values.size() = " << pixel_values.size() << "\n";
-  std::cout << "[DEBUG] cu_seqlens_list.size() = " << attnmask.size() << "\n";
-
-  std::vector<int> input_ids(SEQLEN, 0);
-  std::vector<uint16_t> attention_mask(SEQLEN * SEQLEN, 0);
+  LOGI(
+      "forward_first, tokens: %zu, position_ids: %zu, pixel_values: %zu, "
+      "attnmask: %zu",
+      tokens.size(), position_ids.size(), pixel_values.size(),
+      attnmask.size());
 
   // 检查 tokens 大小是否超出 SEQLEN
-  if (tokens.size() > SEQLEN) {
-    std::cerr << "[ERROR] tokens.size() > SEQLEN (" << tokens.size() << " > "
-              << SEQLEN << ")\n";
+  if (tokens.size() > (size_t)SEQLEN) {
+    LOGE("tokens.size() > SEQLEN (%zu > %d)", tokens.size(), SEQLEN);
     return -1;
   }
-
-  std::copy(tokens.begin(), tokens.end(), input_ids.data());
-
-  POSITION_IDS.resize(position_ids.size() / 3, std::vector<int>(3));
-  MAX_POS = 0;
-  std::vector<int> p_ids(SEQLEN * 3, 0);
-  std::cout << "[DEBUG] POSITION_IDS resized to " << position_ids.size() / 3
-            << " rows\n";
-
-  // std::vector<uint16_t> input_vit(500*3584, 0);
-  // for (size_t i = 0; i < vit_out_ref.size(); ++i)
-  //   input_vit[i] = fp32_to_bf16_bits(vit_out_ref[i]);
-
-  std::vector<float> pixel_values_pad(MAX_PIXELS * VIT_DIMS, 0);
   // 对 pixel_values 进行数据拷贝，检查尺寸是否足够
-  if (pixel_values.size() > pixel_values_pad.size()) {
-    std::cerr << "[ERROR] pixel_values.size() > pixel_values_pad.size() ("
-              << pixel_values.size() << " > " << pixel_values_pad.size()
-              << ")\n";
+  if (pixel_values.size() > pixel_values_staging.size()) {
+    LOGE("pixel_values.size() > MAX_PIXELS * VIT_DIMS (%zu > %zu)",
+         pixel_values.size(), pixel_values_staging.size());
+    return -1;
+  }
+  int vit_pixels = int(pixel_values.size() / VIT_DIMS);
+  // attnmask is either MAX_PIXELS x MAX_PIXELS or vit_pixels x vit_pixels,
+  // entries outside the vit_pixels x vit_pixels block are padding
+  bool compact_vit_mask = attnmask.size() == (size_t)vit_pixels * vit_pixels;
+  if (img_offset > 0 && !compact_vit_mask &&
+      attnmask.size() < (size_t)MAX_PIXELS * MAX_PIXELS) {
+    LOGE("attnmask.size() %zu is neither %d x %d nor %d x %d",
+         attnmask.size(), vit_pixels, vit_pixels, MAX_PIXELS, MAX_PIXELS);
+    return -1;
+  }
+  if (img_offset > 0 &&
+      (size_t)pixel_num * HIDDEN_SIZE > vit_out_fp32.size()) {
+    LOGE("pixel_num %d exceeds the vit output", pixel_num);
     return -1;
   }
-  std::copy(pixel_values.begin(), pixel_values.end(), pixel_values_pad.data());
-  std::cout << "[DEBUG] Copied pixel_values to pixel_values_pad\n";
+
+  token_length = tokens.size();  // text input length
+  std::copy(tokens.begin(), tokens.end(), input_ids_staging.begin());
+  if (input_ids_dirty > token_length) {
+    std::fill(input_ids_staging.begin() + token_length,
+              input_ids_staging.begin() + input_ids_dirty, 0);
+  }
+  input_ids_dirty = token_length;
 
   // 遍历 position_ids 并赋值给 POSITION_IDS
+  POSITION_IDS.resize(position_ids.size() / 3, std::vector<int>(3));
+  MAX_POS = 0;
   for (size_t i = 0; i < POSITION_IDS.size(); ++i) {
     for (int j = 0; j < 3; ++j) {
-      size_t pos_index = j * POSITION_IDS.size() + i;
-      if (pos_index >= position_ids.size()) {
-        std::cerr << "[ERROR] pos_index (" << pos_index
-                  << ") out of range for position_ids.size() = "
-                  << position_ids.size() << "\n";
-        return -1;
-      }
-      int current_value = position_ids[pos_index];
+      int current_value = position_ids[j * POSITION_IDS.size() + i];
       if (MAX_POS < current_value) MAX_POS = current_value;
       POSITION_IDS[i][j] = current_value;
     }
   }
-  std::cout << "[DEBUG] POSITION_IDS populated; MAX_POS = " << MAX_POS << "\n";
-
-  token_length = tokens.size();  // text input length
-  std::cout << "[DEBUG] token_length = " << token_length << "\n";
-
-  for (int i = 0; i < token_length; i++) {
-    for (int j = 0; j < SEQLEN; j++) {
-      if (j <= i) {
-        attention_mask[i * SEQLEN + j] = 0;
-      } else {
-        attention_mask[i * SEQLEN + j] = mask_value;
-      }
-    }
-  }
-  std::cout << "[DEBUG] attention_mask initialized\n";
-
-  std::vector<float> vit_attention_mask(MAX_PIXELS * MAX_PIXELS, 0);
-  for (int i = 0; i < MAX_PIXELS * MAX_PIXELS; i++) {
-    if (attnmask[i] != 0) {
-      vit_attention_mask[i] = std::numeric_limits<float>::lowest();
-    }
-  }
-  std::cout << "[DEBUG] vit_attention_mask computed\n";
+  LOGI("token_length: %d, MAX_POS: %d", token_length, MAX_POS);
 
   // forward embeding
   auto &in_mem = net_embed->stages[0].input_mems[0];
-  auto &out_mem = net_embed->stages[0].output_mems[0];
-  bm_memcpy_s2d(bm_handle, in_mem, (void *)input_ids.data());
+  // local copy, the stage memories of the nets must not be rebound
+  bm_device_mem_t out_mem = net_embed->stages[0].output_mems[0];
+  bm_memcpy_s2d(bm_handle, in_mem, (void *)input_ids_staging.data());
   net_launch(net_embed);  // prefil embedding
 
   auto start = std::chrono::high_resolution_clock::now();
@@ -302,83 +308,97 @@ int Qwen2VL::forward_first(std::vector<int> &tokens,
     auto &vit_in_mem_posids = net_vit->stages[0].input_mems[1];
     auto &vit_in_mem_attnmask = net_vit->stages[0].input_mems[2];
     auto &vit_out_mem = net_vit->stages[0].output_mems[0];
-    bm_memcpy_s2d(bm_handle, vit_in_mem_pixels,
-                  (void *)pixel_values_pad.data());
+
+    // pixel values: rewrite this request's pixels, zero what the last
+    // request left beyond them, the rest of the device buffer is still zero
+    // unless the input memory is shared with other nets
+    std::copy(pixel_values.begin(), pixel_values.end(),
+              pixel_values_staging.begin());
+    if (pixel_values_dirty > pixel_values.size()) {
+      std::fill(pixel_values_staging.begin() + pixel_values.size(),
+                pixel_values_staging.begin() + pixel_values_dirty, 0.f);
+    }
+    size_t pixel_upload =
+        io_alone ? std::max(pixel_values.size(), pixel_values_dirty)
+                 : pixel_values_staging.size();
+    bm_memcpy_s2d_partial(bm_handle, vit_in_mem_pixels,
+                          (void *)pixel_values_staging.data(),
+                          pixel_upload * sizeof(float));
+    pixel_values_dirty = pixel_values.size();
+
     bm_memcpy_s2d(bm_handle, vit_in_mem_posids, (void *)posids.data());
-    bm_memcpy_s2d(bm_handle, vit_in_mem_attnmask,
-                  (void *)vit_attention_mask.data());
+
+    // vit mask: same scheme on the leading rows
+    const float mask_lowest = std::numeric_limits<float>::lowest();
+    int mask_rows = std::max(vit_pixels, vit_mask_dirty);
+    for (int r = 0; r < mask_rows; r++) {
+      float *dst = vit_mask_staging.data() + (size_t)r * MAX_PIXELS;
+      if (r >= vit_pixels) {
+        std::fill(dst, dst + vit_mask_dirty, 0.f);
+        continue;
+      }
+      const float *src =
+          attnmask.data() +
+          (size_t)r * (compact_vit_mask ? vit_pixels : MAX_PIXELS);
+      for (int c = 0; c < vit_pixels; c++) {
+        dst[c] = src[c] != 0 ? mask_lowest : 0.f;
+      }
+      if (vit_mask_dirty > vit_pixels) {
+        std::fill(dst + vit_pixels, dst + vit_mask_dirty, 0.f);
+      }
+    }
+    int upload_rows = io_alone ? mask_rows : MAX_PIXELS;
+    bm_memcpy_s2d_partial(bm_handle, vit_in_mem_attnmask,
+                          (void *)vit_mask_staging.data(),
+                          (size_t)upload_rows * MAX_PIXELS * sizeof(float));
+    vit_mask_dirty = vit_pixels;
+
     // dump_net_input_to_file(bm_handle, net_vit, "vit_input.npz");
     net_launch(net_vit);
 
-    // concatenante texting embedding and image embedding
+    // concatenante texting embedding and image embedding, only the
+    // pixel_num rows that are used are converted to bf16
     int dst_offset = img_offset * HIDDEN_SIZE * 2;
-    int vit_size = pixel_num * HIDDEN_SIZE * sizeof(uint16_t);
-    // bm_memcpy_d2d_byte(bm_handle, out_mem, dst_offset, vit_out_mem, 0,
-    // vit_size);
-
-    int cnt = bm_mem_get_device_size(vit_out_mem) / 4;
-    auto buffer = std::make_unique<float[]>(cnt);
-    bm_memcpy_d2s(bm_handle, buffer.get(), vit_out_mem);
-    std::vector<uint16_t> uint16_value(cnt, 0);
-    for (int i = 0; i < cnt; ++i)
-      uint16_value[i] = fp32_to_bf16_bits(buffer[i]);
-    auto buffer_size = bm_mem_get_device_size(vit_out_mem);
-    bm_device_mem_t bf16_buffer;
-    bm_status_t status =
-        bm_malloc_device_byte(bm_handle, &bf16_buffer, buffer_size / 2);
-    assert(BM_SUCCESS == status);
-    bm_memcpy_s2d(bm_handle, bf16_buffer, (void *)uint16_value.data());
-    // compare_similarity(bm_handle, bf16_buffer,
-    // net_blocks[0]->input_dtypes[0],
-    // "/workspace/LLM-TPU/models/Qwen2_VL/python_demo_video/compile/vit_out_mem.npz",
-    // "tensor");
-
-    bm_memcpy_d2d_byte(bm_handle, out_mem, dst_offset, bf16_buffer, 0,
-                       pixel_num * HIDDEN_SIZE * 2);
-
-    // bm_memcpy_s2d(bm_handle, bf16_buffer, (void *)input_vit.data());
-    // bm_memcpy_d2d_byte(bm_handle, out_mem, dst_offset, bf16_buffer, 0,
-    //                    pixel_num * HIDDEN_SIZE * 2);
-    // compare_similarity(bm_handle, bf16_buffer,
-    // net_blocks[0]->input_dtypes[0],
-    // "/workspace/LLM-TPU/models/Qwen2_VL/python_demo_video/compile/vit_out_mem.npz",
-    // "tensor"); compare_similarity(bm_handle, out_mem,
-    // net_blocks[0]->input_dtypes[0],
-    // "/workspace/LLM-TPU/models/Qwen2_VL/python_demo_video/compile/llm_input.npz",
-    // "tensor");
+    size_t vit_num = (size_t)pixel_num * HIDDEN_SIZE;
+    bm_memcpy_d2s_partial(bm_handle, vit_out_fp32.data(), vit_out_mem,
+                          vit_num * sizeof(float));
+    for (size_t i = 0; i < vit_num; ++i) {
+      vit_out_bf16[i] = fp32_to_bf16_bits(vit_out_fp32[i]);
+    }
+    bm_memcpy_s2d_partial(bm_handle, vit_bf16_buffer,
+                          (void *)vit_out_bf16.data(),
+                          vit_num * sizeof(uint16_t));
+    bm_memcpy_d2d_byte(bm_handle, out_mem, dst_offset, vit_bf16_buffer, 0,
+                       vit_num * sizeof(uint16_t));
   }
   auto end = std::chrono::high_resolution_clock::now();
   std::chrono::duration<double> duration = end - start;
-  std::cout << "vit_launch execution time: " << duration.count() << " seconds"
-            << std::endl;
+  LOGI("vit_launch execution time: %f seconds", duration.count());
 
-  int out_mem_num = bm_mem_get_device_size(out_mem) / 2;
   for (int idx = 0; idx < NUM_LAYERS; idx++) {
     auto &in0_mem = net_blocks[idx]->stages[0].input_mems[0];
     auto &in1_mem = net_blocks[idx]->stages[0].input_mems[1];
     auto &in2_mem = net_blocks[idx]->stages[0].input_mems[2];
-    // d2d(in0_mem, block_out_mem);
     d2d(in0_mem, out_mem);
     if (idx == 0) {
       // only first time need copy
       bm_memcpy_s2d(bm_handle, in1_mem, (void *)position_ids.data());
-      bm_memcpy_s2d(bm_handle, in2_mem, (void *)attention_mask.data());
+      // the mask is constant, rows beyond token_length only need to be
+      // finite; the rows in use are uploaded every time since the block
+      // input memory may be shared with other nets, in which case the
+      // rows beyond them are not kept either
+      int mask_rows = io_alone ? std::max(token_length, prefill_mask_dirty_rows)
+                               : SEQLEN;
+      bm_memcpy_s2d_partial(bm_handle, in2_mem, (void *)prefill_mask.data(),
+                            (size_t)mask_rows * SEQLEN * sizeof(uint16_t));
+      prefill_mask_dirty_rows = 0;
     }
     net_launch(net_blocks[idx]);
     out_mem = net_blocks[idx]->stages[0].output_mems[0];
-    // std::string ref_file_name =
-    // "/workspace/LLM-TPU/models/Qwen2_VL/python_demo_video/compile/block_";
-    // ref_file_name += std::to_string(idx);
-    // ref_file_name += ".npz";
-    // compare_similarity(bm_handle, out_mem, net_blocks[0]->input_dtypes[0],
-    // ref_file_name, "tensor");
 
     d2d(past_key[idx], net_blocks[idx]->stages[0].output_mems[1]);
     d2d(past_value[idx], net_blocks[idx]->stages[0].output_mems[2]);
   }
-  // compare_similarity(bm_handle, out_mem, net_blocks[0]->input_dtypes[0],
-  // "/workspace/LLM-TPU/models/Qwen2_VL/python_demo_video/compile/ref.npz",
-  // "tensor");
 
   // forward lmhead
   int bytes = out_mem.size / SEQLEN;
@@ -387,10 +407,8 @@ int Qwen2VL::forward_first(std::vector<int> &tokens,
   bm_memcpy_d2d_byte(bm_handle, lm_in_mem, 0, out_mem,
                      (token_length - 1) * bytes, bytes);
   net_launch(net_lm);
-  int token = 0;
-  std::cout << "-----------" << generation_mode << "--------" << std::endl;
   // if (generation_mode == "greedy") {
-  token = greedy_search(net_greedy_head, lm_out_mem);
+  int token = greedy_search(net_greedy_head, lm_out_mem);
   // } else {
   //   // token = penalty_sample(net_penalty_sample_head, lm_out_mem,
   //   total_tokens,
@@ -415,7 +433,7 @@ int Qwen2VL::forward_next() {
 
   auto &greedy_out_mem = net_greedy_head->stages[0].output_mems[0];
   auto &in_mem = net_embed_cache->stages[0].input_mems[0];
-  auto &out_mem = net_embed_cache->stages[0].output_mems[0];
+  bm_device_mem_t out_mem = net_embed_cache->stages[0].output_mems[0];
   d2d(in_mem, greedy_out_mem);
   net_launch(net_embed_cache);
 
@@ -46,6 +46,7 @@ class Qwen2VL {
   int greedy_search(const bm_net_info_t *net, bm_device_mem_t &logits_mem);
   int penalty_sample(const bm_net_info_t *net, bm_device_mem_t &logits_mem,
                      std::vector<int> &input_tokens, int &token_length);
+  void init_prefill_staging();
   uint16_t mask_value;
 
  public:
@@ -72,6 +73,22 @@ class Qwen2VL {
   bm_device_mem_t dev_buffer;
   std::vector<bm_device_mem_t> past_key;
   std::vector<bm_device_mem_t> past_value;
+
+  // prefill 输入的常驻缓存,每次请求只重写与本次输入相关的部分,
+  // *_dirty 记录设备端非填充数据的范围,首次请求前为整块;
+  // 只有 io_alone 时输入内存独占, 才能只上传变化的部分
+  bool io_alone;
+  std::vector<int> input_ids_staging;
+  int input_ids_dirty;
+  std::vector<uint16_t> prefill_mask;  // causal pattern, built once
+  int prefill_mask_dirty_rows;
+  std::vector<float> pixel_values_staging;
+  size_t pixel_values_dirty;
+  std::vector<float> vit_mask_staging;
+  int vit_mask_dirty;
+  std::vector<float> vit_out_fp32;
+  std::vector<uint16_t> vit_out_bf16;
+  bm_device_mem_t vit_bf16_buffer;
 };
 
 #endif  // TDL_SDK_QWEN2VL_HPP
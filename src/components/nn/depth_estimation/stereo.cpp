@@ -1,6 +1,8 @@
 #include "depth_estimation/stereo.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -14,6 +16,7 @@ Stereo::Stereo() {
 
   w_ = 0;
   h_ = 0;
+  buffer_pool_ = std::make_shared<BufferPool>();
 }
 
 Stereo::~Stereo() {}
@@ -29,16 +32,56 @@ int32_t Stereo::onModelOpened() {
   }
   return 0;
 }
-int32_t Stereo::outputParse(
+int32_t Stereo::inference(
     const std::vector<std::vector<std::shared_ptr<BaseImage>>>& images,
-    std::vector<std::shared_ptr<ModelOutputInfo>>& out_datas) {
-  std::string input_tensor_name = net_->getInputNames()[0];
-  TensorInfo input_tensor = net_->getTensorInfo(input_tensor_name);
+    std::vector<std::shared_ptr<ModelOutputInfo>>& out_datas,
+    const std::map<std::string, float>& parameters) {
+  auto it = parameters.find("native_output");
+  native_output_ = (it != parameters.end() && it->second != 0);
+  it = parameters.find("focal_baseline");
+  focal_baseline_ = it != parameters.end() ? it->second : 0.0f;
+  return BaseModel::inference(images, out_datas, parameters);
+}
+
+Stereo::BufferPool::~BufferPool() {
+  for (auto buffer : buffers) {
+    delete buffer;
+  }
+}
 
-  LOGI("outputParse, batch size:%d, input shape:%d,%d,%d,%d", images.size(),
-       input_tensor.shape[0], input_tensor.shape[1], input_tensor.shape[2],
-       input_tensor.shape[3]);
+std::shared_ptr<std::vector<uint8_t>> Stereo::acquireBuffer(size_t size) {
+  // 只保留少量空闲缓冲区, 调用方同时持有多帧时多出的缓冲区直接释放
+  const size_t max_pooled = 4;
+  std::vector<uint8_t>* buffer = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(buffer_pool_->mutex);
+    if (!buffer_pool_->buffers.empty()) {
+      buffer = buffer_pool_->buffers.back();
+      buffer_pool_->buffers.pop_back();
+    }
+  }
+  if (buffer == nullptr) {
+    buffer = new std::vector<uint8_t>();
+  }
+  buffer->resize(size);
+  std::weak_ptr<BufferPool> weak_pool = buffer_pool_;
+  return std::shared_ptr<std::vector<uint8_t>>(
+      buffer, [weak_pool, max_pooled](std::vector<uint8_t>* released) {
+        std::shared_ptr<BufferPool> pool = weak_pool.lock();
+        if (pool != nullptr) {
+          std::lock_guard<std::mutex> lock(pool->mutex);
+          if (pool->buffers.size() < max_pooled) {
+            pool->buffers.push_back(released);
+            return;
+          }
+        }
+        delete released;
+      });
+}
 
+int32_t Stereo::outputParse(
+    const std::vector<std::vector<std::shared_ptr<BaseImage>>>& images,
+    std::vector<std::shared_ptr<ModelOutputInfo>>& out_datas) {
   std::string output_tensor_name = net_->getOutputNames()[0];
   TensorInfo output_tensor = net_->getTensorInfo(output_tensor_name);
   std::shared_ptr<BaseTensor> output_tensor_ptr =
@@ -47,33 +90,47 @@ int32_t Stereo::outputParse(
   h_ = output_tensor.shape[1];
   w_ = output_tensor.shape[2];
 
-  int byte_per_pixel = output_tensor.tensor_size / output_tensor.tensor_elem;
-  float qscale_output = byte_per_pixel == 1 ? output_tensor.qscale : 1;
-
-  for (uint32_t b = 0; b < (uint32_t)input_tensor.shape[0]; b++) {
-    uint32_t image_width = images[b][0]->getWidth();
-    uint32_t image_height = images[b][0]->getHeight();
-
+  TDLDataType data_type = output_tensor.data_type;
+  float qscale_output = (data_type == TDLDataType::INT8 ||
+                         data_type == TDLDataType::UINT8)
+                            ? output_tensor.qscale
+                            : 1.0f;
+  if (data_type != TDLDataType::INT8 && data_type != TDLDataType::UINT8 &&
+      data_type != TDLDataType::FP16 && data_type != TDLDataType::BF16 &&
+      data_type != TDLDataType::FP32) {
+    LOGE("unsupported depth output data type: %d", (int)data_type);
+    return -1;
+  }
+  size_t pix_size = size_t(w_) * h_;
+  size_t elem_bytes = output_tensor_ptr->getElementSize();
+  const uint8_t* out_data = static_cast<const uint8_t*>(
+      output_tensor_ptr->getMemoryBlock()->virtualAddress);
+
+  uint32_t batch_num =
+      std::min((uint32_t)images.size(), (uint32_t)output_tensor.shape[0]);
+  for (uint32_t b = 0; b < batch_num; b++) {
     std::shared_ptr<ModelDepthInfo> depth_info =
         std::make_shared<ModelDepthInfo>();
 
     depth_info->w = w_;
     depth_info->h = h_;
-
-    int pix_size = w_ * h_;
-    depth_info->logits = (float*)malloc(pix_size * sizeof(float));
-
-    if (byte_per_pixel == 1) {
-      int8_t* int8_out_data = output_tensor_ptr->getBatchPtr<int8_t>(b);
-      for (int i = 0; i < pix_size; i++) {
-        depth_info->logits[i] =
-            static_cast<float>(int8_out_data[i] * qscale_output);
-      }
+    depth_info->native_type = data_type;
+    depth_info->native_scale = qscale_output;
+    depth_info->focal_baseline = focal_baseline_;
+
+    const uint8_t* batch_data = out_data + b * pix_size * elem_bytes;
+    if (native_output_) {
+      // 输出张量会被下一次推理覆盖, 拷贝原始数据 (int8 只有 float 的 1/4)
+      depth_info->buffer = acquireBuffer(pix_size * elem_bytes);
+      memcpy(depth_info->buffer->data(), batch_data, pix_size * elem_bytes);
+      depth_info->native_data = depth_info->buffer->data();
     } else {
-      float* float_out_data = output_tensor_ptr->getBatchPtr<float>(b);
-      for (int i = 0; i < pix_size; i++) {
-        depth_info->logits[i] = float_out_data[i] * qscale_output;
-      }
+      depth_info->buffer = acquireBuffer(pix_size * sizeof(float));
+      depth_info->logits =
+          reinterpret_cast<float*>(depth_info->buffer->data());
+      ModelDepthInfo::convertToFloat(batch_data, data_type, qscale_output,
+                                     focal_baseline_, depth_info->logits,
+                                     pix_size);
     }
 
     out_datas.push_back(depth_info);
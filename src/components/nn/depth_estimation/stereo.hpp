@@ -1,5 +1,7 @@
 #pragma once
 #include <bitset>
+#include <map>
+#include <mutex>
 
 #include "model/base_model.hpp"
 
@@ -8,12 +10,33 @@ class Stereo final : public BaseModel {
   Stereo();
   ~Stereo();
 
+  using BaseModel::inference;
+  // parameters:
+  //  "native_output" 非 0 时只输出模型原始类型的数据与 scale (native_data),
+  //  不展开为 float, 需要的点/区域通过 ModelDepthInfo 的接口换算
+  //  "focal_baseline" > 0 时按 focal_baseline / 视差 输出深度
+  virtual int32_t inference(
+      const std::vector<std::vector<std::shared_ptr<BaseImage>>>& images,
+      std::vector<std::shared_ptr<ModelOutputInfo>>& out_datas,
+      const std::map<std::string, float>& parameters = {}) override;
+
   virtual int32_t outputParse(
       const std::vector<std::vector<std::shared_ptr<BaseImage>>>& images,
       std::vector<std::shared_ptr<ModelOutputInfo>>& out_datas) override;
   virtual int32_t onModelOpened() override;
 
  private:
+  // 输出缓冲区池, ModelDepthInfo 释放后缓冲区归还复用
+  struct BufferPool {
+    std::mutex mutex;
+    std::vector<std::vector<uint8_t>*> buffers;
+    ~BufferPool();
+  };
+  std::shared_ptr<std::vector<uint8_t>> acquireBuffer(size_t size);
+
   int w_;
   int h_;
+  bool native_output_ = false;
+  float focal_baseline_ = 0.0f;
+  std::shared_ptr<BufferPool> buffer_pool_;
 };
@@ -22,8 +22,6 @@ int32_t SCRFD::onModelOpened() {
   std::vector<anchor_cfg> cfg;
   anchor_cfg tmp;
 
-  m_feat_stride_fpn = {8, 16, 32};
-
   tmp.SCALES = {1, 2};
   tmp.BASE_SIZE = 16;
   tmp.RATIOS = {1.0};
@@ -49,6 +47,7 @@ int32_t SCRFD::onModelOpened() {
   std::string input_tensor_name = net_->getInputNames()[0];
   TensorInfo input_tensor = net_->getTensorInfo(input_tensor_name);
 
+  fpn_levels_.clear();
   for (size_t i = 0; i < cfg.size(); i++) {
     std::vector<std::vector<float>> base_anchors =
         DetectionHelper::generateMmdetBaseAnchors(cfg[i].BASE_SIZE, 0,
@@ -58,12 +57,22 @@ int32_t SCRFD::onModelOpened() {
     int input_h = input_tensor.shape[2];
     int feat_w = ceil(input_w / float(stride));
     int feat_h = ceil(input_h / float(stride));
-    fpn_anchors_[stride] = DetectionHelper::generateMmdetGridAnchors(
-        feat_w, feat_h, stride, base_anchors);
+    std::vector<std::vector<float>> grid_anchors =
+        DetectionHelper::generateMmdetGridAnchors(feat_w, feat_h, stride,
+                                                  base_anchors);
+
+    FpnLevel level;
+    level.stride = stride;
+    level.anchor_cx.reserve(grid_anchors.size());
+    level.anchor_cy.reserve(grid_anchors.size());
+    for (const std::vector<float> &grid : grid_anchors) {
+      level.anchor_cx.push_back((grid[0] + grid[2]) / 2);
+      level.anchor_cy.push_back((grid[1] + grid[3]) / 2);
+    }
 
     int num_feat_branch = 0;
     int num_anchors = int(cfg[i].SCALES.size() * cfg[i].RATIOS.size());
-    fpn_grid_anchor_num_[stride] = num_anchors;
+    level.num_anchors = num_anchors;
     std::vector<std::string> output_tensor_names = net_->getOutputNames();
     for (size_t j = 0; j < output_tensor_names.size(); j++) {
       TensorInfo oj = net_->getTensorInfo(output_tensor_names[j]);
@@ -78,25 +87,25 @@ int32_t SCRFD::onModelOpened() {
       if (oj.shape[2] == feat_h && oj.shape[3] == feat_w) {
         LOGI("fpnnode,stride:%d,w:%d,feath:%d", stride, feat_w, feat_h);
         if (oj.shape[1] == num_anchors * 1) {
-          fpn_out_nodes_[stride]["score"] = output_tensor_names[j];
+          level.score_name = output_tensor_names[j];
           num_feat_branch++;
         } else if (oj.shape[1] == num_anchors * 4) {
-          fpn_out_nodes_[stride]["bbox"] = output_tensor_names[j];
+          level.bbox_name = output_tensor_names[j];
           num_feat_branch++;
         } else if (oj.shape[1] == num_anchors * 10) {
-          fpn_out_nodes_[stride]["landmark"] = output_tensor_names[j];
+          level.landmark_name = output_tensor_names[j];
           num_feat_branch++;
         }
       }
     }
     // std::cout << "numfeat:" << num_feat_branch << std::endl;
-    for (auto &kv : fpn_out_nodes_[stride]) {
-      LOGI("%s:%s", kv.first.c_str(), kv.second.c_str());
-    }
+    LOGI("score:%s,bbox:%s,landmark:%s", level.score_name.c_str(),
+         level.bbox_name.c_str(), level.landmark_name.c_str());
     if (num_feat_branch != int(cfg.size())) {
       LOGE("output nodenum error,got:%d,expected:%d at branch:%d",
            num_feat_branch, int(cfg.size()), int(i));
     }
+    fpn_levels_.push_back(std::move(level));
   }
   return 0;
 }
@@ -113,132 +122,117 @@ int32_t SCRFD::outputParse(
        input_tensor.shape[0], input_tensor.shape[1], input_tensor.shape[2],
        input_tensor.shape[3]);
 
+  // 每个 stride 的输出张量只查找一次
+  struct LevelTensors {
+    const FpnLevel *level;
+    TensorInfo score, bbox, landmark;
+  };
+  std::vector<LevelTensors> level_tensors;
+  level_tensors.reserve(fpn_levels_.size());
+  for (const FpnLevel &level : fpn_levels_) {
+    level_tensors.push_back({&level, net_->getTensorInfo(level.score_name),
+                             net_->getTensorInfo(level.bbox_name),
+                             net_->getTensorInfo(level.landmark_name)});
+  }
+
   const int FACE_LANDMARKS_NUM = 5;
   int total_face_num = 0;
   for (uint32_t b = 0; b < (uint32_t)input_tensor.shape[0]; b++) {
     uint32_t image_width = images[b]->getWidth();
     uint32_t image_height = images[b]->getHeight();
-    // float image_width_f = float(image_width);
-    // float image_height_f = float(image_height);
-    std::vector<ObjectBoxLandmarkInfo> vec_bbox;
-    std::vector<ObjectBoxLandmarkInfo> vec_bbox_nms;
     std::vector<float> &rescale_params =
         batch_rescale_params_[input_tensor_name][b];
-
-    LOGI("stride size:%d", m_feat_stride_fpn.size());
-    for (size_t i = 0; i < m_feat_stride_fpn.size(); i++) {
-      int stride = m_feat_stride_fpn[i];
-      std::string score_str = fpn_out_nodes_[stride]["score"];
-      TensorInfo score_tensor = net_->getTensorInfo(score_str);
-      // std::cout << "stride:" << m_feat_stride_fpn[i] << "\n";
-      // print_dim(score_shape, "score");
-      size_t score_size =
-          score_tensor.shape[1] * score_tensor.shape[2] * score_tensor.shape[3];
-      float *score_blob = (float *)score_tensor.sys_mem + (b * score_size);
-      LOGI(
-          "scoretensor:%s,shape:%d,%d,%d,%d,dev_addr:%d,dtype:%d,val0:%f,"
-          "threshold:%f",
-          score_str.c_str(), score_tensor.shape[0], score_tensor.shape[1],
-          score_tensor.shape[2], score_tensor.shape[3], score_tensor.phy_addr,
-          score_tensor.data_type, score_blob[0], model_threshold_);
-      std::string bbox_str = fpn_out_nodes_[stride]["bbox"];
-      TensorInfo bbox_tensor = net_->getTensorInfo(bbox_str);
-      // print_dim(blob_shape, "bbox");
-      size_t blob_size =
-          bbox_tensor.shape[1] * bbox_tensor.shape[2] * bbox_tensor.shape[3];
-      float *bbox_blob = (float *)bbox_tensor.sys_mem + (b * blob_size);
-
-      std::string landmark_str = fpn_out_nodes_[stride]["landmark"];
-      TensorInfo landmark_tensor = net_->getTensorInfo(landmark_str);
-      // print_dim(blob_shape, "bbox");
-      size_t landmark_size = landmark_tensor.shape[1] *
-                             landmark_tensor.shape[2] *
-                             landmark_tensor.shape[3];
-      float *landmark_blob =
-          (float *)landmark_tensor.sys_mem + (b * landmark_size);
-      int width = bbox_tensor.shape[3];
-      int height = bbox_tensor.shape[2];
+    float scale_x = rescale_params[0];
+    float scale_y = rescale_params[1];
+    float offset_x = rescale_params[2];
+    float offset_y = rescale_params[3];
+
+    candidate_boxes_.clear();
+    candidate_landmarks_.clear();
+    for (const LevelTensors &tensors : level_tensors) {
+      const FpnLevel &level = *tensors.level;
+      const float stride = level.stride;
+      int width = tensors.bbox.shape[3];
+      int height = tensors.bbox.shape[2];
       size_t count = width * height;
-      size_t num_anchor = fpn_grid_anchor_num_[stride];
-      // std::cout << "numanchor:" << num_anchor << ",count:" << count << "\n";
-      std::vector<std::vector<float>> &fpn_grids = fpn_anchors_[stride];
-      for (size_t num = 0; num < num_anchor; num++) {  // anchor index
-        for (size_t j = 0; j < count; j++) {           // j:grid index
-          float conf = score_blob[j + count * num];
-          if (conf <= model_threshold_) {
-            continue;
-          }
-
-          // TODO:could be optimized
-          std::vector<float> &grid = fpn_grids[j + count * num];
-          float grid_cx = (grid[0] + grid[2]) / 2;
-          float grid_cy = (grid[1] + grid[3]) / 2;
-
-          float box_score = conf;
-
-          float box_x1 =
-              grid_cx - bbox_blob[j + count * (0 + num * 4)] * stride;
-          float box_y1 =
-              grid_cy - bbox_blob[j + count * (1 + num * 4)] * stride;
-          float box_x2 =
-              grid_cx + bbox_blob[j + count * (2 + num * 4)] * stride;
-          float box_y2 =
-              grid_cy + bbox_blob[j + count * (3 + num * 4)] * stride;
-
-          if (box_x1 >= box_x2 || box_y1 >= box_y2) {
-            LOGI(
-                "bbox "
-                "invalid,x1:%f,y1:%f,x2:%f,y2:%f,stride:%d,grid_cx:%f,grid_cy:%"
-                "f\n",
-                box_x1, box_y1, box_x2, box_y2, stride, grid_cx, grid_cy);
-            continue;
-          }
-
-          std::vector<float> landmarks_x;
-          std::vector<float> landmarks_y;
-          std::vector<float> landmarks_score;
-          for (size_t k = 0; k < FACE_LANDMARKS_NUM; k++) {
-            float landmark_x =
-                landmark_blob[j + count * (num * 10 + k * 2)] * stride +
-                grid_cx;
-            float landmark_y =
-                landmark_blob[j + count * (num * 10 + k * 2 + 1)] * stride +
-                grid_cy;
-
-            landmarks_x.push_back(landmark_x);
-            landmarks_y.push_back(landmark_y);
-            landmarks_score.push_back(0);
-          }
-          ObjectBoxLandmarkInfo box;
-          box.class_id = 0;
-          box.object_type = OBJECT_TYPE_FACE;
-          box.score = box_score;
-          box.x1 = box_x1;
-          box.y1 = box_y1;
-          box.x2 = box_x2;
-          box.y2 = box_y2;
-          box.landmarks_x = landmarks_x;
-          box.landmarks_y = landmarks_y;
-          box.landmarks_score = landmarks_score;
-          DetectionHelper::rescaleBbox(box, rescale_params);
-          box.x1 = std::max(0.0f, box.x1);
-          box.y1 = std::max(0.0f, box.y1);
-          box.x2 = std::min((float)image_width, box.x2);
-          box.y2 = std::min((float)image_height, box.y2);
-          vec_bbox.push_back(box);
+      size_t score_size = tensors.score.shape[1] * count;
+      const float *score_blob = (float *)tensors.score.sys_mem + b * score_size;
+      const float *bbox_blob =
+          (float *)tensors.bbox.sys_mem + b * tensors.bbox.shape[1] * count;
+      const float *landmark_blob = (float *)tensors.landmark.sys_mem +
+                                   b * tensors.landmark.shape[1] * count;
+      uint32_t num_scores = std::min(level.num_anchors * count,
+                                     level.anchor_cx.size());
+
+      // 先筛出超过阈值的 anchor, 再逐个解码
+      candidate_indices_.clear();
+      DetectionHelper::filterScores(score_blob, num_scores, model_threshold_,
+                                    candidate_indices_);
+      for (uint32_t idx : candidate_indices_) {
+        size_t num = idx / count;      // anchor index
+        size_t j = idx - num * count;  // grid index
+        float grid_cx = level.anchor_cx[idx];
+        float grid_cy = level.anchor_cy[idx];
+        const float *box_ptr = bbox_blob + j + count * num * 4;
+
+        ObjectBoxInfo box;
+        box.class_id = 0;
+        box.object_type = OBJECT_TYPE_FACE;
+        box.score = score_blob[idx];
+        box.x1 = grid_cx - box_ptr[0] * stride;
+        box.y1 = grid_cy - box_ptr[count] * stride;
+        box.x2 = grid_cx + box_ptr[count * 2] * stride;
+        box.y2 = grid_cy + box_ptr[count * 3] * stride;
+        if (box.x1 >= box.x2 || box.y1 >= box.y2) {
+          continue;
+        }
+
+        box.x1 = std::max(0.0f, box.x1 * scale_x + offset_x);
+        box.y1 = std::max(0.0f, box.y1 * scale_y + offset_y);
+        box.x2 = std::min((float)image_width, box.x2 * scale_x + offset_x);
+        box.y2 = std::min((float)image_height, box.y2 * scale_y + offset_y);
+        candidate_boxes_.push_back(box);
+
+        const float *landmark_ptr = landmark_blob + j + count * num * 10;
+        for (int k = 0; k < FACE_LANDMARKS_NUM; k++) {
+          float landmark_x = landmark_ptr[count * k * 2] * stride + grid_cx;
+          float landmark_y =
+              landmark_ptr[count * (k * 2 + 1)] * stride + grid_cy;
+          candidate_landmarks_.push_back(landmark_x * scale_x + offset_x);
+          candidate_landmarks_.push_back(landmark_y * scale_y + offset_y);
         }
       }
     }
     // DO nms on output result
+    DetectionHelper::nmsIndices(candidate_boxes_, iou_threshold_,
+                                keep_indices_);
 
-    DetectionHelper::nmsObjects(vec_bbox, iou_threshold_);
-    // Init face meta
-
+    // Init face meta, 只为 nms 后保留的框生成关键点
     std::shared_ptr<ModelBoxLandmarkInfo> facemeta =
         std::make_shared<ModelBoxLandmarkInfo>();
     facemeta->image_width = image_width;
     facemeta->image_height = image_height;
-    facemeta->box_landmarks = vec_bbox;
+    facemeta->box_landmarks.resize(keep_indices_.size());
+    for (size_t i = 0; i < keep_indices_.size(); i++) {
+      const ObjectBoxInfo &box = candidate_boxes_[keep_indices_[i]];
+      const float *landmarks =
+          &candidate_landmarks_[keep_indices_[i] * FACE_LANDMARKS_NUM * 2];
+      ObjectBoxLandmarkInfo &face = facemeta->box_landmarks[i];
+      face.class_id = box.class_id;
+      face.object_type = box.object_type;
+      face.score = box.score;
+      face.x1 = box.x1;
+      face.y1 = box.y1;
+      face.x2 = box.x2;
+      face.y2 = box.y2;
+      face.landmarks_x.resize(FACE_LANDMARKS_NUM);
+      face.landmarks_y.resize(FACE_LANDMARKS_NUM);
+      face.landmarks_score.assign(FACE_LANDMARKS_NUM, 0);
+      for (int k = 0; k < FACE_LANDMARKS_NUM; k++) {
+        face.landmarks_x[k] = landmarks[k * 2];
+        face.landmarks_y[k] = landmarks[k * 2 + 1];
+      }
+    }
     total_face_num += facemeta->box_landmarks.size();
     out_datas.push_back(facemeta);
   }
@@ -15,13 +15,24 @@ class SCRFD : public BaseModel {
   virtual int onModelOpened() override;
 
  private:
-  std::vector<int> m_feat_stride_fpn;
-  // std::map<std::string, std::vector<anchor_box>> m_anchors;
-  // std::map<std::string, int> m_num_anchors;
-  std::map<int, std::vector<std::vector<float>>> fpn_anchors_;
-  std::map<int, std::map<std::string, std::string>>
-      fpn_out_nodes_;  //{stride:{"box":"xxxx","score":"xxx","landmark":"xxxx"}}
-  std::map<int, int> fpn_grid_anchor_num_;
+  // 一个 stride 的输出层, 在 onModelOpened 时确定
+  struct FpnLevel {
+    int stride;
+    int num_anchors;
+    std::string score_name;
+    std::string bbox_name;
+    std::string landmark_name;
+    // anchor 中心, 序号与 score 相同: anchor * feat_w * feat_h + grid
+    std::vector<float> anchor_cx;
+    std::vector<float> anchor_cy;
+  };
+  std::vector<FpnLevel> fpn_levels_;
   float iou_threshold_ = 0.5;
+
+  // 解码缓存, 每帧复用: 候选框及其关键点 (每个候选 10 个, x0,y0,...,x4,y4)
+  std::vector<uint32_t> candidate_indices_;
+  std::vector<ObjectBoxInfo> candidate_boxes_;
+  std::vector<float> candidate_landmarks_;
+  std::vector<uint32_t> keep_indices_;
 };
 #endif
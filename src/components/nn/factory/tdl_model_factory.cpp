@@ -1,6 +1,9 @@
 #include "tdl_model_factory.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <thread>
 #include "audio_classification/audio_classification.hpp"
 #include "face_attribute/face_attribute_cls.hpp"
 #include "face_detection/scrfd.hpp"
@@ -221,6 +224,56 @@ ModelConfig TDLModelFactory::getModelConfig(const ModelType model_type) {
   return model_config;
 }
 
+std::vector<std::shared_ptr<BaseModel>> TDLModelFactory::getModels(
+    const std::vector<ModelLoadRequest> &requests, int num_threads) {
+  std::vector<std::shared_ptr<BaseModel>> models(requests.size());
+  if (requests.empty()) {
+    return models;
+  }
+  if (num_threads <= 0) {
+    num_threads = std::max(1, (int)std::thread::hardware_concurrency());
+  }
+  num_threads = std::min(num_threads, (int)requests.size());
+
+  // model files are read and parsed concurrently, with model sharing on the
+  // requests of the same file wait for the first one and share its weights
+  std::atomic<size_t> next_index(0);
+  auto load_worker = [&]() {
+    for (size_t i = next_index++; i < requests.size(); i = next_index++) {
+      const ModelLoadRequest &request = requests[i];
+      if (request.model_path.empty()) {
+        models[i] = getModel(request.model_type, request.device_id);
+      } else {
+        models[i] =
+            getModel(request.model_type, request.model_path, request.device_id);
+      }
+      if (models[i] == nullptr) {
+        LOGE("getModels failed to open model: %s",
+             modelTypeToString(request.model_type).c_str());
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int i = 1; i < num_threads; i++) {
+    workers.emplace_back(load_worker);
+  }
+  load_worker();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  return models;
+}
+
+std::vector<std::shared_ptr<BaseModel>> TDLModelFactory::getModels(
+    const std::vector<ModelType> &model_types, const int device_id) {
+  std::vector<ModelLoadRequest> requests(model_types.size());
+  for (size_t i = 0; i < model_types.size(); i++) {
+    requests[i].model_type = model_types[i];
+    requests[i].device_id = device_id;
+  }
+  return getModels(requests);
+}
+
 void TDLModelFactory::setModelDir(const std::string &model_dir) {
   model_dir_ = model_dir;
   LOGIP("setModelDir success,model_dir:%s", model_dir.c_str());
@@ -418,6 +471,7 @@ std::shared_ptr<BaseModel> TDLModelFactory::getModelImpl(
   net_param_default.model_config = model_config_merged;
   net_param_default.runtime_mem_addrs = mem_addrs;
   net_param_default.runtime_mem_sizes = mem_sizes;
+  net_param_default.share_model = share_model_;
 
   model->setNetParam(net_param_default);
 
@@ -459,6 +513,7 @@ std::shared_ptr<BaseModel> TDLModelFactory::getModelWithoutOpen(
   model->setModelType(model_type);
   NetParam net_param_default = model->getNetParam();
   net_param_default.model_file_path = model_path;
+  net_param_default.share_model = share_model_;
 
   // Merge model_config into net_param_default
   ModelConfig model_config_merged = model_config;
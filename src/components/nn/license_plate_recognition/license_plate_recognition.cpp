@@ -1,8 +1,9 @@
 
 #include "license_plate_recognition.hpp"
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
-#include <sstream>
 #include <vector>
 
 #include "utils/detection_helper.hpp"
@@ -20,90 +21,76 @@ std::vector<std::string> CHARS = {
     "H",  "J",  "K",  "L",  "M",  "N",  "P",  "Q",  "R",  "S",  "T",  "U",
     "V",  "W",  "X",  "Y",  "Z",  "I",  "O",  "-"};
 
-LicensePlateRecognition::LicensePlateRecognition() {
+typedef std::bitset<PlateCtcDecoder::kMaxClasses> LabelSet;
+
+// CHARS 中 [first, last] 之间的字符
+static LabelSet labelRange(const std::string &first, const std::string &last) {
+  LabelSet labels;
+  size_t begin = std::find(CHARS.begin(), CHARS.end(), first) - CHARS.begin();
+  size_t end = std::find(CHARS.begin(), CHARS.end(), last) - CHARS.begin();
+  for (size_t i = begin; i <= end && i < CHARS.size(); i++) {
+    labels.set(i);
+  }
+  return labels;
+}
+
+// 省份 + 字母 + 5 位字母数字, 或以学/警/港/澳/挂/领结尾, 新能源为 6 位
+static std::vector<PlateCtcDecoder::PlateFormat> plateFormats() {
+  LabelSet province = labelRange("京", "新");
+  LabelSet letter = labelRange("A", "Z");
+  LabelSet alnum = labelRange("0", "9") | letter;
+  LabelSet suffix = labelRange("学", "挂") | labelRange("领", "领");
+  PlateCtcDecoder::PlateFormat standard = {province, letter, alnum, alnum,
+                                           alnum,    alnum,  alnum};
+  PlateCtcDecoder::PlateFormat special = standard;
+  special.back() = suffix;
+  PlateCtcDecoder::PlateFormat new_energy = standard;
+  new_energy.push_back(alnum);
+  return {standard, special, new_energy};
+}
+
+LicensePlateRecognition::LicensePlateRecognition() : decoder_(CHARS) {
   net_param_.model_config.mean = {127.5, 127.5, 127.5};
   net_param_.model_config.std = {128, 128, 128};
   net_param_.model_config.rgb_order = "bgr";
   keep_aspect_ratio_ = false;
+  decoder_.setPlateFormats(plateFormats());
 }
 
-std::string LicensePlateRecognition::greedy_decode(float *prebs) {
-  auto shape = net_->getTensorInfo(net_->getOutputNames()[0]).shape;
-
-  const auto &output_layer = net_->getOutputNames()[0];
-  auto output_shape = net_->getTensorInfo(output_layer).shape;
-
-  // 80，18
-  int rows = output_shape[1];
-  int cols = output_shape[2];
-
-  int index[cols];
-  // argmax index
-  for (int i = 0; i < cols; i++) {
-    float max = prebs[i];
-    int maxIndex = 0;
-    for (int j = 0; j < rows; j++) {
-      if (prebs[i + j * cols] > max) {
-        max = prebs[i + j * cols];
-        maxIndex = j;
-      }
-    }
-    index[i] = maxIndex;
-  }
-  std::vector<int> no_repeat_blank_label;
-  uint32_t pre_c = index[0];
-  if (pre_c != CHARS.size() - 1) {
-    no_repeat_blank_label.push_back(pre_c);
-  }
-  for (int i = 0; i < cols; i++) {
-    uint32_t c = index[i];
-    if ((pre_c == c) || (c == CHARS.size() - 1)) {
-      if (c == CHARS.size() - 1) {
-        pre_c = c;
-      }
-      continue;
-    }
-    no_repeat_blank_label.push_back(c);
-    pre_c = c;
-  }
-  std::string lb;
-  for (int k : no_repeat_blank_label) {
-    lb += CHARS[k];
-  }
-
-  return lb;
+int32_t LicensePlateRecognition::inference(
+    const std::vector<std::shared_ptr<BaseImage>> &images,
+    std::vector<std::shared_ptr<ModelOutputInfo>> &out_datas,
+    const std::map<std::string, float> &parameters) {
+  auto it = parameters.find("beam_width");
+  decoder_.setBeamWidth(it != parameters.end() ? int(it->second) : 1);
+  return BaseModel::inference(images, out_datas, parameters);
 }
 
 int32_t LicensePlateRecognition::outputParse(
     const std::vector<std::shared_ptr<BaseImage>> &images,
     std::vector<std::shared_ptr<ModelOutputInfo>> &out_datas) {
-  std::string input_tensor_name = net_->getInputNames()[0];
-  TensorInfo input_tensor = net_->getTensorInfo(input_tensor_name);
-  // uint32_t input_width = input_tensor.shape[3];
-  // uint32_t input_height = input_tensor.shape[2];
-  LOGI("outputParse,batch size:%d,input shape:%d,%d,%d,%d", images.size(),
-       input_tensor.shape[0], input_tensor.shape[1], input_tensor.shape[2],
-       input_tensor.shape[3]);
-
   std::string out_data_name = net_->getOutputNames()[0];
-
   TensorInfo out_data_info = net_->getTensorInfo(out_data_name);
   std::shared_ptr<BaseTensor> out_data_tensor =
       net_->getOutputTensor(out_data_name);
 
-  for (uint32_t b = 0; b < (uint32_t)input_tensor.shape[0]; b++) {
-    // uint32_t image_width = images[b]->getWidth();
-    // uint32_t image_height = images[b]->getHeight();
-    std::shared_ptr<ModelOcrInfo> ocr_info = std::make_shared<ModelOcrInfo>();
-
-    float *out_data = out_data_tensor->getBatchPtr<float>(b);
-
-    std::string license = greedy_decode(out_data);
-
-    ocr_info->length = license.length();
-    ocr_info->text_info = new char[license.length()];
-    strcpy(ocr_info->text_info, license.c_str());
+  // [batch, num_classes(80), num_steps(18)], 直接解码原始类型, int8 不反量化
+  int batch_num = std::min((int)images.size(), out_data_info.shape[0]);
+  int32_t ret = decoder_.decode(
+      out_data_tensor->getMemoryBlock()->virtualAddress,
+      out_data_info.data_type, out_data_info.qscale, batch_num,
+      out_data_info.shape[1], out_data_info.shape[2]);
+  if (ret != 0) {
+    LOGE("license plate ctc decode failed");
+    return ret;
+  }
 
+  for (int b = 0; b < batch_num; b++) {
+    std::shared_ptr<ModelOcrInfo> ocr_info = std::make_shared<ModelOcrInfo>();
+    // text_info 归 ModelOcrInfo 所有, 从解码结果区拷贝 (含结尾的 '\0')
+    ocr_info->length = decoder_.getLength(b);
+    ocr_info->text_info = new char[ocr_info->length + 1];
+    memcpy(ocr_info->text_info, decoder_.getText(b), ocr_info->length + 1);
     out_datas.push_back(ocr_info);
   }
   return 0;
@@ -1,13 +1,25 @@
 #pragma once
 #include <bitset>
+#include <map>
 
+#include "license_plate_recognition/plate_ctc_decoder.hpp"
 #include "model/base_model.hpp"
 
 class LicensePlateRecognition final : public BaseModel {
  public:
   LicensePlateRecognition();
-  std::string greedy_decode(float *prebs);
+
+  using BaseModel::inference;
+  // parameters:
+  //  "beam_width" > 1 时使用按车牌格式约束的 beam search, 默认贪心解码
+  virtual int32_t inference(
+      const std::vector<std::shared_ptr<BaseImage>> &images,
+      std::vector<std::shared_ptr<ModelOutputInfo>> &out_datas,
+      const std::map<std::string, float> &parameters = {}) override;
   virtual int32_t outputParse(
       const std::vector<std::shared_ptr<BaseImage>> &images,
       std::vector<std::shared_ptr<ModelOutputInfo>> &out_datas) override;
+
+ private:
+  PlateCtcDecoder decoder_;
 };
@@ -0,0 +1,438 @@
+#include "license_plate_recognition/plate_ctc_decoder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "utils/tdl_log.hpp"
+
+// a complete plate must be at least this likely relative to the best beam
+static const float kMinCompleteRatio = 0.01f;
+// labels less likely than this relative to the argmax of a step are not
+// used to extend beams
+static const float kMinLabelProb = 1e-3f;
+// beams less likely than this relative to the best one are dropped
+static const float kMinBeamProb = 1e-6f;
+
+// argmax over the classes of steps [begin, num_steps), class c of step t is
+// logits[c * num_steps + t]; ties keep the lower label
+template <typename T>
+static void argmaxSteps(const T *logits, int num_classes, int num_steps,
+                        int begin, uint8_t *labels) {
+  for (int t = begin; t < num_steps; t++) {
+    T max_value = logits[t];
+    int max_label = 0;
+    for (int c = 1; c < num_classes; c++) {
+      T value = logits[size_t(c) * num_steps + t];
+      if (value > max_value) {
+        max_value = value;
+        max_label = c;
+      }
+    }
+    labels[t] = (uint8_t)max_label;
+  }
+}
+
+// vectorized across the steps, returns the number of steps done
+static int argmaxStepsSimd(const float *logits, int num_classes,
+                           int num_steps, uint8_t *labels) {
+  int t = 0;
+#if defined(__SSE2__)
+  for (; t + 4 <= num_steps; t += 4) {
+    __m128 max_value = _mm_loadu_ps(logits + t);
+    __m128i max_label = _mm_setzero_si128();
+    for (int c = 1; c < num_classes; c++) {
+      __m128 value = _mm_loadu_ps(logits + size_t(c) * num_steps + t);
+      __m128 gt = _mm_cmpgt_ps(value, max_value);
+      __m128i gt_mask = _mm_castps_si128(gt);
+      max_value =
+          _mm_or_ps(_mm_and_ps(gt, value), _mm_andnot_ps(gt, max_value));
+      max_label = _mm_or_si128(_mm_and_si128(gt_mask, _mm_set1_epi32(c)),
+                               _mm_andnot_si128(gt_mask, max_label));
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), max_label);
+    for (int k = 0; k < 4; k++) {
+      labels[t + k] = (uint8_t)lanes[k];
+    }
+  }
+#elif defined(__ARM_NEON)
+  for (; t + 4 <= num_steps; t += 4) {
+    float32x4_t max_value = vld1q_f32(logits + t);
+    uint32x4_t max_label = vdupq_n_u32(0);
+    for (int c = 1; c < num_classes; c++) {
+      float32x4_t value = vld1q_f32(logits + size_t(c) * num_steps + t);
+      uint32x4_t gt = vcgtq_f32(value, max_value);
+      max_value = vbslq_f32(gt, value, max_value);
+      max_label = vbslq_u32(gt, vdupq_n_u32(c), max_label);
+    }
+    uint32_t lanes[4];
+    vst1q_u32(lanes, max_label);
+    for (int k = 0; k < 4; k++) {
+      labels[t + k] = (uint8_t)lanes[k];
+    }
+  }
+#endif
+  return t;
+}
+
+static int argmaxStepsSimd(const int8_t *logits, int num_classes,
+                           int num_steps, uint8_t *labels) {
+  int t = 0;
+#if defined(__SSE2__)
+  for (; t + 16 <= num_steps; t += 16) {
+    __m128i max_value =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(logits + t));
+    __m128i max_label = _mm_setzero_si128();
+    for (int c = 1; c < num_classes; c++) {
+      __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+          logits + size_t(c) * num_steps + t));
+      __m128i gt = _mm_cmpgt_epi8(value, max_value);
+      max_value = _mm_or_si128(_mm_and_si128(gt, value),
+                               _mm_andnot_si128(gt, max_value));
+      max_label = _mm_or_si128(_mm_and_si128(gt, _mm_set1_epi8((char)c)),
+                               _mm_andnot_si128(gt, max_label));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(labels + t), max_label);
+  }
+#elif defined(__ARM_NEON)
+  for (; t + 16 <= num_steps; t += 16) {
+    int8x16_t max_value = vld1q_s8(logits + t);
+    uint8x16_t max_label = vdupq_n_u8(0);
+    for (int c = 1; c < num_classes; c++) {
+      int8x16_t value = vld1q_s8(logits + size_t(c) * num_steps + t);
+      uint8x16_t gt = vcgtq_s8(value, max_value);
+      max_value = vbslq_s8(gt, value, max_value);
+      max_label = vbslq_u8(gt, vdupq_n_u8((uint8_t)c), max_label);
+    }
+    vst1q_u8(labels + t, max_label);
+  }
+#endif
+  return t;
+}
+
+static int argmaxStepsSimd(const uint8_t *logits, int num_classes,
+                           int num_steps, uint8_t *labels) {
+  int t = 0;
+#if defined(__SSE2__)
+  // SSE2 只有有符号比较, 翻转符号位后比较
+  const __m128i sign = _mm_set1_epi8((char)0x80);
+  for (; t + 16 <= num_steps; t += 16) {
+    __m128i max_value = _mm_xor_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(logits + t)), sign);
+    __m128i max_label = _mm_setzero_si128();
+    for (int c = 1; c < num_classes; c++) {
+      __m128i value = _mm_xor_si128(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+              logits + size_t(c) * num_steps + t)),
+          sign);
+      __m128i gt = _mm_cmpgt_epi8(value, max_value);
+      max_value = _mm_or_si128(_mm_and_si128(gt, value),
+                               _mm_andnot_si128(gt, max_value));
+      max_label = _mm_or_si128(_mm_and_si128(gt, _mm_set1_epi8((char)c)),
+                               _mm_andnot_si128(gt, max_label));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(labels + t), max_label);
+  }
+#elif defined(__ARM_NEON)
+  for (; t + 16 <= num_steps; t += 16) {
+    uint8x16_t max_value = vld1q_u8(logits + t);
+    uint8x16_t max_label = vdupq_n_u8(0);
+    for (int c = 1; c < num_classes; c++) {
+      uint8x16_t value = vld1q_u8(logits + size_t(c) * num_steps + t);
+      uint8x16_t gt = vcgtq_u8(value, max_value);
+      max_value = vbslq_u8(gt, value, max_value);
+      max_label = vbslq_u8(gt, vdupq_n_u8((uint8_t)c), max_label);
+    }
+    vst1q_u8(labels + t, max_label);
+  }
+#endif
+  return t;
+}
+
+PlateCtcDecoder::PlateCtcDecoder(const std::vector<std::string> &charset)
+    : charset_(charset), blank_((int)charset.size() - 1) {
+  for (const auto &text : charset_) {
+    max_text_bytes_ = std::max(max_text_bytes_, text.size());
+  }
+  label_masks_.assign(kMaxPlateLength * kMaxClasses, 0);
+  length_masks_.assign(kMaxPlateLength + 1, 0);
+}
+
+int32_t PlateCtcDecoder::setPlateFormats(
+    const std::vector<PlateFormat> &formats) {
+  if (formats.size() > (size_t)kMaxFormats) {
+    LOGE("too many plate formats: %zu", formats.size());
+    return -1;
+  }
+  for (const auto &format : formats) {
+    if (format.empty() || format.size() > (size_t)kMaxPlateLength) {
+      LOGE("invalid plate format length: %zu", format.size());
+      return -1;
+    }
+  }
+  std::fill(label_masks_.begin(), label_masks_.end(), 0);
+  std::fill(length_masks_.begin(), length_masks_.end(), 0);
+  format_mask_ = 0;
+  for (size_t i = 0; i < formats.size(); i++) {
+    const uint32_t bit = 1u << i;
+    for (size_t pos = 0; pos < formats[i].size(); pos++) {
+      for (int c = 0; c < blank_; c++) {
+        if (c < kMaxClasses && formats[i][pos].test(c)) {
+          label_masks_[pos * kMaxClasses + c] |= bit;
+        }
+      }
+    }
+    length_masks_[formats[i].size()] |= bit;
+    format_mask_ |= bit;
+  }
+  return 0;
+}
+
+void PlateCtcDecoder::setBeamWidth(int beam_width) {
+  beam_width_ = std::max(beam_width, 1);
+}
+
+int32_t PlateCtcDecoder::decode(const void *logits, TDLDataType data_type,
+                                float qscale, int batch_num, int num_classes,
+                                int num_steps) {
+  num_results_ = 0;
+  if (logits == nullptr || batch_num < 0 || num_steps <= 0) {
+    LOGE("invalid ctc input, batch_num: %d, num_steps: %d", batch_num,
+         num_steps);
+    return -1;
+  }
+  if (num_classes != (int)charset_.size() || num_classes > kMaxClasses) {
+    LOGE("num_classes %d mismatch with charset size %zu", num_classes,
+         charset_.size());
+    return -1;
+  }
+  num_steps_ = num_steps;
+  // 只增不减, 后续相同 batch 的调用不再分配
+  const size_t num_labels = size_t(batch_num) * num_steps;
+  if (step_labels_.size() < num_labels) {
+    step_labels_.resize(num_labels);
+    labels_.resize(num_labels);
+  }
+  if (label_nums_.size() < (size_t)batch_num) {
+    label_nums_.resize(batch_num);
+    text_offsets_.resize(batch_num + 1);
+  }
+  const size_t text_bytes = batch_num * (num_steps * max_text_bytes_ + 1);
+  if (text_arena_.size() < text_bytes) {
+    text_arena_.resize(text_bytes);
+  }
+  if (qscale <= 0) {
+    qscale = 1.0f;
+  }
+
+  switch (data_type) {
+    case TDLDataType::FP32:
+      decodeBatch(static_cast<const float *>(logits), 1.0f, batch_num);
+      break;
+    case TDLDataType::INT8:
+      decodeBatch(static_cast<const int8_t *>(logits), qscale, batch_num);
+      break;
+    case TDLDataType::UINT8:
+      decodeBatch(static_cast<const uint8_t *>(logits), qscale, batch_num);
+      break;
+    default:
+      LOGE("unsupported ctc logits data type: %d", (int)data_type);
+      return -1;
+  }
+  num_results_ = batch_num;
+  return 0;
+}
+
+template <typename T>
+void PlateCtcDecoder::decodeBatch(const T *logits, float qscale,
+                                  int batch_num) {
+  const int num_classes = blank_ + 1;
+  const size_t plate_size = size_t(num_classes) * num_steps_;
+  text_offsets_[0] = 0;
+  for (int b = 0; b < batch_num; b++) {
+    const T *plate_logits = logits + b * plate_size;
+    uint8_t *step_labels = step_labels_.data() + size_t(b) * num_steps_;
+    int done =
+        argmaxStepsSimd(plate_logits, num_classes, num_steps_, step_labels);
+    argmaxSteps(plate_logits, num_classes, num_steps_, done, step_labels);
+    if (beam_width_ <= 1 || format_mask_ == 0 ||
+        !beamSearch(b, plate_logits, qscale)) {
+      collapse(b);
+    }
+    appendText(b);
+  }
+}
+
+void PlateCtcDecoder::collapse(int idx) {
+  const uint8_t *step_labels = step_labels_.data() + size_t(idx) * num_steps_;
+  uint8_t *labels = labels_.data() + size_t(idx) * num_steps_;
+  int num = 0;
+  int prev = blank_;
+  for (int t = 0; t < num_steps_; t++) {
+    int label = step_labels[t];
+    if (label != blank_ && label != prev) {
+      labels[num++] = (uint8_t)label;
+    }
+    prev = label;
+  }
+  label_nums_[idx] = num;
+}
+
+void PlateCtcDecoder::appendText(int idx) {
+  const uint8_t *labels = labels_.data() + size_t(idx) * num_steps_;
+  char *text = text_arena_.data() + text_offsets_[idx];
+  for (int i = 0; i < label_nums_[idx]; i++) {
+    const std::string &label_text = charset_[labels[i]];
+    memcpy(text, label_text.data(), label_text.size());
+    text += label_text.size();
+  }
+  *text++ = '\0';
+  text_offsets_[idx + 1] = text - text_arena_.data();
+}
+
+PlateCtcDecoder::Beam *PlateCtcDecoder::addBeam(uint64_t key, int length,
+                                                uint32_t format_mask) {
+  // key 中每个字符占一个字节且非零, 已隐含长度
+  for (auto &beam : next_beams_) {
+    if (beam.key == key) {
+      return &beam;
+    }
+  }
+  Beam beam = {key, 0.0f, 0.0f, format_mask, length};
+  next_beams_.push_back(beam);
+  return &next_beams_.back();
+}
+
+template <typename T>
+bool PlateCtcDecoder::beamSearch(int idx, const T *logits, float qscale) {
+  const int top_k = std::min(beam_width_, blank_);
+  const uint8_t *step_labels = step_labels_.data() + size_t(idx) * num_steps_;
+  top_labels_.resize(top_k);
+  top_probs_.resize(top_k);
+  // 预留容量, addBeam 返回的指针在一步内保持有效
+  beams_.reserve(beam_width_ * (top_k + 2));
+  next_beams_.reserve(beam_width_ * (top_k + 2));
+  beams_.clear();
+  const float log_min_label_prob = logf(kMinLabelProb);
+  Beam empty = {0, 1.0f, 0.0f, format_mask_, 0};
+  beams_.push_back(empty);
+
+  for (int t = 0; t < num_steps_; t++) {
+    // 第 c 类为 step[c * num_steps_]
+    const T *step = logits + t;
+    // 未归一化的 softmax, 同一步内所有 beam 共享归一化因子, 不影响排序;
+    // 只对用到的类别求 exp
+    const float max_value = float(step[step_labels[t] * num_steps_]);
+    auto prob = [&](int c) {
+      return expf((float(step[size_t(c) * num_steps_]) - max_value) * qscale);
+    };
+    // 在原始 logits 上按降序选出 top_k 个非空白字符, top_probs_ 先暂存
+    // logits, 再换算为概率
+    float *top_values = top_probs_.data();
+    int *top = top_labels_.data();
+    // 概率低于 kMinLabelProb 的字符不参与扩展, 直接跳过
+    const float min_value = max_value + log_min_label_prob / qscale;
+    int num_top = 0;
+    for (int c = 0; c < blank_; c++) {
+      const float value = float(step[size_t(c) * num_steps_]);
+      if (value < min_value ||
+          (num_top == top_k && value <= top_values[top_k - 1])) {
+        continue;
+      }
+      int pos = num_top < top_k ? num_top++ : top_k - 1;
+      while (pos > 0 && top_values[pos - 1] < value) {
+        top_values[pos] = top_values[pos - 1];
+        top[pos] = top[pos - 1];
+        pos--;
+      }
+      top_values[pos] = value;
+      top[pos] = c;
+    }
+    for (int k = 0; k < num_top; k++) {
+      top_values[k] = expf((top_values[k] - max_value) * qscale);
+    }
+    const float blank_prob = prob(blank_);
+
+    next_beams_.clear();
+    for (const Beam &beam : beams_) {
+      const float total = beam.prob_blank + beam.prob_non_blank;
+      const int last = beam.length > 0 ? int(beam.key & 0xff) - 1 : -1;
+      Beam *same = addBeam(beam.key, beam.length, beam.format_mask);
+      same->prob_blank += total * blank_prob;
+      if (last >= 0) {
+        same->prob_non_blank += beam.prob_non_blank * prob(last);
+      }
+      if (beam.length >= kMaxPlateLength) {
+        continue;
+      }
+      const uint32_t *masks = label_masks_.data() + beam.length * kMaxClasses;
+      for (int k = 0; k < num_top; k++) {
+        const int c = top_labels_[k];
+        const uint32_t format_mask = beam.format_mask & masks[c];
+        if (format_mask == 0) {
+          continue;
+        }
+        // 与上一字符相同时, 只能从以空白结尾的路径扩展
+        const float prefix_prob = c == last ? beam.prob_blank : total;
+        Beam *next = addBeam((beam.key << 8) | uint64_t(c + 1),
+                             beam.length + 1, format_mask);
+        next->prob_non_blank += prefix_prob * top_probs_[k];
+      }
+    }
+
+    size_t keep = std::min(next_beams_.size(), (size_t)beam_width_);
+    std::partial_sort(next_beams_.begin(), next_beams_.begin() + keep,
+                      next_beams_.end(), [](const Beam &a, const Beam &b) {
+                        return a.prob_blank + a.prob_non_blank >
+                               b.prob_blank + b.prob_non_blank;
+                      });
+    // 按最优 beam 归一化, 并丢弃概率过小的 beam, 避免连乘下溢到非规格化数
+    const float best =
+        next_beams_[0].prob_blank + next_beams_[0].prob_non_blank;
+    if (best > 0) {
+      const float scale = 1.0f / best;
+      for (size_t i = 0; i < keep; i++) {
+        Beam &beam = next_beams_[i];
+        if ((beam.prob_blank + beam.prob_non_blank) * scale < kMinBeamProb) {
+          keep = i;
+          break;
+        }
+        beam.prob_blank *= scale;
+        beam.prob_non_blank *= scale;
+      }
+    }
+    next_beams_.resize(keep);
+    beams_.swap(next_beams_);
+  }
+
+  const Beam *result = nullptr;
+  for (const auto &beam : beams_) {
+    if ((beam.format_mask & length_masks_[beam.length]) == 0) {
+      continue;
+    }
+    if (result == nullptr || beam.prob_blank + beam.prob_non_blank >
+                                 result->prob_blank + result->prob_non_blank) {
+      result = &beam;
+    }
+  }
+  // 完整车牌的概率远低于最优 beam 时 (如非车牌或截断), 不强行套用格式
+  const float best = beams_[0].prob_blank + beams_[0].prob_non_blank;
+  if (result == nullptr || result->prob_blank + result->prob_non_blank <
+                               best * kMinCompleteRatio) {
+    return false;
+  }
+  uint8_t *labels = labels_.data() + size_t(idx) * num_steps_;
+  uint64_t key = result->key;
+  for (int i = result->length - 1; i >= 0; i--) {
+    labels[i] = uint8_t((key & 0xff) - 1);
+    key >>= 8;
+  }
+  label_nums_[idx] = result->length;
+  return true;
+}
@@ -0,0 +1,104 @@
+#ifndef PLATE_CTC_DECODER_HPP
+#define PLATE_CTC_DECODER_HPP
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/common_types.hpp"
+
+// CTC decoding of license plate recognition output.
+//
+// The logits of a batch are [batch_num, num_classes, num_steps] in the
+// native output type (fp32, int8 or uint8), the last class is the blank.
+// Greedy decoding takes the argmax of every step without dequantizing,
+// vectorized across the steps, and collapses the labels straight into a
+// text arena that is reused across calls.
+//
+// With a beam width > 1 a prefix beam search runs on top, only extending
+// prefixes that still match one of the plate formats. The best complete
+// plate wins; if no beam completes a format, or the complete ones are far
+// less likely than the best beam, the greedy text is kept.
+class PlateCtcDecoder {
+ public:
+  static const int kMaxClasses = 256;
+  static const int kMaxPlateLength = 8;
+  static const int kMaxFormats = 32;
+
+  // allowed labels of each character position of a plate
+  typedef std::vector<std::bitset<kMaxClasses>> PlateFormat;
+
+  // charset: text of every label, the blank is the last one
+  explicit PlateCtcDecoder(const std::vector<std::string>& charset);
+
+  // at most kMaxFormats formats of 1 ~ kMaxPlateLength characters, the beam
+  // search only runs when formats are set
+  int32_t setPlateFormats(const std::vector<PlateFormat>& formats);
+  // <= 1 for greedy decoding
+  void setBeamWidth(int beam_width);
+  int getBeamWidth() const { return beam_width_; }
+
+  // qscale only matters to the beam search of quantized logits
+  int32_t decode(const void* logits, TDLDataType data_type, float qscale,
+                 int batch_num, int num_classes, int num_steps);
+
+  // results of the last decode(), texts are null terminated
+  int getNum() const { return num_results_; }
+  const char* getText(int idx) const {
+    return text_arena_.data() + text_offsets_[idx];
+  }
+  size_t getLength(int idx) const {
+    return text_offsets_[idx + 1] - text_offsets_[idx] - 1;
+  }
+  // collapsed labels of result idx
+  const uint8_t* getLabels(int idx, int* num) const {
+    *num = label_nums_[idx];
+    return labels_.data() + size_t(idx) * num_steps_;
+  }
+
+ private:
+  struct Beam {
+    uint64_t key;  // labels + 1 packed into bytes, last label lowest
+    float prob_blank;
+    float prob_non_blank;
+    uint32_t format_mask;  // formats still matched by the prefix
+    int length;
+  };
+
+  template <typename T>
+  void decodeBatch(const T* logits, float qscale, int batch_num);
+  // false if no beam completes a plate format
+  template <typename T>
+  bool beamSearch(int idx, const T* logits, float qscale);
+  void collapse(int idx);
+  void appendText(int idx);
+  Beam* addBeam(uint64_t key, int length, uint32_t format_mask);
+
+  std::vector<std::string> charset_;
+  size_t max_text_bytes_ = 0;  // longest label text
+  // formats allowing label c at position i, [kMaxPlateLength, kMaxClasses]
+  std::vector<uint32_t> label_masks_;
+  // formats of each length, [kMaxPlateLength + 1]
+  std::vector<uint32_t> length_masks_;
+  uint32_t format_mask_ = 0;  // all formats
+  int beam_width_ = 1;
+  int blank_;
+
+  int num_results_ = 0;
+  int num_steps_ = 0;
+  // argmax per step, then the collapsed labels, [batch_num, num_steps]
+  std::vector<uint8_t> step_labels_;
+  std::vector<uint8_t> labels_;
+  std::vector<int> label_nums_;
+  std::vector<char> text_arena_;
+  std::vector<size_t> text_offsets_;
+
+  // beam search scratch
+  std::vector<Beam> beams_;
+  std::vector<Beam> next_beams_;
+  std::vector<int> top_labels_;
+  std::vector<float> top_probs_;
+};
+
+#endif
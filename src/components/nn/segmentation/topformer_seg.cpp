@@ -1,6 +1,8 @@
 #include "segmentation/topformer_seg.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <sstream>
 #include <tuple>
@@ -14,42 +16,67 @@
 #define B_SCALE 0.0174291
 #define NAME_SCORE 0
 
+// 按索引表最近邻采样, 映射到同一源行的相邻输出行直接复制
 template <typename T, typename U>
-void nearestNeighborInterpolation(
-    std::shared_ptr<ModelSegmentationInfo>& filter, T* out_id, U* out_conf,
-    int outH, int outW, int preH, int preW, int outShapeH, int outShapeW) {
-  filter->class_id = (uint8_t*)malloc(outH * outW * sizeof(uint8_t));
-  filter->class_conf = (uint8_t*)malloc(outH * outW * sizeof(uint8_t));
-
-  uint8_t* class_id = filter->class_id;
-  uint8_t* class_conf = filter->class_conf;
-  filter->output_height = outH;
-  filter->output_width = outW;
-  float scale_H = static_cast<float>(preH - 1) / static_cast<float>(outH - 1);
-  float scale_W = static_cast<float>(preW - 1) / static_cast<float>(outW - 1);
-  int* srcX_s = new int[outH];
-  int* srcY_s = new int[outW];
-
+void nearestNeighborInterpolation(const T* out_id, const U* out_conf,
+                                  int stride, const std::vector<int>& rows,
+                                  const std::vector<int>& cols,
+                                  uint8_t* class_id, uint8_t* class_conf) {
+  int outH = rows.size();
+  int outW = cols.size();
+  const int* col = cols.data();
   for (int x = 0; x < outH; ++x) {
-    srcX_s[x] = static_cast<int>((x + 0.5) * scale_H);
-  }
-  for (int y = 0; y < outW; ++y) {
-    srcY_s[y] = static_cast<int>((y + 0.5) * scale_W);
+    uint8_t* id_row = class_id + x * outW;
+    uint8_t* conf_row = class_conf + x * outW;
+    if (x > 0 && rows[x] == rows[x - 1]) {
+      memcpy(id_row, id_row - outW, outW);
+      memcpy(conf_row, conf_row - outW, outW);
+      continue;
+    }
+    const T* id_src = out_id + rows[x] * stride;
+    const U* conf_src = out_conf + rows[x] * stride;
+    for (int y = 0; y < outW; ++y) {
+      id_row[y] = static_cast<uint8_t>(id_src[col[y]]);
+      conf_row[y] = static_cast<uint8_t>(conf_src[col[y]]);
+    }
   }
+}
 
-  for (int x = 0; x < outH; ++x) {
-    int srcX = srcX_s[x];
-    for (int y = 0; y < outW; ++y) {
-      int srcY = srcY_s[y];
-      class_id[x * outW + y] =
-          static_cast<uint8_t>(out_id[srcX * outShapeW + srcY]);
-      class_conf[x * outW + y] =
-          static_cast<uint8_t>(out_conf[srcX * outShapeW + srcY]);
+// 截取有效区域 (preH x preW) 转为 uint8 的模型分辨率类别图
+template <typename T, typename U>
+void convertNativeMaps(const T* out_id, const U* out_conf, int stride,
+                       int preH, int preW,
+                       std::shared_ptr<ModelSegmentationInfo>& seg) {
+  seg->native_width = preW;
+  seg->native_height = preH;
+  seg->native_class_id.resize(preH * preW);
+  seg->native_class_conf.resize(preH * preW);
+  for (int x = 0; x < preH; ++x) {
+    const T* id_src = out_id + x * stride;
+    const U* conf_src = out_conf + x * stride;
+    uint8_t* id_dst = seg->native_class_id.data() + x * preW;
+    uint8_t* conf_dst = seg->native_class_conf.data() + x * preW;
+    for (int y = 0; y < preW; ++y) {
+      id_dst[y] = static_cast<uint8_t>(id_src[y]);
+      conf_dst[y] = static_cast<uint8_t>(conf_src[y]);
     }
   }
+}
 
-  delete[] srcX_s;
-  delete[] srcY_s;
+template <typename T>
+void parseSegOutput(const T* out_id, const float* out_conf, int stride,
+                    int preH, int preW, const std::vector<int>& rows,
+                    const std::vector<int>& cols, bool lazy,
+                    std::shared_ptr<ModelSegmentationInfo>& seg) {
+  if (lazy) {
+    convertNativeMaps(out_id, out_conf, stride, preH, preW, seg);
+    return;
+  }
+  size_t size = rows.size() * cols.size();
+  seg->class_id = (uint8_t*)malloc(size * sizeof(uint8_t));
+  seg->class_conf = (uint8_t*)malloc(size * sizeof(uint8_t));
+  nearestNeighborInterpolation(out_id, out_conf, stride, rows, cols,
+                               seg->class_id, seg->class_conf);
 }
 
 TopformerSeg::TopformerSeg() : TopformerSeg(16) {}
@@ -73,6 +100,44 @@ TopformerSeg::TopformerSeg(int down_rato) {
 }
 TopformerSeg::~TopformerSeg() {}
 
+int32_t TopformerSeg::inference(
+    const std::vector<std::shared_ptr<BaseImage>>& images,
+    std::vector<std::shared_ptr<ModelOutputInfo>>& out_datas,
+    const std::map<std::string, float>& parameters) {
+  auto it = parameters.find("lazy_upsample");
+  lazy_upsample_ = (it != parameters.end() && it->second != 0);
+  return BaseModel::inference(images, out_datas, parameters);
+}
+
+const TopformerSeg::IndexLut& TopformerSeg::getIndexLut(int out_h, int out_w,
+                                                        int pre_h,
+                                                        int pre_w) {
+  auto key = std::make_tuple(out_h, out_w, pre_h, pre_w);
+  auto it = index_luts_.find(key);
+  if (it != index_luts_.end()) {
+    return it->second;
+  }
+  if (index_luts_.size() >= 16) {
+    index_luts_.clear();  // 输入分辨率频繁变化时避免无限增长
+  }
+  auto make_index = [](int out_size, int pre_size) {
+    auto index = std::make_shared<std::vector<int>>(out_size);
+    float scale = out_size > 1 ? static_cast<float>(pre_size - 1) /
+                                     static_cast<float>(out_size - 1)
+                               : 0.0f;
+    for (int i = 0; i < out_size; ++i) {
+      (*index)[i] =
+          std::min(static_cast<int>((i + 0.5) * scale), pre_size - 1);
+    }
+    return std::shared_ptr<const std::vector<int>>(index);
+  };
+  IndexLut& lut = index_luts_[key];
+  lut.rows = make_index(out_h, pre_h);
+  lut.cols = make_index(out_w, pre_w);
+  return lut;
+}
+
+
 int32_t TopformerSeg::outputParse(
     const std::vector<std::shared_ptr<BaseImage>>& images,
     std::vector<std::shared_ptr<ModelOutputInfo>>& out_datas) {
@@ -123,14 +188,21 @@ int32_t TopformerSeg::outputParse(
     outW = std::ceil(static_cast<float>(image_width) / downRato);
     outH = std::ceil(static_cast<float>(image_height) / downRato);
 
+    const IndexLut& lut = getIndexLut(outH, outW, preH, preW);
+    seg->image_width = image_width;
+    seg->image_height = image_height;
+    seg->output_width = outW;
+    seg->output_height = outH;
+    seg->row_index = lut.rows;
+    seg->col_index = lut.cols;
+
     if (out_id_info.data_type == TDLDataType::FP32) {
-      nearestNeighborInterpolation(seg, out_id_tensor->getBatchPtr<float>(b),
-                                   out_conf, outH, outW, preH, preW, outShapeH,
-                                   outShapeW);
+      parseSegOutput(out_id_tensor->getBatchPtr<float>(b), out_conf, outShapeW,
+                     preH, preW, *lut.rows, *lut.cols, lazy_upsample_, seg);
     } else if (out_id_info.data_type == TDLDataType::INT32) {
-      nearestNeighborInterpolation(seg, out_id_tensor->getBatchPtr<int32_t>(b),
-                                   out_conf, outH, outW, preH, preW, outShapeH,
-                                   outShapeW);
+      parseSegOutput(out_id_tensor->getBatchPtr<int32_t>(b), out_conf,
+                     outShapeW, preH, preW, *lut.rows, *lut.cols,
+                     lazy_upsample_, seg);
     } else {
       LOGE("unsupported data type:%d\n",
            static_cast<int>(out_id_info.data_type));
@@ -1,5 +1,7 @@
 #pragma once
 #include <bitset>
+#include <map>
+#include <tuple>
 
 #include "model/base_model.hpp"
 
@@ -9,14 +11,31 @@ class TopformerSeg final : public BaseModel {
   TopformerSeg(int down_rato);
   ~TopformerSeg();
 
+  using BaseModel::inference;
+  // parameters: "lazy_upsample" 非 0 时只输出模型分辨率的类别图与索引表,
+  // 全分辨率结果由 ModelSegmentationInfo::upsampleRoi 按需生成
+  virtual int32_t inference(
+      const std::vector<std::shared_ptr<BaseImage>> &images,
+      std::vector<std::shared_ptr<ModelOutputInfo>> &out_datas,
+      const std::map<std::string, float> &parameters = {}) override;
+
   virtual int32_t outputParse(
       const std::vector<std::shared_ptr<BaseImage>> &images,
       std::vector<std::shared_ptr<ModelOutputInfo>> &out_datas) override;
 
  private:
+  struct IndexLut {
+    std::shared_ptr<const std::vector<int>> rows;
+    std::shared_ptr<const std::vector<int>> cols;
+  };
+  // 最近邻索引表按 (outH, outW, preH, preW) 缓存, 同分辨率的帧不再重算
+  const IndexLut &getIndexLut(int out_h, int out_w, int pre_h, int pre_w);
+
   int oriW, oriH;
   int outW, outH;
   int preW, preH;
   int outShapeH, outShapeW;
   int downRato;
+  bool lazy_upsample_ = false;
+  std::map<std::tuple<int, int, int, int>, IndexLut> index_luts_;
 };
@@ -17,7 +17,16 @@ int32_t ZipformerDecoder::setupNetwork(NetParam &net_param) {
   return 0;
 }
 
-int32_t ZipformerDecoder::onModelOpened() { return 0; }
+int32_t ZipformerDecoder::onModelOpened() {
+  std::vector<std::string> input_layers = net_->getInputNames();
+  const TensorInfo &tinfo = net_->getTensorInfo(input_layers[0]);
+  batch_size_ = tinfo.shape[0];
+  std::vector<std::string> output_layers = net_->getOutputNames();
+  const TensorInfo &out_tinfo = net_->getTensorInfo(output_layers[0]);
+  feature_size_ = out_tinfo.shape[0] * out_tinfo.shape[1] *
+                  out_tinfo.shape[2] * out_tinfo.shape[3] / batch_size_;
+  return 0;
+}
 
 int32_t ZipformerDecoder::inference(
     const std::shared_ptr<BaseImage> &image,
@@ -79,3 +88,32 @@ int32_t ZipformerDecoder::outputParse(
 
   return 0;
 }
+
+int32_t ZipformerDecoder::inferenceBatch(const int32_t *contexts, int num,
+                                         float *features) {
+  if (num <= 0 || num > batch_size_) {
+    LOGE("ZipformerDecoder batch num %d out of range [1, %d]\n", num,
+         batch_size_);
+    return -1;
+  }
+  std::vector<std::string> input_layers = net_->getInputNames();
+  const TensorInfo &tinfo = net_->getTensorInfo(input_layers[0]);
+  int context_size =
+      tinfo.shape[0] * tinfo.shape[1] * tinfo.shape[2] * tinfo.shape[3] /
+      batch_size_;
+  int32_t *input_ptr = (int32_t *)tinfo.sys_mem;
+  memcpy(input_ptr, contexts, num * context_size * sizeof(int32_t));
+  memset(input_ptr + num * context_size, 0,
+         (batch_size_ - num) * context_size * sizeof(int32_t));
+
+  net_->updateInputTensors();
+  net_->forward();
+  net_->updateOutputTensors();
+
+  std::vector<std::string> output_layers = net_->getOutputNames();
+  std::shared_ptr<BaseTensor> output_tensor =
+      net_->getOutputTensor(output_layers[0]);
+  memcpy(features, output_tensor->getBatchPtr<float>(0),
+         num * feature_size_ * sizeof(float));
+  return 0;
+}
@@ -15,6 +15,16 @@ class ZipformerDecoder : public BaseModel {
       const std::shared_ptr<BaseImage>& image,
       std::shared_ptr<ModelOutputInfo>& out_data) override;
   virtual int32_t onModelOpened() override;
+
+  // num (<= getBatchSize()) contexts of two tokens, writes num decoder
+  // features of getFeatureSize() floats
+  int32_t inferenceBatch(const int32_t* contexts, int num, float* features);
+  int getBatchSize() const { return batch_size_; }
+  int getFeatureSize() const { return feature_size_; }
+
+ private:
+  int batch_size_ = 1;
+  int feature_size_ = 0;
 };
 
 #endif
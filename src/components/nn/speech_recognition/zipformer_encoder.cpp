@@ -1,6 +1,8 @@
 #include "speech_recognition/zipformer_encoder.hpp"
 #include <fstream>
 #include <numeric>
+#include "speech_recognition/zipformer_decoder.hpp"
+#include "speech_recognition/zipformer_joiner.hpp"
 #include "utils/tdl_log.hpp"
 
 #define ZIPFORMER_SAMPLE_RATE 16000
@@ -17,31 +19,47 @@ static void replace_substr(std::string &str, const std::string &from,
   }
 }
 
-ZipformerEncoder::ZipformerEncoder() {
-  knf::FbankOptions fbank_opts;
-  fbank_opts.frame_opts.dither = 0;
-  fbank_opts.frame_opts.snip_edges = false;
-  fbank_opts.frame_opts.samp_freq = ZIPFORMER_SAMPLE_RATE;
-  fbank_opts.mel_opts.num_bins = 80;
-  fbank_opts.mel_opts.high_freq = -400;
-
-  fbank_extractor_ = new knf::OnlineFbank(fbank_opts);
-
-  decoder_input_data_ = ImageFactory::createImage(2, 1, ImageFormat::GRAY,
-                                                  TDLDataType::INT32, true);
-  joiner_input_data_ =
-      ImageFactory::createImage(ZIPFORMER_FEATURE_SIZE * 2, 1,
-                                ImageFormat::GRAY, TDLDataType::FP32, true);
+// batch axis of a streaming zipformer cache input:
+//   cached_len/avg/conv1/conv2: [num_layers, batch, ...] -> 1
+//   cached_key/val/val2: [num_layers, left_context, batch, dim] -> 2
+// other inputs fall back to the only axis equal to batch_size, -1 on failure
+static int cacheBatchAxis(const std::string &name,
+                          const std::vector<int> &shape, int batch_size) {
+  int axis = -1;
+  if (name.find("cached_key") != std::string::npos ||
+      name.find("cached_val") != std::string::npos) {
+    axis = 2;
+  } else if (name.find("cached_") != std::string::npos) {
+    axis = 1;
+  } else {
+    for (int a = 0; a < (int)shape.size(); a++) {
+      if (shape[a] != batch_size) continue;
+      if (axis >= 0) {
+        LOGE("ZipformerEncoder input %s has more than one batch axis\n",
+             name.c_str());
+        return -1;
+      }
+      axis = a;
+    }
+  }
+  if (axis < 0 || axis >= (int)shape.size() || shape[axis] != batch_size) {
+    LOGE("ZipformerEncoder can not find the batch axis of input %s\n",
+         name.c_str());
+    return -1;
+  }
+  return axis;
 }
 
-ZipformerEncoder::~ZipformerEncoder() {
-  free(int32_chached_inputs_);
-  int32_chached_inputs_ = nullptr;
-  free(float_chached_inputs_);
-  float_chached_inputs_ = nullptr;
-  delete fbank_extractor_;
+ZipformerEncoder::ZipformerEncoder() {
+  fbank_opts_.frame_opts.dither = 0;
+  fbank_opts_.frame_opts.snip_edges = false;
+  fbank_opts_.frame_opts.samp_freq = ZIPFORMER_SAMPLE_RATE;
+  fbank_opts_.mel_opts.num_bins = 80;
+  fbank_opts_.mel_opts.high_freq = -400;
 }
 
+ZipformerEncoder::~ZipformerEncoder() {}
+
 int32_t ZipformerEncoder::setupNetwork(NetParam &net_param) {
   net_ = NetFactory::createNet(net_param, net_param.platform);
   int32_t ret = net_->setup();
@@ -83,8 +101,37 @@ int32_t ZipformerEncoder::setTokensPath(std::string tokens_path) {
 
 int32_t ZipformerEncoder::setModel(std::shared_ptr<BaseModel> decoder_model,
                                    std::shared_ptr<BaseModel> joiner_model) {
-  decoder_model_ = decoder_model;
-  joiner_model_ = joiner_model;
+  decoder_model_ = std::dynamic_pointer_cast<ZipformerDecoder>(decoder_model);
+  joiner_model_ = std::dynamic_pointer_cast<ZipformerJoiner>(joiner_model);
+  if (decoder_model_ == nullptr || joiner_model_ == nullptr) {
+    LOGE("ZipformerEncoder setModel failed, decoder or joiner type mismatch\n");
+    return -1;
+  }
+  return initSearch();
+}
+
+int32_t ZipformerEncoder::initSearch() {
+  if (decoder_model_->getFeatureSize() != ZIPFORMER_FEATURE_SIZE) {
+    LOGE("ZipformerDecoder feature size %d, expect %d\n",
+         decoder_model_->getFeatureSize(), ZIPFORMER_FEATURE_SIZE);
+    return -1;
+  }
+  std::shared_ptr<ZipformerDecoder> decoder = decoder_model_;
+  std::shared_ptr<ZipformerJoiner> joiner = joiner_model_;
+  search_.reset(new ZipformerGreedySearch(
+      ZIPFORMER_FEATURE_SIZE, joiner->getBatchSize(),
+      decoder->getBatchSize(),
+      [joiner](const float *encoder_out, const float *decoder_out, int num,
+               int32_t *tokens) {
+        return joiner->inferenceBatch(encoder_out, decoder_out, num, tokens);
+      },
+      [decoder](const int32_t *contexts, int num, float *decoder_out) {
+        return decoder->inferenceBatch(contexts, num, decoder_out);
+      }));
+  // streams restart their search with the new models
+  for (auto &it : streams_) {
+    it.second->search_ready = false;
+  }
   return 0;
 }
 
@@ -95,6 +142,7 @@ int32_t ZipformerEncoder::onModelOpened() {
 
   float_cached_offset_.clear();
   int32_cached_offset_.clear();
+  cache_batch_axis_.assign(input_layers.size(), 0);
   for (int i = 0; i < input_layers.size(); i++) {
     const TensorInfo &tinfo = net_->getTensorInfo(input_layers[i]);
 
@@ -104,6 +152,7 @@ int32_t ZipformerEncoder::onModelOpened() {
       float_cached_offset_.push_back(0);
       int32_cached_offset_.push_back(0);
       data_type = tinfo.data_type;
+      batch_size_ = tinfo.shape[0];
       segment_size_ = tinfo.shape[1];
       num_mel_ = tinfo.shape[2];
 
@@ -112,12 +161,24 @@ int32_t ZipformerEncoder::onModelOpened() {
       } else {
         frame_offset_ = 64;  // model-s
       }
-      LOGI("ZipformerEncoder segment_size_: %d, num_mel_: %d\n", segment_size_,
-           num_mel_);
+      LOGI(
+          "ZipformerEncoder batch_size_: %d, segment_size_: %d, num_mel_: "
+          "%d\n",
+          batch_size_, segment_size_, num_mel_);
       continue;
     }
     int cached_size =
         tinfo.shape[0] * tinfo.shape[1] * tinfo.shape[2] * tinfo.shape[3];
+    if (batch_size_ > 1) {
+      // the caches of a batched model keep the batch on an inner axis,
+      // num_layers may equal batch_size so the axis comes from the name
+      int axis = cacheBatchAxis(input_layers[i], tinfo.shape, batch_size_);
+      if (axis < 0) {
+        return -1;
+      }
+      cache_batch_axis_[i] = axis;
+      cached_size /= batch_size_;
+    }
 
     if (i <= 5) {
       int32_cached_offset_.push_back(
@@ -135,89 +196,281 @@ int32_t ZipformerEncoder::onModelOpened() {
   if (data_type != TDLDataType::FP32) {
     LOGE("ZipformerEncoder only support float32 input now!\n");
     return -1;
-  } else {
-    int32_chached_inputs_ =
-        (int32_t *)malloc(int32_cached_offset_.back() * sizeof(int32_t));
-    memset(int32_chached_inputs_, 0,
-           int32_cached_offset_.back() * sizeof(int32_t));
+  }
+
+  // existing streams are reset to the new cache layout
+  for (auto &it : streams_) {
+    resetStream(*it.second);
+  }
+  if (streams_.count(kDefaultStreamId) == 0) {
+    streams_[kDefaultStreamId].reset(new ZipformerStream());
+    resetStream(*streams_[kDefaultStreamId]);
+  }
+  return 0;
+}
+
+void ZipformerEncoder::resetStream(ZipformerStream &stream) {
+  stream.fbank_extractor.reset(new knf::OnlineFbank(fbank_opts_));
+  stream.int32_cached_inputs.assign(int32_cached_offset_.back(), 0);
+  stream.float_cached_inputs.assign(float_cached_offset_.back(), 0);
+  stream.num_processed_frames = 0;
+  stream.num_used_chunks = 0;
+  stream.input_finished = false;
+  stream.search_ready = false;
+  stream.search.encoder_out = nullptr;
+  stream.search.num_frames = 0;
+  stream.search.hyp = {0};
+}
+
+ZipformerStream *ZipformerEncoder::getStream(int32_t stream_id) {
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end()) {
+    LOGE("ZipformerEncoder stream %d not found\n", stream_id);
+    return nullptr;
+  }
+  return it->second.get();
+}
+
+int32_t ZipformerEncoder::createStream() {
+  if (float_cached_offset_.empty()) {
+    LOGE("ZipformerEncoder model not opened\n");
+    return -1;
+  }
+  int32_t stream_id = next_stream_id_++;
+  streams_[stream_id].reset(new ZipformerStream());
+  resetStream(*streams_[stream_id]);
+  return stream_id;
+}
 
-    float_chached_inputs_ =
-        (float *)malloc(float_cached_offset_.back() * sizeof(float));
-    memset(float_chached_inputs_, 0,
-           float_cached_offset_.back() * sizeof(float));
+int32_t ZipformerEncoder::destroyStream(int32_t stream_id) {
+  if (stream_id == kDefaultStreamId || streams_.erase(stream_id) == 0) {
+    LOGE("ZipformerEncoder destroyStream failed, stream_id: %d\n", stream_id);
+    return -1;
   }
+  return 0;
+}
 
+int32_t ZipformerEncoder::acceptWaveform(int32_t stream_id, const int16_t *pcm,
+                                         size_t num_samples,
+                                         bool input_finished) {
+  ZipformerStream *stream = getStream(stream_id);
+  if (stream == nullptr) {
+    return -1;
+  }
+  // int16 -> float in a reused buffer, the loop is vectorized
+  pcm_buffer_.resize(num_samples);
+  float *dst = pcm_buffer_.data();
+  const float scale = 1.0f / 32768;
+  for (size_t i = 0; i < num_samples; i++) {
+    dst[i] = pcm[i] * scale;
+  }
+  stream->fbank_extractor->AcceptWaveform(ZIPFORMER_SAMPLE_RATE, dst,
+                                          num_samples);
+  stream->input_finished = input_finished;
   return 0;
 }
 
-int32_t ZipformerEncoder::prepareInput() {
+void ZipformerEncoder::gatherCaches(
+    const std::vector<ZipformerStream *> &streams) {
   std::vector<std::string> input_layers = net_->getInputNames();
-
-  for (int i = 0; i < input_layers.size(); i++) {
+  int num = streams.size();
+  for (int i = 1; i < input_layers.size(); i++) {
     const TensorInfo &tinfo = net_->getTensorInfo(input_layers[i]);
+    bool is_int32 = i <= 5;
+    int offset = is_int32 ? int32_cached_offset_[i - 1]
+                          : float_cached_offset_[i - 6];
+    int size = is_int32 ? int32_cached_offset_[i] - offset
+                        : float_cached_offset_[i - 5] - offset;
+    // [outer, batch, inner] view of the input, both types are 4 bytes
+    int axis = cache_batch_axis_[i];
+    int outer = 1;
+    for (int a = 0; a < axis; a++) outer *= tinfo.shape[a];
+    int inner = size / outer;
+    uint8_t *dst = tinfo.sys_mem;
+    for (int b = 0; b < batch_size_; b++) {
+      const uint8_t *src =
+          b >= num ? nullptr
+          : is_int32
+              ? (const uint8_t *)(streams[b]->int32_cached_inputs.data() +
+                                  offset)
+              : (const uint8_t *)(streams[b]->float_cached_inputs.data() +
+                                  offset);
+      for (int o = 0; o < outer; o++) {
+        uint8_t *dst_row = dst + (size_t(o) * batch_size_ + b) * inner * 4;
+        if (src != nullptr) {
+          memcpy(dst_row, src + size_t(o) * inner * 4, inner * 4);
+        } else {
+          memset(dst_row, 0, inner * 4);  // padding slot
+        }
+      }
+    }
+  }
+}
 
-    if (i == 0) {
-      float *input_ptr = (float *)tinfo.sys_mem;
+int32_t ZipformerEncoder::scatterCaches(
+    const std::vector<ZipformerStream *> &streams) {
+  std::vector<std::string> output_layers = net_->getOutputNames();
+  int num = streams.size();
+  for (int i = 1; i < output_layers.size(); i++) {
+    const TensorInfo &tinfo = net_->getTensorInfo(output_layers[i]);
+    int data_size =
+        tinfo.shape[0] * tinfo.shape[1] * tinfo.shape[2] * tinfo.shape[3];
+    bool is_int32 = i <= 5;
+    int offset = is_int32 ? int32_cached_offset_[i - 1]
+                          : float_cached_offset_[i - 6];
+    int size = is_int32 ? int32_cached_offset_[i] - offset
+                        : float_cached_offset_[i - 5] - offset;
+    if (data_size != size * batch_size_) {
+      LOGE(
+          "ZipformerEncoder output size %d not equal to cached input size "
+          "%d\n",
+          data_size, size * batch_size_);
+      return -1;
+    }
 
-      for (int j = 0; j < segment_size_; j++) {
-        const float *frame =
-            fbank_extractor_->GetFrame(num_processed_frames_ + j);
-        memcpy(input_ptr + j * num_mel_, frame, num_mel_ * sizeof(float));
+    std::shared_ptr<BaseTensor> output_tensor =
+        net_->getOutputTensor(output_layers[i]);
+    const float *output_ptr = output_tensor->getBatchPtr<float>(0);
+    int axis = cache_batch_axis_[i];
+    int outer = 1;
+    for (int a = 0; a < axis; a++) outer *= tinfo.shape[a];
+    int inner = size / outer;
+    for (int b = 0; b < num; b++) {
+      for (int o = 0; o < outer; o++) {
+        const float *src = output_ptr + (size_t(o) * batch_size_ + b) * inner;
+        if (is_int32) {
+          int32_t *dst =
+              streams[b]->int32_cached_inputs.data() + offset + o * inner;
+          for (int j = 0; j < inner; j++) {
+            dst[j] = (int32_t)(src[j]);  // output data type != input data
+                                         // type cause of tpu-milr bug
+          }
+        } else {
+          memcpy(streams[b]->float_cached_inputs.data() + offset + o * inner,
+                 src, inner * sizeof(float));
+        }
       }
-      num_processed_frames_ += frame_offset_;
-
-    } else if (i <= 5) {
-      int32_t *input_ptr = (int32_t *)tinfo.sys_mem;
-      memcpy(input_ptr, int32_chached_inputs_ + int32_cached_offset_[i - 1],
-             (int32_cached_offset_[i] - int32_cached_offset_[i - 1]) *
-                 sizeof(int32_t));
-    } else {
-      float *input_ptr = (float *)tinfo.sys_mem;
-      memcpy(input_ptr, float_chached_inputs_ + float_cached_offset_[i - 6],
-             (float_cached_offset_[i - 5] - float_cached_offset_[i - 6]) *
-                 sizeof(float));
     }
   }
-
   return 0;
 }
 
-int32_t ZipformerEncoder::greedy_search(
-    float *data_ptr, std::shared_ptr<ModelOutputInfo> &out_data) {
-  std::shared_ptr<ModelASRInfo> asr_meta =
-      std::static_pointer_cast<ModelASRInfo>(out_data);
+int32_t ZipformerEncoder::forwardChunk(
+    const std::vector<ZipformerStream *> &streams) {
+  std::vector<std::string> input_layers = net_->getInputNames();
+  const TensorInfo &tinfo = net_->getTensorInfo(input_layers[0]);
+  float *input_ptr = (float *)tinfo.sys_mem;
+  int num = streams.size();
+  for (int b = 0; b < batch_size_; b++) {
+    float *batch_ptr = input_ptr + size_t(b) * segment_size_ * num_mel_;
+    if (b >= num) {
+      memset(batch_ptr, 0, segment_size_ * num_mel_ * sizeof(float));
+      continue;
+    }
+    for (int j = 0; j < segment_size_; j++) {
+      const float *frame = streams[b]->fbank_extractor->GetFrame(
+          streams[b]->num_processed_frames + j);
+      memcpy(batch_ptr + j * num_mel_, frame, num_mel_ * sizeof(float));
+    }
+  }
+  gatherCaches(streams);
 
-  if (!init_decoder_output_) {
-    int32_t *decoder_input_buffer =
-        (int32_t *)decoder_input_data_->getVirtualAddress()[0];
+  net_->updateInputTensors();
+  net_->forward();
+  net_->updateOutputTensors();
 
-    memset(decoder_input_buffer, 0,
-           decoder_input_data_->getWidth() * decoder_input_data_->getHeight() *
-               sizeof(int32_t));
-    decoder_model_->inference(decoder_input_data_, out_data);
-    init_decoder_output_ = true;
+  int32_t ret = scatterCaches(streams);
+  if (ret != 0) {
+    return ret;
   }
 
-  for (int i = 0; i < feature_num_; i++) {
-    float *joiner_input_buffer =
-        (float *)joiner_input_data_->getVirtualAddress()[0];
-    memcpy(joiner_input_buffer, data_ptr + i * ZIPFORMER_FEATURE_SIZE,
-           ZIPFORMER_FEATURE_SIZE * sizeof(float));
-    memcpy(joiner_input_buffer + ZIPFORMER_FEATURE_SIZE,
-           asr_meta->decoder_feature, ZIPFORMER_FEATURE_SIZE * sizeof(float));
+  std::vector<std::string> output_layers = net_->getOutputNames();
+  const TensorInfo &out_tinfo = net_->getTensorInfo(output_layers[0]);
+  feature_num_ = out_tinfo.shape[1];
+  std::shared_ptr<BaseTensor> output_tensor =
+      net_->getOutputTensor(output_layers[0]);
+  std::vector<ZipformerSearchStream *> search_streams;
+  for (int b = 0; b < num; b++) {
+    streams[b]->search.encoder_out = output_tensor->getBatchPtr<float>(b);
+    streams[b]->search.num_frames = feature_num_;
+    streams[b]->num_processed_frames += frame_offset_;
+    streams[b]->num_used_chunks++;
+    search_streams.push_back(&streams[b]->search);
+  }
+  // the joiner runs over all frames of the chunk of every stream
+  return search_->search(search_streams);
+}
 
-    joiner_model_->inference(joiner_input_data_, out_data);
+int32_t ZipformerEncoder::decodeStreams(
+    const std::vector<int32_t> &stream_ids) {
+  if (search_ == nullptr) {
+    LOGE("ZipformerEncoder decoder and joiner not set\n");
+    return -1;
+  }
+  std::vector<ZipformerStream *> streams;
+  for (int32_t stream_id : stream_ids) {
+    ZipformerStream *stream = getStream(stream_id);
+    if (stream == nullptr) {
+      return -1;
+    }
+    if (!stream->search_ready) {
+      int32_t ret = search_->initStream(stream->search);
+      if (ret != 0) {
+        return ret;
+      }
+      stream->search_ready = true;
+    }
+    streams.push_back(stream);
+  }
 
-    if (asr_meta->pred_index != 0) {
-      int32_t *decoder_input_buffer =
-          (int32_t *)decoder_input_data_->getVirtualAddress()[0];
+  std::vector<ZipformerStream *> ready;
+  std::vector<ZipformerStream *> group;
+  while (true) {
+    ready.clear();
+    for (ZipformerStream *stream : streams) {
+      if (stream->fbank_extractor->NumFramesReady() -
+              stream->num_processed_frames >=
+          segment_size_) {
+        ready.push_back(stream);
+      }
+    }
+    if (ready.empty()) {
+      break;
+    }
+    for (size_t start = 0; start < ready.size(); start += batch_size_) {
+      size_t end = std::min(ready.size(), start + batch_size_);
+      group.assign(ready.begin() + start, ready.begin() + end);
+      int32_t ret = forwardChunk(group);
+      if (ret != 0) {
+        return ret;
+      }
+    }
+  }
 
-      decoder_input_buffer[0] = hyp_.back();
-      decoder_input_buffer[1] = asr_meta->pred_index;
-      hyp_.push_back(asr_meta->pred_index);
+  for (ZipformerStream *stream : streams) {
+    // release used frames
+    stream->fbank_extractor->Pop(stream->num_used_chunks * frame_offset_);
+    stream->num_used_chunks = 0;
+  }
+  return 0;
+}
 
-      decoder_model_->inference(decoder_input_data_, out_data);
-    }
+int32_t ZipformerEncoder::getStreamText(int32_t stream_id, std::string &text) {
+  ZipformerStream *stream = getStream(stream_id);
+  if (stream == nullptr) {
+    return -1;
+  }
+  text.clear();
+  std::vector<int32_t> &hyp = stream->search.hyp;
+  for (int i = 1; i < hyp.size(); i++) {
+    std::string tmp = tokens_[hyp[i]];
+    replace_substr(tmp, "▁", " ");
+    text += tmp;
+  }
+  hyp = {hyp.back()};
+
+  if (stream->input_finished) {  // for evaluating next sound file
+    resetStream(*stream);
   }
   return 0;
 }
@@ -231,38 +484,17 @@ int32_t ZipformerEncoder::inference(
 
   int img_width = image->getWidth() / 2;  // unit: 16 bits
   int img_height = image->getHeight();
-  short *temp_buffer = (short *)image->getVirtualAddress()[0];
+  const int16_t *pcm = (const int16_t *)image->getVirtualAddress()[0];
 
   LOGI("input data size: %d", img_width * img_height);
 
-  std::vector<float> float_buffer(img_width * img_height);
-  for (int i = 0; i < float_buffer.size(); i++) {
-    float_buffer[i] = (float)(temp_buffer[i]) / 32768.0;
+  int32_t ret = acceptWaveform(kDefaultStreamId, pcm, img_width * img_height,
+                               asr_meta->input_finished);
+  if (ret == 0) {
+    ret = decodeStreams({kDefaultStreamId});
   }
-
-  fbank_extractor_->AcceptWaveform(ZIPFORMER_SAMPLE_RATE, float_buffer.data(),
-                                   float_buffer.size());
-
-  int32_t num_frames = fbank_extractor_->NumFramesReady();
-
-  int used_count = 0;
-
-  while (num_frames - num_processed_frames_ >= segment_size_) {
-    prepareInput();
-
-    net_->updateInputTensors();
-    net_->forward();
-    net_->updateOutputTensors();
-    outputParse(image, out_data);
-
-    std::vector<std::string> output_layers = net_->getOutputNames();
-    std::shared_ptr<BaseTensor> output_tensor =
-        net_->getOutputTensor(output_layers[0]);
-    float *output_ptr = output_tensor->getBatchPtr<float>(0);
-
-    greedy_search(output_ptr, out_data);
-
-    used_count++;
+  if (ret != 0) {
+    return ret;
   }
 
   if (asr_meta->text_info) {
@@ -272,11 +504,7 @@ int32_t ZipformerEncoder::inference(
   }
 
   std::string text;
-  for (int i = 1; i < hyp_.size(); i++) {
-    std::string tmp = tokens_[hyp_[i]];
-    replace_substr(tmp, "▁", " ");
-    text += tmp;
-  }
+  getStreamText(kDefaultStreamId, text);
 
   if (!text.empty()) {
     // 多申请 1 字节给 '\0'
@@ -285,77 +513,12 @@ int32_t ZipformerEncoder::inference(
     asr_meta->text_length = text.size();  // 不含 '\0' 的长度
   }
 
-  hyp_ = {hyp_.back()};
-
-  fbank_extractor_->Pop(used_count * frame_offset_);  // release used frames
-
-  if (asr_meta->input_finished) {  // for evaluating next sound file
-
-    hyp_ = {0};
-    init_decoder_output_ = false;
-
-    memset(int32_chached_inputs_, 0,
-           int32_cached_offset_.back() * sizeof(int32_t));
-    memset(float_chached_inputs_, 0,
-           float_cached_offset_.back() * sizeof(float));
-
-    fbank_extractor_->Pop(num_frames -
-                          num_processed_frames_);  // release remaining frames
-    num_processed_frames_ = num_frames;
-  }
-
   return 0;
 }
 
 int32_t ZipformerEncoder::outputParse(
     const std::shared_ptr<BaseImage> &image,
     std::shared_ptr<ModelOutputInfo> &out_data) {
-  std::vector<std::string> output_layers = net_->getOutputNames();
-
-  for (int i = 0; i < output_layers.size(); i++) {
-    const TensorInfo &tinfo = net_->getTensorInfo(output_layers[i]);
-    int data_size =
-        tinfo.shape[0] * tinfo.shape[1] * tinfo.shape[2] * tinfo.shape[3];
-
-    std::shared_ptr<BaseTensor> output_tensor =
-        net_->getOutputTensor(output_layers[i]);
-    float *output_ptr = output_tensor->getBatchPtr<float>(0);
-
-    if (i == 0) {
-      feature_num_ = tinfo.shape[1];
-      LOGI("feature_num_: %d\n", feature_num_);
-    } else if (i <= 5) {  // update int32_t cached input
-
-      if (data_size != int32_cached_offset_[i] - int32_cached_offset_[i - 1]) {
-        LOGE(
-            "ZipformerEncoder output size %d not equal to int32_cached_offset_ "
-            "size %d\n",
-            data_size, int32_cached_offset_[i] - int32_cached_offset_[i - 1]);
-        return -1;
-      }
-
-      for (int j = 0; j < data_size; j++) {
-        int32_chached_inputs_[(i - 1) * data_size + j] =
-            (int32_t)(output_ptr[j]);  // output data type != input data type
-                                       // cause of tpu-milr bug
-      }
-    } else {  // update float cached input
-
-      if (data_size !=
-          float_cached_offset_[i - 5] - float_cached_offset_[i - 6]) {
-        LOGE(
-            "ZipformerEncoder output size %d not equal to float_cached_offset_ "
-            "size %d\n",
-            data_size,
-            float_cached_offset_[i - 5] - float_cached_offset_[i - 6]);
-        return -1;
-      }
-
-      memcpy(float_chached_inputs_ + float_cached_offset_[i - 6], output_ptr,
-             (float_cached_offset_[i - 5] - float_cached_offset_[i - 6]) *
-                 sizeof(float));
-    }
-  }
-
+  // outputs are consumed per chunk in forwardChunk
   return 0;
 }
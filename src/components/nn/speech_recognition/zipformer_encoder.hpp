@@ -1,8 +1,26 @@
 #ifndef ZIPFORMER_ENCODER_HPP
 #define ZIPFORMER_ENCODER_HPP
+#include <map>
+#include <memory>
 #include "feature-fbank.h"
 #include "model/base_model.hpp"
 #include "online-feature.h"
+#include "speech_recognition/zipformer_search.hpp"
+
+class ZipformerDecoder;
+class ZipformerJoiner;
+
+// state of one audio stream: features, encoder caches and search state
+struct ZipformerStream {
+  std::unique_ptr<knf::OnlineFbank> fbank_extractor;
+  std::vector<int32_t> int32_cached_inputs;
+  std::vector<float> float_cached_inputs;
+  int32_t num_processed_frames = 0;
+  int32_t num_used_chunks = 0;  // chunks not yet popped from fbank
+  bool input_finished = false;
+  bool search_ready = false;
+  ZipformerSearchStream search;
+};
 
 class ZipformerEncoder : public BaseModel {
  public:
@@ -22,30 +40,50 @@ class ZipformerEncoder : public BaseModel {
 
   int32_t setTokensPath(std::string tokens_path);
 
+  // 多路流接口: 每路流独立保存 fbank 特征与 encoder cache,
+  // decodeStreams 把多路流的 chunk 合并为一次 batch forward
+  // (batch 大小由 encoder 模型输入决定), joiner/decoder 同样批量执行
+  int32_t createStream();
+  int32_t destroyStream(int32_t stream_id);
+  int32_t acceptWaveform(int32_t stream_id, const int16_t* pcm,
+                         size_t num_samples, bool input_finished = false);
+  // run every ready chunk of the streams
+  int32_t decodeStreams(const std::vector<int32_t>& stream_ids);
+  // text decoded since the last call, a finished stream is reset afterwards
+  int32_t getStreamText(int32_t stream_id, std::string& text);
+
  private:
-  int32_t prepareInput();
-  int32_t greedy_search(float* data_ptr,
-                        std::shared_ptr<ModelOutputInfo>& out_data);
+  int32_t initSearch();
+  ZipformerStream* getStream(int32_t stream_id);
+  void resetStream(ZipformerStream& stream);
+  // encoder forward of the next chunk of up to batch_size_ streams
+  int32_t forwardChunk(const std::vector<ZipformerStream*>& streams);
+  // copy stream caches into the batched input tensors and back
+  void gatherCaches(const std::vector<ZipformerStream*>& streams);
+  int32_t scatterCaches(const std::vector<ZipformerStream*>& streams);
 
-  knf::OnlineFbank* fbank_extractor_ = nullptr;
-  float* float_chached_inputs_ = nullptr;
-  int32_t* int32_chached_inputs_ = nullptr;
+  knf::FbankOptions fbank_opts_;
+  // offsets of every cache input inside the per-stream cache buffers
   std::vector<int> float_cached_offset_;
   std::vector<int> int32_cached_offset_;
-  bool init_decoder_output_ = false;
-  int32_t num_processed_frames_ = 0;
+  // batch axis of every cache input (index = input index)
+  std::vector<int> cache_batch_axis_;
+  int batch_size_ = 1;
   int frame_offset_;
   int segment_size_;
   int num_mel_;
   int feature_num_;
-  std::vector<int32_t> hyp_ = {0};
   std::vector<std::string> tokens_;
 
-  std::shared_ptr<BaseModel> decoder_model_;
-  std::shared_ptr<BaseModel> joiner_model_;
+  std::map<int32_t, std::unique_ptr<ZipformerStream>> streams_;
+  int32_t next_stream_id_ = 1;
+  // stream used by inference()
+  static constexpr int32_t kDefaultStreamId = 0;
+  std::vector<float> pcm_buffer_;
 
-  std::shared_ptr<BaseImage> decoder_input_data_;
-  std::shared_ptr<BaseImage> joiner_input_data_;
+  std::shared_ptr<ZipformerDecoder> decoder_model_;
+  std::shared_ptr<ZipformerJoiner> joiner_model_;
+  std::unique_ptr<ZipformerGreedySearch> search_;
 };
 
 #endif
@@ -1,4 +1,5 @@
 #include "speech_recognition/zipformer_joiner.hpp"
+#include <algorithm>
 #include <numeric>
 #include "utils/tdl_log.hpp"
 
@@ -17,7 +18,12 @@ int32_t ZipformerJoiner::setupNetwork(NetParam &net_param) {
   return 0;
 }
 
-int32_t ZipformerJoiner::onModelOpened() { return 0; }
+int32_t ZipformerJoiner::onModelOpened() {
+  std::vector<std::string> input_layers = net_->getInputNames();
+  const TensorInfo &tinfo = net_->getTensorInfo(input_layers[0]);
+  batch_size_ = tinfo.shape[0];
+  return 0;
+}
 
 int32_t ZipformerJoiner::inference(
     const std::shared_ptr<BaseImage> &image,
@@ -79,3 +85,44 @@ int32_t ZipformerJoiner::outputParse(
 
   return 0;
 }
+
+int32_t ZipformerJoiner::inferenceBatch(const float *encoder_out,
+                                        const float *decoder_out, int num,
+                                        int32_t *tokens) {
+  if (num <= 0 || num > batch_size_) {
+    LOGE("ZipformerJoiner batch num %d out of range [1, %d]\n", num,
+         batch_size_);
+    return -1;
+  }
+  std::vector<std::string> input_layers = net_->getInputNames();
+  const float *inputs[2] = {encoder_out, decoder_out};
+  for (int i = 0; i < input_layers.size() && i < 2; i++) {
+    const TensorInfo &tinfo = net_->getTensorInfo(input_layers[i]);
+    int row_size =
+        tinfo.shape[0] * tinfo.shape[1] * tinfo.shape[2] * tinfo.shape[3] /
+        batch_size_;
+    float *input_ptr = (float *)tinfo.sys_mem;
+    memcpy(input_ptr, inputs[i], num * row_size * sizeof(float));
+    // padding rows, their results are dropped
+    memset(input_ptr + num * row_size, 0,
+           (batch_size_ - num) * row_size * sizeof(float));
+  }
+
+  net_->updateInputTensors();
+  net_->forward();
+  net_->updateOutputTensors();
+
+  std::vector<std::string> output_layers = net_->getOutputNames();
+  const TensorInfo &tinfo = net_->getTensorInfo(output_layers[0]);
+  int vocab_size =
+      tinfo.shape[0] * tinfo.shape[1] * tinfo.shape[2] * tinfo.shape[3] /
+      batch_size_;
+  std::shared_ptr<BaseTensor> output_tensor =
+      net_->getOutputTensor(output_layers[0]);
+  for (int b = 0; b < num; b++) {
+    const float *logits = output_tensor->getBatchPtr<float>(b);
+    tokens[b] = static_cast<int32_t>(
+        std::max_element(logits, logits + vocab_size) - logits);
+  }
+  return 0;
+}
@@ -16,8 +16,15 @@ class ZipformerJoiner : public BaseModel {
       std::shared_ptr<ModelOutputInfo>& out_data) override;
   virtual int32_t onModelOpened() override;
 
+  // num (<= getBatchSize()) rows of encoder and decoder features, writes the
+  // argmax token of every row
+  int32_t inferenceBatch(const float* encoder_out, const float* decoder_out,
+                         int num, int32_t* tokens);
+  int getBatchSize() const { return batch_size_; }
+
  private:
   int feature_size_ = 0;
+  int batch_size_ = 1;
 };
 
 #endif
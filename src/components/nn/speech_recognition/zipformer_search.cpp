@@ -0,0 +1,211 @@
+#include "speech_recognition/zipformer_search.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include "utils/tdl_log.hpp"
+
+const std::vector<float> *ZipformerDecoderCache::find(int32_t ctx0,
+                                                      int32_t ctx1) {
+  auto it = index_.find(makeKey(ctx0, ctx1));
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return &it->second->feature;
+}
+
+void ZipformerDecoderCache::insert(int32_t ctx0, int32_t ctx1,
+                                   const float *feature, int size) {
+  if (capacity_ == 0) {
+    return;
+  }
+  uint64_t key = makeKey(ctx0, ctx1);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    entries_.splice(entries_.begin(), entries_, it->second);
+    it->second->feature.assign(feature, feature + size);
+    return;
+  }
+  if (entries_.size() >= capacity_) {
+    // reuse the least recently used node
+    index_.erase(entries_.back().key);
+    entries_.splice(entries_.begin(), entries_, std::prev(entries_.end()));
+  } else {
+    entries_.emplace_front();
+  }
+  entries_.front().key = key;
+  entries_.front().feature.assign(feature, feature + size);
+  index_[key] = entries_.begin();
+}
+
+void ZipformerDecoderCache::clear() {
+  entries_.clear();
+  index_.clear();
+}
+
+ZipformerGreedySearch::ZipformerGreedySearch(int feature_size,
+                                             int joiner_batch,
+                                             int decoder_batch,
+                                             JoinerFunc joiner,
+                                             DecoderFunc decoder)
+    : feature_size_(feature_size),
+      joiner_batch_(std::max(joiner_batch, 1)),
+      decoder_batch_(std::max(decoder_batch, 1)),
+      joiner_(joiner),
+      decoder_(decoder) {}
+
+int32_t ZipformerGreedySearch::initStream(ZipformerSearchStream &stream) {
+  stream.hyp = {0};
+  stream.context[0] = 0;
+  stream.context[1] = 0;
+  return updateDecoderOut({&stream});
+}
+
+int32_t ZipformerGreedySearch::search(
+    const std::vector<ZipformerSearchStream *> &streams) {
+  struct Row {
+    int stream;
+    int frame;
+  };
+  std::vector<int> cursors(streams.size(), 0);
+  std::vector<int> active;
+  std::vector<Row> rows;
+  std::vector<ZipformerSearchStream *> emitted;
+
+  while (true) {
+    active.clear();
+    for (size_t i = 0; i < streams.size(); i++) {
+      if (cursors[i] < streams[i]->num_frames) {
+        active.push_back(i);
+      }
+    }
+    if (active.empty()) {
+      break;
+    }
+
+    // frames evaluated per stream in this round, the frames after an
+    // emitted token are wasted, so only speculate while the batch has room
+    int span = std::max(1, joiner_batch_ / int(active.size()));
+    rows.clear();
+    for (int i : active) {
+      int end = std::min(cursors[i] + span, streams[i]->num_frames);
+      for (int f = cursors[i]; f < end; f++) {
+        rows.push_back({i, f});
+      }
+    }
+
+    joiner_tokens_.resize(rows.size());
+    joiner_encoder_in_.resize(size_t(joiner_batch_) * feature_size_);
+    joiner_decoder_in_.resize(size_t(joiner_batch_) * feature_size_);
+    for (size_t start = 0; start < rows.size(); start += joiner_batch_) {
+      int num = std::min<int>(joiner_batch_, rows.size() - start);
+      for (int j = 0; j < num; j++) {
+        const Row &row = rows[start + j];
+        const ZipformerSearchStream *stream = streams[row.stream];
+        memcpy(joiner_encoder_in_.data() + size_t(j) * feature_size_,
+               stream->encoder_out + size_t(row.frame) * feature_size_,
+               feature_size_ * sizeof(float));
+        memcpy(joiner_decoder_in_.data() + size_t(j) * feature_size_,
+               stream->decoder_out.data(), feature_size_ * sizeof(float));
+      }
+      int32_t ret = joiner_(joiner_encoder_in_.data(),
+                            joiner_decoder_in_.data(), num,
+                            joiner_tokens_.data() + start);
+      joiner_calls_++;
+      if (ret != 0) {
+        LOGE("ZipformerGreedySearch joiner failed, ret: %d", ret);
+        return ret;
+      }
+    }
+
+    // rows are grouped by stream in frame order
+    emitted.clear();
+    size_t r = 0;
+    for (int i : active) {
+      ZipformerSearchStream *stream = streams[i];
+      bool emit = false;
+      for (; r < rows.size() && rows[r].stream == i; r++) {
+        if (emit) {
+          continue;  // evaluated with a stale decoder output
+        }
+        cursors[i] = rows[r].frame + 1;
+        int32_t token = joiner_tokens_[r];
+        if (token != 0) {
+          stream->context[0] = stream->hyp.back();
+          stream->context[1] = token;
+          stream->hyp.push_back(token);
+          emit = true;
+        }
+      }
+      if (emit) {
+        emitted.push_back(stream);
+      }
+    }
+
+    int32_t ret = updateDecoderOut(emitted);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  return 0;
+}
+
+int32_t ZipformerGreedySearch::updateDecoderOut(
+    const std::vector<ZipformerSearchStream *> &streams) {
+  std::vector<ZipformerSearchStream *> pending;
+  std::vector<int> pending_index;
+  decoder_contexts_.clear();
+  for (ZipformerSearchStream *stream : streams) {
+    const std::vector<float> *cached =
+        decoder_cache_.find(stream->context[0], stream->context[1]);
+    if (cached != nullptr) {
+      stream->decoder_out = *cached;
+      decoder_cache_hits_++;
+      continue;
+    }
+    // streams with the same context share one decoder row
+    int index = -1;
+    for (size_t k = 0; k < decoder_contexts_.size() / 2; k++) {
+      if (decoder_contexts_[k * 2] == stream->context[0] &&
+          decoder_contexts_[k * 2 + 1] == stream->context[1]) {
+        index = k;
+        break;
+      }
+    }
+    if (index < 0) {
+      index = decoder_contexts_.size() / 2;
+      decoder_contexts_.push_back(stream->context[0]);
+      decoder_contexts_.push_back(stream->context[1]);
+    }
+    pending.push_back(stream);
+    pending_index.push_back(index);
+  }
+  if (pending.empty()) {
+    return 0;
+  }
+
+  int num_contexts = decoder_contexts_.size() / 2;
+  decoder_out_.resize(size_t(num_contexts) * feature_size_);
+  for (int start = 0; start < num_contexts; start += decoder_batch_) {
+    int num = std::min(decoder_batch_, num_contexts - start);
+    int32_t ret =
+        decoder_(decoder_contexts_.data() + start * 2, num,
+                 decoder_out_.data() + size_t(start) * feature_size_);
+    decoder_calls_++;
+    if (ret != 0) {
+      LOGE("ZipformerGreedySearch decoder failed, ret: %d", ret);
+      return ret;
+    }
+  }
+  for (int k = 0; k < num_contexts; k++) {
+    decoder_cache_.insert(
+        decoder_contexts_[k * 2], decoder_contexts_[k * 2 + 1],
+        decoder_out_.data() + size_t(k) * feature_size_, feature_size_);
+  }
+  for (size_t i = 0; i < pending.size(); i++) {
+    const float *feature =
+        decoder_out_.data() + size_t(pending_index[i]) * feature_size_;
+    pending[i]->decoder_out.assign(feature, feature + feature_size_);
+  }
+  return 0;
+}
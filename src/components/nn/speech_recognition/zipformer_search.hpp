@@ -0,0 +1,102 @@
+#ifndef ZIPFORMER_SEARCH_HPP
+#define ZIPFORMER_SEARCH_HPP
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// decoder 输出缓存, 以 decoder 的两个上下文 token 为 key, LRU 淘汰
+class ZipformerDecoderCache {
+ public:
+  explicit ZipformerDecoderCache(size_t capacity = 1024)
+      : capacity_(capacity) {}
+
+  // nullptr if the context is not cached
+  const std::vector<float>* find(int32_t ctx0, int32_t ctx1);
+  void insert(int32_t ctx0, int32_t ctx1, const float* feature, int size);
+  void clear();
+  size_t size() const { return entries_.size(); }
+
+ private:
+  static uint64_t makeKey(int32_t ctx0, int32_t ctx1) {
+    return (uint64_t(uint32_t(ctx0)) << 32) | uint32_t(ctx1);
+  }
+
+  struct Entry {
+    uint64_t key;
+    std::vector<float> feature;
+  };
+  size_t capacity_;
+  std::list<Entry> entries_;  // most recently used first
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+};
+
+// greedy search state of one audio stream
+struct ZipformerSearchStream {
+  // encoder output of the current chunk, [num_frames, feature_size]
+  const float* encoder_out = nullptr;
+  int num_frames = 0;
+
+  std::vector<int32_t> hyp = {0};
+  // decoder context (the last two tokens) and its output
+  int32_t context[2] = {0, 0};
+  std::vector<float> decoder_out;
+};
+
+// transducer greedy search (at most one symbol per frame) over many streams.
+//
+// Instead of one joiner call per frame, every round evaluates a span of
+// pending frames of all streams with their current decoder output in batched
+// joiner calls. Frames up to the first non-blank one are final; the stream
+// then updates its decoder output (batched, cached per context) and the next
+// round resumes right after the emitting frame. The result is identical to
+// the frame by frame search.
+class ZipformerGreedySearch {
+ public:
+  // num rows of (encoder, decoder) features -> argmax token of each row
+  typedef std::function<int32_t(const float* encoder_out,
+                                const float* decoder_out, int num,
+                                int32_t* tokens)>
+      JoinerFunc;
+  // num contexts of two tokens -> num decoder features
+  typedef std::function<int32_t(const int32_t* contexts, int num,
+                                float* decoder_out)>
+      DecoderFunc;
+
+  ZipformerGreedySearch(int feature_size, int joiner_batch, int decoder_batch,
+                        JoinerFunc joiner, DecoderFunc decoder);
+
+  // decoder output for the initial (blank) context of a stream
+  int32_t initStream(ZipformerSearchStream& stream);
+  int32_t search(const std::vector<ZipformerSearchStream*>& streams);
+
+  uint64_t getJoinerCalls() const { return joiner_calls_; }
+  uint64_t getDecoderCalls() const { return decoder_calls_; }
+  uint64_t getDecoderCacheHits() const { return decoder_cache_hits_; }
+
+ private:
+  // update decoder_out of streams from their context, misses batched
+  int32_t updateDecoderOut(const std::vector<ZipformerSearchStream*>& streams);
+
+  int feature_size_;
+  int joiner_batch_;
+  int decoder_batch_;
+  JoinerFunc joiner_;
+  DecoderFunc decoder_;
+  ZipformerDecoderCache decoder_cache_;
+
+  // scratch buffers kept across calls
+  std::vector<float> joiner_encoder_in_;
+  std::vector<float> joiner_decoder_in_;
+  std::vector<int32_t> joiner_tokens_;
+  std::vector<int32_t> decoder_contexts_;
+  std::vector<float> decoder_out_;
+
+  uint64_t joiner_calls_ = 0;
+  uint64_t decoder_calls_ = 0;
+  uint64_t decoder_cache_hits_ = 0;
+};
+
+#endif
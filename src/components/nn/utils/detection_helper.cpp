@@ -4,6 +4,13 @@
 #include <cmath>
 #include <cstdint>
 #include <memory>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 std::vector<std::vector<float>> DetectionHelper::generateMmdetBaseAnchors(
     float base_size, float center_offset, const std::vector<float> &ratios,
@@ -151,6 +158,66 @@ void DetectionHelper::nmsObjects(std::vector<ObjectBoxLandmarkInfo> &objects,
   objects = objects_nms;
 }
 
+void DetectionHelper::filterScores(const float *scores, uint32_t num,
+                                   float threshold,
+                                   std::vector<uint32_t> &indices) {
+  uint32_t i = 0;
+  // 大部分得分低于阈值, 每次比较 4 个, 有命中时再逐个检查
+#if defined(__SSE2__)
+  const __m128 thr = _mm_set1_ps(threshold);
+  for (; i + 4 <= num; i += 4) {
+    int mask = _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(scores + i), thr));
+    while (mask != 0) {
+      indices.push_back(i + __builtin_ctz(mask));
+      mask &= mask - 1;
+    }
+  }
+#elif defined(__ARM_NEON)
+  const float32x4_t thr = vdupq_n_f32(threshold);
+  for (; i + 4 <= num; i += 4) {
+    uint32x4_t hit = vcgtq_f32(vld1q_f32(scores + i), thr);
+    uint32x2_t any = vorr_u32(vget_low_u32(hit), vget_high_u32(hit));
+    if (vget_lane_u32(vpmax_u32(any, any), 0) == 0) continue;
+    for (uint32_t k = i; k < i + 4; k++) {
+      if (scores[k] > threshold) indices.push_back(k);
+    }
+  }
+#endif
+  for (; i < num; i++) {
+    if (scores[i] > threshold) indices.push_back(i);
+  }
+}
+
+void DetectionHelper::nmsIndices(const std::vector<ObjectBoxInfo> &boxes,
+                                 float iou_threshold,
+                                 std::vector<uint32_t> &keep) {
+  keep.resize(boxes.size());
+  std::iota(keep.begin(), keep.end(), 0);
+  std::stable_sort(keep.begin(), keep.end(), [&](uint32_t a, uint32_t b) {
+    return boxes[a].score > boxes[b].score;
+  });
+
+  // 依次检查每个框是否被之前保留的框抑制, 保留的序号原地压缩到前部
+  size_t num_keep = 0;
+  for (size_t r = 0; r < keep.size(); r++) {
+    const ObjectBoxInfo &box = boxes[keep[r]];
+    float area = (box.x2 - box.x1 + 1) * (box.y2 - box.y1 + 1);
+    bool suppressed = false;
+    for (size_t k = 0; k < num_keep && !suppressed; k++) {
+      const ObjectBoxInfo &kept = boxes[keep[k]];
+      float w = std::min(kept.x2, box.x2) - std::max(kept.x1, box.x1) + 1;
+      float h = std::min(kept.y2, box.y2) - std::max(kept.y1, box.y1) + 1;
+      if (w <= 0 || h <= 0) continue;
+      float kept_area = (kept.x2 - kept.x1 + 1) * (kept.y2 - kept.y1 + 1);
+      float area_intersect = w * h;
+      suppressed =
+          area_intersect / (kept_area + area - area_intersect) > iou_threshold;
+    }
+    if (!suppressed) keep[num_keep++] = keep[r];
+  }
+  keep.resize(num_keep);
+}
+
 void DetectionHelper::nmsObjects(std::vector<ObjectBoxInfo> &objects,
                                  float iou_threshold) {
   std::sort(
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <map>
 #include <vector>
 
@@ -33,6 +34,13 @@ class DetectionHelper {
   static void nmsObjects(std::vector<ObjectBoxLandmarkInfo> &objects,
                          float iou_threshold,
                          std::vector<std::pair<int, uint32_t>> &stride_index);
+  // 把 scores 中大于 threshold 的序号追加到 indices
+  static void filterScores(const float *scores, uint32_t num, float threshold,
+                           std::vector<uint32_t> &indices);
+  // 与 nmsObjects 相同的规则, 只对序号排序和筛选, boxes 不移动;
+  // keep 输出保留的序号, 按得分从高到低
+  static void nmsIndices(const std::vector<ObjectBoxInfo> &boxes,
+                         float iou_threshold, std::vector<uint32_t> &keep);
   static void rescaleBbox(ObjectBoxInfo &bbox,
                           const std::vector<float> &scale_params);
   static void rescaleBbox(ObjectBoxSegmentationInfo &bbox,
@@ -28,6 +28,19 @@ ObjectSnapshot::ObjectSnapshot(int vechn, int encoder_mode) {
   config_.jpg_quality = 60;
   config_.use_reid = false;
   config_.reid_threshold = 0.6f;
+  config_.encode_object_image = false;
+  config_.encode_workers = 1;
+  createSnapshotEncoder();
+}
+
+void ObjectSnapshot::createSnapshotEncoder() {
+  if (image_encoder_ == nullptr) {
+    return;
+  }
+  // 先释放旧的编码线程,未完成的任务会被标记为取消
+  snapshot_encoder_ = nullptr;
+  snapshot_encoder_ = std::make_shared<SnapshotEncoder>(
+      image_encoder_, config_.encode_workers);
 }
 
 int32_t ObjectSnapshot::updateConfig(const nlohmann::json& config) {
@@ -73,6 +86,14 @@ int32_t ObjectSnapshot::updateConfig(const nlohmann::json& config) {
   if (config.contains("reid_threshold")) {
     config_.reid_threshold = config.at("reid_threshold");
   }
+  if (config.contains("encode_object_image")) {
+    config_.encode_object_image = config.at("encode_object_image");
+  }
+  if (config.contains("encode_workers") &&
+      config.at("encode_workers") != config_.encode_workers) {
+    config_.encode_workers = config.at("encode_workers");
+    createSnapshotEncoder();
+  }
   if (config_.use_reid) {
     reid_model_ =
         TDLModelFactory::getInstance().getModel(ModelType::FEATURE_REID);
@@ -92,6 +113,10 @@ int32_t ObjectSnapshot::updateSnapshot(
     const std::map<std::string, Packet>& other_info,
     const std::map<uint64_t, std::shared_ptr<BaseImage>>& crop_face_imgs) {
   std::map<uint64_t, int> track_valid_flag;
+  // 同一帧只提交一次全景图编码,所有在本帧更新的抓拍共享同一个编码任务
+  std::shared_ptr<EncodeJob> frame_job;
+  std::vector<std::shared_ptr<BaseImage>> crop_images;
+  std::vector<uint64_t> crop_track_ids;
   LOGI("ObjectSnapshot updateSnapshot, frame_id: %" PRIu64
        ", tracks.size(): %zu",
        frame_id, tracks.size());
@@ -168,11 +193,15 @@ int32_t ObjectSnapshot::updateSnapshot(
              track.track_id_, frame_id);
       }
 
-      if (image_encoder_ != nullptr &&
+      if (snapshot_encoder_ != nullptr &&
           image_encoder_->getEncoderMode() == 1) {  // 更新全景图
-        snapshot_info.encoded_full_image.clear();
-        image_encoder_->encodeFrame(image, snapshot_info.encoded_full_image,
-                                    config_.jpg_quality);
+        if (frame_job == nullptr) {
+          frame_job = snapshot_encoder_->submitFrame(image, frame_id,
+                                                     config_.jpg_quality);
+        }
+        // the previous job is released here and cancelled if not started
+        snapshot_info.full_image_job = frame_job;
+        snapshot_info.encoded_full_image = nullptr;
       }
 
       if (crop_face_imgs.count(track.track_id_)) {
@@ -288,6 +317,11 @@ int32_t ObjectSnapshot::updateSnapshot(
         }
       }
 
+      if (snapshot_encoder_ != nullptr && config_.encode_object_image) {
+        crop_images.push_back(snapshot_info.object_image);
+        crop_track_ids.push_back(track.track_id_);
+      }
+
       // ReID assisted confirmation
       if (config_.use_reid && box.object_type == OBJECT_TYPE_PERSON &&
           reid_model_ != nullptr) {
@@ -383,6 +417,17 @@ int32_t ObjectSnapshot::updateSnapshot(
       }
     }
   }
+  if (!crop_images.empty()) {
+    // 本帧所有抓拍小图合并为一个编码任务
+    std::shared_ptr<EncodeJob> crop_job = snapshot_encoder_->submitBatch(
+        crop_images, frame_id, config_.jpg_quality);
+    for (size_t i = 0; i < crop_track_ids.size(); i++) {
+      ObjectSnapshotInfo& snapshot_info = snapshot_infos_[crop_track_ids[i]];
+      snapshot_info.object_image_job = crop_job;
+      snapshot_info.object_image_job_index = i;
+      snapshot_info.encoded_object_image = nullptr;
+    }
+  }
   LOGI(
       "ObjectSnapshot to update export_snapshots_, snapshot_infos_.size(): %zu",
       snapshot_infos_.size());
@@ -476,10 +521,43 @@ int32_t ObjectSnapshot::getSnapshotData(
       }
     }
   }
-  snapshots = export_snapshots_;
-  export_snapshots_.clear();
-  LOGI("ObjectSnapshot getSnapshotData, snapshots.size(): %zu",
-       snapshots.size());
+  snapshots.clear();
+  // snapshots still being encoded are kept for the next call unless force_all
+  std::vector<ObjectSnapshotInfo> pending_snapshots;
+  for (auto& snapshot_info : export_snapshots_) {
+    std::shared_ptr<EncodeJob> jobs[2] = {snapshot_info.full_image_job,
+                                          snapshot_info.object_image_job};
+    bool finished = true;
+    for (auto& job : jobs) {
+      if (job == nullptr || job->isFinished()) {
+        continue;
+      }
+      if (force_all) {
+        job->wait();
+      } else {
+        finished = false;
+      }
+    }
+    if (!finished) {
+      pending_snapshots.push_back(std::move(snapshot_info));
+      continue;
+    }
+    if (snapshot_info.full_image_job != nullptr) {
+      snapshot_info.encoded_full_image =
+          snapshot_info.full_image_job->getEncoded(0);
+      snapshot_info.full_image_job = nullptr;
+    }
+    if (snapshot_info.object_image_job != nullptr) {
+      snapshot_info.encoded_object_image =
+          snapshot_info.object_image_job->getEncoded(
+              snapshot_info.object_image_job_index);
+      snapshot_info.object_image_job = nullptr;
+    }
+    snapshots.push_back(std::move(snapshot_info));
+  }
+  export_snapshots_.swap(pending_snapshots);
+  LOGI("ObjectSnapshot getSnapshotData, snapshots.size(): %zu, pending: %zu",
+       snapshots.size(), export_snapshots_.size());
   return 0;
 }
 
@@ -517,6 +595,10 @@ void ObjectSnapshot::resetSnapshotInfo(ObjectSnapshotInfo& info,
   info.miss_counter = 0;
   info.export_frame_id = frame_id;
   info.object_image = nullptr;
+  info.full_image_job = nullptr;
+  info.object_image_job = nullptr;
+  info.encoded_full_image = nullptr;
+  info.encoded_object_image = nullptr;
   info.quality = 0;
   info.snapshot_frame_id = frame_id;
   // info.registered_id = -1;
@@ -0,0 +1,209 @@
+#include "components/snapshot/snapshot_encoder.hpp"
+
+#include <chrono>
+#include <cinttypes>
+
+#include "framework/utils/tdl_log.hpp"
+
+EncodeJob::EncodeJob(uint64_t frame_id,
+                     const std::vector<std::shared_ptr<BaseImage>>& images,
+                     int jpg_quality)
+    : frame_id_(frame_id),
+      jpg_quality_(jpg_quality),
+      images_(images),
+      encoded_(images.size()),
+      state_(State::PENDING) {}
+
+bool EncodeJob::isFinished() const {
+  State state = getState();
+  return state == State::DONE || state == State::FAILED ||
+         state == State::CANCELLED;
+}
+
+bool EncodeJob::wait(int timeout_ms) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (timeout_ms < 0) {
+    cond_.wait(lock, [this]() { return isFinished(); });
+    return true;
+  }
+  return cond_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                        [this]() { return isFinished(); });
+}
+
+std::shared_ptr<const std::vector<uint8_t>> EncodeJob::getEncoded(
+    size_t index) {
+  if (getState() != State::DONE || index >= encoded_.size() ||
+      encoded_[index].empty()) {
+    return nullptr;
+  }
+  // aliasing constructor, the returned pointer keeps the whole job alive
+  return std::shared_ptr<const std::vector<uint8_t>>(shared_from_this(),
+                                                     &encoded_[index]);
+}
+
+void EncodeJob::finish(State state) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    images_.clear();
+    state_.store(state, std::memory_order_release);
+  }
+  cond_.notify_all();
+}
+
+SnapshotEncoder::SnapshotEncoder(std::shared_ptr<ImageEncoder> image_encoder,
+                                 int num_workers, size_t max_pending_jobs)
+    : image_encoder_(image_encoder),
+      max_pending_jobs_(max_pending_jobs > 0 ? max_pending_jobs : 1) {
+  if (image_encoder_ == nullptr) {
+    LOGE("SnapshotEncoder image_encoder is nullptr");
+  }
+  num_workers = num_workers > 0 ? num_workers : 1;
+  for (int i = 0; i < num_workers; i++) {
+    workers_.emplace_back(&SnapshotEncoder::workerLoop, this);
+  }
+}
+
+SnapshotEncoder::~SnapshotEncoder() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  // jobs never run are finished as cancelled so that no waiter hangs
+  for (auto& weak_job : queue_) {
+    std::shared_ptr<EncodeJob> job = weak_job.lock();
+    if (job) {
+      job->finish(EncodeJob::State::CANCELLED);
+    }
+  }
+}
+
+std::shared_ptr<EncodeJob> SnapshotEncoder::submitFrame(
+    const std::shared_ptr<BaseImage>& image, uint64_t frame_id,
+    int jpg_quality) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<EncodeJob> last_job = last_frame_job_.lock();
+    if (last_job && last_job->getFrameId() == frame_id &&
+        last_job->getState() != EncodeJob::State::CANCELLED) {
+      return last_job;
+    }
+  }
+  std::shared_ptr<EncodeJob> job = enqueue(std::make_shared<EncodeJob>(
+      frame_id, std::vector<std::shared_ptr<BaseImage>>{image}, jpg_quality));
+  std::lock_guard<std::mutex> lock(mutex_);
+  last_frame_job_ = job;
+  return job;
+}
+
+std::shared_ptr<EncodeJob> SnapshotEncoder::submitBatch(
+    const std::vector<std::shared_ptr<BaseImage>>& images, uint64_t frame_id,
+    int jpg_quality) {
+  return enqueue(std::make_shared<EncodeJob>(frame_id, images, jpg_quality));
+}
+
+std::shared_ptr<EncodeJob> SnapshotEncoder::enqueue(
+    std::shared_ptr<EncodeJob> job) {
+  std::shared_ptr<EncodeJob> evicted_job;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.submitted++;
+    // drop the oldest job when full, a newer snapshot is worth more
+    while (queue_.size() >= max_pending_jobs_) {
+      evicted_job = queue_.front().lock();
+      queue_.pop_front();
+      if (evicted_job) {
+        stats_.dropped++;
+        LOGW("snapshot encode queue is full, drop the job of frame %" PRIu64,
+             evicted_job->getFrameId());
+        break;
+      }
+      stats_.cancelled++;
+    }
+    queue_.push_back(job);
+  }
+  cond_.notify_one();
+  if (evicted_job) {
+    evicted_job->finish(EncodeJob::State::CANCELLED);
+  }
+  return job;
+}
+
+void SnapshotEncoder::waitIdle() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cond_.wait(lock,
+                  [this]() { return queue_.empty() && running_jobs_ == 0; });
+}
+
+size_t SnapshotEncoder::pendingJobs() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.size() + running_jobs_;
+}
+
+SnapshotEncoderStats SnapshotEncoder::getStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void SnapshotEncoder::workerLoop() {
+  while (true) {
+    std::shared_ptr<EncodeJob> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (stop_) {
+        return;
+      }
+      job = queue_.front().lock();
+      queue_.pop_front();
+      if (job == nullptr) {
+        // every snapshot using the job has been superseded
+        stats_.cancelled++;
+        if (queue_.empty() && running_jobs_ == 0) {
+          idle_cond_.notify_all();
+        }
+        continue;
+      }
+      job->state_.store(EncodeJob::State::RUNNING, std::memory_order_release);
+      running_jobs_++;
+    }
+
+    runJob(job);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_jobs_--;
+    if (job->getState() == EncodeJob::State::DONE) {
+      stats_.encoded++;
+    } else {
+      stats_.failed++;
+    }
+    if (queue_.empty() && running_jobs_ == 0) {
+      idle_cond_.notify_all();
+    }
+  }
+}
+
+void SnapshotEncoder::runJob(const std::shared_ptr<EncodeJob>& job) {
+  if (image_encoder_ == nullptr) {
+    job->finish(EncodeJob::State::FAILED);
+    return;
+  }
+  bool all_failed = true;
+  for (size_t i = 0; i < job->images_.size(); i++) {
+    if (job->images_[i] == nullptr) {
+      continue;
+    }
+    if (image_encoder_->encodeFrame(job->images_[i], job->encoded_[i],
+                                    job->jpg_quality_)) {
+      all_failed = false;
+    } else {
+      LOGW("encode snapshot image failed, frame_id: %" PRIu64 ", index: %zu",
+           job->frame_id_, i);
+      job->encoded_[i].clear();
+    }
+  }
+  job->finish(all_failed ? EncodeJob::State::FAILED : EncodeJob::State::DONE);
+}
@@ -89,12 +89,12 @@ void SOT::clampBBox(std::vector<float>& bbox,
   }
 }
 
-std::shared_ptr<BaseImage> SOT::preprocess(
-    const std::shared_ptr<BaseImage>& image, const std::vector<float>& bbox,
-    float offset, int crop_size, std::vector<int>& context) {
+bool SOT::computeContext(const std::shared_ptr<BaseImage>& image,
+                         const std::vector<float>& bbox, float offset,
+                         std::vector<int>& context) {
   if (!image || bbox.size() < 4) {
     LOGE("预处理输入无效");
-    return nullptr;
+    return false;
   }
 
   int width = image->getWidth();
@@ -116,6 +116,15 @@ std::shared_ptr<BaseImage> SOT::preprocess(
   context[1] = std::max(0, std::min(context[1], height));
   context[2] = std::max(0, std::min(context[2], width - context[0]));
   context[3] = std::max(0, std::min(context[3], height - context[1]));
+  return true;
+}
+
+std::shared_ptr<BaseImage> SOT::preprocess(
+    const std::shared_ptr<BaseImage>& image, const std::vector<float>& bbox,
+    float offset, int crop_size, std::vector<int>& context) {
+  if (!computeContext(image, bbox, offset, context)) {
+    return nullptr;
+  }
 
   PreprocessParams params;
   memset(&params, 0, sizeof(PreprocessParams));
@@ -134,13 +143,6 @@ std::shared_ptr<BaseImage> SOT::preprocess(
   params.scale[1] = 1;
   params.scale[2] = 1;
   params.keep_aspect_ratio = false;
-  LOGI(
-      "dst_image_format: %d\n dst_pixdata_type: %d\n dst_width: %d\n "
-      "dst_height: %d\n crop_x: %d\n crop_y: %d\n crop_width: %d\n "
-      "crop_height: %d",
-      params.dst_image_format, params.dst_pixdata_type, params.dst_width,
-      params.dst_height, params.crop_x, params.crop_y, params.crop_width,
-      params.crop_height);
   std::shared_ptr<BaseImage> crop_image =
       preprocessor_->preprocess(image, params, nullptr);
   return crop_image;
@@ -166,6 +168,11 @@ int32_t SOT::setModel(std::shared_ptr<BaseModel> sot_model) {
     LOGE("sot_model is null");
     return -1;
   }
+  // 模型输入: 模板, 搜索区域
+  if (sot_model->getInputNames().size() != 2) {
+    LOGE("sot_model input num is not 2");
+    return -1;
+  }
   sot_model_ = sot_model;
   return 0;
 }
@@ -560,16 +567,30 @@ int32_t SOT::track(const std::shared_ptr<BaseImage>& image, uint64_t frame_id,
     LOGE("输入图像为空");
     return -1;
   }
-  std::vector<int> context;
-  context.resize(4);
-  std::shared_ptr<BaseImage> search_image = preprocess(
-      image, current_bbox_, search_bbox_offset_, instance_size_, context);
+  if (!template_image_) {
+    LOGE("跟踪器未初始化");
+    return -1;
+  }
+  // 搜索区域不再单独裁剪成图像, 而是作为模型搜索分支输入的裁剪区域,
+  // 由预处理一次完成裁剪/缩放/归一化并直接写入输入张量
+  if (!computeContext(image, current_bbox_, search_bbox_offset_,
+                      search_context_)) {
+    return -1;
+  }
+  const std::vector<int>& context = search_context_;
+  const std::string& search_input_name = sot_model_->getInputNames()[1];
+  if (sot_model_->setInputCrop(search_input_name, context[0], context[1],
+                               context[2], context[3]) != 0) {
+    return -1;
+  }
 
   std::vector<std::vector<std::shared_ptr<BaseImage>>> input_images = {
-      {template_image_, search_image}};
+      {template_image_, image}};
   std::vector<std::shared_ptr<ModelOutputInfo>> output_datas;
 
   sot_model_->inference(input_images, output_datas);
+  // 模型由调用方传入, 可能还有其它推理, 裁剪区域用完即清除
+  sot_model_->setInputCrop(search_input_name, 0, 0, 0, 0);
 
   if (output_datas.empty()) {
     LOGE("跟踪结果为空");
@@ -50,6 +50,11 @@ class SOT : public Tracker {
   int32_t initBBox(const std::shared_ptr<BaseImage>& image,
                    const ObjectBoxInfo& init_bbox);
 
+  // 计算 bbox 按 offset 外扩并裁剪到图像内的上下文区域 [x, y, w, h]
+  bool computeContext(const std::shared_ptr<BaseImage>& image,
+                      const std::vector<float>& bbox, float offset,
+                      std::vector<int>& context);
+
   std::shared_ptr<BaseImage> preprocess(const std::shared_ptr<BaseImage>& image,
                                         const std::vector<float>& bbox,
                                         float offset, int crop_size,
@@ -101,8 +106,10 @@ class SOT : public Tracker {
   // 当前跟踪的目标边界框 [x, y, w, h]
   std::vector<float> current_bbox_;
 
-  // 模板图像
+  // 模板图像, 只在 initBBox 时裁剪一次
   std::shared_ptr<BaseImage> template_image_;
+  // 当前帧搜索区域 [x, y, w, h]
+  std::vector<int> search_context_ = std::vector<int>(4);
 
   // 是否已初始化
   bool is_initialized_ = false;
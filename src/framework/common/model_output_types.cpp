@@ -1,5 +1,15 @@
 #include "common/model_output_types.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 ModelFeatureInfo::~ModelFeatureInfo() {
   if (embedding) {
     delete[] embedding;
@@ -13,4 +23,447 @@ ModelOcrInfo::~ModelOcrInfo() {
     text_info = nullptr;
     length = 0;
   }
-}
\ No newline at end of file
+}
+
+static void gatherRoiRows(const uint8_t *src, int src_stride,
+                          const std::vector<int> &rows,
+                          const std::vector<int> &cols, int roi_x, int roi_y,
+                          int roi_w, int roi_h, uint8_t *dst) {
+  const int *col = cols.data() + roi_x;
+  for (int y = 0; y < roi_h; y++) {
+    uint8_t *dst_row = dst + size_t(y) * roi_w;
+    // 放大时相邻输出行常映射到同一 native 行, 直接复制上一行
+    if (y > 0 && rows[roi_y + y] == rows[roi_y + y - 1]) {
+      memcpy(dst_row, dst_row - roi_w, roi_w);
+      continue;
+    }
+    const uint8_t *src_row = src + size_t(rows[roi_y + y]) * src_stride;
+    for (int x = 0; x < roi_w; x++) {
+      dst_row[x] = src_row[col[x]];
+    }
+  }
+}
+
+int32_t ModelSegmentationInfo::upsampleRoi(int roi_x, int roi_y, int roi_w,
+                                           int roi_h, uint8_t *roi_class_id,
+                                           uint8_t *roi_class_conf) const {
+  if (roi_x < 0 || roi_y < 0 || roi_w <= 0 || roi_h <= 0 ||
+      uint32_t(roi_x + roi_w) > output_width ||
+      uint32_t(roi_y + roi_h) > output_height) {
+    return -1;
+  }
+  const uint8_t *maps[2] = {class_id, class_conf};
+  uint8_t *roi_maps[2] = {roi_class_id, roi_class_conf};
+  const std::vector<uint8_t> *native_maps[2] = {&native_class_id,
+                                                &native_class_conf};
+  for (int i = 0; i < 2; i++) {
+    if (roi_maps[i] == nullptr) {
+      continue;
+    }
+    if (maps[i] != nullptr) {
+      // 全分辨率图已经生成
+      for (int y = 0; y < roi_h; y++) {
+        memcpy(roi_maps[i] + size_t(y) * roi_w,
+               maps[i] + size_t(roi_y + y) * output_width + roi_x, roi_w);
+      }
+      continue;
+    }
+    if (row_index == nullptr || col_index == nullptr ||
+        row_index->size() != output_height ||
+        col_index->size() != output_width ||
+        native_maps[i]->size() != size_t(native_width) * native_height) {
+      return -1;
+    }
+    gatherRoiRows(native_maps[i]->data(), native_width, *row_index,
+                  *col_index, roi_x, roi_y, roi_w, roi_h, roi_maps[i]);
+  }
+  return 0;
+}
+
+// fp16 位模式转 float: 指数与尾数左移 13 位后乘 2^112 补齐指数偏置,
+// 非规格化数同样精确; inf/nan 另行置满指数
+static inline float fp16ToFloat(uint16_t half) {
+  uint32_t bits = uint32_t(half & 0x7fff) << 13;
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  value *= 5.192296858534828e+33f;  // 2^112
+  memcpy(&bits, &value, sizeof(bits));
+  if ((half & 0x7c00) == 0x7c00) {
+    bits |= 0x7f800000;
+  }
+  bits |= uint32_t(half & 0x8000) << 16;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// v = x * scale, kDepth 时再转为 focal_baseline / v, 非正视差记为 0
+template <bool kDepth>
+static inline float finishValue(float value, float scale,
+                                float focal_baseline) {
+  value *= scale;
+  if (kDepth) {
+    value = value > 0 ? focal_baseline / value : 0.0f;
+  }
+  return value;
+}
+
+#if defined(__SSE2__)
+template <bool kDepth>
+static inline void storeValues(float *dst, __m128 value, __m128 scale,
+                               __m128 focal_baseline) {
+  value = _mm_mul_ps(value, scale);
+  if (kDepth) {
+    __m128 valid = _mm_cmpgt_ps(value, _mm_setzero_ps());
+    value = _mm_and_ps(valid, _mm_div_ps(focal_baseline, value));
+  }
+  _mm_storeu_ps(dst, value);
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+template <bool kDepth>
+static inline void storeValues(float *dst, float32x4_t value,
+                               float32x4_t scale, float32x4_t focal_baseline) {
+  value = vmulq_f32(value, scale);
+  if (kDepth) {
+    uint32x4_t valid = vcgtq_f32(value, vdupq_n_f32(0.0f));
+    value = vreinterpretq_f32_u32(vandq_u32(
+        valid, vreinterpretq_u32_f32(vdivq_f32(focal_baseline, value))));
+  }
+  vst1q_f32(dst, value);
+}
+#endif
+
+template <bool kDepth>
+static void int8ToFloat(const int8_t *src, float *dst, size_t n, float scale,
+                        float focal_baseline) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 s = _mm_set1_ps(scale), fb = _mm_set1_ps(focal_baseline);
+  for (; i + 16 <= n; i += 16) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+    __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+    __m128i v0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16);
+    __m128i v1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16);
+    __m128i v2 = _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16);
+    __m128i v3 = _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16);
+    storeValues<kDepth>(dst + i, _mm_cvtepi32_ps(v0), s, fb);
+    storeValues<kDepth>(dst + i + 4, _mm_cvtepi32_ps(v1), s, fb);
+    storeValues<kDepth>(dst + i + 8, _mm_cvtepi32_ps(v2), s, fb);
+    storeValues<kDepth>(dst + i + 12, _mm_cvtepi32_ps(v3), s, fb);
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const float32x4_t s = vdupq_n_f32(scale), fb = vdupq_n_f32(focal_baseline);
+  for (; i + 16 <= n; i += 16) {
+    int8x16_t x = vld1q_s8(src + i);
+    int16x8_t lo = vmovl_s8(vget_low_s8(x));
+    int16x8_t hi = vmovl_s8(vget_high_s8(x));
+    storeValues<kDepth>(dst + i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(lo))),
+                        s, fb);
+    storeValues<kDepth>(dst + i + 4,
+                        vcvtq_f32_s32(vmovl_s16(vget_high_s16(lo))), s, fb);
+    storeValues<kDepth>(dst + i + 8,
+                        vcvtq_f32_s32(vmovl_s16(vget_low_s16(hi))), s, fb);
+    storeValues<kDepth>(dst + i + 12,
+                        vcvtq_f32_s32(vmovl_s16(vget_high_s16(hi))), s, fb);
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = finishValue<kDepth>(float(src[i]), scale, focal_baseline);
+  }
+}
+
+template <bool kDepth>
+static void uint8ToFloat(const uint8_t *src, float *dst, size_t n,
+                         float scale, float focal_baseline) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 s = _mm_set1_ps(scale), fb = _mm_set1_ps(focal_baseline);
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128i lo = _mm_unpacklo_epi8(x, zero);
+    __m128i hi = _mm_unpackhi_epi8(x, zero);
+    storeValues<kDepth>(dst + i, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)),
+                        s, fb);
+    storeValues<kDepth>(dst + i + 4,
+                        _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), s, fb);
+    storeValues<kDepth>(dst + i + 8,
+                        _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), s, fb);
+    storeValues<kDepth>(dst + i + 12,
+                        _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), s, fb);
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const float32x4_t s = vdupq_n_f32(scale), fb = vdupq_n_f32(focal_baseline);
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t x = vld1q_u8(src + i);
+    uint16x8_t lo = vmovl_u8(vget_low_u8(x));
+    uint16x8_t hi = vmovl_u8(vget_high_u8(x));
+    storeValues<kDepth>(dst + i, vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))),
+                        s, fb);
+    storeValues<kDepth>(dst + i + 4,
+                        vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), s, fb);
+    storeValues<kDepth>(dst + i + 8,
+                        vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), s, fb);
+    storeValues<kDepth>(dst + i + 12,
+                        vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), s, fb);
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = finishValue<kDepth>(float(src[i]), scale, focal_baseline);
+  }
+}
+
+template <bool kDepth>
+static void fp16ToFloatRow(const uint16_t *src, float *dst, size_t n,
+                           float scale, float focal_baseline) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 s = _mm_set1_ps(scale), fb = _mm_set1_ps(focal_baseline);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i abs_mask = _mm_set1_epi32(0x7fff);
+  const __m128i inf_half = _mm_set1_epi32(0x7bff);
+  const __m128i inf_bits = _mm_set1_epi32(0x7f800000);
+  const __m128 magic = _mm_set1_ps(5.192296858534828e+33f);
+  for (; i + 4 <= n; i += 4) {
+    __m128i half = _mm_unpacklo_epi16(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i)), zero);
+    __m128i abs_half = _mm_and_si128(half, abs_mask);
+    __m128i bits = _mm_castps_si128(_mm_mul_ps(
+        _mm_castsi128_ps(_mm_slli_epi32(abs_half, 13)), magic));
+    bits = _mm_or_si128(
+        bits, _mm_and_si128(_mm_cmpgt_epi32(abs_half, inf_half), inf_bits));
+    bits = _mm_or_si128(bits,
+                        _mm_slli_epi32(_mm_andnot_si128(abs_mask, half), 16));
+    storeValues<kDepth>(dst + i, _mm_castsi128_ps(bits), s, fb);
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const float32x4_t s = vdupq_n_f32(scale), fb = vdupq_n_f32(focal_baseline);
+  for (; i + 4 <= n; i += 4) {
+    storeValues<kDepth>(
+        dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))), s,
+        fb);
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = finishValue<kDepth>(fp16ToFloat(src[i]), scale, focal_baseline);
+  }
+}
+
+template <bool kDepth>
+static void bf16ToFloatRow(const uint16_t *src, float *dst, size_t n,
+                           float scale, float focal_baseline) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 s = _mm_set1_ps(scale), fb = _mm_set1_ps(focal_baseline);
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 8 <= n; i += 8) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    storeValues<kDepth>(dst + i, _mm_castsi128_ps(_mm_unpacklo_epi16(zero, x)),
+                        s, fb);
+    storeValues<kDepth>(dst + i + 4,
+                        _mm_castsi128_ps(_mm_unpackhi_epi16(zero, x)), s, fb);
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const float32x4_t s = vdupq_n_f32(scale), fb = vdupq_n_f32(focal_baseline);
+  for (; i + 4 <= n; i += 4) {
+    storeValues<kDepth>(
+        dst + i, vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(src + i), 16)), s,
+        fb);
+  }
+#endif
+  for (; i < n; i++) {
+    uint32_t bits = uint32_t(src[i]) << 16;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    dst[i] = finishValue<kDepth>(value, scale, focal_baseline);
+  }
+}
+
+// 可原地转换 (src == dst)
+template <bool kDepth>
+static void fp32ToFloatRow(const float *src, float *dst, size_t n, float scale,
+                           float focal_baseline) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 s = _mm_set1_ps(scale), fb = _mm_set1_ps(focal_baseline);
+  for (; i + 4 <= n; i += 4) {
+    storeValues<kDepth>(dst + i, _mm_loadu_ps(src + i), s, fb);
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const float32x4_t s = vdupq_n_f32(scale), fb = vdupq_n_f32(focal_baseline);
+  for (; i + 4 <= n; i += 4) {
+    storeValues<kDepth>(dst + i, vld1q_f32(src + i), s, fb);
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = finishValue<kDepth>(src[i], scale, focal_baseline);
+  }
+}
+
+template <bool kDepth>
+static int32_t convertDepthRow(const void *src, TDLDataType type, float scale,
+                               float focal_baseline, float *dst, size_t n) {
+  switch (type) {
+    case TDLDataType::INT8:
+      int8ToFloat<kDepth>(static_cast<const int8_t *>(src), dst, n, scale,
+                          focal_baseline);
+      return 0;
+    case TDLDataType::UINT8:
+      uint8ToFloat<kDepth>(static_cast<const uint8_t *>(src), dst, n, scale,
+                           focal_baseline);
+      return 0;
+    case TDLDataType::FP16:
+      fp16ToFloatRow<kDepth>(static_cast<const uint16_t *>(src), dst, n,
+                             scale, focal_baseline);
+      return 0;
+    case TDLDataType::BF16:
+      bf16ToFloatRow<kDepth>(static_cast<const uint16_t *>(src), dst, n,
+                             scale, focal_baseline);
+      return 0;
+    case TDLDataType::FP32:
+      fp32ToFloatRow<kDepth>(static_cast<const float *>(src), dst, n, scale,
+                             focal_baseline);
+      return 0;
+    default:
+      return -1;
+  }
+}
+
+int32_t ModelDepthInfo::convertToFloat(const void *src, TDLDataType type,
+                                       float scale, float focal_baseline,
+                                       float *dst, size_t n) {
+  if (src == nullptr || dst == nullptr) {
+    return -1;
+  }
+  // 反量化与视差转深度在同一次遍历中完成
+  if (focal_baseline > 0) {
+    return convertDepthRow<true>(src, type, scale, focal_baseline, dst, n);
+  }
+  return convertDepthRow<false>(src, type, scale, focal_baseline, dst, n);
+}
+
+static size_t depthElemBytes(TDLDataType type) {
+  switch (type) {
+    case TDLDataType::INT8:
+    case TDLDataType::UINT8:
+      return 1;
+    case TDLDataType::FP16:
+    case TDLDataType::BF16:
+      return 2;
+    default:
+      return 4;
+  }
+}
+
+int32_t ModelDepthInfo::toFloat(float *dst) const {
+  if (dst == nullptr || w <= 0 || h <= 0) {
+    return -1;
+  }
+  if (logits != nullptr) {
+    memcpy(dst, logits, size_t(w) * h * sizeof(float));
+    return 0;
+  }
+  return convertToFloat(native_data, native_type, native_scale,
+                        focal_baseline, dst, size_t(w) * h);
+}
+
+float ModelDepthInfo::valueAt(int x, int y) const {
+  if (x < 0 || y < 0 || x >= w || y >= h) {
+    return 0.0f;
+  }
+  size_t offset = size_t(y) * w + x;
+  if (logits != nullptr) {
+    return logits[offset];
+  }
+  float value = 0.0f;
+  size_t elem_bytes = depthElemBytes(native_type);
+  if (native_data == nullptr ||
+      convertToFloat(static_cast<const uint8_t *>(native_data) +
+                         offset * elem_bytes,
+                     native_type, native_scale, focal_baseline, &value,
+                     1) != 0) {
+    return 0.0f;
+  }
+  return value;
+}
+
+int32_t ModelDepthInfo::roiMedian(int x, int y, int roi_w, int roi_h,
+                                  float *median) const {
+  if (median == nullptr || x < 0 || y < 0 || roi_w <= 0 || roi_h <= 0 ||
+      x + roi_w > w || y + roi_h > h) {
+    return -1;
+  }
+  if (logits == nullptr && native_data == nullptr) {
+    return -1;
+  }
+  // 8 位输出按原始值统计直方图, 每个取值只换算一次
+  if (logits == nullptr && (native_type == TDLDataType::INT8 ||
+                            native_type == TDLDataType::UINT8)) {
+    uint32_t hist[256] = {0};
+    const uint8_t *data = static_cast<const uint8_t *>(native_data);
+    for (int r = 0; r < roi_h; r++) {
+      const uint8_t *row = data + size_t(y + r) * w + x;
+      for (int c = 0; c < roi_w; c++) {
+        hist[row[c]]++;
+      }
+    }
+    std::vector<std::pair<float, uint32_t>> bins;
+    uint32_t total = 0;
+    for (int code = 0; code < 256; code++) {
+      if (hist[code] == 0) {
+        continue;
+      }
+      uint8_t raw = uint8_t(code);
+      float value;
+      convertToFloat(&raw, native_type, native_scale, focal_baseline, &value,
+                     1);
+      if (value > 0) {
+        bins.emplace_back(value, hist[code]);
+        total += hist[code];
+      }
+    }
+    if (total == 0) {
+      return -1;
+    }
+    std::sort(bins.begin(), bins.end());
+    uint32_t rank = (total - 1) / 2;
+    for (const auto &bin : bins) {
+      if (rank < bin.second) {
+        *median = bin.first;
+        break;
+      }
+      rank -= bin.second;
+    }
+    return 0;
+  }
+
+  // 其余类型只展开区域内的行
+  std::vector<float> row_values(roi_w);
+  std::vector<float> values;
+  values.reserve(size_t(roi_w) * roi_h);
+  size_t elem_bytes = depthElemBytes(native_type);
+  for (int r = 0; r < roi_h; r++) {
+    size_t offset = size_t(y + r) * w + x;
+    const float *row = logits != nullptr ? logits + offset : row_values.data();
+    if (logits == nullptr) {
+      if (convertToFloat(static_cast<const uint8_t *>(native_data) +
+                             offset * elem_bytes,
+                         native_type, native_scale, focal_baseline,
+                         row_values.data(), roi_w) != 0) {
+        return -1;
+      }
+    }
+    for (int c = 0; c < roi_w; c++) {
+      if (row[c] > 0) {
+        values.push_back(row[c]);
+      }
+    }
+  }
+  if (values.empty()) {
+    return -1;
+  }
+  auto mid = values.begin() + (values.size() - 1) / 2;
+  std::nth_element(values.begin(), mid, values.end());
+  *median = *mid;
+  return 0;
+}
@@ -281,75 +281,27 @@ std::shared_ptr<BaseImage> ImageFactory::alignFace(
        dst_img_size, aligned_image->getStrides()[0],
        aligned_image->getVirtualAddress()[0]);
 
-  // 分支一：输入为 YUV420SP（NV12 或 NV21）
+  // 分支一：输入为 YUV420SP（NV12 或 NV21）, 直接从 Y/UV 平面取样,
+  // 不需要先把整帧拷贝并转换为 RGB
   if (image->getImageFormat() == ImageFormat::YUV420SP_VU ||
       image->getImageFormat() == ImageFormat::YUV420SP_UV) {
     // YUV420SP 要求宽高为偶数，向下取整到合法值
     const uint32_t width = image->getWidth() & ~1u;
     const uint32_t height = image->getHeight() & ~1u;
-
-    // 期望 image->getVirtualAddress()[0] = Y 平面首地址
-    //       image->getVirtualAddress()[1] = UV/VU 平面首地址
-    // 并且 strides[0] 是 Y 步长，strides[1] 是 UV/VU 步长（如有）
-    // 如果底层 stride 与 width 不同，这里仍采用拼接到紧凑 NV12/NV21
-    // 的方式，再交给 OpenCV 转换。
-
-    size_t nv_size = static_cast<size_t>(width) * height * 3 / 2;
-    unsigned char* nv_data = (unsigned char*)malloc(nv_size);
-    if (!nv_data) {
-      LOGE("Failed to allocate NV buffer");
-      return nullptr;
-    }
-
-    // 拷贝 Y 平面（按行拷贝，考虑 stride 可能大于 width）
-    {
-      const uint8_t* src_y =
-          reinterpret_cast<const uint8_t*>(image->getVirtualAddress()[0]);
-      const int src_y_stride =
-          image->getStrides()[0] > 0 ? image->getStrides()[0] : (int)width;
-      uint8_t* dst_y = nv_data;
-      for (uint32_t r = 0; r < height; ++r) {
-        memcpy(dst_y + r * width, src_y + r * src_y_stride, width);
-      }
-    }
-
-    // 拷贝 UV（或 VU）平面（同样按行拷贝）
-    {
-      const uint8_t* src_uv =
-          reinterpret_cast<const uint8_t*>(image->getVirtualAddress()[1]);
-      const int src_uv_stride =
-          image->getStrides().size() > 1 && image->getStrides()[1] > 0
-              ? image->getStrides()[1]
-              : (int)width;  // UV/VU 平面步长通常等于宽度
-      uint8_t* dst_uv = nv_data + width * height;
-      const uint32_t uv_rows = height / 2;
-      // 每行字节数为 width（打包的交错色度，UV 或 VU）
-      for (uint32_t r = 0; r < uv_rows; ++r) {
-        memcpy(dst_uv + r * width, src_uv + r * src_uv_stride, width);
-      }
-    }
-
-    // 构造单通道 NV 图像
-    cv::Mat nv_img(height + height / 2, width, CV_8UC1, nv_data);
-
-    // 根据格式选择正确的颜色转换码
-    int cvt_code = (image->getImageFormat() == ImageFormat::YUV420SP_UV)
-                       ? cv::COLOR_YUV2RGB_NV12   // NV12: YUV420SP_UV
-                       : cv::COLOR_YUV2RGB_NV21;  // NV21: YUV420SP_VU
-
-    cv::Mat rgb_img;
-    cv::cvtColor(nv_img, rgb_img, cvt_code);
-
-    LOGI("srcimg,width:%d,height:%d,stride:%zu,addr:%p", (int)width,
-         (int)height, rgb_img.step, rgb_img.data);
-
-    // 仿射对齐
-    tdl_face_warp_affine(rgb_img.data, (int)rgb_img.step, (int)width,
-                         (int)height, aligned_image->getVirtualAddress()[0],
-                         aligned_image->getStrides()[0], dst_img_size,
-                         dst_img_size, src_landmark_xy);
-
-    free(nv_data);
+    const int y_stride =
+        image->getStrides()[0] > 0 ? image->getStrides()[0] : (int)width;
+    const int uv_stride =
+        image->getStrides().size() > 1 && image->getStrides()[1] > 0
+            ? image->getStrides()[1]
+            : (int)width;  // UV/VU 平面步长通常等于宽度
+
+    tdl_face_warp_affine_yuv420sp(
+        image->getVirtualAddress()[0], y_stride,
+        image->getVirtualAddress()[1], uv_stride,
+        image->getImageFormat() == ImageFormat::YUV420SP_VU, (int)width,
+        (int)height, aligned_image->getVirtualAddress()[0],
+        aligned_image->getStrides()[0], dst_img_size, dst_img_size,
+        src_landmark_xy);
     return aligned_image;
   }
 
@@ -418,65 +370,26 @@ std::shared_ptr<BaseImage> ImageFactory::alignLicensePlate(
        dst_img_height, aligned_image->getStrides()[0],
        aligned_image->getVirtualAddress()[0]);
 
-  // 分支一：输入为 YUV420SP（NV12 或 NV21）
+  // 分支一：输入为 YUV420SP（NV12 或 NV21）, 直接从 Y/UV 平面取样
   if (image->getImageFormat() == ImageFormat::YUV420SP_VU ||
       image->getImageFormat() == ImageFormat::YUV420SP_UV) {
     // YUV420SP 要求宽高为偶数，向下取整到合法值
     const uint32_t width = image->getWidth() & ~1u;
     const uint32_t height = image->getHeight() & ~1u;
-
-    size_t nv_size = static_cast<size_t>(width) * height * 3 / 2;
-    unsigned char* nv_data = (unsigned char*)malloc(nv_size);
-    if (!nv_data) {
-      LOGE("Failed to allocate NV buffer");
-      return nullptr;
-    }
-
-    // 拷贝 Y 平面
-    {
-      const uint8_t* src_y =
-          reinterpret_cast<const uint8_t*>(image->getVirtualAddress()[0]);
-      const int src_y_stride =
-          image->getStrides()[0] > 0 ? image->getStrides()[0] : (int)width;
-      uint8_t* dst_y = nv_data;
-      for (uint32_t r = 0; r < height; ++r) {
-        memcpy(dst_y + r * width, src_y + r * src_y_stride, width);
-      }
-    }
-
-    // 拷贝 UV（或 VU）平面
-    {
-      const uint8_t* src_uv =
-          reinterpret_cast<const uint8_t*>(image->getVirtualAddress()[1]);
-      const int src_uv_stride =
-          image->getStrides().size() > 1 && image->getStrides()[1] > 0
-              ? image->getStrides()[1]
-              : (int)width;
-      uint8_t* dst_uv = nv_data + width * height;
-      const uint32_t uv_rows = height / 2;
-      for (uint32_t r = 0; r < uv_rows; ++r) {
-        memcpy(dst_uv + r * width, src_uv + r * src_uv_stride, width);
-      }
-    }
-
-    cv::Mat nv_img(height + height / 2, width, CV_8UC1, nv_data);
-
-    int cvt_code = (image->getImageFormat() == ImageFormat::YUV420SP_UV)
-                       ? cv::COLOR_YUV2RGB_NV12   // NV12: YUV420SP_UV
-                       : cv::COLOR_YUV2RGB_NV21;  // NV21: YUV420SP_VU
-
-    cv::Mat rgb_img;
-    cv::cvtColor(nv_img, rgb_img, cvt_code);
-
-    LOGI("srcimg,width:%d,height:%d,stride:%zu,addr:%p", (int)width,
-         (int)height, rgb_img.step, rgb_img.data);
-
-    tdl_license_plate_warp_affine(
-        rgb_img.data, (int)rgb_img.step, (int)width, (int)height,
-        aligned_image->getVirtualAddress()[0], aligned_image->getStrides()[0],
-        dst_img_width, dst_img_height, src_landmark_xy);
-
-    free(nv_data);
+    const int y_stride =
+        image->getStrides()[0] > 0 ? image->getStrides()[0] : (int)width;
+    const int uv_stride =
+        image->getStrides().size() > 1 && image->getStrides()[1] > 0
+            ? image->getStrides()[1]
+            : (int)width;
+
+    tdl_license_plate_warp_affine_yuv420sp(
+        image->getVirtualAddress()[0], y_stride,
+        image->getVirtualAddress()[1], uv_stride,
+        image->getImageFormat() == ImageFormat::YUV420SP_VU, (int)width,
+        (int)height, aligned_image->getVirtualAddress()[0],
+        aligned_image->getStrides()[0], dst_img_width, dst_img_height,
+        src_landmark_xy);
     return aligned_image;
   }
 
@@ -20,24 +20,21 @@ BMContext &BMContext::Get() {
 }
 
 bm_handle_t BMContext::get_handle(int device_id) {
+  // models may be opened from several threads, see TDLModelFactory::getModels
+  pthread_mutex_lock(&lock_);
+  bm_handle_t h = nullptr;
   if (device_handles_.count(device_id)) {
-    return device_handles_[device_id];
-  }
-
-  if (device_id == -1) {
+    h = device_handles_[device_id];
+  } else if (device_id == -1) {
     if (device_handles_.size()) {
-      for (auto kv : device_handles_) {
-        return kv.second;
-      }
+      h = device_handles_.begin()->second;
     }
-    return nullptr;
+  } else {
+    bm_dev_request(&h, device_id);
+    device_handles_[device_id] = h;
   }
-  pthread_mutex_lock(&lock_);
-  bm_handle_t h;
-  bm_dev_request(&h, device_id);
-  device_handles_[device_id] = h;
   pthread_mutex_unlock(&lock_);
-  return device_handles_[device_id];
+  return h;
 }
 
 void BMContext::set_device_id(int device_id) {
@@ -22,6 +22,38 @@ void print_netparam(const NetParam& net_param) {
   LOGI("%s", ss.str().c_str());
 }
 
+// 已缩放到输入尺寸且不需要裁剪的 CPU 图像可直接转换写入输入张量,
+// 不必经过预处理器的中间图像
+static bool canCopyToTensor(const std::shared_ptr<BaseImage>& image,
+                            const PreprocessParams& params,
+                            const std::shared_ptr<BaseTensor>& tensor) {
+  if ((int)CommonUtils::getDataTypeSize(params.dst_pixdata_type) !=
+      tensor->getElementSize()) {
+    return false;
+  }
+  if (image->getImageType() != ImageType::OPENCV_FRAME ||
+      image->getPixDataType() != TDLDataType::UINT8 ||
+      (int)image->getWidth() != params.dst_width ||
+      (int)image->getHeight() != params.dst_height) {
+    return false;
+  }
+  if (params.crop_x != 0 || params.crop_y != 0 ||
+      (params.crop_width != 0 && params.crop_width != params.dst_width) ||
+      (params.crop_height != 0 && params.crop_height != params.dst_height)) {
+    return false;
+  }
+  ImageFormat format = image->getImageFormat();
+  if (params.dst_image_format == ImageFormat::GRAY) {
+    return format == ImageFormat::GRAY;
+  }
+  return (params.dst_image_format == ImageFormat::RGB_PLANAR ||
+          params.dst_image_format == ImageFormat::BGR_PLANAR) &&
+         (format == ImageFormat::RGB_PLANAR ||
+          format == ImageFormat::RGB_PACKED ||
+          format == ImageFormat::BGR_PLANAR ||
+          format == ImageFormat::BGR_PACKED);
+}
+
 BaseModel::BaseModel() {
   // bug:should not use memset for struct has stl container
   //  memset(&net_param_, 0, sizeof(NetParam));
@@ -55,6 +87,18 @@ int32_t BaseModel::modelOpen(const int device_id) {
     preprocessor_ =
         PreprocessorFactory::createPreprocessor(net_param_.platform, device_id);
   }
+  std::string model_name = net_param_.model_file_path;
+  size_t pos = model_name.find_last_of('/');
+  if (pos != std::string::npos) {
+    model_name = model_name.substr(pos + 1);
+  }
+  if (model_name.empty()) {
+    model_name = std::to_string(static_cast<int>(model_type_));
+  }
+  model_name = "model/" + model_name;
+  trace_preprocess_id_ = Tracer::registerName(model_name + "/preprocess");
+  trace_forward_id_ = Tracer::registerName(model_name + "/forward");
+  trace_post_id_ = Tracer::registerName(model_name + "/post");
   return 0;
 }
 
@@ -141,6 +185,21 @@ int32_t BaseModel::setPreprocessParameters(const PreprocessParams& pre_param,
   return 0;
 }
 
+int32_t BaseModel::setInputCrop(const std::string& input_name,
+                                int32_t crop_x, int32_t crop_y,
+                                int32_t crop_width, int32_t crop_height) {
+  auto it = preprocess_params_.find(input_name);
+  if (it == preprocess_params_.end()) {
+    LOGE("input_name:%s not found", input_name.c_str());
+    return -1;
+  }
+  it->second.crop_x = crop_x;
+  it->second.crop_y = crop_y;
+  it->second.crop_width = crop_width;
+  it->second.crop_height = crop_height;
+  return 0;
+}
+
 int32_t BaseModel::setupNetwork(NetParam& net_param) {
   net_ = NetFactory::createNet(net_param, net_param.platform);
   int32_t ret = net_->setup();
@@ -232,10 +291,12 @@ int32_t BaseModel::inference(
       preprocess_params.dst_height, preprocess_params.dst_width,
       preprocess_params.dst_pixdata_type);
   model_timer_.TicToc("runstart");
+  TraceSteps trace_steps;
   std::shared_ptr<BaseTensor> input_tensor =
       net_->getInputTensor(input_layer_name);
   while (process_idx < batch_size) {
     int fit_batch_size = getFitBatchSize(batch_size - process_idx);
+    trace_steps.start();
     std::vector<std::shared_ptr<BaseImage>> batch_images;
     batch_rescale_params_[input_layer_name].clear();
     for (int i = 0; i < fit_batch_size; i++) {
@@ -257,9 +318,16 @@ int32_t BaseModel::inference(
         batch_rescale_params_[input_layer_name].push_back(
             std::vector<float>({1.0f, 1.0f, 0.0f, 0.0f}));
       } else {
-        preprocessor_->preprocessToTensor(
-            images[process_idx + i], preprocess_params, i,
-            net_->getInputTensor(input_layer_name));
+        if (!canCopyToTensor(images[process_idx + i], preprocess_params,
+                             input_tensor) ||
+            input_tensor->copyFromImage(images[process_idx + i],
+                                        preprocess_params, i) != 0) {
+          preprocessor_->preprocessToTensor(
+              images[process_idx + i], preprocess_params, i,
+              net_->getInputTensor(input_layer_name));
+        } else {
+          input_tensor->flushCache();
+        }
         std::vector<float> rescale_params = preprocessor_->getRescaleConfig(
             preprocess_params, images[process_idx + i]->getWidth(),
             images[process_idx + i]->getHeight());
@@ -267,13 +335,16 @@ int32_t BaseModel::inference(
       }
     }
     model_timer_.TicToc("preprocess");
+    trace_steps.step(trace_preprocess_id_);
     net_->updateInputTensors();
     net_->forward();
     model_timer_.TicToc("tpu");
+    trace_steps.step(trace_forward_id_);
     net_->updateOutputTensors();
     std::vector<std::shared_ptr<ModelOutputInfo>> batch_results;
     outputParse(batch_images, batch_results);
     model_timer_.TicToc("post");
+    trace_steps.step(trace_post_id_);
     out_datas.insert(out_datas.end(), batch_results.begin(),
                      batch_results.end());
     process_idx += fit_batch_size;
@@ -319,8 +390,10 @@ int32_t BaseModel::inference(
   }
 
   model_timer_.TicToc("runstart");
+  TraceSteps trace_steps;
   while (process_idx < batch_size) {
     int fit_batch_size = getFitBatchSize(batch_size - process_idx);
+    trace_steps.start();
     for (int i = 0; i < input_layer_names.size(); i++) {
       setInputBatchSize(input_layer_names[i], fit_batch_size);
       batch_rescale_params_[input_layer_names[i]].clear();
@@ -355,13 +428,16 @@ int32_t BaseModel::inference(
       }
     }
     model_timer_.TicToc("preprocess");
+    trace_steps.step(trace_preprocess_id_);
     net_->updateInputTensors();
     net_->forward();
     model_timer_.TicToc("tpu");
+    trace_steps.step(trace_forward_id_);
     net_->updateOutputTensors();
     std::vector<std::shared_ptr<ModelOutputInfo>> batch_results;
     outputParse(batch_images, batch_results);
     model_timer_.TicToc("post");
+    trace_steps.step(trace_post_id_);
     out_datas.insert(out_datas.end(), batch_results.begin(),
                      batch_results.end());
     process_idx += fit_batch_size;
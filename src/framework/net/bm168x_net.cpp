@@ -22,11 +22,11 @@ BM168xNet::~BM168xNet() {
     delete[] output_tensors_;
     output_tensors_ = 0;
   }
-  if (p_bmrt_ != nullptr) {
+  if (p_bmrt_ != nullptr && shared_runtime_ == nullptr) {
     LOGI("destroy bmrt");
     bmrt_destroy(p_bmrt_);
-    p_bmrt_ = nullptr;
   }
+  p_bmrt_ = nullptr;
   net_info_ = nullptr;
   LOGI("destroy 168xnet:%s", net_name_.c_str());
 }
@@ -47,12 +47,34 @@ int32_t BM168xNet::setup() {
   memory_pool_ = std::make_shared<BmMemoryPool>(bm_handle_);
 
   LOGI("to get_model_bmrt: %s", net_param_.model_file_path.c_str());
-  p_bmrt_ = bmrt_create(bm_handle_);
-
-  int32_t ret = loadModel();
-  if (ret != 0) {
-    LOGE("load model failed");
-    return -1;
+  std::string share_key = NetFactory::getSharedModelKey(net_param_);
+  if (share_key.empty()) {
+    p_bmrt_ = bmrt_create(bm_handle_);
+    int32_t ret = loadModel(p_bmrt_);
+    if (ret != 0) {
+      LOGE("load model failed");
+      return -1;
+    }
+  } else {
+    bool created = false;
+    std::shared_ptr<void> shared_model = NetFactory::getSharedModel(
+        share_key,
+        [this]() -> std::shared_ptr<void> {
+          auto runtime = std::make_shared<SharedRuntime>();
+          runtime->p_bmrt = bmrt_create(bm_handle_);
+          if (loadModel(runtime->p_bmrt) != 0) {
+            return nullptr;
+          }
+          return runtime;
+        },
+        &created);
+    if (shared_model == nullptr) {
+      LOGE("load model failed");
+      return -1;
+    }
+    shared_runtime_ = std::static_pointer_cast<SharedRuntime>(shared_model);
+    p_bmrt_ = shared_runtime_->p_bmrt;
+    LOGI("%s bmrt: %s", created ? "load" : "share", share_key.c_str());
   }
   // if name was not set,use the name inside bmodel as default
   std::string net_name = net_param_.model_config.net_name;
@@ -124,7 +146,15 @@ int32_t BM168xNet::setup() {
   return 0;
 }
 
-int32_t BM168xNet::loadModel() {
+BM168xNet::SharedRuntime::~SharedRuntime() {
+  if (p_bmrt != nullptr) {
+    LOGI("destroy shared bmrt");
+    bmrt_destroy(p_bmrt);
+    p_bmrt = nullptr;
+  }
+}
+
+int32_t BM168xNet::loadModel(void *p_bmrt) {
   bool flag = false;
   LOGI("runtime_mem_addrs size:%d,runtime_mem_sizes size:%d",
        net_param_.runtime_mem_addrs.size(),
@@ -162,7 +192,7 @@ int32_t BM168xNet::loadModel() {
         LOGE("updateMemoryInfo failed");
         return -1;
       }
-      flag = bmrt_load_bmodel_data_with_mem(p_bmrt_, net_param_.model_buffer,
+      flag = bmrt_load_bmodel_data_with_mem(p_bmrt, net_param_.model_buffer,
                                             net_param_.model_buffer_size,
                                             &mem_info);
       if (flag == false) {
@@ -170,7 +200,7 @@ int32_t BM168xNet::loadModel() {
         return -1;
       }
       // Use the same mem_info for multi-thread pre-allocation
-      flag = bmrt_pre_alloc_mem_multi_thread(p_bmrt_, 0, &mem_info);
+      flag = bmrt_pre_alloc_mem_multi_thread(p_bmrt, 0, &mem_info);
       if (flag == false) {
         LOGE("bmrt_pre_alloc_mem_multi_thread failed");
         return -1;
@@ -181,7 +211,7 @@ int32_t BM168xNet::loadModel() {
       return -1;
 #endif
     } else {
-      flag = bmrt_load_bmodel_data(p_bmrt_, net_param_.model_buffer,
+      flag = bmrt_load_bmodel_data(p_bmrt, net_param_.model_buffer,
                                    net_param_.model_buffer_size);
     }
 
@@ -202,14 +232,14 @@ int32_t BM168xNet::loadModel() {
       }
       LOGI("to load bmodel with mem");
       flag = bmrt_load_bmodel_with_mem(
-          p_bmrt_, net_param_.model_file_path.c_str(), &mem_info);
+          p_bmrt, net_param_.model_file_path.c_str(), &mem_info);
       if (flag == false) {
         LOGE("bmrt_load_bmodel_with_mem failed");
         return -1;
       }
       // Use the same mem_info for multi-thread pre-allocation
       LOGI("to pre-alloc mem for multi-thread");
-      flag = bmrt_pre_alloc_mem_multi_thread(p_bmrt_, 0, &mem_info);
+      flag = bmrt_pre_alloc_mem_multi_thread(p_bmrt, 0, &mem_info);
       if (flag == false) {
         LOGE("bmrt_pre_alloc_mem_multi_thread failed");
         return -1;
@@ -221,7 +251,7 @@ int32_t BM168xNet::loadModel() {
       return -1;
 #endif
     } else {
-      flag = bmrt_load_bmodel(p_bmrt_, net_param_.model_file_path.c_str());
+      flag = bmrt_load_bmodel(p_bmrt, net_param_.model_file_path.c_str());
     }
   }
   if (!flag) {
@@ -391,7 +421,9 @@ int32_t BM168xNet::updateInputTensors() {
       assert(0);
     }
     LOGI("to get stage:%d,stagenum:%d", stage_index, net_info_->stage_num);
-    auto &bmrt_shape = net_info_->stages[stage_index].input_shapes[tensor_idx];
+    // copy, net_info_ may be shared with other nets
+    bm_shape_t bmrt_shape =
+        net_info_->stages[stage_index].input_shapes[tensor_idx];
     int num_bmrt_elems = 1;
     for (int i = 0; i < bmrt_shape.num_dims; i++) {
       num_bmrt_elems *= bmrt_shape.dims[i];
@@ -516,6 +548,10 @@ int32_t BM168xNet::forward(bool sync) {
     }
   }
   LOGI("start to do inference");
+  std::unique_lock<std::mutex> launch_lock;
+  if (shared_runtime_ != nullptr) {
+    launch_lock = std::unique_lock<std::mutex>(shared_runtime_->launch_mutex);
+  }
   bool ret = bmrt_launch_tensor_ex(p_bmrt_, net_info_->name, input_tensors_,
                                    net_info_->input_num, output_tensors_,
                                    net_info_->output_num, true, false);
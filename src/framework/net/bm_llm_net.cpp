@@ -1,5 +1,6 @@
 #include "net/bm_llm_net.hpp"
 #include <assert.h>
+#include <cstring>
 #include "utils/tdl_log.hpp"
 
 #define SOC_TARGET 1
@@ -10,10 +11,42 @@ void empty(bm_handle_t &bm_handle, bm_device_mem_t &mem) {
   assert(BM_SUCCESS == ret);
 }
 
+static float bf16ToFp32(uint16_t value) {
+  uint32_t bits = uint32_t(value) << 16;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+static float fp16ToFp32(uint16_t value) {
+  uint32_t sign = uint32_t(value & 0x8000) << 16;
+  uint32_t exponent = (value >> 10) & 0x1f;
+  uint32_t mantissa = value & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0x1f) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else if (exponent != 0) {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    bits = sign;
+  } else {
+    // subnormal
+    exponent = 113;
+    while ((mantissa & 0x400) == 0) {
+      mantissa <<= 1;
+      exponent--;
+    }
+    bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  }
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
 BMLLMNet::BMLLMNet() {
-  sgen_ = std::mt19937(std::random_device()());
   infer_param_.max_new_tokens = 2048;
   infer_param_.top_p = 1.0f;
+  infer_param_.top_k = 0;
   infer_param_.temperature = 1.0f;
   infer_param_.repetition_penalty = 1.0f;
   infer_param_.repetition_last_n = 64;
@@ -21,6 +54,17 @@ BMLLMNet::BMLLMNet() {
   infer_param_.prompt_mode = "prompted";
 }
 
+int32_t BMLLMNet::setInferParam(const LLMInferParam &infer_param) {
+  if (infer_param.generation_mode != "greedy" &&
+      infer_param.generation_mode != "penalty_sample") {
+    LOGE("unsupported generation_mode: %s",
+         infer_param.generation_mode.c_str());
+    return -1;
+  }
+  infer_param_ = infer_param;
+  return 0;
+}
+
 void BMLLMNet::d2d(bm_device_mem_t &dst, bm_device_mem_t &src) {
   bm_memcpy_d2d_byte(bm_handle_, dst, 0, src, 0, bm_mem_get_device_size(src));
 }
@@ -77,6 +121,9 @@ int32_t BMLLMNet::init(const std::vector<int> &devices,
   net_greedy_head_ = bmrt_get_network_info(p_bmrt_, "greedy_head");
   net_penalty_sample_head_ =
       bmrt_get_network_info(p_bmrt_, "penalty_sample_head");
+  if (net_penalty_sample_head_ == nullptr) {
+    LOGW("no penalty_sample_head in bmodel, penalty_sample runs on host");
+  }
   SEQLEN_ = net_embed_->stages[0].input_shapes[0].dims[1];  // real seqlen
   auto num_nets = bmrt_get_network_number(p_bmrt_);
   NUM_LAYERS_ = (num_nets - 5) / 2;
@@ -248,29 +295,116 @@ int BMLLMNet::penaltySample(const bm_net_info_t *net,
   auto &out1_mem = net->stages[0].output_mems[1];  // topken_topk
 
   // repeat_penalty + top_p + top_k + temperature
-  std::vector<int> generated_tokens(SEQLEN_,
-                                    visited_tokens_[token_length_ - 1]);
-  int repeat_last_n = std::min(infer_param_.repetition_last_n, token_length_);
-  std::copy(visited_tokens_.begin() + token_length_ - repeat_last_n,
-            visited_tokens_.begin() + token_length_, generated_tokens.begin());
-  bm_memcpy_s2d(bm_handle_, in1_mem, (void *)generated_tokens.data());
-  bm_memcpy_s2d(bm_handle_, in2_mem, (void *)&infer_param_.top_p);
-  bm_memcpy_s2d(bm_handle_, in3_mem, (void *)&infer_param_.temperature);
-  bm_memcpy_s2d(bm_handle_, in4_mem, (void *)&infer_param_.repetition_penalty);
+  // 重复惩罚窗口只同步上次采样后变化的 slot, 参数不变时不再上传;
+  // 非 io_alone 时各 net 共用输入内存, 其它 net 运行后内容不再保留,
+  // 每个 token 都要完整上传
+  const std::vector<int> &history = history_window_.buffer();
+  if (history_full_upload_ || !io_alone_) {
+    bm_memcpy_s2d(bm_handle_, in1_mem, (void *)history.data());
+  } else if (history_dirty_slot_ >= 0) {
+    bm_memcpy_s2d_partial_offset(bm_handle_, in1_mem,
+                                 (void *)&history[history_dirty_slot_],
+                                 sizeof(int),
+                                 history_dirty_slot_ * sizeof(int));
+  }
+  history_full_upload_ = false;
+  history_dirty_slot_ = -1;
+
+  if (!io_alone_ || !param_uploaded_ ||
+      uploaded_param_.top_p != infer_param_.top_p ||
+      uploaded_param_.temperature != infer_param_.temperature ||
+      uploaded_param_.repetition_penalty !=
+          infer_param_.repetition_penalty) {
+    bm_memcpy_s2d(bm_handle_, in2_mem, (void *)&infer_param_.top_p);
+    bm_memcpy_s2d(bm_handle_, in3_mem, (void *)&infer_param_.temperature);
+    bm_memcpy_s2d(bm_handle_, in4_mem,
+                  (void *)&infer_param_.repetition_penalty);
+    uploaded_param_.top_p = infer_param_.top_p;
+    uploaded_param_.temperature = infer_param_.temperature;
+    uploaded_param_.repetition_penalty = infer_param_.repetition_penalty;
+    param_uploaded_ = true;
+  }
 
   // inference
   headLaunch(net, logits_mem);
 
   // get logit & token
   int candidate_num = net->stages[0].output_shapes[0].dims[1];
-  std::vector<float> probs(candidate_num);
-  bm_memcpy_d2s(bm_handle_, probs.data(), out0_mem);
+  host_logits_.resize(candidate_num);
+  bm_memcpy_d2s(bm_handle_, host_logits_.data(), out0_mem);
   std::vector<int> tokens(candidate_num);
   bm_memcpy_d2s(bm_handle_, tokens.data(), out1_mem);
 
   // penalty_sample
-  std::discrete_distribution<> dist(probs.begin(), probs.end());
-  return tokens[dist(sgen_)];
+  return sampler_.sampleCandidates(host_logits_.data(), tokens.data(),
+                                   candidate_num);
+}
+
+int BMLLMNet::hostSample(const bm_net_info_t *net,
+                         bm_device_mem_t &logits_mem) {
+  int vocab_size = bmrt_shape_count(&net->stages[0].output_shapes[0]);
+  host_logits_.resize(vocab_size);
+  bm_data_type_t dtype = net->output_dtypes[0];
+  if (dtype == BM_FLOAT32) {
+    bm_memcpy_d2s_partial(bm_handle_, host_logits_.data(), logits_mem,
+                          vocab_size * sizeof(float));
+  } else if (dtype == BM_FLOAT16 || dtype == BM_BFLOAT16) {
+    host_logits_half_.resize(vocab_size);
+    bm_memcpy_d2s_partial(bm_handle_, host_logits_half_.data(), logits_mem,
+                          vocab_size * sizeof(uint16_t));
+    for (int i = 0; i < vocab_size; i++) {
+      host_logits_[i] = dtype == BM_BFLOAT16 ? bf16ToFp32(host_logits_half_[i])
+                                             : fp16ToFp32(host_logits_half_[i]);
+    }
+  } else {
+    LOGE("unsupported lm_head output dtype: %d", dtype);
+    return 0;
+  }
+
+  LLMSampleParam param;
+  param.temperature = infer_param_.temperature;
+  param.top_p = infer_param_.top_p;
+  param.top_k = infer_param_.top_k;
+  param.repetition_penalty = infer_param_.repetition_penalty;
+  return sampler_.sample(host_logits_.data(), vocab_size, param,
+                         history_window_.buffer().data(),
+                         history_window_.size());
+}
+
+int BMLLMNet::sampleToken(bm_device_mem_t &logits_mem) {
+  int token = 0;
+  if (infer_param_.generation_mode == "greedy") {
+    token = greedySearch(net_greedy_head_, logits_mem);
+  } else if (infer_param_.generation_mode == "penalty_sample") {
+    if (net_penalty_sample_head_ != nullptr) {
+      token = penaltySample(net_penalty_sample_head_, logits_mem);
+    } else {
+      token = hostSample(net_lm_, logits_mem);
+    }
+  }
+  return token;
+}
+
+void BMLLMNet::resetHistory(const std::vector<int> &tokens) {
+  int capacity = SEQLEN_;
+  if (net_penalty_sample_head_ != nullptr) {
+    capacity = bm_mem_get_device_size(
+                   net_penalty_sample_head_->stages[0].input_mems[1]) /
+               sizeof(int);
+  }
+  history_window_.reset(capacity, infer_param_.repetition_last_n,
+                        tokens.data(), tokens.size());
+  history_full_upload_ = true;
+  history_dirty_slot_ = -1;
+}
+
+void BMLLMNet::updateHistory(int token) {
+  bool padding_changed = history_window_.push(token);
+  if (padding_changed || history_dirty_slot_ >= 0) {
+    history_full_upload_ = true;
+  } else {
+    history_dirty_slot_ = history_window_.lastSlot();
+  }
 }
 
 int BMLLMNet::forwardFirst(const std::vector<int> &tokens) {
@@ -278,6 +412,7 @@ int BMLLMNet::forwardFirst(const std::vector<int> &tokens) {
   std::vector<uint16_t> attention_mask(SEQLEN_ * SEQLEN_, ATTENTION_MASK);
   std::fill(visited_tokens_.begin(), visited_tokens_.end(), 0);
   std::copy(tokens.begin(), tokens.end(), visited_tokens_.data());
+  resetHistory(tokens);
 
   token_length_ = tokens.size();
   TOKEN_LEN_ = tokens.size();
@@ -353,14 +488,10 @@ int BMLLMNet::forwardFirst(const std::vector<int> &tokens) {
                      (token_length_ - 1) * hidden_bytes_, hidden_bytes_);
   netLaunch(net_lm_);
 
-  int token = 0;
-  if (infer_param_.generation_mode == "greedy") {
-    token = greedySearch(net_greedy_head_, lm_out_mem);
-  } else if (infer_param_.generation_mode == "penalty_sample") {
-    token = penaltySample(net_penalty_sample_head_, lm_out_mem);
-  }
+  int token = sampleToken(lm_out_mem);
 
   visited_tokens_[token_length_] = token;
+  updateHistory(token);
   token_length_ += 1;
   return token;
 }
@@ -436,14 +567,10 @@ int BMLLMNet::forwardNext() {
   d2d(lm_in_mem, out_mem);
   netLaunch(net_lm_);
 
-  int token = 0;
-  if (infer_param_.generation_mode == "greedy") {
-    token = greedySearch(net_greedy_head_, lm_out_mem);
-  } else if (infer_param_.generation_mode == "penalty_sample") {
-    token = penaltySample(net_penalty_sample_head_, lm_out_mem);
-  }
+  int token = sampleToken(lm_out_mem);
 
   visited_tokens_[token_length_] = token;
+  updateHistory(token);
   token_length_ += 1;
   return token;
 }
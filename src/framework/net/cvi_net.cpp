@@ -9,7 +9,8 @@
 CviNet::CviNet(const NetParam& param) : BaseNet(param) {}
 
 CviNet::~CviNet() {
-  if (model_handle_ != nullptr) {
+  // the handle registered by this net is released with shared_model_
+  if (model_handle_ != nullptr && model_handle_ != shared_model_.get()) {
     int32_t ret = CVI_NN_CleanupModel(model_handle_);
     if (ret != CVI_RC_SUCCESS) {  // NOLINT
       LOGE("CVI_NN_CleanupModel failed: %d\n", ret);
@@ -18,9 +19,7 @@ CviNet::~CviNet() {
   model_handle_ = nullptr;
 }
 
-int32_t CviNet::setup() {
-  LOGI("to setup CviNet,model_file_path: %s",
-       net_param_.model_file_path.c_str());
+int32_t CviNet::registerModel(CVI_MODEL_HANDLE* model_handle) {
   int ret = 0;
   if (net_param_.model_file_path.empty()) {
     if (net_param_.model_buffer == nullptr ||
@@ -30,20 +29,54 @@ int32_t CviNet::setup() {
     }
     ret = CVI_NN_RegisterModelFromBuffer(
         reinterpret_cast<const int8_t*>(net_param_.model_buffer),
-        net_param_.model_buffer_size, &model_handle_);
+        net_param_.model_buffer_size, model_handle);
   } else {
-    if (net_param_.model_file_path.empty()) {
-      LOGE("model_file_path is empty");
-      return -1;
-    }
     ret = CVI_NN_RegisterModel(net_param_.model_file_path.c_str(),
-                               &model_handle_);
+                               model_handle);
   }
-
   if (ret != 0) {
     LOGE("CVI_NN_RegisterModel failed");
     return ret;
   }
+  return 0;
+}
+
+int32_t CviNet::setup() {
+  LOGI("to setup CviNet,model_file_path: %s",
+       net_param_.model_file_path.c_str());
+  int ret = 0;
+  std::string share_key = NetFactory::getSharedModelKey(net_param_);
+  if (share_key.empty()) {
+    ret = registerModel(&model_handle_);
+  } else {
+    bool created = false;
+    shared_model_ = NetFactory::getSharedModel(
+        share_key,
+        [this]() -> std::shared_ptr<void> {
+          CVI_MODEL_HANDLE handle = nullptr;
+          if (registerModel(&handle) != 0) {
+            return nullptr;
+          }
+          return std::shared_ptr<void>(
+              handle, [](void* h) { CVI_NN_CleanupModel(h); });
+        },
+        &created);
+    if (shared_model_ == nullptr) {
+      ret = -1;
+    } else if (created) {
+      model_handle_ = shared_model_.get();
+    } else {
+      // the clone shares weights and cmdbuf, but has its own tensors
+      ret = CVI_NN_CloneModel(shared_model_.get(), &model_handle_);
+      if (ret != 0) {
+        LOGE("CVI_NN_CloneModel failed: %d", ret);
+      }
+    }
+  }
+
+  if (ret != 0) {
+    return ret;
+  }
   LOGI("CVI_NN_RegisterModel success");
   ret = CVI_NN_SetConfig(model_handle_, OPTION_OUTPUT_ALL_TENSORS, 0);
   if (ret != 0) {
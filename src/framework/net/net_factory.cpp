@@ -7,8 +7,26 @@
 #else
 #include "net/cvi_net.hpp"
 #endif
+#include <limits.h>
+#include <stdlib.h>
+#include <mutex>
+#include <sstream>
+
 #include "utils/tdl_log.hpp"
 
+namespace {
+
+struct SharedModelEntry {
+  // held while loading so that concurrent opens of one model load it once
+  std::mutex load_mutex;
+  std::weak_ptr<void> model;
+};
+
+std::mutex g_shared_model_mutex;
+std::map<std::string, std::shared_ptr<SharedModelEntry>> g_shared_models;
+
+}  // namespace
+
 std::shared_ptr<BaseNet> NetFactory::createNet(const NetParam &net_param,
                                                InferencePlatform platform) {
   LOGI("createNet,platform: %d", (int)platform);
@@ -63,4 +81,78 @@ int32_t NetFactory::getModelMemInfo(const void *model_buffer,
   return -1;
 #endif
   return 0;
-}
\ No newline at end of file
+}
+
+std::string NetFactory::getSharedModelKey(const NetParam &net_param) {
+  if (!net_param.share_model || !net_param.runtime_mem_addrs.empty()) {
+    return "";
+  }
+  std::stringstream ss;
+  ss << static_cast<int>(net_param.platform) << ":" << net_param.device_id
+     << ":" << net_param.model_config.net_name << ":";
+  if (!net_param.model_file_path.empty()) {
+    // different spellings of the same file (relative path, symlink) share
+    char resolved[PATH_MAX];
+    if (realpath(net_param.model_file_path.c_str(), resolved) != nullptr) {
+      ss << "file:" << resolved;
+    } else {
+      ss << "file:" << net_param.model_file_path;
+    }
+  } else if (net_param.model_buffer != nullptr &&
+             net_param.model_buffer_size != 0) {
+    ss << "buffer:" << static_cast<const void *>(net_param.model_buffer) << ":"
+       << net_param.model_buffer_size;
+  } else {
+    return "";
+  }
+  return ss.str();
+}
+
+std::shared_ptr<void> NetFactory::getSharedModel(
+    const std::string &key, const std::function<std::shared_ptr<void>()> &loader,
+    bool *created) {
+  *created = false;
+  std::shared_ptr<SharedModelEntry> entry;
+  {
+    std::lock_guard<std::mutex> lock(g_shared_model_mutex);
+    // drop the entries whose model has been released
+    for (auto iter = g_shared_models.begin(); iter != g_shared_models.end();) {
+      // an entry still referenced elsewhere may be loading right now
+      if (iter->first != key && iter->second.use_count() == 1 &&
+          iter->second->model.expired()) {
+        iter = g_shared_models.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+    std::shared_ptr<SharedModelEntry> &slot = g_shared_models[key];
+    if (slot == nullptr) {
+      slot = std::make_shared<SharedModelEntry>();
+    }
+    entry = slot;
+  }
+
+  std::lock_guard<std::mutex> lock(entry->load_mutex);
+  std::shared_ptr<void> model = entry->model.lock();
+  if (model != nullptr) {
+    LOGI("reuse loaded model: %s", key.c_str());
+    return model;
+  }
+  model = loader();
+  if (model != nullptr) {
+    entry->model = model;
+    *created = true;
+  }
+  return model;
+}
+
+size_t NetFactory::getSharedModelNum() {
+  std::lock_guard<std::mutex> lock(g_shared_model_mutex);
+  size_t num = 0;
+  for (auto &kv : g_shared_models) {
+    if (!kv.second->model.expired()) {
+      num++;
+    }
+  }
+  return num;
+}
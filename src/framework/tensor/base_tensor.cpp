@@ -1,13 +1,223 @@
 #include "tensor/base_tensor.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <numeric>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 #include "utils/common_utils.hpp"
 #include "utils/tdl_log.hpp"
+
+namespace {
+
+// 每个线程一次处理的行数, 以及启用多线程的最少像素数
+constexpr int kRowsPerTask = 16;
+constexpr int kMinPixelsPerThread = 128 * 128;
+constexpr int kMaxThreads = 4;
+
+// float -> bf16/fp16, 就近舍入到偶数
+inline uint16_t floatToBf16(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return (uint16_t)((bits + 0x7fff + ((bits >> 16) & 1)) >> 16);
+}
+
+inline uint16_t floatToFp16(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+  uint32_t abs_bits = bits & 0x7fffffff;
+  if (abs_bits >= 0x47800000) {  // |v| >= 65536, 溢出为 inf
+    return sign | (abs_bits > 0x7f800000 ? 0x7e00 : 0x7c00);
+  }
+  if (abs_bits < 0x38800000) {  // |v| < 2^-14, 非规格化数
+    float abs_value;
+    memcpy(&abs_value, &abs_bits, sizeof(abs_value));
+    return sign | (uint16_t)lrintf(abs_value * 16777216.0f);
+  }
+  uint32_t half = (abs_bits - 0x38000000) >> 13;
+  uint32_t rem = abs_bits & 0x1fff;
+  if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) half++;
+  return sign | (uint16_t)half;
+}
+
+template <TDLDataType kType>
+inline void storeScalar(float v, uint8_t* dst, int i) {
+  if (kType == TDLDataType::INT8) {
+    v = std::min(127.f, std::max(-128.f, v));
+    reinterpret_cast<int8_t*>(dst)[i] = (int8_t)lrintf(v);
+  } else if (kType == TDLDataType::UINT8) {
+    v = std::min(255.f, std::max(0.f, v));
+    dst[i] = (uint8_t)lrintf(v);
+  } else if (kType == TDLDataType::FP32) {
+    reinterpret_cast<float*>(dst)[i] = v;
+  } else if (kType == TDLDataType::BF16) {
+    reinterpret_cast<uint16_t*>(dst)[i] = floatToBf16(v);
+  } else {
+    reinterpret_cast<uint16_t*>(dst)[i] = floatToFp16(v);
+  }
+}
+
+// 一行 uint8 转换为目标类型: y = x * scale - mean
+template <TDLDataType kType>
+void convertRow(const uint8_t* src, int n, float scale, float mean,
+                uint8_t* dst) {
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128 vscale = _mm_set1_ps(scale), vmean = _mm_set1_ps(mean);
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16) {
+    __m128i u8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i lo = _mm_unpacklo_epi8(u8, zero);
+    __m128i hi = _mm_unpackhi_epi8(u8, zero);
+    __m128 f[4] = {_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)),
+                   _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)),
+                   _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)),
+                   _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero))};
+    for (int k = 0; k < 4; k++) {
+      f[k] = _mm_sub_ps(_mm_mul_ps(f[k], vscale), vmean);
+    }
+    if (kType == TDLDataType::INT8 || kType == TDLDataType::UINT8) {
+      const bool is_signed = kType == TDLDataType::INT8;
+      const __m128 vmin = _mm_set1_ps(is_signed ? -128.f : 0.f);
+      const __m128 vmax = _mm_set1_ps(is_signed ? 127.f : 255.f);
+      __m128i q[4];
+      for (int k = 0; k < 4; k++) {
+        q[k] = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(f[k], vmin), vmax));
+      }
+      __m128i s16_lo = _mm_packs_epi32(q[0], q[1]);
+      __m128i s16_hi = _mm_packs_epi32(q[2], q[3]);
+      __m128i out = is_signed ? _mm_packs_epi16(s16_lo, s16_hi)
+                              : _mm_packus_epi16(s16_lo, s16_hi);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), out);
+    } else if (kType == TDLDataType::FP32) {
+      float* out = reinterpret_cast<float*>(dst) + i;
+      for (int k = 0; k < 4; k++) _mm_storeu_ps(out + 4 * k, f[k]);
+    } else if (kType == TDLDataType::BF16) {
+      const __m128i bias = _mm_set1_epi32(0x7fff);
+      const __m128i one = _mm_set1_epi32(1);
+      __m128i h[4];
+      for (int k = 0; k < 4; k++) {
+        __m128i bits = _mm_castps_si128(f[k]);
+        __m128i odd = _mm_and_si128(_mm_srli_epi32(bits, 16), one);
+        bits = _mm_add_epi32(bits, _mm_add_epi32(bias, odd));
+        // 高 16 位移到低位并符号扩展, 使 packs 不发生饱和
+        h[k] = _mm_srai_epi32(bits, 16);
+      }
+      __m128i* out = reinterpret_cast<__m128i*>(dst) + i / 8;
+      _mm_storeu_si128(out, _mm_packs_epi32(h[0], h[1]));
+      _mm_storeu_si128(out + 1, _mm_packs_epi32(h[2], h[3]));
+    } else {
+      // SSE2 没有 fp16 转换指令, 只向量化前面的计算
+      alignas(16) float values[16];
+      for (int k = 0; k < 4; k++) _mm_store_ps(values + 4 * k, f[k]);
+      for (int k = 0; k < 16; k++) storeScalar<kType>(values[k], dst, i + k);
+    }
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const float32x4_t vscale = vdupq_n_f32(scale), vmean = vdupq_n_f32(mean);
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t u8 = vld1q_u8(src + i);
+    uint16x8_t lo = vmovl_u8(vget_low_u8(u8));
+    uint16x8_t hi = vmovl_high_u8(u8);
+    float32x4_t f[4] = {vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))),
+                        vcvtq_f32_u32(vmovl_high_u16(lo)),
+                        vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))),
+                        vcvtq_f32_u32(vmovl_high_u16(hi))};
+    for (int k = 0; k < 4; k++) {
+      f[k] = vsubq_f32(vmulq_f32(f[k], vscale), vmean);
+    }
+    if (kType == TDLDataType::INT8 || kType == TDLDataType::UINT8) {
+      int32x4_t q[4];
+      for (int k = 0; k < 4; k++) q[k] = vcvtnq_s32_f32(f[k]);
+      int16x8_t s16_lo = vcombine_s16(vqmovn_s32(q[0]), vqmovn_s32(q[1]));
+      int16x8_t s16_hi = vcombine_s16(vqmovn_s32(q[2]), vqmovn_s32(q[3]));
+      if (kType == TDLDataType::INT8) {
+        vst1q_s8(reinterpret_cast<int8_t*>(dst) + i,
+                 vcombine_s8(vqmovn_s16(s16_lo), vqmovn_s16(s16_hi)));
+      } else {
+        vst1q_u8(dst + i,
+                 vcombine_u8(vqmovun_s16(s16_lo), vqmovun_s16(s16_hi)));
+      }
+    } else if (kType == TDLDataType::FP32) {
+      float* out = reinterpret_cast<float*>(dst) + i;
+      for (int k = 0; k < 4; k++) vst1q_f32(out + 4 * k, f[k]);
+    } else if (kType == TDLDataType::BF16) {
+      uint16_t* out = reinterpret_cast<uint16_t*>(dst) + i;
+      for (int k = 0; k < 4; k++) {
+        uint32x4_t bits = vreinterpretq_u32_f32(f[k]);
+        uint32x4_t odd = vandq_u32(vshrq_n_u32(bits, 16), vdupq_n_u32(1));
+        bits = vaddq_u32(bits, vaddq_u32(vdupq_n_u32(0x7fff), odd));
+        vst1_u16(out + 4 * k, vshrn_n_u32(bits, 16));
+      }
+    } else {
+      uint16_t* out = reinterpret_cast<uint16_t*>(dst) + i;
+      for (int k = 0; k < 4; k++) {
+        vst1_u16(out + 4 * k, vreinterpret_u16_f16(vcvt_f16_f32(f[k])));
+      }
+    }
+  }
+#endif
+  for (; i < n; i++) {
+    storeScalar<kType>(src[i] * scale - mean, dst, i);
+  }
+}
+
+typedef void (*ConvertRowFunc)(const uint8_t*, int, float, float, uint8_t*);
+
+ConvertRowFunc getConvertRowFunc(TDLDataType type) {
+  switch (type) {
+    case TDLDataType::INT8:
+      return convertRow<TDLDataType::INT8>;
+    case TDLDataType::UINT8:
+      return convertRow<TDLDataType::UINT8>;
+    case TDLDataType::FP32:
+      return convertRow<TDLDataType::FP32>;
+    case TDLDataType::BF16:
+      return convertRow<TDLDataType::BF16>;
+    case TDLDataType::FP16:
+      return convertRow<TDLDataType::FP16>;
+    default:
+      return nullptr;
+  }
+}
+
+// packed 三通道的一行拆分为三个连续的通道行
+void deinterleaveRow(const uint8_t* src, int n, uint8_t* c0, uint8_t* c1,
+                     uint8_t* c2) {
+  int i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 16 <= n; i += 16) {
+    uint8x16x3_t v = vld3q_u8(src + 3 * i);
+    vst1q_u8(c0 + i, v.val[0]);
+    vst1q_u8(c1 + i, v.val[1]);
+    vst1q_u8(c2 + i, v.val[2]);
+  }
+#endif
+  for (; i < n; i++) {
+    c0[i] = src[3 * i];
+    c1[i] = src[3 * i + 1];
+    c2[i] = src[3 * i + 2];
+  }
+}
+
+bool isRgbFormat(ImageFormat format) {
+  return format == ImageFormat::RGB_PLANAR || format == ImageFormat::RGB_PACKED;
+}
+
+}  // namespace
+
 BaseTensor::BaseTensor(int element_bytes,
                        std::shared_ptr<BaseMemoryPool> memory_pool)
     : element_bytes_(element_bytes), owns_data_(false) {
@@ -193,20 +403,6 @@ int32_t BaseTensor::copyFromImage(std::shared_ptr<BaseImage> image,
   uint32_t w = getWidth();
   uint32_t h = getHeight();
 
-  LOGI(
-      "copyFromImage, batch_idx:%d,img_stride:[%d,%d,%d], "
-      "batch_bytes:%d,plane_size:%d,w:%d,h:%d,plane_num:%d,src_ptrs:%p,dst_ptr:"
-      "%p",
-      batch_idx, image->getStrides()[0], image->getStrides()[1],
-      image->getStrides()[2], batch_bytes, plane_size, w, h,
-      image->getPlaneNum(), src_ptrs[0], dst_tensor_ptr);
-  LOGI(
-      "tensor "
-      "bytes:%d,memory_block_bytes:%d,memory_start:%p,memory_end:%p,element_"
-      "bytes:%d",
-      getCapacity(), memory_block_->size, memory_block_->virtualAddress,
-      (uint8_t*)(memory_block_->virtualAddress) + memory_block_->size,
-      element_bytes_);
   for (uint32_t i = 0; i < image->getPlaneNum(); i++) {
     uint8_t* src_ptr = src_ptrs[i];
     uint8_t* dst_ptr = dst_tensor_ptr + i * plane_size;
@@ -214,8 +410,6 @@ int32_t BaseTensor::copyFromImage(std::shared_ptr<BaseImage> image,
     if (img_stride_i == w * element_bytes_) {
       memcpy(dst_ptr, src_ptr, plane_size);
     } else {
-      LOGI("plane:%d,src_ptr:%p,dst_ptr:%p,img_stride_i:%d", i, src_ptr,
-           dst_ptr, img_stride_i);
       for (uint32_t j = 0; j < h; j++) {
         uint8_t* src_row_ptr = src_ptr + j * img_stride_i;
         uint8_t* dst_row_ptr = dst_ptr + j * w * element_bytes_;
@@ -227,6 +421,126 @@ int32_t BaseTensor::copyFromImage(std::shared_ptr<BaseImage> image,
   return 0;
 }
 
+int32_t BaseTensor::copyFromImage(std::shared_ptr<BaseImage> image,
+                                  const PreprocessParams& params,
+                                  int batch_idx, float qscale) {
+  if (memory_block_ == nullptr) {
+    LOGE("memory_block_ is nullptr\n");
+    return -1;
+  }
+  if (image->getWidth() != getWidth() || image->getHeight() != getHeight()) {
+    LOGE(
+        "image width(%d) != tensor width(%d) or height(%d) != tensor "
+        "height(%d)\n",
+        image->getWidth(), getWidth(), image->getHeight(), getHeight());
+    return -1;
+  }
+  if (batch_idx < 0 || batch_idx >= shape_[0]) {
+    LOGE("batch_idx(%d) out of range, batch_size(%d)\n", batch_idx,
+         shape_[0]);
+    return -1;
+  }
+  if (image->getPixDataType() != TDLDataType::UINT8) {
+    LOGE("image pix data type(%d) is not uint8\n",
+         (int)image->getPixDataType());
+    return -1;
+  }
+  ConvertRowFunc convert_row = getConvertRowFunc(params.dst_pixdata_type);
+  if (convert_row == nullptr ||
+      (int)CommonUtils::getDataTypeSize(params.dst_pixdata_type) !=
+          element_bytes_) {
+    LOGE("dst pix data type(%d) not supported, element_bytes:%d\n",
+         (int)params.dst_pixdata_type, element_bytes_);
+    return -1;
+  }
+
+  ImageFormat src_format = image->getImageFormat();
+  ImageFormat dst_format = params.dst_image_format;
+  int channels;
+  if (src_format == ImageFormat::GRAY && dst_format == ImageFormat::GRAY) {
+    channels = 1;
+  } else if (src_format != ImageFormat::GRAY &&
+             (dst_format == ImageFormat::RGB_PLANAR ||
+              dst_format == ImageFormat::BGR_PLANAR) &&
+             (isRgbFormat(src_format) ||
+              src_format == ImageFormat::BGR_PLANAR ||
+              src_format == ImageFormat::BGR_PACKED)) {
+    channels = 3;
+  } else {
+    LOGE("image format(%d) to tensor format(%d) not supported\n",
+         (int)src_format, (int)dst_format);
+    return -1;
+  }
+  if (channels != shape_[1]) {
+    LOGE("image channels(%d) != tensor channels(%d)\n", channels, shape_[1]);
+    return -1;
+  }
+
+  const int w = getWidth();
+  const int h = getHeight();
+  const bool packed = channels == 3 && !image->isPlanar();
+  const bool swap_rb = channels == 3 && isRgbFormat(src_format) !=
+                                            isRgbFormat(dst_format);
+  std::vector<uint8_t*> src_ptrs = image->getVirtualAddress();
+  std::vector<uint32_t> strides = image->getStrides();
+  size_t plane_num = packed ? 1 : channels;
+  if (src_ptrs.size() < plane_num || strides.size() < plane_num) {
+    LOGE("image plane num(%d) < %d\n", (int)src_ptrs.size(), (int)plane_num);
+    return -1;
+  }
+  float scales[3], means[3];
+  for (int c = 0; c < channels; c++) {
+    scales[c] = params.scale[c] * qscale;
+    means[c] = params.mean[c] * qscale;
+  }
+  const size_t plane_bytes = (size_t)w * h * element_bytes_;
+  uint8_t* dst_batch = static_cast<uint8_t*>(memory_block_->virtualAddress) +
+                       batch_idx * plane_bytes * channels;
+
+  // 按行分块, 多个线程从同一个计数器领取
+  std::atomic<int> next_row(0);
+  auto worker = [&]() {
+    std::vector<uint8_t> row_buffer(packed ? 3 * w : 0);
+    for (int y0 = next_row.fetch_add(kRowsPerTask); y0 < h;
+         y0 = next_row.fetch_add(kRowsPerTask)) {
+      int y1 = std::min(h, y0 + kRowsPerTask);
+      for (int y = y0; y < y1; y++) {
+        const uint8_t* rows[3];
+        if (packed) {
+          deinterleaveRow(src_ptrs[0] + (size_t)y * strides[0], w,
+                          row_buffer.data(), row_buffer.data() + w,
+                          row_buffer.data() + 2 * w);
+          for (int c = 0; c < 3; c++) rows[c] = row_buffer.data() + c * w;
+        } else {
+          for (int c = 0; c < channels; c++) {
+            rows[c] = src_ptrs[c] + (size_t)y * strides[c];
+          }
+        }
+        for (int c = 0; c < channels; c++) {
+          int src_c = swap_rb ? 2 - c : c;
+          uint8_t* dst = dst_batch + c * plane_bytes +
+                         (size_t)y * w * element_bytes_;
+          convert_row(rows[src_c], w, scales[c], means[c], dst);
+        }
+      }
+    }
+  };
+
+  int num_threads = std::min(
+      {kMaxThreads, (w * h) / kMinPixelsPerThread,
+       (h + kRowsPerTask - 1) / kRowsPerTask,
+       std::max(1, (int)std::thread::hardware_concurrency())});
+  std::vector<std::thread> workers;
+  for (int i = 1; i < num_threads; i++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto& t : workers) {
+    t.join();
+  }
+  return 0;
+}
+
 int32_t BaseTensor::release() {
   if (memory_block_ != nullptr && memory_block_->own_memory &&
       memory_pool_ != nullptr) {
@@ -1,6 +1,19 @@
 #include "utils/frame_dump.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+#include "utils/common_utils.hpp"
 #include "utils/tdl_log.hpp"
 
+#if defined(__CV181X__) || defined(__CV180X__) || defined(__CV184X__) || \
+    defined(__CV186X__)
 int32_t FrameDump::saveFrame(char *filename,
                              VIDEO_FRAME_INFO_S *pstVideoFrame) {
   CVI_S32 s32Ret = CVI_SUCCESS;
@@ -51,4 +64,477 @@ int32_t FrameDump::saveFrame(char *filename,
 
   fclose(fp);
   return s32Ret;
-}
\ No newline at end of file
+}
+#endif
+
+namespace {
+
+// O_DIRECT needs aligned buffers, offsets and sizes
+constexpr size_t kDirectAlign = 4096;
+constexpr size_t kStagingCapacity = 256 * kDirectAlign;
+
+uint64_t nowNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+// Rows and row bytes of every plane without stride padding, returns the
+// plane number, 0 if the format is not supported
+uint32_t getPlaneLayout(const std::shared_ptr<BaseImage> &image,
+                        uint32_t rows[3], uint32_t row_bytes[3]) {
+  uint32_t w = image->getWidth();
+  uint32_t h = image->getHeight();
+  uint32_t pix = CommonUtils::getDataTypeSize(image->getPixDataType());
+  if (image->getImageType() == ImageType::RAW_FRAME) {
+    rows[0] = 1;
+    row_bytes[0] = image->getImageByteSize();
+    return 1;
+  }
+  switch (image->getImageFormat()) {
+    case ImageFormat::GRAY:
+      rows[0] = h;
+      row_bytes[0] = w * pix;
+      return 1;
+    case ImageFormat::RGB_PACKED:
+    case ImageFormat::BGR_PACKED:
+      rows[0] = h;
+      row_bytes[0] = 3 * w * pix;
+      return 1;
+    case ImageFormat::RGB_PLANAR:
+    case ImageFormat::BGR_PLANAR:
+      for (int i = 0; i < 3; i++) {
+        rows[i] = h;
+        row_bytes[i] = w * pix;
+      }
+      return 3;
+    case ImageFormat::YUV420SP_UV:
+    case ImageFormat::YUV420SP_VU:
+    case ImageFormat::YUV422SP_UV:
+    case ImageFormat::YUV422SP_VU: {
+      bool is_420 = image->getImageFormat() == ImageFormat::YUV420SP_UV ||
+                    image->getImageFormat() == ImageFormat::YUV420SP_VU;
+      rows[0] = h;
+      row_bytes[0] = w * pix;
+      rows[1] = is_420 ? h / 2 : h;
+      row_bytes[1] = w / 2 * 2 * pix;
+      return 2;
+    }
+    case ImageFormat::YUV420P_UV:
+    case ImageFormat::YUV420P_VU:
+    case ImageFormat::YUV422P_UV:
+    case ImageFormat::YUV422P_VU: {
+      bool is_420 = image->getImageFormat() == ImageFormat::YUV420P_UV ||
+                    image->getImageFormat() == ImageFormat::YUV420P_VU;
+      rows[0] = h;
+      row_bytes[0] = w * pix;
+      for (int i = 1; i < 3; i++) {
+        rows[i] = is_420 ? h / 2 : h;
+        row_bytes[i] = w / 2 * pix;
+      }
+      return 3;
+    }
+    default:
+      return 0;
+  }
+}
+
+}  // namespace
+
+void FrameDumper::IndexQueue::init(uint32_t capacity) {
+  uint64_t size = 1;
+  while (size < capacity) size <<= 1;
+  cells_.reset(new Cell[size]);
+  for (uint64_t i = 0; i < size; i++) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  mask_ = size - 1;
+  head_.store(0, std::memory_order_relaxed);
+  tail_.store(0, std::memory_order_relaxed);
+}
+
+bool FrameDumper::IndexQueue::push(uint32_t value) {
+  uint64_t pos = tail_.load(std::memory_order_relaxed);
+  while (true) {
+    Cell &cell = cells_[pos & mask_];
+    uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+    int64_t diff = (int64_t)(sequence - pos);
+    if (diff == 0) {
+      if (tail_.compare_exchange_weak(pos, pos + 1,
+                                      std::memory_order_relaxed)) {
+        cell.value = value;
+        cell.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      return false;  // full
+    } else {
+      pos = tail_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool FrameDumper::IndexQueue::pop(uint32_t &value) {
+  uint64_t pos = head_.load(std::memory_order_relaxed);
+  while (true) {
+    Cell &cell = cells_[pos & mask_];
+    uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+    int64_t diff = (int64_t)(sequence - (pos + 1));
+    if (diff == 0) {
+      if (head_.compare_exchange_weak(pos, pos + 1,
+                                      std::memory_order_relaxed)) {
+        value = cell.value;
+        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      return false;  // empty
+    } else {
+      pos = head_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+FrameDumper::FrameDumper() {}
+
+FrameDumper::~FrameDumper() { stop(); }
+
+int32_t FrameDumper::start(const FrameDumpConfig &config) {
+  if (running_.load()) {
+    LOGE("frame dumper is already running");
+    return -1;
+  }
+  if (config.file_path.empty() || config.queue_size == 0) {
+    LOGE("invalid frame dump config, file_path:%s, queue_size:%u",
+         config.file_path.c_str(), config.queue_size);
+    return -1;
+  }
+  config_ = config;
+
+  int flags = O_WRONLY | O_CREAT | O_TRUNC;
+  direct_io_ = false;
+#ifdef O_DIRECT
+  if (config_.direct_io) {
+    fd_ = open(config_.file_path.c_str(), flags | O_DIRECT, 0644);
+    direct_io_ = fd_ >= 0;
+    if (fd_ < 0) {
+      LOGW("open %s with O_DIRECT failed(%s), use buffered io",
+           config_.file_path.c_str(), strerror(errno));
+    }
+  }
+#endif
+  if (fd_ < 0) {
+    fd_ = open(config_.file_path.c_str(), flags, 0644);
+  }
+  if (fd_ < 0) {
+    LOGE("open %s failed: %s", config_.file_path.c_str(), strerror(errno));
+    return -1;
+  }
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+  if (config_.preallocate_bytes > 0 &&
+      fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0,
+                (off_t)config_.preallocate_bytes) != 0) {
+    LOGW("fallocate %" PRIu64 " bytes failed: %s",
+         config_.preallocate_bytes, strerror(errno));
+  }
+#endif
+  if (posix_memalign(reinterpret_cast<void **>(&staging_), kDirectAlign,
+                     kStagingCapacity) != 0) {
+    LOGE("allocate staging buffer failed");
+    close(fd_);
+    fd_ = -1;
+    return -1;
+  }
+  staging_size_ = 0;
+  file_size_ = 0;
+
+  buffers_.resize(config_.queue_size);
+  free_queue_.init(config_.queue_size);
+  ready_queue_.init(config_.queue_size);
+  for (uint32_t i = 0; i < config_.queue_size; i++) {
+    free_queue_.push(i);
+  }
+  frame_counter_.store(0);
+  trigger_frames_.store(0);
+  written_frames_.store(0);
+  dropped_frames_.store(0);
+  y4m_fixed_ = false;
+
+  running_.store(true);
+  writer_ = std::thread(&FrameDumper::writerLoop, this);
+  return 0;
+}
+
+int32_t FrameDumper::stop() {
+  if (!running_.exchange(false)) {
+    return 0;
+  }
+  wake_cond_.notify_one();
+  writer_.join();
+  int32_t ret = flushStaging(true);
+  close(fd_);
+  fd_ = -1;
+  free(staging_);
+  staging_ = nullptr;
+  LOGI("frame dump %s done, written:%" PRIu64 ", dropped:%" PRIu64,
+       config_.file_path.c_str(), written_frames_.load(),
+       dropped_frames_.load());
+  return ret;
+}
+
+void FrameDumper::trigger(uint32_t frame_num) {
+  trigger_frames_.fetch_add(frame_num);
+}
+
+void FrameDumper::setTimeWindow(uint64_t start_ns, uint64_t end_ns) {
+  window_start_ns_.store(start_ns);
+  window_end_ns_.store(end_ns);
+}
+
+bool FrameDumper::pickFrame(uint64_t frame_index, uint64_t now_ns) {
+  uint32_t triggered = trigger_frames_.load(std::memory_order_relaxed);
+  while (triggered > 0) {
+    if (trigger_frames_.compare_exchange_weak(triggered, triggered - 1)) {
+      return true;
+    }
+  }
+  if (now_ns >= window_start_ns_.load(std::memory_order_relaxed) &&
+      now_ns < window_end_ns_.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  return config_.every_n > 0 && frame_index % config_.every_n == 0;
+}
+
+int32_t FrameDumper::checkY4mFrame(const FrameDumpRawHeader &header) {
+  ImageFormat format = static_cast<ImageFormat>(header.image_format);
+  if (format != ImageFormat::GRAY && format != ImageFormat::YUV420SP_UV &&
+      format != ImageFormat::YUV420SP_VU &&
+      format != ImageFormat::YUV420P_UV && format != ImageFormat::YUV420P_VU) {
+    LOGE("image format %d can not be written to y4m", (int)format);
+    return -1;
+  }
+  if (header.pix_data_type != (uint32_t)TDLDataType::UINT8 ||
+      header.width % 2 != 0 || header.height % 2 != 0) {
+    LOGE("y4m needs uint8 image with even size, got %ux%u, type %u",
+         header.width, header.height, header.pix_data_type);
+    return -1;
+  }
+  std::lock_guard<std::mutex> lock(y4m_mutex_);
+  if (!y4m_fixed_) {
+    y4m_header_ = header;
+    y4m_fixed_ = true;
+    return 0;
+  }
+  bool is_gray = format == ImageFormat::GRAY;
+  bool first_gray =
+      y4m_header_.image_format == (uint32_t)ImageFormat::GRAY;
+  if (header.width != y4m_header_.width ||
+      header.height != y4m_header_.height || is_gray != first_gray) {
+    LOGE("y4m frame %ux%u does not match the stream %ux%u", header.width,
+         header.height, y4m_header_.width, y4m_header_.height);
+    return -1;
+  }
+  return 0;
+}
+
+int32_t FrameDumper::submit(const std::shared_ptr<BaseImage> &image) {
+  if (!running_.load(std::memory_order_relaxed) || image == nullptr) {
+    return -1;
+  }
+  uint64_t frame_index = frame_counter_.fetch_add(1);
+  uint64_t now_ns = nowNs();
+  if (!pickFrame(frame_index, now_ns)) {
+    return 1;
+  }
+
+  FrameDumpRawHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, "TDLF", 4);
+  header.header_size = sizeof(header);
+  header.width = image->getWidth();
+  header.height = image->getHeight();
+  header.image_format = (uint32_t)image->getImageFormat();
+  header.pix_data_type = (uint32_t)image->getPixDataType();
+  header.frame_index = frame_index;
+  header.timestamp_ns = now_ns;
+  uint32_t rows[3], row_bytes[3];
+  header.plane_num = getPlaneLayout(image, rows, row_bytes);
+  std::vector<uint8_t *> addrs = image->getVirtualAddress();
+  std::vector<uint32_t> strides = image->getStrides();
+  if (header.plane_num == 0 || addrs.size() < header.plane_num ||
+      strides.size() < header.plane_num) {
+    LOGE("image format %d is not supported by frame dump",
+         header.image_format);
+    dropped_frames_.fetch_add(1);
+    return -1;
+  }
+  size_t total_bytes = 0;
+  for (uint32_t i = 0; i < header.plane_num; i++) {
+    header.plane_bytes[i] = rows[i] * row_bytes[i];
+    total_bytes += header.plane_bytes[i];
+  }
+  if (config_.format == FrameDumpFormat::Y4M && checkY4mFrame(header) != 0) {
+    dropped_frames_.fetch_add(1);
+    return -1;
+  }
+
+  uint32_t slot;
+  if (!free_queue_.pop(slot)) {
+    dropped_frames_.fetch_add(1);
+    return -1;
+  }
+  FrameBuffer &buffer = buffers_[slot];
+  buffer.header = header;
+  if (buffer.data.size() < total_bytes) {
+    buffer.data.resize(total_bytes);
+  }
+  image->invalidateCache();
+  uint8_t *dst = buffer.data.data();
+  for (uint32_t i = 0; i < header.plane_num; i++) {
+    const uint8_t *src = addrs[i];
+    if (row_bytes[i] == strides[i] || rows[i] == 1) {
+      memcpy(dst, src, header.plane_bytes[i]);
+      dst += header.plane_bytes[i];
+      continue;
+    }
+    for (uint32_t r = 0; r < rows[i]; r++) {
+      memcpy(dst, src + (size_t)r * strides[i], row_bytes[i]);
+      dst += row_bytes[i];
+    }
+  }
+  ready_queue_.push(slot);
+  wake_cond_.notify_one();
+  return 0;
+}
+
+void FrameDumper::writerLoop() {
+  while (true) {
+    // read the flag first, frames queued before stop() are still written
+    bool stopping = !running_.load();
+    uint32_t slot;
+    if (ready_queue_.pop(slot)) {
+      if (writeFrame(buffers_[slot]) == 0) {
+        written_frames_.fetch_add(1);
+      } else {
+        dropped_frames_.fetch_add(1);
+      }
+      free_queue_.push(slot);
+      continue;
+    }
+    if (stopping) {
+      break;
+    }
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_cond_.wait_for(lock, std::chrono::milliseconds(10));
+  }
+}
+
+int32_t FrameDumper::writeFrame(const FrameBuffer &frame) {
+  const FrameDumpRawHeader &header = frame.header;
+  if (config_.format == FrameDumpFormat::RAW) {
+    if (append(reinterpret_cast<const uint8_t *>(&header), sizeof(header)) !=
+        0) {
+      return -1;
+    }
+    size_t total_bytes = 0;
+    for (uint32_t i = 0; i < header.plane_num; i++) {
+      total_bytes += header.plane_bytes[i];
+    }
+    return append(frame.data.data(), total_bytes);
+  }
+
+  ImageFormat format = static_cast<ImageFormat>(header.image_format);
+  bool is_gray = format == ImageFormat::GRAY;
+  if (file_size_ == 0 && staging_size_ == 0) {
+    char stream_header[128];
+    int len = snprintf(stream_header, sizeof(stream_header),
+                       "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C%s\n", header.width,
+                       header.height, config_.fps,
+                       is_gray ? "mono" : "420jpeg");
+    if (append(reinterpret_cast<const uint8_t *>(stream_header), len) != 0) {
+      return -1;
+    }
+  }
+  static const char kFrameTag[] = "FRAME\n";
+  if (append(reinterpret_cast<const uint8_t *>(kFrameTag),
+             sizeof(kFrameTag) - 1) != 0) {
+    return -1;
+  }
+  const uint8_t *y = frame.data.data();
+  if (append(y, header.plane_bytes[0]) != 0) {
+    return -1;
+  }
+  if (is_gray) {
+    return 0;
+  }
+  const uint8_t *chroma = y + header.plane_bytes[0];
+  size_t chroma_bytes = (size_t)(header.width / 2) * (header.height / 2);
+  if (format == ImageFormat::YUV420P_UV || format == ImageFormat::YUV420P_VU) {
+    const uint8_t *u = chroma, *v = chroma + chroma_bytes;
+    if (format == ImageFormat::YUV420P_VU) std::swap(u, v);
+    return append(u, chroma_bytes) == 0 && append(v, chroma_bytes) == 0 ? 0
+                                                                        : -1;
+  }
+  // semi-planar: split the interleaved plane into U and V
+  plane_buffer_.resize(2 * chroma_bytes);
+  uint8_t *u = plane_buffer_.data(), *v = u + chroma_bytes;
+  if (format == ImageFormat::YUV420SP_VU) std::swap(u, v);
+  for (size_t i = 0; i < chroma_bytes; i++) {
+    u[i] = chroma[2 * i];
+    v[i] = chroma[2 * i + 1];
+  }
+  return append(plane_buffer_.data(), 2 * chroma_bytes);
+}
+
+int32_t FrameDumper::append(const uint8_t *data, size_t size) {
+  while (size > 0) {
+    size_t n = std::min(size, kStagingCapacity - staging_size_);
+    memcpy(staging_ + staging_size_, data, n);
+    staging_size_ += n;
+    data += n;
+    size -= n;
+    if (staging_size_ == kStagingCapacity && flushStaging(false) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int32_t FrameDumper::flushStaging(bool final_block) {
+  size_t size = staging_size_;
+  size_t write_size = size;
+  if (direct_io_ && final_block && size % kDirectAlign != 0) {
+    // pad the last block, the file is truncated to the real size below
+    write_size = (size + kDirectAlign - 1) / kDirectAlign * kDirectAlign;
+    memset(staging_ + size, 0, write_size - size);
+  }
+  size_t offset = 0;
+  while (offset < write_size) {
+    ssize_t n = write(fd_, staging_ + offset, write_size - offset);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+#ifdef O_DIRECT
+      if (errno == EINVAL && direct_io_) {
+        // the file system rejects O_DIRECT writes, continue buffered
+        LOGW("O_DIRECT write not supported, use buffered io");
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_DIRECT);
+        direct_io_ = false;
+        write_size = size;
+        continue;
+      }
+#endif
+      LOGE("write frame dump failed: %s", strerror(errno));
+      staging_size_ = 0;
+      return -1;
+    }
+    offset += n;
+  }
+  file_size_ += size;
+  staging_size_ = 0;
+  if (write_size != size && ftruncate(fd_, (off_t)file_size_) != 0) {
+    LOGE("truncate frame dump failed: %s", strerror(errno));
+    return -1;
+  }
+  return 0;
+}
@@ -1,13 +1,18 @@
 #include "utils/image_alignment.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <vector>
 
-#include "Eigen/Core"
-#include "Eigen/Dense"
 #include "utils/tdl_log.hpp"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #define EXT_FUNCTION 0
 #undef SHRT_MIN
 #define SHRT_MIN -32768
@@ -641,45 +646,59 @@ void tdl_warp_affine(const unsigned char *src_data,
 
 /**
  * Solve similarity transform matrix (no reflection)
+ * 最小二乘的闭式解, 关键点去中心后:
+ * cosθ = Σ(sx * dx + sy * dy) / Σ(sx^2 + sy^2)
+ * sinθ = Σ(sy * dx - sx * dy) / Σ(sx^2 + sy^2)
  */
-Eigen::Matrix<float, 4, 1> solve_stm_no_reflection(const float *src_pts,
-                                                   const float *dst_pts,
-                                                   int num_points,
-                                                   float *distance) {
-  Eigen::MatrixXf A(2 * num_points, 4);
-  Eigen::VectorXf b(2 * num_points);
+static void solve_stm_no_reflection(const float *src_pts, const float *dst_pts,
+                                    int num_points, float *stm,
+                                    float *distance) {
+  double src_mx = 0, src_my = 0, dst_mx = 0, dst_my = 0;
+  for (int i = 0; i < num_points; ++i) {
+    src_mx += src_pts[2 * i];
+    src_my += src_pts[2 * i + 1];
+    dst_mx += dst_pts[2 * i];
+    dst_my += dst_pts[2 * i + 1];
+  }
+  if (num_points > 0) {
+    src_mx /= num_points;
+    src_my /= num_points;
+    dst_mx /= num_points;
+    dst_my /= num_points;
+  }
 
+  double num_a = 0, num_b = 0, den = 0;
   for (int i = 0; i < num_points; ++i) {
-    float sx = src_pts[2 * i];
-    float sy = src_pts[2 * i + 1];
-    float dx = dst_pts[2 * i];
-    float dy = dst_pts[2 * i + 1];
-
-    // 上半部分
-    A(i, 0) = sx;
-    A(i, 1) = sy;
-    A(i, 2) = 1.0f;
-    A(i, 3) = 0.0f;
-    b(i) = dx;
-
-    // 下半部分
-    A(i + num_points, 0) = sy;
-    A(i + num_points, 1) = -sx;
-    A(i + num_points, 2) = 0.0f;
-    A(i + num_points, 3) = 1.0f;
-    b(i + num_points) = dy;
+    double sx = src_pts[2 * i] - src_mx;
+    double sy = src_pts[2 * i + 1] - src_my;
+    double dx = dst_pts[2 * i] - dst_mx;
+    double dy = dst_pts[2 * i + 1] - dst_my;
+    num_a += sx * dx + sy * dy;
+    num_b += sy * dx - sx * dy;
+    den += sx * sx + sy * sy;
   }
+  double a = den > 0 ? num_a / den : 0;
+  double b = den > 0 ? num_b / den : 0;
+  double tx = dst_mx - a * src_mx - b * src_my;
+  double ty = dst_my - a * src_my + b * src_mx;
 
-  // 2. 求解最小二乘问题 x = (A^T A)^-1 A^T b
-  //    也可以用 QR/SVD 等分解
-  Eigen::Vector4f x = (A.transpose() * A).ldlt().solve(A.transpose() * b);
+  // [cosθ, sinθ, tx, ty]
+  stm[0] = static_cast<float>(a);
+  stm[1] = static_cast<float>(b);
+  stm[2] = static_cast<float>(tx);
+  stm[3] = static_cast<float>(ty);
 
-  // 3. 可选：计算残差 (A*x - b).squaredNorm()
   if (distance != nullptr) {
-    *distance = (A * x - b).squaredNorm();
+    double sum = 0;
+    for (int i = 0; i < num_points; ++i) {
+      double sx = src_pts[2 * i];
+      double sy = src_pts[2 * i + 1];
+      double ex = a * sx + b * sy + tx - dst_pts[2 * i];
+      double ey = a * sy - b * sx + ty - dst_pts[2 * i + 1];
+      sum += ex * ex + ey * ey;
+    }
+    *distance = static_cast<float>(sum);
   }
-
-  return x;  // [cosθ, sinθ, tx, ty]
 }
 
 int tdl_get_similarity_transform_matrix(const float *src_pts_xy,
@@ -689,10 +708,9 @@ int tdl_get_similarity_transform_matrix(const float *src_pts_xy,
   //   LOGE("get_similarity_transform_matrix num_points must be greater than
   //   5"); return -1;
   // }
-  float d_0;
   // [cosθ, sinθ, tx, ty]
-  Eigen::Matrix<float, 4, 1> stm =
-      solve_stm_no_reflection(src_pts_xy, dst_pts_xy, num_points, &d_0);
+  float stm[4];
+  solve_stm_no_reflection(src_pts_xy, dst_pts_xy, num_points, stm, nullptr);
 
   transform[0] = stm[0];
   transform[1] = stm[1];
@@ -703,45 +721,45 @@ int tdl_get_similarity_transform_matrix(const float *src_pts_xy,
   return 0;
 }
 
+static const float kFaceReferPts96[10] = {
+    30.29459953, 51.69630051, 65.53179932, 51.50139999, 48.02519989,
+    71.73660278, 33.54930115, 92.3655014,  62.72990036, 92.20410156};
+// {38.4066, 51.5989, 73.6438, 51.5989, 56.0252,
+//  71.7366, 41.4349, 92.2848, 70.6155, 92.2848};
+static const float kFaceReferPts112[10] = {
+    38.29459953, 51.69630051, 73.53179932, 51.50139999, 56.02519989,
+    71.73660278, 41.54930115, 92.3655014,  70.72990036, 92.20410156};
+static const float kFaceReferPts64[10] = {
+    21.88262830, 29.53926611, 42.01607013, 29.42789995, 32.01279921,
+    40.99029482, 23.74127067, 45.7776475,  40.41506506, 45.68542363};
+static const float kLicensePlateReferPts[8] = {0.0,  0.0,  96.0, 0.0,
+                                               96.0, 24.0, 0.0,  24.0};
+
 int get_face_transform(const float *landmark_pts, const int width,
                        float *transform) {
   assert(width == 96 || width == 112 || width == 64);
   // assert(height == 112 || (width == 64 && height == 64));
 
-  // int ref_width = width;
-
-  std::vector<float> refer_pts;
+  const float *refer_pts = nullptr;
   if (96 == width) {
-    refer_pts = {30.29459953, 51.69630051, 65.53179932, 51.50139999,
-                 48.02519989, 71.73660278, 33.54930115, 92.3655014,
-                 62.72990036, 92.20410156};
+    refer_pts = kFaceReferPts96;
   } else if (112 == width) {
-    // refer_pts = {38.4066, 51.5989, 73.6438, 51.5989, 56.0252,
-    //              71.7366, 41.4349, 92.2848, 70.6155, 92.2848};
-    refer_pts = {38.29459953, 51.69630051, 73.53179932, 51.50139999,
-                 56.02519989, 71.73660278, 41.54930115, 92.3655014,
-                 70.72990036, 92.20410156};
+    refer_pts = kFaceReferPts112;
   } else if (64 == width) {
-    refer_pts = {21.88262830, 29.53926611, 42.01607013, 29.42789995,
-                 32.01279921, 40.99029482, 23.74127067, 45.7776475,
-                 40.41506506, 45.68542363};
+    refer_pts = kFaceReferPts64;
   } else {
     LOGE("unsupported face image width: %d", width);
     return -1;
   }
 
-  int ret = tdl_get_similarity_transform_matrix(landmark_pts, &refer_pts[0], 5,
+  int ret = tdl_get_similarity_transform_matrix(landmark_pts, refer_pts, 5,
                                                 transform);
   return ret;
 }
 
 int get_license_plate_transform(const float *landmark_pts, float *transform) {
-  std::vector<float> refer_pts;
-
-  refer_pts = {0.0, 0.0, 96.0, 0.0, 96.0, 24.0, 0.0, 24.0};
-
-  int ret = tdl_get_similarity_transform_matrix(landmark_pts, &refer_pts[0], 4,
-                                                transform);
+  int ret = tdl_get_similarity_transform_matrix(
+      landmark_pts, kLicensePlateReferPts, 4, transform);
   return ret;
 }
 
@@ -842,30 +860,222 @@ int32_t tdl_warp_affine_opencv(const unsigned char *src_data,
 }
 #endif
 
+/************** bilinear warp for face/plate alignment ***************/
+// 与 cv::warpAffine(INTER_LINEAR, BORDER_CONSTANT) 相同的定点方式: 源坐标
+// 取 10 位小数再舍入到 5 位, 四个插值权重为 5 位小数之积, 和恰为 1024.
+// 只处理三通道 8 位输出, 输出尺寸较小 (人脸 112x112, 车牌 96x24),
+// 每个输出像素一次完成取样与插值.
+
+static const int kWarpCoordBits = 10;
+static const int kWarpWeightBits = INTER_BITS * 2;
+static const int kWarpStackWidth = 256;
+
+// BT.601 YUV -> RGB, 与 cv::cvtColor(COLOR_YUV2RGB_NV12/NV21) 一致
+static const int kYuvShift = 20;
+static const int kYuvCY = 1220542;
+static const int kYuvCUB = 2116026;
+static const int kYuvCUG = -409993;
+static const int kYuvCVG = -852492;
+static const int kYuvCVR = 1673527;
+
+static inline void blendC3(const uchar *p00, const uchar *p01,
+                           const uchar *p10, const uchar *p11, int ax, int ay,
+                           uchar *dst) {
+  int w00 = (INTER_TAB_SIZE - ax) * (INTER_TAB_SIZE - ay);
+  int w01 = ax * (INTER_TAB_SIZE - ay);
+  int w10 = (INTER_TAB_SIZE - ax) * ay;
+  int w11 = ax * ay;
+  const int round = 1 << (kWarpWeightBits - 1);
+  for (int c = 0; c < 3; c++) {
+    dst[c] = (uchar)((p00[c] * w00 + p01[c] * w01 + p10[c] * w10 +
+                      p11[c] * w11 + round) >>
+                     kWarpWeightBits);
+  }
+}
+
+// RGB/BGR packed source
+struct PackedC3Sampler {
+  const uchar *data;
+  int step;
+  int width;
+  int height;
+
+  void fetch(int x, int y, uchar *pixel) const {
+    const uchar *p = data + y * step + x * 3;
+    pixel[0] = p[0];
+    pixel[1] = p[1];
+    pixel[2] = p[2];
+  }
+
+  // (sx, sy) 与 (sx + 1, sy + 1) 都在图像内
+  void interpolate(int sx, int sy, int ax, int ay, uchar *dst) const {
+    const uchar *p = data + sy * step + sx * 3;
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    // 每行从 p 与 p + 3 各读 8 字节, 距行尾至少 4 个像素时不会越界
+    if (sx + 4 <= width) {
+      int w00 = (INTER_TAB_SIZE - ax) * (INTER_TAB_SIZE - ay);
+      int w01 = ax * (INTER_TAB_SIZE - ay);
+      int w10 = (INTER_TAB_SIZE - ax) * ay;
+      int w11 = ax * ay;
+#if defined(__SSE2__)
+      const __m128i zero = _mm_setzero_si128();
+      // [p00.c0, p01.c0, p00.c1, p01.c1, p00.c2, p01.c2, ...]
+      __m128i top = _mm_unpacklo_epi16(
+          _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)p), zero),
+          _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(p + 3)), zero));
+      __m128i bottom = _mm_unpacklo_epi16(
+          _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(p + step)),
+                            zero),
+          _mm_unpacklo_epi8(
+              _mm_loadl_epi64((const __m128i *)(p + step + 3)), zero));
+      __m128i sum = _mm_add_epi32(
+          _mm_madd_epi16(top, _mm_set1_epi32((w01 << 16) | w00)),
+          _mm_madd_epi16(bottom, _mm_set1_epi32((w11 << 16) | w10)));
+      sum = _mm_srai_epi32(
+          _mm_add_epi32(sum, _mm_set1_epi32(1 << (kWarpWeightBits - 1))),
+          kWarpWeightBits);
+      sum = _mm_packs_epi32(sum, sum);
+      uint32_t value = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+      dst[0] = (uchar)value;
+      dst[1] = (uchar)(value >> 8);
+      dst[2] = (uchar)(value >> 16);
+#else
+      uint32x4_t sum =
+          vmull_n_u16(vget_low_u16(vmovl_u8(vld1_u8(p))), (uint16_t)w00);
+      sum = vmlal_n_u16(sum, vget_low_u16(vmovl_u8(vld1_u8(p + 3))),
+                        (uint16_t)w01);
+      sum = vmlal_n_u16(sum, vget_low_u16(vmovl_u8(vld1_u8(p + step))),
+                        (uint16_t)w10);
+      sum = vmlal_n_u16(sum, vget_low_u16(vmovl_u8(vld1_u8(p + step + 3))),
+                        (uint16_t)w11);
+      uint16x4_t value = vrshrn_n_u32(sum, kWarpWeightBits);
+      dst[0] = (uchar)vget_lane_u16(value, 0);
+      dst[1] = (uchar)vget_lane_u16(value, 1);
+      dst[2] = (uchar)vget_lane_u16(value, 2);
+#endif
+      return;
+    }
+#endif
+    blendC3(p, p + 3, p + step, p + step + 3, ax, ay, dst);
+  }
+};
+
+// YUV420SP (NV12/NV21) source, 输出 RGB packed
+struct Yuv420spSampler {
+  const uchar *y_data;
+  int y_step;
+  const uchar *uv_data;
+  int uv_step;
+  int u_index;  // 0: NV12, 1: NV21
+  int width;
+  int height;
+
+  void fetch(int x, int y, uchar *pixel) const {
+    const uchar *uv = uv_data + (y >> 1) * uv_step + (x & ~1);
+    int u = uv[u_index] - 128;
+    int v = uv[u_index ^ 1] - 128;
+    int yy = std::max(0, y_data[y * y_step + x] - 16) * kYuvCY;
+    const int round = 1 << (kYuvShift - 1);
+    pixel[0] = saturate_cast_uchar((yy + round + kYuvCVR * v) >> kYuvShift);
+    pixel[1] = saturate_cast_uchar(
+        (yy + round + kYuvCVG * v + kYuvCUG * u) >> kYuvShift);
+    pixel[2] = saturate_cast_uchar((yy + round + kYuvCUB * u) >> kYuvShift);
+  }
+
+  void interpolate(int sx, int sy, int ax, int ay, uchar *dst) const {
+    uchar p[4][3];
+    fetch(sx, sy, p[0]);
+    fetch(sx + 1, sy, p[1]);
+    fetch(sx, sy + 1, p[2]);
+    fetch(sx + 1, sy + 1, p[3]);
+    blendC3(p[0], p[1], p[2], p[3], ax, ay, dst);
+  }
+};
+
+// M 为 dst -> src 的逆变换
+template <typename Sampler>
+static void warp_affine_bilinear_c3(const Sampler &src, const double *M,
+                                    uchar *dst_data, int dst_step,
+                                    int dst_width, int dst_height) {
+  const int ab_scale = 1 << kWarpCoordBits;
+  const int round_delta = ab_scale / INTER_TAB_SIZE / 2;
+  int delta_buf[kWarpStackWidth * 2];
+  std::vector<int> delta_heap;
+  int *adelta = delta_buf;
+  if (dst_width > kWarpStackWidth) {
+    delta_heap.resize(dst_width * 2);
+    adelta = delta_heap.data();
+  }
+  int *bdelta = adelta + dst_width;
+  for (int x = 0; x < dst_width; x++) {
+    adelta[x] = cv_round_src(M[0] * x * ab_scale);
+    bdelta[x] = cv_round_src(M[3] * x * ab_scale);
+  }
+
+  for (int y = 0; y < dst_height; y++) {
+    int X0 = cv_round_src((M[1] * y + M[2]) * ab_scale) + round_delta;
+    int Y0 = cv_round_src((M[4] * y + M[5]) * ab_scale) + round_delta;
+    uchar *d = dst_data + y * dst_step;
+    for (int x = 0; x < dst_width; x++, d += 3) {
+      int X = (X0 + adelta[x]) >> (kWarpCoordBits - INTER_BITS);
+      int Y = (Y0 + bdelta[x]) >> (kWarpCoordBits - INTER_BITS);
+      int sx = X >> INTER_BITS;
+      int sy = Y >> INTER_BITS;
+      int ax = X & (INTER_TAB_SIZE - 1);
+      int ay = Y & (INTER_TAB_SIZE - 1);
+      if ((unsigned)sx < (unsigned)(src.width - 1) &&
+          (unsigned)sy < (unsigned)(src.height - 1)) {
+        src.interpolate(sx, sy, ax, ay, d);
+        continue;
+      }
+      // 边界: 图像外的邻点取 0
+      if (sx >= src.width || sx + 1 < 0 || sy >= src.height || sy + 1 < 0) {
+        d[0] = d[1] = d[2] = 0;
+        continue;
+      }
+      uchar p[4][3] = {{0}};
+      for (int k = 0; k < 4; k++) {
+        int px = sx + (k & 1);
+        int py = sy + (k >> 1);
+        if (px >= 0 && px < src.width && py >= 0 && py < src.height) {
+          src.fetch(px, py, p[k]);
+        }
+      }
+      blendC3(p[0], p[1], p[2], p[3], ax, ay, d);
+    }
+  }
+}
+
+// transform 为 src -> dst 的正变换, 求 dst -> src 的逆变换
+static void invert_affine_transform(const float *transform, double *M) {
+  double D = (double)transform[0] * transform[4] -
+             (double)transform[1] * transform[3];
+  D = D != 0 ? 1. / D : 0;
+  double A11 = transform[4] * D, A22 = transform[0] * D;
+  double A12 = -transform[1] * D, A21 = -transform[3] * D;
+  M[0] = A11;
+  M[1] = A12;
+  M[3] = A21;
+  M[4] = A22;
+  M[2] = -A11 * transform[2] - A12 * transform[5];
+  M[5] = -A21 * transform[2] - A22 * transform[5];
+}
+
 int32_t tdl_face_warp_affine(const unsigned char *src_data,
                              unsigned int src_step, int src_width,
                              int src_height, unsigned char *dst_data,
                              unsigned int dst_step, int dst_width,
                              int dst_height, const float *src_pts5_xy) {
-  cv::Mat src(src_height, src_width, CV_8UC3,
-              const_cast<unsigned char *>(src_data), src_step);
-  cv::Mat dst(dst_height, dst_width, CV_8UC3, dst_data, dst_step);
-
   float transform[6];
   int ret = get_face_transform(src_pts5_xy, 112, transform);
   if (ret != 0) {
     LOGE("get_face_transform failed");
     return ret;
   }
-  cv::Mat trans = cv::Mat::zeros(2, 3, CV_64F);
-  for (int i = 0; i < 6; i++) {
-    trans.at<double>(i) = transform[i];
-  }
-  cv::warpAffine(src, dst, trans, dst.size(), cv::INTER_LINEAR);
-
-  // tdl_warp_affine(src_data, transform, src_step, src_width, src_height,
-  //                 dst_data, dst_step, dst_width, dst_height);
-
+  double M[6];
+  invert_affine_transform(transform, M);
+  PackedC3Sampler src = {src_data, (int)src_step, src_width, src_height};
+  warp_affine_bilinear_c3(src, M, dst_data, dst_step, dst_width, dst_height);
   return 0;
 }
 
@@ -875,21 +1085,55 @@ int32_t tdl_license_plate_warp_affine(const unsigned char *src_data,
                                       unsigned int dst_step, int dst_width,
                                       int dst_height,
                                       const float *src_pts4_xy) {
-  cv::Mat src(src_height, src_width, CV_8UC3,
-              const_cast<unsigned char *>(src_data), src_step);
-  cv::Mat dst(dst_height, dst_width, CV_8UC3, dst_data, dst_step);
-
   float transform[6];
   int ret = get_license_plate_transform(src_pts4_xy, transform);
   if (ret != 0) {
-    LOGE("get_face_transform failed");
+    LOGE("get_license_plate_transform failed");
     return ret;
   }
-  cv::Mat trans = cv::Mat::zeros(2, 3, CV_64F);
-  for (int i = 0; i < 6; i++) {
-    trans.at<double>(i) = transform[i];
+  double M[6];
+  invert_affine_transform(transform, M);
+  PackedC3Sampler src = {src_data, (int)src_step, src_width, src_height};
+  warp_affine_bilinear_c3(src, M, dst_data, dst_step, dst_width, dst_height);
+  return 0;
+}
+
+int32_t tdl_face_warp_affine_yuv420sp(
+    const unsigned char *y_data, unsigned int y_step,
+    const unsigned char *uv_data, unsigned int uv_step, bool is_nv21,
+    int src_width, int src_height, unsigned char *dst_data,
+    unsigned int dst_step, int dst_width, int dst_height,
+    const float *src_pts5_xy) {
+  float transform[6];
+  int ret = get_face_transform(src_pts5_xy, 112, transform);
+  if (ret != 0) {
+    LOGE("get_face_transform failed");
+    return ret;
   }
-  cv::warpAffine(src, dst, trans, dst.size(), cv::INTER_LINEAR);
+  double M[6];
+  invert_affine_transform(transform, M);
+  Yuv420spSampler src = {y_data,          (int)y_step, uv_data,   (int)uv_step,
+                         is_nv21 ? 1 : 0, src_width,   src_height};
+  warp_affine_bilinear_c3(src, M, dst_data, dst_step, dst_width, dst_height);
+  return 0;
+}
 
+int32_t tdl_license_plate_warp_affine_yuv420sp(
+    const unsigned char *y_data, unsigned int y_step,
+    const unsigned char *uv_data, unsigned int uv_step, bool is_nv21,
+    int src_width, int src_height, unsigned char *dst_data,
+    unsigned int dst_step, int dst_width, int dst_height,
+    const float *src_pts4_xy) {
+  float transform[6];
+  int ret = get_license_plate_transform(src_pts4_xy, transform);
+  if (ret != 0) {
+    LOGE("get_license_plate_transform failed");
+    return ret;
+  }
+  double M[6];
+  invert_affine_transform(transform, M);
+  Yuv420spSampler src = {y_data,          (int)y_step, uv_data,   (int)uv_step,
+                         is_nv21 ? 1 : 0, src_width,   src_height};
+  warp_affine_bilinear_c3(src, M, dst_data, dst_step, dst_width, dst_height);
   return 0;
-}
\ No newline at end of file
+}
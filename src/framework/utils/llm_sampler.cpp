@@ -0,0 +1,201 @@
+#include "utils/llm_sampler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+// exp of every element in place. Range reduction to 2^n * e^r with a degree 6
+// polynomial for e^r (relative error ~2e-7), written without branches so the
+// loop is vectorized by the compiler.
+void expInPlace(float *data, int num) {
+  const float kLog2e = 1.44269504f;
+  const float kLn2Hi = 0.693359375f;
+  const float kLn2Lo = -2.12194440e-4f;
+  // adding and subtracting 1.5 * 2^23 rounds to the nearest integer, the
+  // integer is then in the low mantissa bits
+  const float kRound = 12582912.0f;
+  // clamped in a separate loop, inside the main loop gcc splits off the
+  // constant path of the clamp and gives up vectorizing
+  for (int i = 0; i < num; i++) {
+    data[i] = std::min(std::max(data[i], -87.0f), 88.0f);
+  }
+  for (int i = 0; i < num; i++) {
+    float x = data[i];
+    float t = x * kLog2e + kRound;
+    float fn = t - kRound;
+    float r = x - fn * kLn2Hi - fn * kLn2Lo;
+    float p = 1.0f / 720;
+    p = p * r + 1.0f / 120;
+    p = p * r + 1.0f / 24;
+    p = p * r + 1.0f / 6;
+    p = p * r + 0.5f;
+    p = p * r + 1.0f;
+    p = p * r + 1.0f;
+    uint32_t bits;
+    std::memcpy(&bits, &t, sizeof(bits));
+    bits = (bits + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    data[i] = p * scale;
+  }
+}
+
+}  // namespace
+
+void TokenWindow::reset(int capacity, int window_size, const int *tokens,
+                        int num_tokens) {
+  capacity = std::max(capacity, 1);
+  window_size_ = std::min(std::max(window_size, 1), capacity);
+  buffer_.assign(capacity, 0);
+  count_ = num_tokens;
+  last_slot_ = 0;
+  pad_slot_ = 0;
+  if (num_tokens <= 0) {
+    count_ = 0;
+    return;
+  }
+  for (int i = std::max(0, num_tokens - window_size_); i < num_tokens; i++) {
+    buffer_[i % window_size_] = tokens[i];
+  }
+  last_slot_ = (num_tokens - 1) % window_size_;
+  fillPadding(tokens[num_tokens - 1]);
+}
+
+bool TokenWindow::push(int token) {
+  int slot = int(count_ % window_size_);
+  buffer_[slot] = token;
+  last_slot_ = slot;
+  count_++;
+  // the padding token has just left the window, use the newest one instead,
+  // which stays for window_size_ more tokens
+  if (slot == pad_slot_) {
+    fillPadding(token);
+    return size() < int(buffer_.size());
+  }
+  return false;
+}
+
+int TokenWindow::size() const {
+  return int(std::min<int64_t>(count_, window_size_));
+}
+
+void TokenWindow::fillPadding(int token) {
+  pad_slot_ = last_slot_;
+  std::fill(buffer_.begin() + size(), buffer_.end(), token);
+}
+
+LLMSampler::LLMSampler(uint32_t seed) : rng_(seed) {}
+
+int LLMSampler::argmax(const float *logits, int num) {
+  int best = 0;
+  for (int i = 1; i < num; i++) {
+    if (logits[i] > logits[best]) best = i;
+  }
+  return best;
+}
+
+int LLMSampler::sample(float *logits, int vocab_size,
+                       const LLMSampleParam &param, const int *history,
+                       int history_len) {
+  if (vocab_size <= 0) {
+    return -1;
+  }
+
+  if (param.repetition_penalty != 1.0f && history_len > 0) {
+    // the stamp makes each token penalized once however often it repeats
+    if (penalty_stamp_.size() != size_t(vocab_size) || ++stamp_ == 0) {
+      penalty_stamp_.assign(vocab_size, 0);
+      stamp_ = 1;
+    }
+    for (int i = 0; i < history_len; i++) {
+      int token = history[i];
+      if (token < 0 || token >= vocab_size ||
+          penalty_stamp_[token] == stamp_) {
+        continue;
+      }
+      penalty_stamp_[token] = stamp_;
+      float &logit = logits[token];
+      logit = logit > 0 ? logit / param.repetition_penalty
+                        : logit * param.repetition_penalty;
+    }
+  }
+
+  if (param.temperature <= 0 || param.top_k == 1) {
+    return argmax(logits, vocab_size);
+  }
+  float inv_temperature = 1.0f / param.temperature;
+
+  int num = vocab_size;
+  if (param.top_k > 0) {
+    num = std::min(param.top_k, vocab_size);
+  }
+  // candidates only need to be ordered when some of them are cut off
+  bool sorted = num < vocab_size || param.top_p < 1.0f;
+  weights_.resize(num);
+  float max_logit;
+  if (sorted) {
+    indices_.resize(vocab_size);
+    std::iota(indices_.begin(), indices_.end(), 0);
+    auto greater = [logits](int a, int b) {
+      return logits[a] > logits[b] || (logits[a] == logits[b] && a < b);
+    };
+    if (num < vocab_size) {
+      std::nth_element(indices_.begin(), indices_.begin() + num,
+                       indices_.end(), greater);
+    }
+    std::sort(indices_.begin(), indices_.begin() + num, greater);
+    max_logit = logits[indices_[0]];
+    for (int i = 0; i < num; i++) {
+      weights_[i] = (logits[indices_[i]] - max_logit) * inv_temperature;
+    }
+  } else {
+    max_logit = *std::max_element(logits, logits + vocab_size);
+    for (int i = 0; i < num; i++) {
+      weights_[i] = (logits[i] - max_logit) * inv_temperature;
+    }
+  }
+  expInPlace(weights_.data(), num);
+  float total = std::accumulate(weights_.begin(), weights_.end(), 0.0f);
+
+  if (param.top_p < 1.0f) {
+    // smallest prefix of the sorted candidates reaching top_p
+    float threshold = param.top_p * total;
+    float cumsum = 0;
+    int keep = 0;
+    while (keep < num) {
+      cumsum += weights_[keep++];
+      if (cumsum >= threshold) break;
+    }
+    num = keep;
+    total = cumsum;
+  }
+
+  int index = sampleIndex(weights_.data(), num, total);
+  return sorted ? indices_[index] : index;
+}
+
+int LLMSampler::sampleCandidates(const float *probs, const int *tokens,
+                                 int num) {
+  if (num <= 0) {
+    return -1;
+  }
+  float total = std::accumulate(probs, probs + num, 0.0f);
+  return tokens[sampleIndex(probs, num, total)];
+}
+
+int LLMSampler::sampleIndex(const float *weights, int num, float total) {
+  std::uniform_real_distribution<float> dist(0.0f, total);
+  float target = dist(rng_);
+  float cumsum = 0;
+  int last_valid = 0;
+  for (int i = 0; i < num; i++) {
+    if (weights[i] <= 0) continue;
+    cumsum += weights[i];
+    last_valid = i;
+    if (target < cumsum) return i;
+  }
+  // rounding, target was at the very end
+  return last_valid;
+}
@@ -1,5 +1,13 @@
 #include "utils/qwen_vl_helper.hpp"
+
+#include <algorithm>
+#include <thread>
+#if defined(__BM168X__)
 #include <opencv2/core/bmcv.hpp>
+#endif
+
+#include "utils/tdl_log.hpp"
+
 // -----------------------------------------------------------------------
 // 常量定义
 // -----------------------------------------------------------------------
@@ -15,6 +23,9 @@ const double FPS = 2.0;
 const int FPS_MIN_FRAMES = 4;
 const int FPS_MAX_FRAMES = 768;
 const int VIDEO_TOTAL_PIXELS = 24576 * 28 * 28;
+// 同时解码的视频实例上限,每个实例负责一段不相交的帧区间
+const int VIDEO_MAX_DECODE_THREADS = 4;
+const int VIDEO_MIN_FRAMES_PER_THREAD = 4;
 
 int round_by_factor(int number, int factor) {
   return int(std::round(double(number) / factor)) * factor;
@@ -65,6 +76,176 @@ int smart_nframes(int total_frames, double video_fps, int desired_nframes,
   return nframes;
 }
 
+struct VideoSampleStats {
+  int decoded_frames = 0;  // frames grabbed or read from the decoder
+  int seek_times = 0;
+  double process_ticks = 0;
+};
+
+std::vector<int> sample_frame_indices(int total_frames, int nframes,
+                                      int max_process_frames) {
+  std::vector<int> indices;
+  for (int i = 0; i < nframes; i++) {
+    int idx = int(std::round(double(i) / (nframes - 1) * (total_frames - 1)));
+    if (max_process_frames > 0 && idx >= max_process_frames) {
+      break;
+    }
+    indices.push_back(idx);
+  }
+  return indices;
+}
+
+void resize_frame(const cv::Mat &frame, cv::Mat &resized) {
+#if defined(__BM168X__)
+  cv::bmcv::resize(frame, resized, true, BMCV_INTER_NEAREST);
+#else
+  cv::resize(frame, resized, resized.size(), 0, 0, cv::INTER_NEAREST);
+#endif
+}
+
+// seek 到 frame_index 附近,返回实际落点,失败返回 -1
+int seek_frame(cv::VideoCapture &cap, int frame_index) {
+  if (!cap.set(cv::CAP_PROP_POS_FRAMES, frame_index)) {
+    return -1;
+  }
+  return int(cap.get(cv::CAP_PROP_POS_FRAMES));
+}
+
+// 解码 indices[begin, end) 对应的帧,indices 升序
+// 与目标帧间隔较远时 seek 到目标帧之前的关键帧,其余帧只 grab 不 retrieve
+// 返回成功解码的帧数,遇到视频提前结束时小于 end - begin
+int decode_frame_range(cv::VideoCapture &cap, const std::vector<int> &indices,
+                       size_t begin, size_t end, int seek_min_gap,
+                       const cv::Size &new_size,
+                       std::vector<std::vector<cv::Mat>> &frames,
+                       VideoSampleStats &stats) {
+  cv::Mat frame;
+  // resize 的输出缓存,每帧复用
+  cv::Mat resized(new_size.height, new_size.width, CV_8UC3);
+  int next_frame = 0;  // index of the frame returned by the next grab()
+  int num_decoded = 0;
+  for (size_t i = begin; i < end; i++) {
+    int target = indices[i];
+    if (i > begin && target == indices[i - 1]) {
+      frames[i] = frames[i - 1];
+      num_decoded++;
+      continue;
+    }
+    if (target - next_frame > seek_min_gap) {
+      // backends that can not seek exactly land on a nearby frame, which may
+      // be past the target; seek earlier and finally to the first frame,
+      // then grab up to the target
+      const int seek_targets[] = {target, std::max(target - seek_min_gap, 0),
+                                  0};
+      for (int seek_target : seek_targets) {
+        int pos = seek_frame(cap, seek_target);
+        if (pos < 0) {
+          continue;
+        }
+        next_frame = pos;
+        stats.seek_times++;
+        if (pos <= target) {
+          break;
+        }
+      }
+      if (next_frame > target) {
+        LOGW("seek to frame %d failed, landed on frame %d", target,
+             next_frame);
+      }
+    }
+    bool video_end = false;
+    while (next_frame < target) {
+      if (!cap.grab()) {
+        video_end = true;
+        break;
+      }
+      next_frame++;
+      stats.decoded_frames++;
+    }
+    if (video_end || !cap.read(frame) || frame.empty()) {
+      break;
+    }
+    next_frame++;
+    stats.decoded_frames++;
+
+    double tick_process = cv::getTickCount();
+    resize_frame(frame, resized);
+    // b、g、r 三个通道放在同一块连续内存中,只分配一次
+    cv::Mat planar(new_size.height * 3, new_size.width, CV_8UC1);
+    std::vector<cv::Mat> bgr_frames = {
+        planar.rowRange(0, new_size.height),
+        planar.rowRange(new_size.height, new_size.height * 2),
+        planar.rowRange(new_size.height * 2, new_size.height * 3)};
+    cv::split(resized, bgr_frames);
+    frames[i] = bgr_frames;
+    stats.process_ticks += cv::getTickCount() - tick_process;
+    num_decoded++;
+  }
+  return num_decoded;
+}
+
+// 将采样帧分段,在多个视频实例上并行解码,cap 用于第一段
+std::vector<std::vector<cv::Mat>> decode_sampled_frames(
+    cv::VideoCapture &cap, const std::string &video_path,
+    const std::vector<int> &indices, double video_fps,
+    const cv::Size &new_size, VideoSampleStats &stats) {
+  int num_threads = std::min(
+      VIDEO_MAX_DECODE_THREADS,
+      std::max(1, (int)std::thread::hardware_concurrency()));
+  num_threads = std::max(
+      1, std::min(num_threads,
+                  (int)indices.size() / VIDEO_MIN_FRAMES_PER_THREAD));
+  // 关键帧间隔通常为 1~2 秒,更近的目标帧直接 grab 更快
+  int seek_min_gap = std::max(int(video_fps), 1);
+
+  std::vector<std::vector<cv::Mat>> frames(indices.size());
+  std::vector<VideoSampleStats> thread_stats(num_threads);
+  std::vector<size_t> range_begin(num_threads + 1);
+  std::vector<int> range_decoded(num_threads, 0);
+  for (int t = 0; t <= num_threads; t++) {
+    range_begin[t] = indices.size() * t / num_threads;
+  }
+  auto decode_range = [&](int t) {
+    cv::VideoCapture range_cap;
+    cv::VideoCapture *p_cap = &cap;
+    if (t > 0) {
+      if (!range_cap.open(video_path, cv::CAP_ANY, 0) ||
+          !range_cap.isOpened()) {
+        printf("open video failed for decode thread %d\n", t);
+        return;
+      }
+      p_cap = &range_cap;
+    }
+    range_decoded[t] =
+        decode_frame_range(*p_cap, indices, range_begin[t], range_begin[t + 1],
+                           seek_min_gap, new_size, frames, thread_stats[t]);
+  };
+  std::vector<std::thread> threads;
+  for (int t = 1; t < num_threads; t++) {
+    threads.emplace_back(decode_range, t);
+  }
+  decode_range(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // 与顺序解码一致:在第一个未能解码的帧处截断
+  size_t num_frames = 0;
+  for (int t = 0; t < num_threads; t++) {
+    num_frames += range_decoded[t];
+    if (range_begin[t] + range_decoded[t] < range_begin[t + 1]) {
+      break;
+    }
+  }
+  frames.resize(num_frames);
+  for (auto &thread_stat : thread_stats) {
+    stats.decoded_frames += thread_stat.decoded_frames;
+    stats.seek_times += thread_stat.seek_times;
+    stats.process_ticks += thread_stat.process_ticks;
+  }
+  return frames;
+}
+
 QwenVLHelper::QwenVLHelper() {}
 
 QwenVLHelper::~QwenVLHelper() {}
@@ -140,57 +321,18 @@ std::map<std::string, float> QwenVLHelper::testFetchVideoTs(
       total_frames, video_fps, img_width, img_height, desired_fps,
       desired_nframes, nframes);
 
-  std::vector<int> indices;
-  for (int i = 0; i < nframes; i++) {
-    int idx = int(std::round(double(i) / (nframes - 1) * (total_frames - 1)));
-    indices.push_back(idx);
-  }
-
   int max_process_frames = max_video_sec * video_fps;
-  std::vector<std::vector<cv::Mat>> frames;  // std::vector<cv::Mat> = <b,g,r>
-  int current_frame = 0;
-  int target_idx = 0;
-
-  int last_frame = indices[indices.size() - 1];
+  std::vector<int> indices =
+      sample_frame_indices(total_frames, nframes, max_process_frames);
 
-  double tick_process_total = 0;
   double tick_read_start = cv::getTickCount();
   cv::Size new_size =
       smart_resize(img_height, img_width, size_factor, min_pixels,
                    total_pixels / std::max(nframes, 1));
   printf("new_size: %d, %d\n", new_size.height, new_size.width);
-  cv::Mat resized(new_size.height, new_size.width, CV_8UC3);
-  // cv::Mat frame(img_height, img_width, CV_8UC3);
-  while (true) {
-    cv::Mat frame;
-
-    cap.read(frame);
-    if (frame.empty()) {
-      break;
-    }
-
-    if (current_frame == indices[target_idx]) {
-      double tick_process = cv::getTickCount();
-
-      // cv::Mat resized;
-      cv::bmcv::resize(frame, resized, true, BMCV_INTER_NEAREST);
-      std::vector<cv::Mat> bgr_frames;
-      cv::split(resized, bgr_frames);
-      frames.push_back(bgr_frames);
-      tick_process_total += cv::getTickCount() - tick_process;
-      target_idx++;
-
-      if (target_idx >= static_cast<int>(indices.size())) break;
-      if (desired_nframes > 0 && current_frame >= desired_nframes) break;
-    }
-    current_frame++;
-    if (current_frame > last_frame) {
-      break;
-    }
-    if (max_process_frames > 0 && current_frame >= max_process_frames) {
-      break;
-    }
-  }
+  VideoSampleStats stats;
+  std::vector<std::vector<cv::Mat>> frames = decode_sampled_frames(
+      cap, video_path, indices, video_fps, new_size, stats);
   double tick_read_end = cv::getTickCount();
   cap.release();
   double tick_video_close = cv::getTickCount();
@@ -198,7 +340,8 @@ std::map<std::string, float> QwenVLHelper::testFetchVideoTs(
       (tick_video_open_end - tick_video_open) * 1000 / cv::getTickFrequency();
   double duration_read =
       (tick_read_end - tick_read_start) * 1000 / cv::getTickFrequency();
-  double duration_process = tick_process_total * 1000 / cv::getTickFrequency();
+  double duration_process =
+      stats.process_ticks * 1000 / cv::getTickFrequency();
   double duration_video_close =
       (tick_video_close - tick_read_end) * 1000 / cv::getTickFrequency();
 
@@ -207,8 +350,9 @@ std::map<std::string, float> QwenVLHelper::testFetchVideoTs(
   result["duration_read"] = duration_read;
   result["duration_process"] = duration_process;
   result["duration_video_close"] = duration_video_close;
-  result["read_frames"] = current_frame;
-  result["process_frames"] = target_idx;
+  result["read_frames"] = stats.decoded_frames;
+  result["process_frames"] = frames.size();
+  result["seek_times"] = stats.seek_times;
   return result;
 }
 
@@ -249,20 +393,9 @@ std::vector<std::vector<cv::Mat>> QwenVLHelper::fetchVideo(
       total_frames, video_fps, img_width, img_height, desired_fps,
       desired_nframes, nframes);
 
-  std::vector<int> indices;
-  for (int i = 0; i < nframes; i++) {
-    int idx = int(std::round(double(i) / (nframes - 1) * (total_frames - 1)));
-    indices.push_back(idx);
-  }
-
   int max_process_frames = max_video_sec * video_fps;
-  std::vector<std::vector<cv::Mat>> frames;  // std::vector<cv::Mat> = <b,g,r>
-  int current_frame = 0;
-  int target_idx = 0;
-  int last_frame = indices[indices.size() - 1];
-
-  double tick_process_total = 0;
-  double tick_read_start = cv::getTickCount();
+  std::vector<int> indices =
+      sample_frame_indices(total_frames, nframes, max_process_frames);
 
   // 计算 custom_max_pixels，假设 TOTAL_PIXELS 等于 VIDEO_TOTAL_PIXELS
   int total_pixels = VIDEO_TOTAL_PIXELS;
@@ -275,39 +408,12 @@ std::vector<std::vector<cv::Mat>> QwenVLHelper::fetchVideo(
   cv::Size new_size = smart_resize(img_height, img_width, size_factor,
                                    min_pixels, custom_max_pixels);
   printf("new_size: %d, %d\n", new_size.height, new_size.width);
-  cv::Mat resized(new_size.height, new_size.width, CV_8UC3);
-  while (true) {
-    cv::Mat frame;
-    cap.read(frame);
-    if (frame.empty()) {
-      break;
-    }
-    if (current_frame == indices[target_idx]) {
-      double tick_process = cv::getTickCount();
-      cv::bmcv::resize(frame, resized, true, BMCV_INTER_NEAREST);
-      // cv::Size new_size =
-      //     smart_resize(frame.rows, frame.cols, size_factor, min_pixels,
-      //                  total_pixels / std::max(nframes, 1));
-      // cv::Mat resized;
-      // cv::Mat resized_float;
-      // resized.convertTo(resized_float, CV_32FC3, 1.0 / 255);
-      std::vector<cv::Mat> bgr_frames;
-      cv::split(resized, bgr_frames);
-      frames.push_back(bgr_frames);
-      tick_process_total += cv::getTickCount() - tick_process;
-      target_idx++;
-
-      if (target_idx >= static_cast<int>(indices.size())) break;
-      if (desired_nframes > 0 && current_frame >= desired_nframes) break;
-    }
-    current_frame++;
-    if (current_frame > last_frame) {
-      break;
-    }
-    if (max_process_frames > 0 && current_frame >= max_process_frames) {
-      break;
-    }
-  }
+  VideoSampleStats stats;
+  // std::vector<cv::Mat> = <b,g,r>
+  std::vector<std::vector<cv::Mat>> frames = decode_sampled_frames(
+      cap, video_path, indices, video_fps, new_size, stats);
+  LOGI("sampled frames: %zu, decoded frames: %d, seek times: %d",
+       frames.size(), stats.decoded_frames, stats.seek_times);
 
   cap.release();
   return frames;
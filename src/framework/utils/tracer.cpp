@@ -0,0 +1,496 @@
+#include "utils/tracer.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "utils/tdl_log.hpp"
+
+namespace {
+
+struct TraceSpan {
+  uint32_t name_id;
+  uint64_t start_ns;
+  uint64_t duration_ns;
+};
+
+// Written only by the owning thread, read by the exporter. The exporter may
+// race with the writer on the oldest entries, those are dropped when the
+// head moved past them during the copy, together with the slot the writer
+// may be filling right now.
+class TraceRing {
+ public:
+  explicit TraceRing(uint32_t thread_index)
+      : thread_index_(thread_index), spans_(new TraceSpan[kCapacity]) {}
+
+  void push(const TraceSpan &span) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    spans_[head & (kCapacity - 1)] = span;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  void snapshot(std::vector<TraceSpan> &spans) const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t begin = head > kCapacity ? head - kCapacity : 0;
+    std::vector<TraceSpan> copied;
+    copied.reserve(head - begin);
+    for (uint64_t i = begin; i < head; i++) {
+      copied.push_back(spans_[i & (kCapacity - 1)]);
+    }
+    uint64_t new_head = head_.load(std::memory_order_acquire);
+    // slot new_head may already be under write, it aliases new_head-kCapacity
+    uint64_t valid_begin =
+        new_head + 1 > kCapacity ? new_head + 1 - kCapacity : 0;
+    size_t skip = valid_begin > begin ? valid_begin - begin : 0;
+    if (skip < copied.size()) {
+      spans.insert(spans.end(), copied.begin() + skip, copied.end());
+    }
+  }
+
+  void reset() { head_.store(0, std::memory_order_release); }
+  uint32_t threadIndex() const { return thread_index_; }
+
+ private:
+  static constexpr uint64_t kCapacity = Tracer::kRingCapacity;
+  static_assert((kCapacity & (kCapacity - 1)) == 0,
+                "ring capacity should be power of 2");
+
+  uint32_t thread_index_;
+  std::unique_ptr<TraceSpan[]> spans_;
+  std::atomic<uint64_t> head_{0};
+};
+
+constexpr uint64_t TraceRing::kCapacity;
+
+struct TraceRegistry {
+  std::mutex mutex;
+  std::map<std::string, uint32_t> name_ids;
+  std::vector<std::string> names;
+  // allocated on registerName, never freed so that record() needs no lock
+  std::atomic<LatencyHistogram *> histograms[Tracer::kMaxNames];
+  // rings are kept after the thread exits so that its spans can be dumped,
+  // and handed to the next new thread (keeping its tid) instead of growing
+  std::vector<std::shared_ptr<TraceRing>> rings;
+  std::vector<TraceRing *> free_rings;
+
+  TraceRegistry() {
+    for (uint32_t i = 0; i < Tracer::kMaxNames; i++) {
+      histograms[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+};
+
+TraceRegistry &registry() {
+  static TraceRegistry *instance = new TraceRegistry();
+  return *instance;
+}
+
+// gives the ring of the thread back to the registry when the thread exits
+struct ThreadRingHolder {
+  TraceRing *ring = nullptr;
+
+  ~ThreadRingHolder() {
+    if (ring != nullptr) {
+      TraceRegistry &reg = registry();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      reg.free_rings.push_back(ring);
+      ring = nullptr;
+    }
+  }
+};
+
+TraceRing *threadRing() {
+  thread_local ThreadRingHolder holder;
+  if (holder.ring == nullptr) {
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    if (!reg.free_rings.empty()) {
+      holder.ring = reg.free_rings.back();
+      reg.free_rings.pop_back();
+    } else {
+      reg.rings.push_back(std::make_shared<TraceRing>(
+          static_cast<uint32_t>(reg.rings.size())));
+      holder.ring = reg.rings.back().get();
+    }
+  }
+  return holder.ring;
+}
+
+bool envTraceEnabled() {
+  const char *env = std::getenv("TDL_TRACE");
+  return env != nullptr && std::string(env) == "1";
+}
+
+std::string escapeLabel(const std::string &str) {
+  std::string escaped;
+  for (char c : str) {
+    if (c == '\\' || c == '"') {
+      escaped.push_back('\\');
+      escaped.push_back(c);
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+class MetricsServer {
+ public:
+  ~MetricsServer() { stop(); }
+
+  int32_t start(int port) {
+    if (running_) {
+      LOGW("metrics server is already running");
+      return 0;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+      LOGE("create metrics socket failed");
+      return -1;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) !=
+            0 ||
+        listen(fd, 4) != 0) {
+      LOGE("bind metrics server to port %d failed", port);
+      close(fd);
+      return -1;
+    }
+    listen_fd_ = fd;
+    running_ = true;
+    thread_ = std::thread(&MetricsServer::run, this);
+    LOGI("metrics server started at http://127.0.0.1:%d/metrics", port);
+    return 0;
+  }
+
+  void stop() {
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+    close(listen_fd_);
+    listen_fd_ = -1;
+  }
+
+ private:
+  void run() {
+    while (running_) {
+      struct pollfd pfd;
+      pfd.fd = listen_fd_;
+      pfd.events = POLLIN;
+      if (poll(&pfd, 1, 200) <= 0) {
+        continue;
+      }
+      int conn = accept(listen_fd_, nullptr, nullptr);
+      if (conn < 0) {
+        continue;
+      }
+      // the request is not parsed, any path returns the metrics
+      char request[1024];
+      recv(conn, request, sizeof(request), 0);
+      std::string body = Tracer::exportPrometheus();
+      std::string response =
+          "HTTP/1.0 200 OK\r\n"
+          "Content-Type: text/plain; version=0.0.4\r\n"
+          "Content-Length: " +
+          std::to_string(body.size()) + "\r\n\r\n" + body;
+      size_t sent = 0;
+      while (sent < response.size()) {
+        ssize_t n = send(conn, response.data() + sent, response.size() - sent,
+                         MSG_NOSIGNAL);
+        if (n <= 0) {
+          break;
+        }
+        sent += static_cast<size_t>(n);
+      }
+      close(conn);
+    }
+  }
+
+  std::atomic<bool> running_{false};
+  int listen_fd_ = -1;
+  std::thread thread_;
+};
+
+MetricsServer &metricsServer() {
+  static MetricsServer server;
+  return server;
+}
+
+}  // namespace
+
+/* =========================================== */
+/*               LatencyHistogram              */
+/* =========================================== */
+
+constexpr int LatencyHistogram::kSubBucketBits;
+constexpr int LatencyHistogram::kSubBucketCount;
+constexpr int LatencyHistogram::kBucketNum;
+
+LatencyHistogram::LatencyHistogram() { reset(); }
+
+int LatencyHistogram::bucketIndex(uint64_t value) {
+  // values below 2*kSubBucketCount are exact, above that each power of 2
+  // range is split into kSubBucketCount linear sub buckets
+  if (value < 2 * kSubBucketCount) {
+    return static_cast<int>(value);
+  }
+  int msb = 63 - __builtin_clzll(value);
+  int shift = msb - kSubBucketBits;
+  int sub = static_cast<int>(value >> shift);  // in [kSubBucketCount, 2x)
+  return shift * kSubBucketCount + sub;
+}
+
+uint64_t LatencyHistogram::bucketValue(int index) {
+  if (index < 2 * kSubBucketCount) {
+    return static_cast<uint64_t>(index);
+  }
+  int shift = index / kSubBucketCount - 1;
+  uint64_t sub = static_cast<uint64_t>(index % kSubBucketCount +
+                                       kSubBucketCount);
+  uint64_t lower = sub << shift;
+  return lower + ((1ULL << shift) >> 1);
+}
+
+void LatencyHistogram::record(uint64_t value_ns) {
+  counts_[bucketIndex(value_ns)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value_ns, std::memory_order_relaxed);
+  uint64_t cur_max = max_.load(std::memory_order_relaxed);
+  while (value_ns > cur_max &&
+         !max_.compare_exchange_weak(cur_max, value_ns,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+void LatencyHistogram::reset() {
+  for (int i = 0; i < kBucketNum; i++) {
+    counts_[i].store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::valueAtPercentile(double percentile) const {
+  uint64_t total = count();
+  if (total == 0) {
+    return 0;
+  }
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  uint64_t target = static_cast<uint64_t>(percentile / 100.0 * total + 0.5);
+  target = std::max<uint64_t>(target, 1);
+  uint64_t accumulated = 0;
+  for (int i = 0; i < kBucketNum; i++) {
+    accumulated += counts_[i].load(std::memory_order_relaxed);
+    if (accumulated >= target) {
+      return std::min(bucketValue(i), max());
+    }
+  }
+  return max();
+}
+
+/* =========================================== */
+/*                    Tracer                   */
+/* =========================================== */
+
+constexpr uint32_t Tracer::kMaxNames;
+constexpr uint32_t Tracer::kRingCapacity;
+
+std::atomic<bool> Tracer::enabled_(envTraceEnabled());
+
+void Tracer::setEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+uint32_t Tracer::registerName(const std::string &name) {
+  TraceRegistry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  auto iter = reg.name_ids.find(name);
+  if (iter != reg.name_ids.end()) {
+    return iter->second;
+  }
+  if (reg.names.size() >= kMaxNames) {
+    LOGW("too many trace names, max:%u, %s is merged into the last one",
+         kMaxNames, name.c_str());
+    return kMaxNames - 1;
+  }
+  uint32_t name_id = static_cast<uint32_t>(reg.names.size());
+  reg.names.push_back(name);
+  reg.name_ids[name] = name_id;
+  reg.histograms[name_id].store(new LatencyHistogram(),
+                                std::memory_order_release);
+  return name_id;
+}
+
+std::string Tracer::getName(uint32_t name_id) {
+  TraceRegistry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  if (name_id >= reg.names.size()) {
+    return "";
+  }
+  return reg.names[name_id];
+}
+
+const LatencyHistogram *Tracer::getHistogram(uint32_t name_id) {
+  if (name_id >= kMaxNames) {
+    return nullptr;
+  }
+  return registry().histograms[name_id].load(std::memory_order_acquire);
+}
+
+uint64_t Tracer::nowNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+void Tracer::record(uint32_t name_id, uint64_t start_ns, uint64_t end_ns) {
+  if (name_id >= kMaxNames) {
+    return;
+  }
+  uint64_t duration_ns = end_ns > start_ns ? end_ns - start_ns : 0;
+  LatencyHistogram *histogram =
+      registry().histograms[name_id].load(std::memory_order_acquire);
+  if (histogram != nullptr) {
+    histogram->record(duration_ns);
+  }
+  threadRing()->push({name_id, start_ns, duration_ns});
+}
+
+std::string Tracer::exportPrometheus() {
+  std::vector<std::string> names;
+  {
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    names = reg.names;
+  }
+  const double quantiles[] = {0.5, 0.9, 0.99};
+  std::stringstream ss;
+  ss << "# HELP tdl_span_duration_seconds Latency of traced spans.\n";
+  ss << "# TYPE tdl_span_duration_seconds summary\n";
+  std::stringstream ss_max;
+  ss_max << "# HELP tdl_span_duration_max_seconds Max latency of traced "
+            "spans.\n";
+  ss_max << "# TYPE tdl_span_duration_max_seconds gauge\n";
+  for (size_t i = 0; i < names.size(); i++) {
+    LatencyHistogram *histogram =
+        registry().histograms[i].load(std::memory_order_acquire);
+    if (histogram == nullptr || histogram->count() == 0) {
+      continue;
+    }
+    std::string label = "span=\"" + escapeLabel(names[i]) + "\"";
+    for (double q : quantiles) {
+      ss << "tdl_span_duration_seconds{" << label << ",quantile=\"" << q
+         << "\"} " << histogram->valueAtPercentile(q * 100) / 1e9 << "\n";
+    }
+    ss << "tdl_span_duration_seconds_sum{" << label << "} "
+       << histogram->sum() / 1e9 << "\n";
+    ss << "tdl_span_duration_seconds_count{" << label << "} "
+       << histogram->count() << "\n";
+    ss_max << "tdl_span_duration_max_seconds{" << label << "} "
+           << histogram->max() / 1e9 << "\n";
+  }
+  return ss.str() + ss_max.str();
+}
+
+int32_t Tracer::writePrometheus(const std::string &file_path) {
+  // write to a temp file first so that a scraper never reads a partial file
+  std::string tmp_path = file_path + ".tmp";
+  std::ofstream ofs(tmp_path);
+  if (!ofs.is_open()) {
+    LOGE("open %s failed", tmp_path.c_str());
+    return -1;
+  }
+  ofs << exportPrometheus();
+  ofs.close();
+  if (std::rename(tmp_path.c_str(), file_path.c_str()) != 0) {
+    LOGE("rename %s to %s failed", tmp_path.c_str(), file_path.c_str());
+    return -1;
+  }
+  return 0;
+}
+
+int32_t Tracer::dumpChromeTrace(const std::string &file_path) {
+  std::vector<std::shared_ptr<TraceRing>> rings;
+  std::vector<std::string> names;
+  {
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    rings = reg.rings;
+    names = reg.names;
+  }
+  std::ofstream ofs(file_path);
+  if (!ofs.is_open()) {
+    LOGE("open %s failed", file_path.c_str());
+    return -1;
+  }
+  int pid = static_cast<int>(getpid());
+  ofs << "{\"traceEvents\":[";
+  bool first = true;
+  char buf[64];
+  std::vector<TraceSpan> spans;
+  for (auto &ring : rings) {
+    spans.clear();
+    ring->snapshot(spans);
+    for (auto &span : spans) {
+      if (!first) {
+        ofs << ",";
+      }
+      first = false;
+      const std::string name =
+          span.name_id < names.size() ? names[span.name_id] : "unknown";
+      ofs << "\n{\"name\":\"" << escapeLabel(name)
+          << "\",\"cat\":\"tdl\",\"ph\":\"X\"";
+      snprintf(buf, sizeof(buf), ",\"ts\":%.3f,\"dur\":%.3f",
+               span.start_ns / 1e3, span.duration_ns / 1e3);
+      ofs << buf << ",\"pid\":" << pid << ",\"tid\":" << ring->threadIndex()
+          << "}";
+    }
+  }
+  ofs << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  ofs.close();
+  LOGI("chrome trace dumped to %s", file_path.c_str());
+  return 0;
+}
+
+int32_t Tracer::startMetricsServer(int port) {
+  return metricsServer().start(port);
+}
+
+void Tracer::stopMetricsServer() { metricsServer().stop(); }
+
+void Tracer::reset() {
+  TraceRegistry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  for (size_t i = 0; i < reg.names.size(); i++) {
+    reg.histograms[i].load(std::memory_order_acquire)->reset();
+  }
+  for (auto &ring : reg.rings) {
+    ring->reset();
+  }
+}
@@ -83,6 +83,16 @@ PtrFrameInfo PipelineChannel::getFreeFrame(int wait_ms) {
   return free_queue_.pop(wait_ms);
 }
 
+PtrFrameInfo PipelineChannel::acquireFrame() {
+  if (free_queue_.size() > 0) {
+    PtrFrameInfo frame_info = free_queue_.pop(1);
+    if (frame_info != nullptr) {
+      return frame_info;
+    }
+  }
+  return std::make_unique<PipelineFrameInfo>();
+}
+
 int32_t PipelineChannel::addFreeFrame(PtrFrameInfo frame_info) {
   LOGI("channel:%s,to add free frame,size:%d,frame_id:%lu", name_.c_str(),
        int(free_queue_.sizeUnsafe()), frame_info->frame_id_);
@@ -96,6 +106,13 @@ int32_t PipelineChannel::addFreeFrame(PtrFrameInfo frame_info) {
   } else {
     LOGW("not cleared frame added to free frame,channel:%s", name_.c_str());
   }
+  frame_info->trace_enqueue_ns_ = 0;
+  if (external_frame_) {
+    // do not hold the user image until the frame is reused
+    frame_info->node_data_.clear();
+    frame_info->frame_width = 0;
+    frame_info->frame_height = 0;
+  }
   LOGI("channel:%s,add free frame,size:%d,frame_id:%lu", name_.c_str(),
        int(free_queue_.sizeUnsafe()), frame_info->frame_id_);
   free_queue_.push(std::move(frame_info));
@@ -0,0 +1,22 @@
+#include "pipeline/pipeline_data_types.hpp"
+
+#include <mutex>
+#include "framework/utils/tdl_log.hpp"
+
+int PipelineFrameInfo::getSlotIndex(const std::string &name) {
+  static std::mutex slot_mutex;
+  static std::map<std::string, int> slot_indices;
+  std::lock_guard<std::mutex> lock(slot_mutex);
+  auto iter = slot_indices.find(name);
+  if (iter != slot_indices.end()) {
+    return iter->second;
+  }
+  int index = static_cast<int>(slot_indices.size());
+  if (index >= NodeDataSlots::kMaxSlots) {
+    LOGE("too many node data slots, max:%d, name:%s", NodeDataSlots::kMaxSlots,
+         name.c_str());
+    throw std::out_of_range("too many node data slots");
+  }
+  slot_indices[name] = index;
+  return index;
+}
@@ -48,6 +48,11 @@ void *PipelineNode::process(void *arg) {
       if (frame_info == nullptr) {
         continue;
       }
+      if (frame_info->trace_enqueue_ns_ != 0) {
+        Tracer::record(node->trace_wait_id_, frame_info->trace_enqueue_ns_,
+                       Tracer::nowNs());
+        frame_info->trace_enqueue_ns_ = 0;
+      }
       batch_channels.push_back(p_chn);
       batch_frames.push_back(std::move(frame_info));
     }
@@ -61,6 +66,7 @@ void *PipelineNode::process(void *arg) {
          int(batch_frames.size()));
     for (auto &frame_info : batch_frames) {
       if (node->process_func_) {
+        TraceScope trace_scope(node->trace_process_id_);
         int32_t ret = node->process_func_(frame_info, node->worker_);
         if (ret != 0) {
           LOGE("process func return %d", ret);
@@ -73,6 +79,7 @@ void *PipelineNode::process(void *arg) {
     LOGI("node:%s,to send frame to next node,size:%d", node->name_.c_str(),
          int(batch_frames.size()));
     for (size_t i = 0; i < batch_frames.size(); i++) {
+      TraceScope trace_scope(node->trace_handoff_id_);
       batch_channels[i]->toNextNode(node, std::move(batch_frames[i]));
     }
     batch_frames.clear();
@@ -114,6 +121,9 @@ int32_t PipelineNode::addProcessFrame(PipelineChannel *p_chn,
     assert(false);
     return -1;
   }
+  if (Tracer::isEnabled()) {
+    frame_info->trace_enqueue_ns_ = Tracer::nowNs();
+  }
   input_queues_[p_chn].push(std::move(frame_info));
   if (input_queues_[p_chn].size() > static_cast<size_t>(max_pending_frame_)) {
     LOGE("drop frame in channel:%s,node:%s", p_chn->name().c_str(),
@@ -131,7 +141,12 @@ int32_t PipelineNode::setFristNode(bool is_frist_node) {
   return 0;
 }
 
-void PipelineNode::setName(std::string name) { name_ = name; }
+void PipelineNode::setName(std::string name) {
+  name_ = name;
+  trace_wait_id_ = Tracer::registerName("node/" + name_ + "/queue_wait");
+  trace_process_id_ = Tracer::registerName("node/" + name_ + "/process");
+  trace_handoff_id_ = Tracer::registerName("node/" + name_ + "/handoff");
+}
 
 int32_t PipelineNode::start() {
   is_running_ = true;
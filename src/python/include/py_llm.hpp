@@ -76,6 +76,7 @@ class PyLLMBase {
     py::dict d;
     d["max_new_tokens"] = param.max_new_tokens;
     d["top_p"] = param.top_p;
+    d["top_k"] = param.top_k;
     d["temperature"] = param.temperature;
     d["repetition_penalty"] = param.repetition_penalty;
     d["repetition_last_n"] = param.repetition_last_n;
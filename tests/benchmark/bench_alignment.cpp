@@ -0,0 +1,52 @@
+#include <random>
+#include <vector>
+
+#include "bench_framework.hpp"
+#include "utils/image_alignment.hpp"
+
+namespace cvitdl {
+namespace bench {
+
+namespace {
+
+std::vector<unsigned char> randomImage(int width, int height, int channels) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, 255);
+  std::vector<unsigned char> data(width * height * channels);
+  for (auto &value : data) {
+    value = static_cast<unsigned char>(dist(gen));
+  }
+  return data;
+}
+
+}  // namespace
+
+TDL_BENCHMARK(BM_FaceWarpAffine_112x112) {
+  const int src_width = 1920, src_height = 1080;
+  std::vector<unsigned char> src = randomImage(src_width, src_height, 3);
+  std::vector<unsigned char> dst(112 * 112 * 3);
+  // 一张约 200x200 的人脸的五点关键点
+  const float pts5[10] = {900, 500, 980, 498, 940, 545, 908, 590, 972, 588};
+  while (state.keepRunning()) {
+    int32_t ret = tdl_face_warp_affine(src.data(), src_width * 3, src_width,
+                                       src_height, dst.data(), 112 * 3, 112,
+                                       112, pts5);
+    doNotOptimize(ret);
+  }
+}
+
+TDL_BENCHMARK(BM_LicensePlateWarpAffine_96x32) {
+  const int src_width = 1920, src_height = 1080;
+  std::vector<unsigned char> src = randomImage(src_width, src_height, 3);
+  std::vector<unsigned char> dst(96 * 32 * 3);
+  const float pts4[8] = {800, 600, 960, 590, 962, 642, 802, 652};
+  while (state.keepRunning()) {
+    int32_t ret = tdl_license_plate_warp_affine(
+        src.data(), src_width * 3, src_width, src_height, dst.data(), 96 * 3,
+        96, 32, pts4);
+    doNotOptimize(ret);
+  }
+}
+
+}  // namespace bench
+}  // namespace cvitdl
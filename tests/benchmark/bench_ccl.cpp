@@ -0,0 +1,57 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_framework.hpp"
+#include "ccl.hpp"
+
+namespace cvitdl {
+namespace bench {
+
+namespace {
+
+// 生成带若干前景块与散点噪声的运动掩码
+std::vector<unsigned char> generateMotionMask(int width, int height,
+                                              int num_blobs) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> x_dist(0, width - 1);
+  std::uniform_int_distribution<int> y_dist(0, height - 1);
+  std::uniform_int_distribution<int> size_dist(8, 64);
+  std::vector<unsigned char> mask(width * height, 0);
+  for (int i = 0; i < num_blobs; i++) {
+    int x0 = x_dist(gen), y0 = y_dist(gen);
+    int w = size_dist(gen), h = size_dist(gen);
+    for (int y = y0; y < std::min(height, y0 + h); y++) {
+      memset(mask.data() + y * width + x0, 255, std::min(width - x0, w));
+    }
+  }
+  for (int i = 0; i < width * height / 200; i++) {
+    mask[y_dist(gen) * width + x_dist(gen)] = 255;
+  }
+  return mask;
+}
+
+void runCcl(BenchState &state, int width, int height) {
+  std::vector<unsigned char> mask = generateMotionMask(width, height, 40);
+  void *cc_inst = createConnectInstance();
+  int num_boxes = 0;
+  state.setItemsPerIteration(1);
+  while (state.keepRunning()) {
+    int *boxes = extractConnectedComponent(mask.data(), width, height, width,
+                                           64, cc_inst, &num_boxes);
+    doNotOptimize(boxes);
+  }
+  state.setLabel("boxes=" + std::to_string(num_boxes));
+  destroyConnectedComponent(cc_inst);
+}
+
+}  // namespace
+
+TDL_BENCHMARK(BM_MotionCcl_640x360) { runCcl(state, 640, 360); }
+
+TDL_BENCHMARK(BM_MotionCcl_1920x1080) { runCcl(state, 1920, 1080); }
+
+}  // namespace bench
+}  // namespace cvitdl
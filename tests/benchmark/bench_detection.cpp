@@ -0,0 +1,71 @@
+#include <random>
+#include <vector>
+
+#include "bench_framework.hpp"
+#include "utils/detection_helper.hpp"
+
+namespace cvitdl {
+namespace bench {
+
+namespace {
+
+// 生成模拟检测器输出的候选框,每个目标周围聚集若干重叠框
+std::vector<ObjectBoxInfo> generateCandidateBoxes(int num_objects,
+                                                  int boxes_per_object,
+                                                  int num_classes) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> pos_dist(0, 1800);
+  std::uniform_real_distribution<float> size_dist(20, 200);
+  std::uniform_real_distribution<float> jitter_dist(-8, 8);
+  std::uniform_real_distribution<float> score_dist(0.3f, 1.0f);
+  std::vector<ObjectBoxInfo> boxes;
+  boxes.reserve(num_objects * boxes_per_object);
+  for (int i = 0; i < num_objects; i++) {
+    float x = pos_dist(gen);
+    float y = pos_dist(gen) * 0.6f;
+    float w = size_dist(gen);
+    float h = size_dist(gen);
+    int class_id = i % num_classes;
+    for (int j = 0; j < boxes_per_object; j++) {
+      float x1 = x + jitter_dist(gen);
+      float y1 = y + jitter_dist(gen);
+      boxes.emplace_back(class_id, score_dist(gen), x1, y1,
+                         x1 + w + jitter_dist(gen), y1 + h + jitter_dist(gen));
+    }
+  }
+  return boxes;
+}
+
+}  // namespace
+
+// YOLO decode reads the output tensors of a device net, so only its
+// NMS stage can be benchmarked on the host
+TDL_BENCHMARK(BM_NmsObjects_1000Boxes) {
+  const std::vector<ObjectBoxInfo> candidates =
+      generateCandidateBoxes(100, 10, 4);
+  std::vector<ObjectBoxInfo> boxes;
+  state.setItemsPerIteration(candidates.size());
+  while (state.keepRunning()) {
+    boxes = candidates;
+    DetectionHelper::nmsObjects(boxes, 0.5f);
+    doNotOptimize(boxes.data());
+  }
+}
+
+TDL_BENCHMARK(BM_NmsObjects_PerClassMap) {
+  const std::vector<ObjectBoxInfo> candidates =
+      generateCandidateBoxes(100, 10, 4);
+  std::map<int, std::vector<ObjectBoxInfo>> class_boxes;
+  state.setItemsPerIteration(candidates.size());
+  while (state.keepRunning()) {
+    class_boxes.clear();
+    for (auto &box : candidates) {
+      class_boxes[box.class_id].push_back(box);
+    }
+    DetectionHelper::nmsObjects(class_boxes, 0.5f);
+    doNotOptimize(class_boxes.size());
+  }
+}
+
+}  // namespace bench
+}  // namespace cvitdl
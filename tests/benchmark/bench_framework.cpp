@@ -0,0 +1,149 @@
+#include "bench_framework.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> g_allocation_count(0);
+std::atomic<uint64_t> g_allocation_bytes(0);
+
+uint64_t nowNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+void *countedAlloc(size_t size) {
+  g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  g_allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+  void *ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+}  // namespace
+
+// count every heap allocation made through operator new in this binary,
+// including the ones made inside libtdl_core
+void *operator new(size_t size) { return countedAlloc(size); }
+void *operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+
+namespace cvitdl {
+namespace bench {
+
+uint64_t allocationCount() {
+  return g_allocation_count.load(std::memory_order_relaxed);
+}
+
+uint64_t allocationBytes() {
+  return g_allocation_bytes.load(std::memory_order_relaxed);
+}
+
+BenchState::BenchState(double min_time_ms, int64_t min_iterations)
+    : min_time_ms_(min_time_ms), min_iterations_(min_iterations) {}
+
+void BenchState::startMeasure() {
+  iterations_ = 0;
+  start_allocations_ = allocationCount();
+  start_allocated_bytes_ = allocationBytes();
+  start_ns_ = nowNs();
+}
+
+void BenchState::stopMeasure() {
+  elapsed_ns_ = nowNs() - start_ns_;
+  allocations_ = allocationCount() - start_allocations_;
+  allocated_bytes_ = allocationBytes() - start_allocated_bytes_;
+}
+
+bool BenchState::keepRunning() {
+  if (!skip_reason_.empty()) {
+    return false;
+  }
+  if (start_ns_ == 0) {
+    startMeasure();
+  }
+  uint64_t elapsed_ns = nowNs() - start_ns_;
+  if (warming_up_) {
+    // warm up caches and lazily allocated buffers for 1/10 of the time
+    if (elapsed_ns < min_time_ms_ * 1e5 || iterations_ < 1) {
+      iterations_++;
+      return true;
+    }
+    warmup_iterations_ = iterations_;
+    warming_up_ = false;
+    startMeasure();
+    iterations_++;
+    return true;
+  }
+  if (elapsed_ns < min_time_ms_ * 1e6 || iterations_ < min_iterations_) {
+    iterations_++;
+    return true;
+  }
+  stopMeasure();
+  return false;
+}
+
+BenchRegistry &BenchRegistry::instance() {
+  static BenchRegistry registry;
+  return registry;
+}
+
+const BenchOptions &BenchRegistry::options() { return instance().options_; }
+
+int BenchRegistry::registerBench(const std::string &name, BenchFunc func) {
+  benches_.emplace_back(name, func);
+  return static_cast<int>(benches_.size());
+}
+
+std::vector<BenchResult> BenchRegistry::run(const BenchOptions &options) {
+  options_ = options;
+  std::vector<BenchResult> results;
+  for (auto &bench : benches_) {
+    if (!options.filter.empty() &&
+        bench.first.find(options.filter) == std::string::npos) {
+      continue;
+    }
+    BenchState state(options.min_time_ms, options.min_iterations);
+    bench.second(state);
+
+    BenchResult result;
+    result.name = bench.first;
+    result.label = state.label();
+    if (!state.skipReason().empty() || state.iterations() == 0) {
+      result.skipped = true;
+      result.label = state.skipReason();
+      printf("%-40s skipped: %s\n", result.name.c_str(),
+             result.label.c_str());
+      results.push_back(result);
+      continue;
+    }
+    double iterations = static_cast<double>(state.iterations());
+    result.iterations = state.iterations();
+    result.ns_per_op = state.elapsedNs() / iterations;
+    result.items_per_second =
+        state.itemsPerIteration() * iterations * 1e9 / state.elapsedNs();
+    result.allocs_per_op = state.allocations() / iterations;
+    result.bytes_per_op = state.allocatedBytes() / iterations;
+    printf("%-40s %10ld it %14.1f ns/op %14.1f items/s %10.1f allocs/op "
+           "%12.1f B/op %s\n",
+           result.name.c_str(), (long)result.iterations, result.ns_per_op,
+           result.items_per_second, result.allocs_per_op, result.bytes_per_op,
+           result.label.c_str());
+    results.push_back(result);
+  }
+  return results;
+}
+
+}  // namespace bench
+}  // namespace cvitdl
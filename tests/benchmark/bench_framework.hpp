@@ -0,0 +1,110 @@
+#ifndef TDL_BENCH_FRAMEWORK_HPP
+#define TDL_BENCH_FRAMEWORK_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace cvitdl {
+namespace bench {
+
+// Passed to every benchmark body, the body runs the measured code inside
+// `while (state.keepRunning()) { ... }`; setup before the loop is not timed.
+class BenchState {
+ public:
+  BenchState(double min_time_ms, int64_t min_iterations);
+
+  bool keepRunning();
+  // number of items handled per iteration, used for the throughput column
+  void setItemsPerIteration(int64_t items) { items_per_iteration_ = items; }
+  void setLabel(const std::string &label) { label_ = label; }
+  // mark the benchmark as skipped (e.g. missing fixture)
+  void skip(const std::string &reason) { skip_reason_ = reason; }
+
+  int64_t iterations() const { return iterations_; }
+  uint64_t elapsedNs() const { return elapsed_ns_; }
+  uint64_t allocations() const { return allocations_; }
+  uint64_t allocatedBytes() const { return allocated_bytes_; }
+  int64_t itemsPerIteration() const { return items_per_iteration_; }
+  const std::string &label() const { return label_; }
+  const std::string &skipReason() const { return skip_reason_; }
+
+ private:
+  void startMeasure();
+  void stopMeasure();
+
+  double min_time_ms_;
+  int64_t min_iterations_;
+  bool warming_up_ = true;
+  int64_t iterations_ = 0;
+  int64_t warmup_iterations_ = 0;
+  uint64_t start_ns_ = 0;
+  uint64_t elapsed_ns_ = 0;
+  uint64_t start_allocations_ = 0;
+  uint64_t start_allocated_bytes_ = 0;
+  uint64_t allocations_ = 0;
+  uint64_t allocated_bytes_ = 0;
+  int64_t items_per_iteration_ = 1;
+  std::string label_;
+  std::string skip_reason_;
+};
+
+struct BenchResult {
+  std::string name;
+  std::string label;
+  bool skipped = false;
+  int64_t iterations = 0;
+  double ns_per_op = 0;
+  double items_per_second = 0;
+  double allocs_per_op = 0;
+  double bytes_per_op = 0;
+};
+
+typedef std::function<void(BenchState &)> BenchFunc;
+
+struct BenchOptions {
+  std::string filter;  // substring of the benchmark name
+  double min_time_ms = 200;
+  int64_t min_iterations = 10;
+  std::string fixture_dir;
+};
+
+class BenchRegistry {
+ public:
+  static BenchRegistry &instance();
+  int registerBench(const std::string &name, BenchFunc func);
+  std::vector<BenchResult> run(const BenchOptions &options);
+
+  // global options, readable by the benchmark bodies (fixture_dir)
+  static const BenchOptions &options();
+
+ private:
+  std::vector<std::pair<std::string, BenchFunc>> benches_;
+  BenchOptions options_;
+};
+
+// allocation counters, maintained by the operator new hooks of the binary
+uint64_t allocationCount();
+uint64_t allocationBytes();
+
+// prevent the compiler from optimizing away a result
+template <typename T>
+inline void doNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+}  // namespace bench
+}  // namespace cvitdl
+
+#define TDL_BENCH_CONCAT_IMPL(a, b) a##b
+#define TDL_BENCH_CONCAT(a, b) TDL_BENCH_CONCAT_IMPL(a, b)
+#define TDL_BENCHMARK(name)                                           \
+  static void name(cvitdl::bench::BenchState &state);                 \
+  static int TDL_BENCH_CONCAT(bench_registered_, name)                \
+      __attribute__((unused)) =                                       \
+          cvitdl::bench::BenchRegistry::instance().registerBench(#name, \
+                                                                 name); \
+  static void name(cvitdl::bench::BenchState &state)
+
+#endif
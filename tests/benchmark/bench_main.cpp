@@ -0,0 +1,139 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <json.hpp>
+#include <map>
+#include <string>
+
+#include "bench_framework.hpp"
+
+using cvitdl::bench::BenchOptions;
+using cvitdl::bench::BenchRegistry;
+using cvitdl::bench::BenchResult;
+
+namespace {
+
+void printUsage(const char *prog) {
+  printf(
+      "Usage: %s [options]\n"
+      "  --filter <str>        only run benchmarks whose name contains str\n"
+      "  --min_time_ms <ms>    measure each benchmark at least ms (200)\n"
+      "  --min_iters <n>       measure each benchmark at least n iters (10)\n"
+      "  --fixture_dir <dir>   recorded fixtures, e.g. <dir>/bpe/encoder.txt\n"
+      "  --json <file>         write the results as json\n"
+      "  --baseline <file>     compare ns/op with a previous json result\n"
+      "  --threshold <ratio>   allowed slowdown against baseline (0.1)\n",
+      prog);
+}
+
+int32_t writeJson(const std::string &file_path,
+                  const std::vector<BenchResult> &results) {
+  nlohmann::json root;
+  root["benchmarks"] = nlohmann::json::array();
+  for (auto &result : results) {
+    nlohmann::json item;
+    item["name"] = result.name;
+    item["label"] = result.label;
+    item["skipped"] = result.skipped;
+    item["iterations"] = result.iterations;
+    item["ns_per_op"] = result.ns_per_op;
+    item["items_per_second"] = result.items_per_second;
+    item["allocs_per_op"] = result.allocs_per_op;
+    item["bytes_per_op"] = result.bytes_per_op;
+    root["benchmarks"].push_back(item);
+  }
+  std::ofstream ofs(file_path);
+  if (!ofs.is_open()) {
+    printf("failed to open %s\n", file_path.c_str());
+    return -1;
+  }
+  ofs << root.dump(2) << std::endl;
+  return 0;
+}
+
+// return the number of benchmarks slower than baseline * (1 + threshold)
+int compareBaseline(const std::string &file_path,
+                    const std::vector<BenchResult> &results, float threshold) {
+  std::ifstream ifs(file_path);
+  if (!ifs.is_open()) {
+    printf("failed to open baseline %s\n", file_path.c_str());
+    return -1;
+  }
+  nlohmann::json root;
+  ifs >> root;
+  std::map<std::string, double> baseline;
+  for (auto &item : root["benchmarks"]) {
+    if (!item.value("skipped", false)) {
+      baseline[item["name"].get<std::string>()] =
+          item["ns_per_op"].get<double>();
+    }
+  }
+
+  int num_regressions = 0;
+  printf("\n%-40s %14s %14s %8s\n", "benchmark", "baseline ns", "current ns",
+         "change");
+  for (auto &result : results) {
+    if (result.skipped || baseline.count(result.name) == 0) {
+      continue;
+    }
+    double base_ns = baseline[result.name];
+    double change = base_ns > 0 ? result.ns_per_op / base_ns - 1 : 0;
+    bool regressed = change > threshold;
+    printf("%-40s %14.1f %14.1f %+7.1f%%%s\n", result.name.c_str(), base_ns,
+           result.ns_per_op, change * 100, regressed ? "  REGRESSION" : "");
+    if (regressed) {
+      num_regressions++;
+    }
+  }
+  return num_regressions;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  BenchOptions options;
+  std::string json_file;
+  std::string baseline_file;
+  float threshold = 0.1f;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--filter" && has_value) {
+      options.filter = argv[++i];
+    } else if (arg == "--min_time_ms" && has_value) {
+      options.min_time_ms = atof(argv[++i]);
+    } else if (arg == "--min_iters" && has_value) {
+      options.min_iterations = atol(argv[++i]);
+    } else if (arg == "--fixture_dir" && has_value) {
+      options.fixture_dir = argv[++i];
+    } else if (arg == "--json" && has_value) {
+      json_file = argv[++i];
+    } else if (arg == "--baseline" && has_value) {
+      baseline_file = argv[++i];
+    } else if (arg == "--threshold" && has_value) {
+      threshold = atof(argv[++i]);
+    } else {
+      printUsage(argv[0]);
+      return arg == "--help" || arg == "-h" ? 0 : -1;
+    }
+  }
+
+  std::vector<BenchResult> results = BenchRegistry::instance().run(options);
+
+  if (!json_file.empty() && writeJson(json_file, results) != 0) {
+    return -1;
+  }
+  if (!baseline_file.empty()) {
+    int num_regressions = compareBaseline(baseline_file, results, threshold);
+    if (num_regressions < 0) {
+      return -1;
+    }
+    if (num_regressions > 0) {
+      printf("%d benchmark(s) slower than baseline by more than %.0f%%\n",
+             num_regressions, threshold * 100);
+      return 1;
+    }
+  }
+  return 0;
+}
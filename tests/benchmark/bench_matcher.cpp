@@ -0,0 +1,68 @@
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "bench_framework.hpp"
+#include "matcher/base_matcher.hpp"
+
+namespace cvitdl {
+namespace bench {
+
+namespace {
+
+std::vector<std::shared_ptr<ModelFeatureInfo>> generateFeatures(
+    int num_features, int feature_dim, int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<std::shared_ptr<ModelFeatureInfo>> features;
+  for (int i = 0; i < num_features; i++) {
+    auto feature = std::make_shared<ModelFeatureInfo>();
+    feature->embedding = new uint8_t[feature_dim * sizeof(float)];
+    feature->embedding_num = feature_dim;
+    feature->embedding_type = TDLDataType::FP32;
+    float *data = reinterpret_cast<float *>(feature->embedding);
+    for (int j = 0; j < feature_dim; j++) {
+      data[j] = dist(gen);
+    }
+    features.push_back(feature);
+  }
+  return features;
+}
+
+void runCpuMatcher(BenchState &state, int gallery_num, int query_num) {
+  const int feature_dim = 512;
+  auto gallery = generateFeatures(gallery_num, feature_dim, 42);
+  auto queries = generateFeatures(query_num, feature_dim, 7);
+  std::shared_ptr<BaseMatcher> matcher = BaseMatcher::getMatcher("cpu");
+  if (matcher->loadGallery(gallery) != 0) {
+    state.skip("loadGallery failed");
+    return;
+  }
+  MatchResult result;
+  state.setItemsPerIteration(query_num);
+  while (state.keepRunning()) {
+    matcher->queryWithTopK(queries, 5, result);
+    doNotOptimize(result.indices.data());
+  }
+}
+
+}  // namespace
+
+TDL_BENCHMARK(BM_CpuMatcher_1Query_10kGallery) {
+  runCpuMatcher(state, 10000, 1);
+}
+
+TDL_BENCHMARK(BM_CpuMatcher_16Query_10kGallery) {
+  runCpuMatcher(state, 10000, 16);
+}
+
+TDL_BENCHMARK(BM_CpuMatcher_LoadGallery_10k) {
+  auto gallery = generateFeatures(10000, 512, 42);
+  std::shared_ptr<BaseMatcher> matcher = BaseMatcher::getMatcher("cpu");
+  while (state.keepRunning()) {
+    doNotOptimize(matcher->loadGallery(gallery));
+  }
+}
+
+}  // namespace bench
+}  // namespace cvitdl
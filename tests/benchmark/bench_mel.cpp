@@ -0,0 +1,34 @@
+#include <cmath>
+#include <vector>
+
+#include "audio_classification/melspec.hpp"
+#include "bench_framework.hpp"
+
+namespace cvitdl {
+namespace bench {
+
+// 与 AudioClassification 默认配置一致:16k 采样,3 秒音频
+TDL_BENCHMARK(BM_MelSpectrogram_3s16k) {
+  const int sample_rate = 16000;
+  const int n_fft = 1024, n_hop = 256, n_mel = 40;
+  const int data_len = sample_rate * 3;
+  const int num_frames = data_len / n_hop + 1;
+  melspec::MelFeatureExtract extractor(data_len, sample_rate, n_fft, n_hop,
+                                       n_mel, 0, sample_rate / 2, "reflect",
+                                       false);
+  std::vector<short> audio(data_len);
+  for (int i = 0; i < data_len; i++) {
+    audio[i] = static_cast<short>(
+        8000 * std::sin(2 * M_PI * 440 * i / sample_rate) +
+        2000 * std::sin(2 * M_PI * 3100 * i / sample_rate));
+  }
+  std::vector<int8_t> feature(num_frames * n_mel);
+  while (state.keepRunning()) {
+    extractor.melspectrogram_optimze(audio.data(), data_len, feature.data(),
+                                     feature.size(), 1.0f);
+    doNotOptimize(feature.data());
+  }
+}
+
+}  // namespace bench
+}  // namespace cvitdl
@@ -0,0 +1,82 @@
+#include <cstring>
+#include <memory>
+
+#include "bench_framework.hpp"
+#include "image/opencv_image.hpp"
+#include "preprocess/opencv_preprocessor.hpp"
+
+namespace cvitdl {
+namespace bench {
+
+namespace {
+
+PreprocessParams makeParams(int dst_width, int dst_height,
+                            ImageFormat dst_format, TDLDataType dst_type,
+                            bool keep_aspect_ratio) {
+  PreprocessParams params;
+  memset(&params, 0, sizeof(PreprocessParams));
+  params.dst_width = dst_width;
+  params.dst_height = dst_height;
+  params.dst_image_format = dst_format;
+  params.dst_pixdata_type = dst_type;
+  for (int i = 0; i < 3; i++) {
+    params.mean[i] = 0.5f;
+    params.scale[i] = 1 / 255.0f;
+  }
+  params.keep_aspect_ratio = keep_aspect_ratio;
+  return params;
+}
+
+void runPreprocess(BenchState &state, ImageFormat src_format,
+                   ImageFormat dst_format, TDLDataType dst_type,
+                   bool keep_aspect_ratio) {
+  std::shared_ptr<BaseImage> src_image = std::make_shared<OpenCVImage>(
+      1920, 1080, src_format, TDLDataType::UINT8, true);
+  src_image->randomFill();
+  OpenCVPreprocessor preprocessor;
+  PreprocessParams params =
+      makeParams(640, 640, dst_format, dst_type, keep_aspect_ratio);
+  state.setItemsPerIteration(1);
+  while (state.keepRunning()) {
+    std::shared_ptr<BaseImage> dst_image =
+        preprocessor.preprocess(src_image, params, nullptr);
+    if (dst_image == nullptr) {
+      state.skip("preprocess failed");
+      return;
+    }
+    doNotOptimize(dst_image.get());
+  }
+}
+
+}  // namespace
+
+TDL_BENCHMARK(BM_OpencvPreprocess_1080pToPlanarU8) {
+  runPreprocess(state, ImageFormat::BGR_PACKED, ImageFormat::RGB_PLANAR,
+                TDLDataType::UINT8, true);
+}
+
+TDL_BENCHMARK(BM_OpencvPreprocess_1080pToPlanarFp32) {
+  runPreprocess(state, ImageFormat::BGR_PACKED, ImageFormat::RGB_PLANAR,
+                TDLDataType::FP32, false);
+}
+
+TDL_BENCHMARK(BM_OpencvPreprocessToImage_Reused) {
+  std::shared_ptr<BaseImage> src_image = std::make_shared<OpenCVImage>(
+      1920, 1080, ImageFormat::BGR_PACKED, TDLDataType::UINT8, true);
+  src_image->randomFill();
+  std::shared_ptr<BaseImage> dst_image = std::make_shared<OpenCVImage>(
+      640, 640, ImageFormat::RGB_PLANAR, TDLDataType::UINT8, true);
+  OpenCVPreprocessor preprocessor;
+  PreprocessParams params = makeParams(640, 640, ImageFormat::RGB_PLANAR,
+                                       TDLDataType::UINT8, true);
+  while (state.keepRunning()) {
+    if (preprocessor.preprocessToImage(src_image, params, dst_image) != 0) {
+      state.skip("preprocessToImage failed");
+      return;
+    }
+    doNotOptimize(dst_image.get());
+  }
+}
+
+}  // namespace bench
+}  // namespace cvitdl
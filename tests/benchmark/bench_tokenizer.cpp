@@ -0,0 +1,116 @@
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench_framework.hpp"
+#include "utils/tokenizer_bpe.hpp"
+
+namespace cvitdl {
+namespace bench {
+
+namespace {
+
+const char *kSyntheticWords[] = {
+    "a",      "person", "walking", "with",    "dog",    "on",    "the",
+    "street", "car",    "parked",  "near",    "red",    "light", "people",
+    "riding", "bike",   "in",      "rain",    "at",     "night", "wearing",
+    "black",  "jacket", "holding", "umbrella"};
+
+// 按 CLIP bpe 文件格式生成一份小词表与合并规则,首行为版本说明
+int32_t writeSyntheticFixture(const std::string &dir) {
+  std::map<std::string, int> vocab;
+  std::vector<std::pair<std::string, std::string>> merges;
+  auto add_token = [&vocab](const std::string &token) {
+    if (vocab.count(token) == 0) {
+      int id = static_cast<int>(vocab.size());
+      vocab[token] = id;
+    }
+  };
+  add_token("<start_of_text>");
+  add_token("<end_of_text>");
+  for (char c = 'a'; c <= 'z'; c++) {
+    add_token(std::string(1, c));
+    add_token(std::string(1, c) + "</w>");
+  }
+  for (const char *word : kSyntheticWords) {
+    std::string w(word);
+    if (w.size() < 2) {
+      continue;
+    }
+    std::string merged(1, w[0]);
+    for (size_t i = 1; i < w.size(); i++) {
+      std::string next(1, w[i]);
+      if (i + 1 == w.size()) {
+        next += "</w>";
+      }
+      merges.emplace_back(merged, next);
+      merged += next;
+      add_token(merged);
+    }
+  }
+
+  std::ofstream encoder_file(dir + "/encoder.txt");
+  std::ofstream bpe_file(dir + "/bpe_simple_vocab.txt");
+  std::ofstream text_file(dir + "/input.txt");
+  if (!encoder_file || !bpe_file || !text_file) {
+    return -1;
+  }
+  for (auto &item : vocab) {
+    encoder_file << item.first << ": " << item.second << "\n";
+  }
+  bpe_file << "#version: synthetic\n";
+  for (auto &merge : merges) {
+    bpe_file << merge.first << " " << merge.second << "\n";
+  }
+  text_file << "a person walking with a dog on the street at night\n"
+            << "a red car parked near the light in the rain\n"
+            << "people riding bike wearing black jacket holding umbrella\n"
+            << "a person wearing red jacket walking in the street\n";
+  return 0;
+}
+
+}  // namespace
+
+// 优先使用 --fixture_dir/bpe 下录制的真实词表,否则使用合成词表
+TDL_BENCHMARK(BM_BpeTokenize_4Lines) {
+  std::string dir = BenchRegistry::options().fixture_dir + "/bpe";
+  if (BenchRegistry::options().fixture_dir.empty() ||
+      !std::ifstream(dir + "/encoder.txt").good()) {
+    dir = "/tmp";
+    if (writeSyntheticFixture(dir) != 0) {
+      state.skip("failed to write synthetic bpe fixture");
+      return;
+    }
+    state.setLabel("synthetic vocab");
+  }
+  BytePairEncoder encoder(dir + "/encoder.txt", dir + "/bpe_simple_vocab.txt");
+  std::string text_file = dir + "/input.txt";
+  std::vector<std::vector<int32_t>> tokens;
+  while (state.keepRunning()) {
+    tokens.clear();
+    encoder.tokenizerBPE(text_file, tokens);
+    doNotOptimize(tokens.data());
+  }
+  state.setItemsPerIteration(tokens.size());
+}
+
+TDL_BENCHMARK(BM_BpeTokenize_Sentence) {
+  std::string dir = "/tmp";
+  if (writeSyntheticFixture(dir) != 0) {
+    state.skip("failed to write synthetic bpe fixture");
+    return;
+  }
+  BytePairEncoder encoder(dir + "/encoder.txt", dir + "/bpe_simple_vocab.txt");
+  std::vector<std::vector<int32_t>> tokens;
+  while (state.keepRunning()) {
+    tokens.clear();
+    encoder.tokenizerBPE("a person wearing black jacket holding umbrella",
+                         tokens);
+    doNotOptimize(tokens.data());
+  }
+}
+
+}  // namespace bench
+}  // namespace cvitdl
@@ -0,0 +1,62 @@
+#include <random>
+#include <vector>
+
+#include "bench_framework.hpp"
+#include "tracker/tracker_types.hpp"
+
+namespace cvitdl {
+namespace bench {
+
+namespace {
+
+struct MovingObject {
+  float x, y, w, h, vx, vy;
+};
+
+void runMotTrack(BenchState &state, int num_objects) {
+  std::shared_ptr<Tracker> tracker =
+      TrackerFactory::createTracker(TrackerType::TDL_MOT_SORT);
+  const int img_width = 1920, img_height = 1080;
+  tracker->setImgSize(img_width, img_height);
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> x_dist(0, img_width - 200);
+  std::uniform_real_distribution<float> y_dist(0, img_height - 300);
+  std::uniform_real_distribution<float> v_dist(-4, 4);
+  std::normal_distribution<float> noise_dist(0, 1.5f);
+  std::vector<MovingObject> objects(num_objects);
+  for (auto &obj : objects) {
+    obj = {x_dist(gen), y_dist(gen), 80, 200, v_dist(gen), v_dist(gen)};
+  }
+
+  std::vector<ObjectBoxInfo> boxes;
+  std::vector<TrackerInfo> trackers;
+  uint64_t frame_id = 0;
+  state.setItemsPerIteration(num_objects);
+  while (state.keepRunning()) {
+    boxes.clear();
+    for (auto &obj : objects) {
+      obj.x += obj.vx;
+      obj.y += obj.vy;
+      if (obj.x < 0 || obj.x + obj.w > img_width) obj.vx = -obj.vx;
+      if (obj.y < 0 || obj.y + obj.h > img_height) obj.vy = -obj.vy;
+      float x1 = obj.x + noise_dist(gen);
+      float y1 = obj.y + noise_dist(gen);
+      ObjectBoxInfo box(0, 0.9f, x1, y1, x1 + obj.w, y1 + obj.h);
+      box.object_type = OBJECT_TYPE_PERSON;
+      boxes.push_back(box);
+    }
+    trackers.clear();
+    tracker->track(boxes, frame_id++, trackers);
+    doNotOptimize(trackers.data());
+  }
+}
+
+}  // namespace
+
+TDL_BENCHMARK(BM_MotTrack_20Objects) { runMotTrack(state, 20); }
+
+TDL_BENCHMARK(BM_MotTrack_100Objects) { runMotTrack(state, 100); }
+
+}  // namespace bench
+}  // namespace cvitdl
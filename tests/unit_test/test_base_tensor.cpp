@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "image/base_image.hpp"
+#include "memory/cpu_memory_pool.hpp"
+#include "tensor/base_tensor.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+static float bf16ToFloat(uint16_t v) {
+  uint32_t bits = (uint32_t)v << 16;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+static float fp16ToFloat(uint16_t v) {
+  int exponent = (v >> 10) & 0x1f;
+  int mantissa = v & 0x3ff;
+  float f = exponent == 0 ? std::ldexp((float)mantissa, -24)
+                          : std::ldexp((float)(mantissa | 0x400),
+                                       exponent - 25);
+  return (v & 0x8000) ? -f : f;
+}
+
+// 随机填充图像, 返回按 (通道, y, x) 排列的像素, 通道为图像自身的顺序
+static std::vector<uint8_t> fillImage(std::shared_ptr<BaseImage> image,
+                                      std::mt19937 &gen) {
+  std::uniform_int_distribution<int> pixel(0, 255);
+  int w = image->getWidth(), h = image->getHeight();
+  std::vector<uint8_t> pixels(3 * w * h);
+  std::vector<uint8_t *> ptrs = image->getVirtualAddress();
+  std::vector<uint32_t> strides = image->getStrides();
+  for (int c = 0; c < 3; c++) {
+    for (int y = 0; y < h; y++) {
+      for (int x = 0; x < w; x++) {
+        uint8_t v = (uint8_t)pixel(gen);
+        pixels[(c * h + y) * w + x] = v;
+        if (image->isPlanar()) {
+          ptrs[c][y * strides[c] + x] = v;
+        } else {
+          ptrs[0][y * strides[0] + 3 * x + c] = v;
+        }
+      }
+    }
+  }
+  return pixels;
+}
+
+TEST(BaseTensorTest, CopyPackedImageToInt8PlanarSlot) {
+  // 宽度不是 16 的倍数, 覆盖尾部
+  const int width = 70, height = 37;
+  std::mt19937 gen(3);
+  auto image = ImageFactory::createImage(width, height, ImageFormat::RGB_PACKED,
+                                         TDLDataType::UINT8, true);
+  ASSERT_NE(image, nullptr);
+  std::vector<uint8_t> pixels = fillImage(image, gen);
+
+  BaseTensor tensor(1, std::make_shared<CpuMemoryPool>());
+  tensor.reshape(2, 3, height, width);
+  memset(tensor.getMemoryBlock()->virtualAddress, 0, tensor.getCapacity());
+
+  PreprocessParams params;
+  memset(&params, 0, sizeof(params));
+  params.dst_image_format = ImageFormat::BGR_PLANAR;
+  params.dst_pixdata_type = TDLDataType::INT8;
+  const float mean[3] = {0.40f, 0.45f, 0.50f};
+  const float scale[3] = {1 / 255.f, 1 / 200.f, 1 / 128.f};
+  const float qscale = 100.f;
+  memcpy(params.mean, mean, sizeof(mean));
+  memcpy(params.scale, scale, sizeof(scale));
+  ASSERT_EQ(tensor.copyFromImage(image, params, 1, qscale), 0);
+
+  const int8_t *data = tensor.getBatchPtr<int8_t>(0);
+  for (int i = 0; i < 3 * width * height; i++) {
+    ASSERT_EQ(data[i], 0) << "batch 0 should be untouched";
+  }
+  data = tensor.getBatchPtr<int8_t>(1);
+  for (int c = 0; c < 3; c++) {
+    // 输出为 BGR, 取源图的 2 - c 通道
+    const uint8_t *src = &pixels[(2 - c) * width * height];
+    for (int i = 0; i < width * height; i++) {
+      float v = src[i] * (scale[c] * qscale) - mean[c] * qscale;
+      int expected = (int)std::lrint(std::fmin(127.f, std::fmax(-128.f, v)));
+      ASSERT_LE(std::abs(data[c * width * height + i] - expected), 1)
+          << "channel " << c << " index " << i;
+    }
+  }
+}
+
+TEST(BaseTensorTest, CopyPlanarImageToFloatTypes) {
+  const int width = 83, height = 29;
+  std::mt19937 gen(5);
+  auto image = ImageFactory::createImage(width, height, ImageFormat::RGB_PLANAR,
+                                         TDLDataType::UINT8, true);
+  ASSERT_NE(image, nullptr);
+  std::vector<uint8_t> pixels = fillImage(image, gen);
+
+  PreprocessParams params;
+  memset(&params, 0, sizeof(params));
+  params.dst_image_format = ImageFormat::RGB_PLANAR;
+  const float mean[3] = {123.675f / 58.395f, 116.28f / 57.12f,
+                         103.53f / 57.375f};
+  const float scale[3] = {1 / 58.395f, 1 / 57.12f, 1 / 57.375f};
+  memcpy(params.mean, mean, sizeof(mean));
+  memcpy(params.scale, scale, sizeof(scale));
+
+  const TDLDataType types[3] = {TDLDataType::FP32, TDLDataType::BF16,
+                                TDLDataType::FP16};
+  const float tolerances[3] = {1e-5f, 1.f / 256, 1.f / 2048};
+  for (int t = 0; t < 3; t++) {
+    params.dst_pixdata_type = types[t];
+    BaseTensor tensor(types[t] == TDLDataType::FP32 ? 4 : 2,
+                      std::make_shared<CpuMemoryPool>());
+    tensor.reshape(1, 3, height, width);
+    ASSERT_EQ(tensor.copyFromImage(image, params, 0), 0);
+    const uint8_t *data =
+        static_cast<uint8_t *>(tensor.getMemoryBlock()->virtualAddress);
+    for (int c = 0; c < 3; c++) {
+      for (int i = 0; i < width * height; i++) {
+        int index = c * width * height + i;
+        float expected = pixels[index] * scale[c] - mean[c];
+        float actual;
+        if (types[t] == TDLDataType::FP32) {
+          actual = reinterpret_cast<const float *>(data)[index];
+        } else if (types[t] == TDLDataType::BF16) {
+          actual = bf16ToFloat(reinterpret_cast<const uint16_t *>(data)[index]);
+        } else {
+          actual = fp16ToFloat(reinterpret_cast<const uint16_t *>(data)[index]);
+        }
+        ASSERT_NEAR(actual, expected,
+                    tolerances[t] * std::fmax(1.f, std::fabs(expected)))
+            << "type " << (int)types[t] << " index " << index;
+      }
+    }
+  }
+}
+
+TEST(BaseTensorTest, CopyRejectsMismatchedImage) {
+  auto image = ImageFactory::createImage(32, 16, ImageFormat::BGR_PACKED,
+                                         TDLDataType::UINT8, true);
+  ASSERT_NE(image, nullptr);
+  PreprocessParams params;
+  memset(&params, 0, sizeof(params));
+  params.dst_image_format = ImageFormat::BGR_PLANAR;
+  params.dst_pixdata_type = TDLDataType::FP32;
+
+  BaseTensor tensor(4, std::make_shared<CpuMemoryPool>());
+  tensor.reshape(1, 3, 16, 30);
+  EXPECT_EQ(tensor.copyFromImage(image, params, 0), -1);  // 尺寸不一致
+  tensor.reshape(1, 3, 16, 32);
+  EXPECT_EQ(tensor.copyFromImage(image, params, 1), -1);  // 槽位越界
+  params.dst_pixdata_type = TDLDataType::INT8;
+  EXPECT_EQ(tensor.copyFromImage(image, params, 0), -1);  // 元素大小不符
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "consumer_counting/consumer_counting.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+// 中心在 (cx, cy) 的 20x20 目标
+static TrackerInfo makeTrack(uint64_t track_id, float cx, float cy,
+                             TDLObjectType type = OBJECT_TYPE_HEAD) {
+  TrackerInfo track;
+  track.track_id_ = track_id;
+  track.obj_idx_ = 0;
+  track.box_info_.object_type = type;
+  track.box_info_.x1 = cx - 10;
+  track.box_info_.y1 = cy - 10;
+  track.box_info_.x2 = cx + 10;
+  track.box_info_.y2 = cy + 10;
+  return track;
+}
+
+TEST(ConsumerCountingTest, CountsPerArea) {
+  // 区域 0: y=100 的水平线, 向下为进入; 区域 1: 正方形区域, 从外到内为进入
+  ConsumerCounting counter(0, 100, 400, 100, 0, 1);
+  ASSERT_EQ(counter.add_counting_region(
+                {{100, 200}, {300, 200}, {300, 300}, {100, 300}}, 0),
+            1);
+
+  // 目标 1 沿 x=200 向下越线, 进入并离开区域; 目标 2 沿 x=350 向上越线
+  const float down_ys[] = {50, 80, 130, 180, 230, 280, 330, 330};
+  const float up_ys[] = {180, 150, 120, 70, 40, 40, 40, 40};
+  for (int frame = 0; frame < 8; frame++) {
+    std::vector<TrackerInfo> tracks = {makeTrack(1, 200, down_ys[frame]),
+                                       makeTrack(2, 350, up_ys[frame])};
+    ASSERT_EQ(counter.update_consumer_counting_state(tracks), 0);
+  }
+
+  std::vector<CountingArea> areas = counter.get_counting_areas();
+  ASSERT_EQ(areas.size(), 2u);
+  EXPECT_EQ(areas[0].enter_num, 1u);
+  EXPECT_EQ(areas[0].miss_num, 1u);
+  EXPECT_EQ(areas[1].enter_num, 1u);
+  EXPECT_EQ(areas[1].miss_num, 1u);
+  EXPECT_EQ(counter.get_enter_num(), 2u);
+  EXPECT_EQ(counter.get_miss_num(), 2u);
+
+  // 同一目标在同一区域的同一方向只计一次
+  for (int frame = 0; frame < 4; frame++) {
+    float y = frame % 2 ? 80 : 130;
+    ASSERT_EQ(counter.update_consumer_counting_state({makeTrack(1, 200, y)}),
+              0);
+  }
+  EXPECT_EQ(counter.get_counting_areas()[0].enter_num, 1u);
+
+  // 计数模式只统计人头, 其它类型的目标被忽略
+  ASSERT_EQ(counter.update_consumer_counting_state(
+                {makeTrack(3, 200, 50, OBJECT_TYPE_PERSON)}),
+            0);
+  EXPECT_EQ(counter.get_enter_num(), 2u);
+}
+
+// 越线检测模式: 目标丢失 lost_frames 帧后在线的另一侧重新出现
+static bool crossAfterLost(int lost_frames) {
+  ConsumerCounting counter(0, 100, 400, 100, 0, 1);
+  std::vector<uint64_t> cross_id;
+  counter.update_cross_detection_state({makeTrack(7, 200, 50)}, cross_id);
+  counter.update_cross_detection_state({makeTrack(7, 200, 60)}, cross_id);
+  EXPECT_TRUE(cross_id.empty());
+  for (int i = 0; i < lost_frames; i++) {
+    counter.update_cross_detection_state({}, cross_id);
+    EXPECT_TRUE(cross_id.empty());
+  }
+  counter.update_cross_detection_state({makeTrack(7, 200, 150)}, cross_id);
+  return cross_id.size() == 1 && cross_id[0] == 7;
+}
+
+TEST(ConsumerCountingTest, CrossDetectionKeepsLostTracks) {
+  // MAX_UNMATCHED_TIME (15) 帧内重新出现时沿用丢失前的位置, 判定为越线
+  EXPECT_TRUE(crossAfterLost(0));
+  EXPECT_TRUE(crossAfterLost(14));
+  // 丢失满 15 帧后 track 被移除, 重新出现时作为新目标, 不判定越线
+  EXPECT_FALSE(crossAfterLost(15));
+}
+
+TEST(ConsumerCountingTest, EditAreasWhileCounting) {
+  ConsumerCounting counter(0, 100, 400, 100, 0, 1);
+  std::atomic<bool> running(true);
+  // 调用方线程不断增删区域, 同时 pipeline 线程逐帧更新计数
+  std::thread editor([&]() {
+    for (int i = 0; running.load(); i++) {
+      if (i % 50 == 49) {
+        counter.clear_counting_areas();
+      } else if (i % 2 == 0) {
+        ASSERT_GE(counter.add_counting_line(0, 50 + i % 300, 400, 50 + i % 300,
+                                            i % 3),
+                  0);
+      } else {
+        ASSERT_GE(counter.add_counting_region(
+                      {{100, 100}, {300, 100}, {300, 300}, {100, 300}}, 0),
+                  0);
+      }
+      counter.set_counting_line(0, 100 + i % 100, 400, 100 + i % 100, 0);
+    }
+  });
+
+  std::vector<uint64_t> cross_id;
+  for (int frame = 0; frame < 2000; frame++) {
+    std::vector<TrackerInfo> tracks;
+    for (uint64_t id = 0; id < 8; id++) {
+      // 每个目标上下往返, 反复越过计数线并进出区域
+      float y = 20 + (frame * (id + 3) + id * 37) % 360;
+      tracks.push_back(makeTrack(id + (frame / 200) * 8, 50 + id * 40, y));
+    }
+    ASSERT_EQ(counter.update_consumer_counting_state(tracks), 0);
+    ASSERT_EQ(counter.update_cross_detection_state(tracks, cross_id), 0);
+    std::vector<CountingArea> areas = counter.get_counting_areas();
+    uint32_t enter_sum = 0;
+    for (const CountingArea &area : areas) {
+      enter_sum += area.enter_num;
+    }
+    // 清空区域后总数仍保留, 不会小于现存区域的计数之和
+    EXPECT_GE(counter.get_enter_num(), enter_sum);
+  }
+  running.store(false);
+  editor.join();
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "motion_detect/cpu_motion_detect/cpu_motion_detect.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+static const uint32_t kWidth = 160, kHeight = 120;
+
+// 灰度 50 的背景, 可选叠加一个灰度 200 的方块
+static std::shared_ptr<BaseImage> makeFrame(const ObjectBoxInfo *block) {
+  auto image = ImageFactory::createImage(kWidth, kHeight, ImageFormat::GRAY,
+                                         TDLDataType::UINT8, true);
+  uint8_t *data = image->getVirtualAddress()[0];
+  uint32_t stride = image->getStrides()[0];
+  for (uint32_t y = 0; y < kHeight; y++) {
+    for (uint32_t x = 0; x < kWidth; x++) {
+      bool inside = block != nullptr && x >= block->x1 && x <= block->x2 &&
+                    y >= block->y1 && y <= block->y2;
+      data[y * stride + x] = inside ? 200 : 50;
+    }
+  }
+  return image;
+}
+
+static ObjectBoxInfo makeBox(float x1, float y1, float x2, float y2) {
+  ObjectBoxInfo box;
+  box.x1 = x1;
+  box.y1 = y1;
+  box.x2 = x2;
+  box.y2 = y2;
+  return box;
+}
+
+TEST(CpuMotionDetectTest, DetectsMovingBlock) {
+  const ObjectBoxInfo block = makeBox(40, 30, 99, 79);
+  auto background = makeFrame(nullptr);
+  auto frame = makeFrame(&block);
+  ASSERT_NE(background, nullptr);
+
+  CpuMotionDetection detector;
+  ASSERT_EQ(detector.setBackground(background), 0);
+  std::vector<ObjectBoxInfo> objs;
+  ASSERT_EQ(detector.detect(background, 30, 100, objs), 0);
+  EXPECT_TRUE(objs.empty());
+
+  ASSERT_EQ(detector.detect(frame, 30, 100, objs), 0);
+  ASSERT_EQ(objs.size(), 1u);
+  // 连通域标记以超像素为单位, 框与方块的偏差在几个像素内
+  EXPECT_NEAR(objs[0].x1, block.x1, 8);
+  EXPECT_NEAR(objs[0].y1, block.y1, 8);
+  EXPECT_NEAR(objs[0].x2, block.x2, 8);
+  EXPECT_NEAR(objs[0].y2, block.y2, 8);
+}
+
+TEST(CpuMotionDetectTest, RoiSmallerThanGridCell) {
+  const ObjectBoxInfo block = makeBox(40, 30, 99, 79);
+  auto background = makeFrame(nullptr);
+  auto frame = makeFrame(&block);
+
+  CpuMotionDetection detector;
+  ASSERT_EQ(detector.setBackground(background), 0);
+  // 方块外的大 ROI, 方块内不足一个网格的 ROI, 背景上的单像素 ROI
+  const ObjectBoxInfo far_roi = makeBox(110, 90, 150, 115);
+  const ObjectBoxInfo tiny_roi = makeBox(61, 50, 61, 51);
+  const ObjectBoxInfo idle_roi = makeBox(5, 5, 5, 5);
+  ASSERT_EQ(detector.setROI({far_roi, tiny_roi, idle_roi}), 0);
+
+  std::vector<ObjectBoxInfo> objs;
+  ASSERT_EQ(detector.detect(frame, 30, 4, objs), 0);
+  ASSERT_EQ(objs.size(), 1u);
+  EXPECT_EQ(objs[0].x1, tiny_roi.x1);
+  EXPECT_EQ(objs[0].y1, tiny_roi.y1);
+  EXPECT_EQ(objs[0].x2, tiny_roi.x2);
+  EXPECT_EQ(objs[0].y2, tiny_roi.y2);
+
+  // 前景面积不足 min_area 时不输出
+  ASSERT_EQ(detector.detect(frame, 30, 100, objs), 0);
+  EXPECT_TRUE(objs.empty());
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
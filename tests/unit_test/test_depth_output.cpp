@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/model_output_types.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+static float referenceFp16(uint16_t half) {
+  int exponent = (half >> 10) & 0x1f;
+  int mantissa = half & 0x3ff;
+  float value;
+  if (exponent == 0) {
+    value = std::ldexp(float(mantissa), -24);
+  } else if (exponent == 31) {
+    value = mantissa == 0 ? INFINITY : NAN;
+  } else {
+    value = std::ldexp(float(mantissa | 0x400), exponent - 25);
+  }
+  return (half & 0x8000) ? -value : value;
+}
+
+static float referenceValue(const std::vector<uint8_t> &raw, TDLDataType type,
+                            size_t i, float scale, float focal_baseline) {
+  float value = 0;
+  if (type == TDLDataType::INT8) {
+    value = float(int8_t(raw[i]));
+  } else if (type == TDLDataType::UINT8) {
+    value = float(raw[i]);
+  } else if (type == TDLDataType::FP16) {
+    value = referenceFp16(uint16_t(raw[2 * i] | (raw[2 * i + 1] << 8)));
+  } else if (type == TDLDataType::BF16) {
+    uint32_t bits = uint32_t(raw[2 * i] | (raw[2 * i + 1] << 8)) << 16;
+    memcpy(&value, &bits, sizeof(value));
+  } else {
+    memcpy(&value, raw.data() + 4 * i, sizeof(value));
+  }
+  value *= scale;
+  if (focal_baseline > 0) {
+    value = value > 0 ? focal_baseline / value : 0.0f;
+  }
+  return value;
+}
+
+TEST(DepthOutputTestSuite, ConvertMatchesScalar) {
+  std::mt19937 gen(5);
+  const size_t n = 4096 + 1037;
+  const TDLDataType types[] = {TDLDataType::INT8, TDLDataType::UINT8,
+                               TDLDataType::FP16, TDLDataType::BF16,
+                               TDLDataType::FP32};
+  const size_t elem_bytes[] = {1, 1, 2, 2, 4};
+  for (int t = 0; t < 5; t++) {
+    std::vector<uint8_t> raw(n * elem_bytes[t]);
+    for (auto &byte : raw) {
+      byte = uint8_t(gen());
+    }
+    if (types[t] == TDLDataType::FP32) {
+      // 随机位模式多为极端值, 改用常规范围
+      std::uniform_real_distribution<float> dist(-8.0f, 64.0f);
+      for (size_t i = 0; i < n; i++) {
+        float value = dist(gen);
+        memcpy(raw.data() + 4 * i, &value, sizeof(value));
+      }
+    }
+    const float scale = types[t] == TDLDataType::INT8 ? 0.125f : 1.0f;
+    for (float focal_baseline : {0.0f, 96.0f}) {
+      std::vector<float> out(n);
+      ASSERT_EQ(ModelDepthInfo::convertToFloat(raw.data(), types[t], scale,
+                                               focal_baseline, out.data(), n),
+                0);
+      for (size_t i = 0; i < n; i++) {
+        float expected = referenceValue(raw, types[t], i, scale,
+                                        focal_baseline);
+        if (std::isnan(expected)) {
+          ASSERT_TRUE(std::isnan(out[i])) << "type " << t << " index " << i;
+        } else {
+          ASSERT_EQ(out[i], expected) << "type " << t << " index " << i;
+        }
+      }
+    }
+  }
+  float value;
+  EXPECT_EQ(ModelDepthInfo::convertToFloat(&value, TDLDataType::INT32, 1.0f,
+                                           0.0f, &value, 1),
+            -1);
+}
+
+// 有效点 (> 0) 的下中位数
+static float referenceMedian(const std::vector<float> &full, int w, int x,
+                             int y, int roi_w, int roi_h) {
+  std::vector<float> values;
+  for (int r = y; r < y + roi_h; r++) {
+    for (int c = x; c < x + roi_w; c++) {
+      if (full[r * w + c] > 0) {
+        values.push_back(full[r * w + c]);
+      }
+    }
+  }
+  std::sort(values.begin(), values.end());
+  return values[(values.size() - 1) / 2];
+}
+
+TEST(DepthOutputTestSuite, RoiMedianOnNativeOutput) {
+  const int w = 40, h = 30;
+  std::mt19937 gen(6);
+  std::vector<int8_t> disparity(w * h);
+  std::vector<uint16_t> disparity_fp16(w * h);
+  for (int i = 0; i < w * h; i++) {
+    // 含非正值 (无效视差)
+    disparity[i] = int8_t(int(gen() % 100) - 10);
+    disparity_fp16[i] = uint16_t(0x3c00 + (gen() % 0x800));  // [1, 4)
+  }
+
+  ModelDepthInfo depth;
+  depth.w = w;
+  depth.h = h;
+  depth.native_type = TDLDataType::INT8;
+  depth.native_scale = 0.25f;
+  depth.native_data = disparity.data();
+  depth.focal_baseline = 50.0f;
+  std::vector<float> full(w * h);
+  ASSERT_EQ(depth.toFloat(full.data()), 0);
+  EXPECT_EQ(depth.valueAt(7, 3), full[3 * w + 7]);
+  EXPECT_EQ(full[0], disparity[0] > 0 ? 50.0f / (disparity[0] * 0.25f) : 0);
+
+  const int rois[][4] = {{0, 0, w, h}, {3, 5, 10, 8}, {21, 17, 6, 1}};
+  for (const auto &roi : rois) {
+    float median = 0;
+    ASSERT_EQ(depth.roiMedian(roi[0], roi[1], roi[2], roi[3], &median), 0);
+    EXPECT_EQ(median, referenceMedian(full, w, roi[0], roi[1], roi[2], roi[3]));
+  }
+  float median;
+  EXPECT_EQ(depth.roiMedian(35, 25, 10, 10, &median), -1);
+
+  depth.native_type = TDLDataType::FP16;
+  depth.native_scale = 1.0f;
+  depth.native_data = disparity_fp16.data();
+  ASSERT_EQ(depth.toFloat(full.data()), 0);
+  for (const auto &roi : rois) {
+    ASSERT_EQ(depth.roiMedian(roi[0], roi[1], roi[2], roi[3], &median), 0);
+    EXPECT_EQ(median, referenceMedian(full, w, roi[0], roi[1], roi[2], roi[3]));
+  }
+
+  // 已展开为 float 时直接在 logits 上统计
+  depth.logits = (float *)malloc(w * h * sizeof(float));
+  memcpy(depth.logits, full.data(), w * h * sizeof(float));
+  depth.native_data = nullptr;
+  ASSERT_EQ(depth.roiMedian(3, 5, 10, 8, &median), 0);
+  EXPECT_EQ(median, referenceMedian(full, w, 3, 5, 10, 8));
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
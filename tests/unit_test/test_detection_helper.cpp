@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "utils/detection_helper.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+TEST(DetectionHelperTest, FilterScoresMatchesScalarScan) {
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  // 长度不是 4 的倍数, 覆盖尾部
+  std::vector<float> scores(1027);
+  for (auto &s : scores) s = dist(gen);
+  scores[3] = 0.5f;  // 等于阈值的不保留
+
+  std::vector<uint32_t> indices = {7};  // 结果追加到已有内容之后
+  DetectionHelper::filterScores(scores.data(), scores.size(), 0.5f, indices);
+
+  std::vector<uint32_t> expected = {7};
+  for (uint32_t i = 0; i < scores.size(); i++) {
+    if (scores[i] > 0.5f) expected.push_back(i);
+  }
+  EXPECT_EQ(indices, expected);
+}
+
+TEST(DetectionHelperTest, NmsIndicesMatchesNmsObjects) {
+  std::mt19937 gen(9);
+  std::uniform_real_distribution<float> pos(0.f, 300.f);
+  std::uniform_real_distribution<float> size(5.f, 60.f);
+  std::uniform_real_distribution<float> score(0.f, 1.f);
+  for (int trial = 0; trial < 20; trial++) {
+    std::vector<ObjectBoxInfo> boxes;
+    std::vector<ObjectBoxLandmarkInfo> objects;
+    for (int i = 0; i < 200; i++) {
+      float x = pos(gen), y = pos(gen);
+      ObjectBoxInfo box(0, score(gen), x, y, x + size(gen), y + size(gen));
+      boxes.push_back(box);
+      ObjectBoxLandmarkInfo object;
+      object.class_id = i;  // 记录原序号
+      object.score = box.score;
+      object.x1 = box.x1;
+      object.y1 = box.y1;
+      object.x2 = box.x2;
+      object.y2 = box.y2;
+      objects.push_back(object);
+    }
+
+    std::vector<uint32_t> keep;
+    DetectionHelper::nmsIndices(boxes, 0.4f, keep);
+    DetectionHelper::nmsObjects(objects, 0.4f);
+    ASSERT_EQ(keep.size(), objects.size());
+    for (size_t i = 0; i < keep.size(); i++) {
+      EXPECT_EQ((int)keep[i], objects[i].class_id);
+    }
+  }
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
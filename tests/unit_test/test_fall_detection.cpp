@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "fall_detection/fall_detection.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+static const float kScoreThreshold = 0.4;
+
+// 改为 FallDetStore 之前逐 track 的实现, 作为对照
+class RefFallDet {
+ public:
+  explicit RefFallDet(uint64_t id) : uid(id) {
+    for (int i = 0; i < 4; i++) valid_list.push(0);
+    for (int i = 0; i < 3; i++) speed_caches_.push(0);
+    for (int i = 0; i < 6; i++) statuses_cache_.push(0);
+  }
+
+  int detect(const ObjectBoxLandmarkInfo &person, float fps) {
+    if (!keypointsUseful(person)) {
+      updateQueue(valid_list, 0);
+      return 0;
+    }
+    updateQueue(valid_list, 1);
+    if (elemCount(valid_list) != 4) {
+      return 0;
+    }
+    float neck_x, neck_y, hip_x, hip_y;
+    average3(history_neck_, 1, &neck_x, &neck_y);
+    average3(history_hip_, 1, &hip_x, &hip_y);
+    float human_angle =
+        atan2(hip_y - neck_y, hip_x - neck_x) * 180.0 / M_PI - 90.0;
+    float aspect_ratio = (person.x2 - person.x1) / (person.y2 - person.y1);
+    float speed = speedDetection(person, fps);
+    int status = actionAnalysis(human_angle, aspect_ratio, speed);
+    updateQueue(statuses_cache_, status == 2 ? 1 : 0);
+    return elemCount(statuses_cache_) >= 3 ? 1 : 0;
+  }
+
+  static void updateQueue(std::queue<int> &q, int val) {
+    q.pop();
+    q.push(val);
+  }
+
+  std::queue<int> valid_list;
+  uint64_t uid;
+  int unmatched_times = 0;
+  int MAX_UNMATCHED_TIME = 30;
+
+ private:
+  typedef std::vector<std::pair<float, float>> PointList;
+
+  static int elemCount(std::queue<int> q) {
+    int num = 0;
+    for (; !q.empty(); q.pop()) num += q.front();
+    return num;
+  }
+
+  static void average3(const PointList &points, int index, float *x, float *y) {
+    float tmp_x = 0, tmp_y = 0;
+    for (int i = index; i < index + 3; i++) {
+      tmp_x += points[i].first;
+      tmp_y += points[i].second;
+    }
+    *x = tmp_x / 3.0f;
+    *y = tmp_y / 3.0f;
+  }
+
+  static float limb(const ObjectBoxLandmarkInfo &p, int a, int b, int c) {
+    float up = sqrt(pow(p.landmarks_x[a] - p.landmarks_x[b], 2) +
+                    pow(p.landmarks_y[a] - p.landmarks_y[b], 2));
+    float bottom = sqrt(pow(p.landmarks_x[b] - p.landmarks_x[c], 2) +
+                        pow(p.landmarks_y[b] - p.landmarks_y[c], 2));
+    return up + bottom;
+  }
+
+  static bool scored(const ObjectBoxLandmarkInfo &p, int a, int b, int c) {
+    return p.landmarks_score[a] > kScoreThreshold &&
+           p.landmarks_score[b] > kScoreThreshold &&
+           p.landmarks_score[c] > kScoreThreshold;
+  }
+
+  bool keypointsUseful(const ObjectBoxLandmarkInfo &p) {
+    if (history_neck_.size() == 4) {
+      history_neck_.erase(history_neck_.begin());
+      history_hip_.erase(history_hip_.begin());
+    }
+    if (p.landmarks_score[5] > kScoreThreshold &&
+        p.landmarks_score[6] > kScoreThreshold &&
+        p.landmarks_score[11] > kScoreThreshold &&
+        p.landmarks_score[12] > kScoreThreshold) {
+      history_neck_.push_back(
+          std::make_pair((p.landmarks_x[5] + p.landmarks_x[6]) / 2.0f,
+                         (p.landmarks_y[5] + p.landmarks_y[6]) / 2.0f));
+      history_hip_.push_back(
+          std::make_pair((p.landmarks_x[11] + p.landmarks_x[12]) / 2.0f,
+                         (p.landmarks_y[11] + p.landmarks_y[12]) / 2.0f));
+      return true;
+    }
+    history_neck_.push_back(std::make_pair(0, 0));
+    history_hip_.push_back(std::make_pair(0, 0));
+    return false;
+  }
+
+  float speedDetection(const ObjectBoxLandmarkInfo &p, float fps) {
+    float x_before, y_before, x_cur, y_cur;
+    average3(history_neck_, 0, &x_before, &y_before);
+    average3(history_neck_, 1, &x_cur, &y_cur);
+    float delta_position =
+        sqrt(pow(x_before - x_cur, 2) + pow(y_before - y_cur, 2));
+    if (y_cur < y_before) {
+      delta_position = -delta_position;
+    }
+
+    float box_w = p.x2 - p.x1;
+    float box_h = p.y2 - p.y1;
+    if (p.landmarks_score[13] < kScoreThreshold &&
+        p.landmarks_score[14] < kScoreThreshold &&
+        p.landmarks_score[15] < kScoreThreshold &&
+        p.landmarks_score[16] < kScoreThreshold) {
+      box_h *= 1.8;
+    } else if (p.landmarks_score[15] < kScoreThreshold &&
+               p.landmarks_score[16] < kScoreThreshold) {
+      box_h *= 1.3;
+    }
+    std::vector<float> delta_val = {
+        (float)sqrt(pow(box_w, 2) + pow(box_h, 2))};
+    if (scored(p, 12, 14, 16)) delta_val.push_back(limb(p, 12, 14, 16) * 2.4);
+    if (scored(p, 11, 13, 15)) delta_val.push_back(limb(p, 11, 13, 15) * 2.4);
+    if (scored(p, 6, 8, 10)) delta_val.push_back(limb(p, 6, 8, 10) * 3.4);
+    if (scored(p, 5, 7, 9)) delta_val.push_back(limb(p, 5, 7, 9) * 3.4);
+    double delta_sum = 0.0;
+    for (float val : delta_val) delta_sum += val;
+    double delta_mean = delta_sum / (float)delta_val.size();
+
+    float speed = 100.0 * delta_position / (delta_mean * (1.0 / fps));
+    updateQueue(speed_caches_, speed > kSpeedThreshold ? 1 : 0);
+    is_moving_ = elemCount(speed_caches_) >= 2;
+    return speed;
+  }
+
+  int actionAnalysis(float human_angle, float aspect_ratio, float speed) {
+    // stand still, walking, fall, lie, sit
+    float score[5] = {0.0};
+    if (human_angle > -25.0 && human_angle < 25.0) {
+      score[0] += 0.8, score[1] += 0.8, score[4] += 0.8;
+    } else {
+      score[2] += 0.8, score[3] += 0.8;
+    }
+    if (aspect_ratio < 0.6f) {
+      score[0] += 0.8, score[1] += 0.8;
+    } else if (aspect_ratio > 1.0f / 0.6f) {
+      score[3] += 0.8;
+    } else {
+      score[2] += 0.8, score[4] += 0.8;
+    }
+    if (speed < kSpeedThreshold) {
+      score[0] += 0.8, score[1] += 0.8, score[3] += 0.8, score[4] += 0.8;
+    } else {
+      score[2] += 0.8;
+    }
+    if (is_moving_) {
+      score[1] += 0.8, score[2] += 0.8;
+    } else {
+      score[0] += 0.8, score[3] += 0.8, score[4] += 0.8;
+    }
+    return std::max_element(score, score + 5) - score;
+  }
+
+  static constexpr float kSpeedThreshold = 95.0;
+
+  PointList history_neck_, history_hip_;
+  std::queue<int> speed_caches_, statuses_cache_;
+  bool is_moving_ = false;
+};
+
+constexpr float RefFallDet::kSpeedThreshold;
+
+TEST(FallDetStoreTest, MatchesPerTrackImplementation) {
+  FallDetStore store;
+  std::vector<RefFallDet> ref_tracks;
+
+  // 10 个 track, 其中 id 为 3 的倍数的每 40 帧交替站立/倒地下落,
+  // 关键点分数随机失效, 每帧约 10% 的 track 缺失
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> uniform(0, 1);
+  std::map<uint64_t, std::pair<float, float>> positions;
+  int num_falls = 0;
+  for (int frame = 0; frame < 500; frame++) {
+    std::vector<uint64_t> uids;
+    std::vector<ObjectBoxLandmarkInfo> persons;
+    for (uint64_t uid = 0; uid < 10; uid++) {
+      if (uniform(rng) < 0.1) {
+        continue;
+      }
+      if (positions.count(uid) == 0) {
+        positions[uid] = std::make_pair(uniform(rng) * 400, uniform(rng) * 400);
+      }
+      bool fall = uid % 3 == 0 && (frame / 40) % 2 == 1;
+      float &cx = positions[uid].first;
+      float &cy = positions[uid].second;
+      cx += (uniform(rng) - 0.5f) * 6;
+      cy += fall ? 30 + uniform(rng) * 10 : (uniform(rng) - 0.5f) * 6;
+      ObjectBoxLandmarkInfo person;
+      for (int k = 0; k < 17; k++) {
+        float ox = fall ? (k - 8) * 8.0f : (k % 2 ? 10.0f : -10.0f);
+        float oy = fall ? (k % 2) * 5.0f : k * 8.0f;
+        person.landmarks_x.push_back(cx + ox + (uniform(rng) - 0.5f) * 4);
+        person.landmarks_y.push_back(cy + oy + (uniform(rng) - 0.5f) * 4);
+        person.landmarks_score.push_back(uniform(rng) < 0.95 ? 0.9f : 0.1f);
+      }
+      person.x1 = cx - (fall ? 70 : 15);
+      person.x2 = cx + (fall ? 70 : 15);
+      person.y1 = cy - 5;
+      person.y2 = cy + (fall ? 20 : 140);
+      uids.push_back(uid);
+      persons.push_back(person);
+    }
+
+    std::vector<const ObjectBoxLandmarkInfo *> person_ptrs;
+    for (auto &person : persons) {
+      person_ptrs.push_back(&person);
+    }
+    std::vector<int> falls;
+    store.detect(uids, person_ptrs, 21.0f, falls);
+
+    // 原 app 中对 track 列表的维护, 丢失的 track 有效队列补 0
+    std::map<uint64_t, size_t> index;
+    for (size_t i = 0; i < uids.size(); i++) {
+      index[uids[i]] = i;
+    }
+    std::map<uint64_t, int> expected;
+    std::map<uint64_t, bool> existing;
+    for (auto it = ref_tracks.begin(); it != ref_tracks.end();) {
+      existing[it->uid] = true;
+      if (index.count(it->uid) == 0) {
+        it->unmatched_times++;
+        if (it->unmatched_times == it->MAX_UNMATCHED_TIME) {
+          it = ref_tracks.erase(it);
+          continue;
+        }
+        RefFallDet::updateQueue(it->valid_list, 0);
+      } else {
+        expected[it->uid] = it->detect(persons[index[it->uid]], 21.0f);
+        it->unmatched_times = 0;
+      }
+      it++;
+    }
+    for (size_t i = 0; i < uids.size(); i++) {
+      if (existing.count(uids[i]) == 0) {
+        ref_tracks.emplace_back(uids[i]);
+        expected[uids[i]] = ref_tracks.back().detect(persons[i], 21.0f);
+      }
+    }
+
+    ASSERT_EQ(store.size(), ref_tracks.size()) << "frame " << frame;
+    ASSERT_EQ(falls.size(), uids.size());
+    for (size_t i = 0; i < uids.size(); i++) {
+      ASSERT_EQ(falls[i], expected[uids[i]])
+          << "frame " << frame << " uid " << uids[i];
+      num_falls += falls[i];
+    }
+  }
+  // 序列中确实出现了跌倒, 对比覆盖到报警分支
+  EXPECT_GT(num_falls, 0);
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
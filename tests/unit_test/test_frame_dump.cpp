@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "utils/frame_dump.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+static std::vector<uint8_t> readFile(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file),
+                              std::istreambuf_iterator<char>());
+}
+
+// 每个字节为 seed + 行 + 列, 便于校验去除了 stride 填充
+static void fillImage(std::shared_ptr<BaseImage> image, uint32_t row_bytes,
+                      int seed) {
+  uint8_t *data = image->getVirtualAddress()[0];
+  uint32_t stride = image->getStrides()[0];
+  for (uint32_t y = 0; y < image->getHeight(); y++) {
+    for (uint32_t x = 0; x < row_bytes; x++) {
+      data[y * stride + x] = (uint8_t)(seed + y + x);
+    }
+  }
+}
+
+TEST(FrameDumpTest, Y4mAppendsEveryNthFrame) {
+  const uint32_t width = 64, height = 48;
+  auto image = ImageFactory::createImage(width, height, ImageFormat::GRAY,
+                                         TDLDataType::UINT8, true);
+  ASSERT_NE(image, nullptr);
+  const std::string path = "frame_dump_test.y4m";
+  FrameDumpConfig config;
+  config.file_path = path;
+  config.format = FrameDumpFormat::Y4M;
+  config.every_n = 2;
+
+  FrameDumper dumper;
+  ASSERT_EQ(dumper.start(config), 0);
+  for (int i = 0; i < 6; i++) {
+    fillImage(image, width, i);
+    EXPECT_EQ(dumper.submit(image), i % 2 == 0 ? 0 : 1);
+  }
+  ASSERT_EQ(dumper.stop(), 0);
+  EXPECT_EQ(dumper.getWrittenFrames(), 3u);
+
+  std::vector<uint8_t> file = readFile(path);
+  const std::string header = "YUV4MPEG2 W64 H48 F25:1 Ip A1:1 Cmono\n";
+  const size_t frame_size = 6 + width * height;
+  ASSERT_EQ(file.size(), header.size() + 3 * frame_size);
+  EXPECT_EQ(std::string(file.begin(), file.begin() + header.size()), header);
+  for (int k = 0; k < 3; k++) {
+    const uint8_t *frame = file.data() + header.size() + k * frame_size;
+    EXPECT_EQ(memcmp(frame, "FRAME\n", 6), 0);
+    for (uint32_t y = 0; y < height; y++) {
+      for (uint32_t x = 0; x < width; x++) {
+        ASSERT_EQ(frame[6 + y * width + x], (uint8_t)(2 * k + y + x));
+      }
+    }
+  }
+  remove(path.c_str());
+}
+
+TEST(FrameDumpTest, RawDumpsTriggeredFrames) {
+  const uint32_t width = 33, height = 17;
+  auto image = ImageFactory::createImage(width, height, ImageFormat::BGR_PACKED,
+                                         TDLDataType::UINT8, true);
+  ASSERT_NE(image, nullptr);
+  const std::string path = "frame_dump_test.raw";
+  FrameDumpConfig config;
+  config.file_path = path;
+  config.format = FrameDumpFormat::RAW;
+  config.every_n = 0;  // 只输出触发的帧
+  config.direct_io = true;
+  config.preallocate_bytes = 1 << 20;
+
+  FrameDumper dumper;
+  ASSERT_EQ(dumper.start(config), 0);
+  for (int i = 0; i < 6; i++) {
+    if (i == 3) dumper.trigger(2);
+    fillImage(image, width * 3, i);
+    EXPECT_EQ(dumper.submit(image), i == 3 || i == 4 ? 0 : 1);
+  }
+  ASSERT_EQ(dumper.stop(), 0);
+  EXPECT_EQ(dumper.getWrittenFrames(), 2u);
+
+  std::vector<uint8_t> file = readFile(path);
+  const size_t plane_bytes = width * 3 * height;
+  ASSERT_EQ(file.size(), 2 * (sizeof(FrameDumpRawHeader) + plane_bytes));
+  const uint8_t *p = file.data();
+  for (int k = 3; k < 5; k++) {
+    FrameDumpRawHeader header;
+    memcpy(&header, p, sizeof(header));
+    EXPECT_EQ(memcmp(header.magic, "TDLF", 4), 0);
+    EXPECT_EQ(header.width, width);
+    EXPECT_EQ(header.height, height);
+    EXPECT_EQ(header.plane_num, 1u);
+    EXPECT_EQ(header.plane_bytes[0], plane_bytes);
+    EXPECT_EQ(header.frame_index, (uint64_t)k);
+    p += sizeof(header);
+    for (uint32_t y = 0; y < height; y++) {
+      for (uint32_t x = 0; x < width * 3; x++) {
+        ASSERT_EQ(p[y * width * 3 + x], (uint8_t)(k + y + x));
+      }
+    }
+    p += plane_bytes;
+  }
+  remove(path.c_str());
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <deque>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "human_pose_smooth/human_pose_smooth.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+// 改为 PoseSmoothStore 之前逐 track 的实现, 作为对照
+class RefHumanKeypoints {
+ public:
+  RefHumanKeypoints(uint64_t id, const SmoothAlgParam &param)
+      : uid(id), param_(param) {
+    if (param_.smooth_type == 0) {
+      weights_ = genWeights(param_.smooth_frames);
+    } else {
+      for (int i = 0; i < 17; i++) {
+        weights_.push_back((i < 5 ? 0.005 : 0.01) * param_.thres_mult);
+      }
+      float r = 2 * M_PI * param_.fc_d * param_.te;
+      alpha_ = r / (r + 1.0f);
+    }
+  }
+
+  void smoothKeypoints(ObjectBoxLandmarkInfo *kps_meta) {
+    if (param_.smooth_type == 0) {
+      weightAdd(kps_meta);
+      return;
+    }
+    if (first_time_) {
+      for (int i = 0; i < 17; i++) {
+        x_prev_hat_[i] = kps_meta->landmarks_x[i];
+        y_prev_hat_[i] = kps_meta->landmarks_y[i];
+      }
+      first_time_ = false;
+      return;
+    }
+    for (int i = 0; i < 17; i++) {
+      float x = kps_meta->landmarks_x[i];
+      float y = kps_meta->landmarks_y[i];
+      float deta_x = (x - x_prev_hat_[i]) / (float)param_.image_width;
+      float deta_y = (y - y_prev_hat_[i]) / (float)param_.image_height;
+      float distance = pow(deta_x * deta_x + deta_y * deta_y, 0.5);
+      if (distance >= weights_[i]) {
+        oneEuroFilter(x, y, i);
+      }
+      kps_meta->landmarks_x[i] = x_prev_hat_[i];
+      kps_meta->landmarks_y[i] = y_prev_hat_[i];
+    }
+  }
+
+  uint64_t uid;
+  int unmatched_times = 0;
+  int MAX_UNMATCHED_TIME = 30;
+
+ private:
+  static std::vector<float> genWeights(int n) {
+    float a1 = 1.0f / (2.0f * n);
+    float d = 1.0f / (float)(n * (n - 1));
+    std::vector<float> weights;
+    for (int i = 0; i < n; i++) {
+      weights.push_back(a1 + i * d);
+    }
+    return weights;
+  }
+
+  void oneEuroFilter(float x, float y, int i) {
+    float te = param_.te;
+    float dx = (x - x_prev_hat_[i]) / te;
+    float dy = (y - y_prev_hat_[i]) / te;
+    float dx_hat = dx * alpha_ + dx_prev_hat_[i] * (1.0f - alpha_);
+    float dy_hat = dy * alpha_ + dy_prev_hat_[i] * (1.0f - alpha_);
+    float fc_x = std::fabs(dx_hat) * param_.beta + param_.fc_min;
+    float fc_y = std::fabs(dy_hat) * param_.beta + param_.fc_min;
+    float r_x = fc_x * 2.0f * M_PI * te;
+    float r_y = fc_y * 2.0f * M_PI * te;
+    float alpha_x = r_x / (r_x + 1.0f);
+    float alpha_y = r_y / (r_y + 1.0f);
+    dx_prev_hat_[i] = dx_hat;
+    dy_prev_hat_[i] = dy_hat;
+    x_prev_hat_[i] = x * alpha_x + x_prev_hat_[i] * (1.0f - alpha_x);
+    y_prev_hat_[i] = y * alpha_y + y_prev_hat_[i] * (1.0f - alpha_y);
+  }
+
+  void weightAdd(ObjectBoxLandmarkInfo *kps_meta) {
+    history_.push_back(*kps_meta);
+    if (history_.size() < 2) {
+      return;
+    } else if ((int)history_.size() > param_.smooth_frames) {
+      history_.pop_front();
+    }
+    std::vector<float> weights = (int)history_.size() < param_.smooth_frames
+                                     ? genWeights(history_.size())
+                                     : weights_;
+    for (size_t i = 0; i < history_.size(); ++i) {
+      for (size_t j = 0; j < 17; ++j) {
+        float x = history_[i].landmarks_x[j] * weights[i];
+        float y = history_[i].landmarks_y[j] * weights[i];
+        kps_meta->landmarks_x[j] = i == 0 ? x : kps_meta->landmarks_x[j] + x;
+        kps_meta->landmarks_y[j] = i == 0 ? y : kps_meta->landmarks_y[j] + y;
+      }
+    }
+  }
+
+  SmoothAlgParam param_;
+  std::vector<float> weights_;
+  std::deque<ObjectBoxLandmarkInfo> history_;
+  float alpha_ = 0;
+  float x_prev_hat_[17] = {0}, y_prev_hat_[17] = {0};
+  float dx_prev_hat_[17] = {0}, dy_prev_hat_[17] = {0};
+  bool first_time_ = true;
+};
+
+// 原 app 中对 track 列表的维护: 丢失计数, 超时移除, 新 track 追加在末尾
+static void refSmooth(std::vector<RefHumanKeypoints> &tracks,
+                      const SmoothAlgParam &param,
+                      const std::vector<uint64_t> &uids,
+                      std::vector<ObjectBoxLandmarkInfo> &persons) {
+  std::map<uint64_t, size_t> index;
+  for (size_t i = 0; i < uids.size(); i++) {
+    index[uids[i]] = i;
+  }
+  std::map<uint64_t, bool> existing;
+  for (auto it = tracks.begin(); it != tracks.end();) {
+    existing[it->uid] = true;
+    if (index.count(it->uid) == 0) {
+      it->unmatched_times++;
+      if (it->unmatched_times == it->MAX_UNMATCHED_TIME) {
+        it = tracks.erase(it);
+        continue;
+      }
+    } else {
+      it->smoothKeypoints(&persons[index[it->uid]]);
+      it->unmatched_times = 0;
+    }
+    it++;
+  }
+  for (size_t i = 0; i < uids.size(); i++) {
+    if (existing.count(uids[i]) == 0) {
+      tracks.emplace_back(uids[i], param);
+      tracks.back().smoothKeypoints(&persons[i]);
+    }
+  }
+}
+
+static void checkAgainstReference(int smooth_type) {
+  SmoothAlgParam param;
+  param.smooth_type = smooth_type;
+  param.image_width = 640;
+  param.image_height = 480;
+  PoseSmoothStore store(param);
+  std::vector<RefHumanKeypoints> ref_tracks;
+
+  // 12 个 track 随机游走, 每帧约 30% 的 track 缺失, 覆盖超时移除与重新出现
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> uniform(0, 1);
+  std::map<uint64_t, std::vector<float>> positions;
+  for (int frame = 0; frame < 300; frame++) {
+    std::vector<uint64_t> uids;
+    std::vector<ObjectBoxLandmarkInfo> persons;
+    for (uint64_t uid = 0; uid < 12; uid++) {
+      if (uniform(rng) < 0.3) {
+        continue;
+      }
+      std::vector<float> &pos = positions[uid];
+      if (pos.empty()) {
+        pos.resize(34);
+        for (auto &v : pos) {
+          v = uniform(rng) * 400;
+        }
+      }
+      ObjectBoxLandmarkInfo person;
+      person.landmarks_x.resize(17);
+      person.landmarks_y.resize(17);
+      for (int k = 0; k < 17; k++) {
+        pos[k] += (uniform(rng) - 0.5f) * 20;
+        pos[17 + k] += (uniform(rng) - 0.5f) * 20;
+        person.landmarks_x[k] = pos[k];
+        person.landmarks_y[k] = pos[17 + k];
+      }
+      uids.push_back(uid);
+      persons.push_back(person);
+    }
+
+    std::vector<ObjectBoxLandmarkInfo> expected = persons;
+    refSmooth(ref_tracks, param, uids, expected);
+    std::vector<ObjectBoxLandmarkInfo *> person_ptrs;
+    for (auto &person : persons) {
+      person_ptrs.push_back(&person);
+    }
+    store.smooth(uids, person_ptrs);
+
+    ASSERT_EQ(store.size(), ref_tracks.size()) << "frame " << frame;
+    for (size_t i = 0; i < persons.size(); i++) {
+      for (int k = 0; k < 17; k++) {
+        ASSERT_NEAR(persons[i].landmarks_x[k], expected[i].landmarks_x[k],
+                    1e-3)
+            << "frame " << frame << " uid " << uids[i] << " kp " << k;
+        ASSERT_NEAR(persons[i].landmarks_y[k], expected[i].landmarks_y[k],
+                    1e-3)
+            << "frame " << frame << " uid " << uids[i] << " kp " << k;
+      }
+    }
+  }
+}
+
+TEST(PoseSmoothStoreTest, WeightAddMatchesPerTrackImplementation) {
+  checkAgainstReference(0);
+}
+
+TEST(PoseSmoothStoreTest, OneEuroMatchesPerTrackImplementation) {
+  checkAgainstReference(1);
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
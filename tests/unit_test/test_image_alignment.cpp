@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "utils/image_alignment.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+static const float kReferPts112[10] = {
+    38.29459953, 51.69630051, 73.53179932, 51.50139999, 56.02519989,
+    71.73660278, 41.54930115, 92.3655014,  70.72990036, 92.20410156};
+
+// 参考点经相似变换 (缩放 scale, 旋转 angle, 平移 tx/ty) 得到源图关键点
+static void makeLandmarks(float scale, float angle, float tx, float ty,
+                          float *pts) {
+  float c = scale * std::cos(angle), s = scale * std::sin(angle);
+  for (int i = 0; i < 5; i++) {
+    float x = kReferPts112[2 * i], y = kReferPts112[2 * i + 1];
+    pts[2 * i] = c * x - s * y + tx;
+    pts[2 * i + 1] = s * x + c * y + ty;
+  }
+}
+
+// 逐像素的浮点双线性参考, 图像外取 0; 源坐标按 cv::warpAffine 的方式
+// 先取 10 位小数 (行起点与列增量分别舍入) 再截断到 5 位小数
+static std::vector<unsigned char> referenceWarp(
+    const std::vector<unsigned char> &src, int width, int height,
+    const float *pts, int dst_size) {
+  float transform[6];
+  tdl_get_similarity_transform_matrix(pts, kReferPts112, 5, transform);
+  double d = (double)transform[0] * transform[4] -
+             (double)transform[1] * transform[3];
+  double m[6] = {transform[4] / d, -transform[1] / d, 0,
+                 -transform[3] / d, transform[0] / d, 0};
+  m[2] = -m[0] * transform[2] - m[1] * transform[5];
+  m[5] = -m[3] * transform[2] - m[4] * transform[5];
+
+  std::vector<unsigned char> dst(dst_size * dst_size * 3);
+  for (int y = 0; y < dst_size; y++) {
+    for (int x = 0; x < dst_size; x++) {
+      int ix = (int)std::lround((m[1] * y + m[2]) * 1024) +
+               (int)std::lround(m[0] * x * 1024) + 16;
+      int iy = (int)std::lround((m[4] * y + m[5]) * 1024) +
+               (int)std::lround(m[3] * x * 1024) + 16;
+      double fx = (ix >> 5) / 32.0, fy = (iy >> 5) / 32.0;
+      int sx = (int)std::floor(fx), sy = (int)std::floor(fy);
+      double ax = fx - sx, ay = fy - sy;
+      for (int c = 0; c < 3; c++) {
+        double v = 0;
+        for (int k = 0; k < 4; k++) {
+          int px = sx + (k & 1), py = sy + (k >> 1);
+          if (px < 0 || px >= width || py < 0 || py >= height) continue;
+          double w = ((k & 1) ? ax : 1 - ax) * ((k >> 1) ? ay : 1 - ay);
+          v += w * src[(py * width + px) * 3 + c];
+        }
+        dst[(y * dst_size + x) * 3 + c] = (unsigned char)(v + 0.5);
+      }
+    }
+  }
+  return dst;
+}
+
+TEST(ImageAlignmentTest, SimilarityTransformRecoversKnownTransform) {
+  float pts[10];
+  const float scale = 1.7f, angle = 0.3f, tx = 120.5f, ty = -40.25f;
+  makeLandmarks(scale, angle, tx, ty, pts);
+  // 源关键点 -> 参考点的变换是生成变换的逆
+  float transform[6];
+  ASSERT_EQ(tdl_get_similarity_transform_matrix(pts, kReferPts112, 5,
+                                                transform),
+            0);
+  for (int i = 0; i < 5; i++) {
+    float x = transform[0] * pts[2 * i] + transform[1] * pts[2 * i + 1] +
+              transform[2];
+    float y = transform[3] * pts[2 * i] + transform[4] * pts[2 * i + 1] +
+              transform[5];
+    EXPECT_NEAR(x, kReferPts112[2 * i], 1e-3);
+    EXPECT_NEAR(y, kReferPts112[2 * i + 1], 1e-3);
+  }
+  EXPECT_NEAR(transform[0], std::cos(angle) / scale, 1e-5);
+  EXPECT_NEAR(transform[1], std::sin(angle) / scale, 1e-5);
+}
+
+TEST(ImageAlignmentTest, FaceWarpMatchesBilinearReference) {
+  const int width = 320, height = 240, dst_size = 112;
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> pixel(0, 255);
+  std::vector<unsigned char> src(width * height * 3);
+  for (auto &v : src) v = (unsigned char)pixel(gen);
+
+  std::uniform_real_distribution<float> scale(0.6f, 2.5f);
+  std::uniform_real_distribution<float> angle(-1.2f, 1.2f);
+  // 平移范围让部分人脸越出图像, 覆盖边界处理
+  std::uniform_real_distribution<float> tx(-80.f, width - 40.f);
+  std::uniform_real_distribution<float> ty(-80.f, height - 40.f);
+  std::vector<unsigned char> dst(dst_size * dst_size * 3);
+  for (int trial = 0; trial < 50; trial++) {
+    float pts[10];
+    makeLandmarks(scale(gen), angle(gen), tx(gen), ty(gen), pts);
+    ASSERT_EQ(tdl_face_warp_affine(src.data(), width * 3, width, height,
+                                   dst.data(), dst_size * 3, dst_size,
+                                   dst_size, pts),
+              0);
+    std::vector<unsigned char> ref =
+        referenceWarp(src, width, height, pts, dst_size);
+    for (size_t i = 0; i < dst.size(); i++) {
+      ASSERT_LE(std::abs((int)dst[i] - (int)ref[i]), 1)
+          << "trial " << trial << " index " << i;
+    }
+  }
+}
+
+TEST(ImageAlignmentTest, Yuv420spWarpMatchesConvertedRgb) {
+  const int width = 200, height = 160, dst_size = 112;
+  std::mt19937 gen(11);
+  std::uniform_int_distribution<int> pixel(0, 255);
+  std::vector<unsigned char> y_plane(width * height);
+  std::vector<unsigned char> uv_plane(width * height / 2);
+  for (auto &v : y_plane) v = (unsigned char)pixel(gen);
+  for (auto &v : uv_plane) v = (unsigned char)pixel(gen);
+
+  for (int nv21 = 0; nv21 < 2; nv21++) {
+    // BT.601 转换, 与 cv::cvtColor(COLOR_YUV2RGB_NV12/NV21) 相同
+    std::vector<unsigned char> rgb(width * height * 3);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        const unsigned char *uv = &uv_plane[(y / 2) * width + (x & ~1)];
+        int u = uv[nv21] - 128, v = uv[1 - nv21] - 128;
+        int yy = std::max(0, y_plane[y * width + x] - 16) * 1220542;
+        int r = (yy + (1 << 19) + 1673527 * v) >> 20;
+        int g = (yy + (1 << 19) - 852492 * v - 409993 * u) >> 20;
+        int b = (yy + (1 << 19) + 2116026 * u) >> 20;
+        unsigned char *p = &rgb[(y * width + x) * 3];
+        p[0] = (unsigned char)std::min(255, std::max(0, r));
+        p[1] = (unsigned char)std::min(255, std::max(0, g));
+        p[2] = (unsigned char)std::min(255, std::max(0, b));
+      }
+    }
+
+    float pts[10];
+    makeLandmarks(1.2f, 0.4f, 60.f, 20.f, pts);
+    std::vector<unsigned char> expected(dst_size * dst_size * 3);
+    std::vector<unsigned char> actual(dst_size * dst_size * 3);
+    ASSERT_EQ(tdl_face_warp_affine(rgb.data(), width * 3, width, height,
+                                   expected.data(), dst_size * 3, dst_size,
+                                   dst_size, pts),
+              0);
+    ASSERT_EQ(tdl_face_warp_affine_yuv420sp(
+                  y_plane.data(), width, uv_plane.data(), width, nv21 == 1,
+                  width, height, actual.data(), dst_size * 3, dst_size,
+                  dst_size, pts),
+              0);
+    EXPECT_EQ(actual, expected) << "nv21 " << nv21;
+  }
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "cv/intrusion_detect/intrusion_detect.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+// 逐区域逐轴的分离轴测试, 作为参考结果
+static bool bruteForceIntrusion(const std::vector<PointsInfo> &regions,
+                                const ObjectBoxInfo &bbox) {
+  float bx[4] = {bbox.x1, bbox.x2, bbox.x2, bbox.x1};
+  float by[4] = {-bbox.y1, -bbox.y1, -bbox.y2, -bbox.y2};
+  for (const PointsInfo &region : regions) {
+    size_t n = region.x.size();
+    std::vector<float> xs = region.x, ys(n);
+    for (size_t i = 0; i < n; i++) ys[i] = -region.y[i];
+    std::vector<Vertex> axes = {{1, 0}, {0, 1}};
+    for (size_t i = 0; i < n; i++) {
+      size_t j = (i + 1) % n;
+      axes.push_back({-(ys[j] - ys[i]), xs[j] - xs[i]});
+    }
+    bool separating = false;
+    for (const Vertex &axis : axes) {
+      float min_1 = std::numeric_limits<float>::max(), max_1 = -min_1;
+      float min_2 = min_1, max_2 = -min_1;
+      for (size_t i = 0; i < n; i++) {
+        float proj = axis.x * xs[i] + axis.y * ys[i];
+        min_1 = std::min(min_1, proj);
+        max_1 = std::max(max_1, proj);
+      }
+      for (int i = 0; i < 4; i++) {
+        float proj = axis.x * bx[i] + axis.y * by[i];
+        min_2 = std::min(min_2, proj);
+        max_2 = std::max(max_2, proj);
+      }
+      if (!(max_1 >= min_2 && max_2 >= min_1)) {
+        separating = true;
+        break;
+      }
+    }
+    if (!separating) return true;
+  }
+  return false;
+}
+
+TEST(IntrusionDetectTestSuite, GridMatchesBruteForce) {
+  std::mt19937 rng(11);
+  IntrusionDetection detector;
+  for (int r = 0; r < 40; r++) {
+    /* 随机星形多边形, 可能是凹多边形 */
+    float cx = rng() % 1920, cy = rng() % 1080;
+    int n = 3 + rng() % 6;
+    PointsInfo points;
+    for (int i = 0; i < n; i++) {
+      float angle = 2 * M_PI * i / n;
+      float radius = 20 + rng() % 100;
+      points.x.push_back(std::round(cx + radius * std::cos(angle)));
+      points.y.push_back(std::round(cy + radius * std::sin(angle)));
+    }
+    ASSERT_EQ(detector.addRegion(points), 0);
+  }
+  std::vector<PointsInfo> regions;
+  detector.getRegion(regions);
+
+  std::vector<ObjectBoxInfo> bboxes(2000);
+  for (ObjectBoxInfo &bbox : bboxes) {
+    bbox.x1 = rng() % 1920;
+    bbox.y1 = rng() % 1080;
+    bbox.x2 = bbox.x1 + rng() % 150;
+    bbox.y2 = bbox.y1 + rng() % 150;
+  }
+  std::vector<bool> intrusions;
+  detector.isIntrusion(bboxes, intrusions);
+  ASSERT_EQ(intrusions.size(), bboxes.size());
+  int num_intrusions = 0;
+  for (size_t i = 0; i < bboxes.size(); i++) {
+    bool expected = bruteForceIntrusion(regions, bboxes[i]);
+    EXPECT_EQ(intrusions[i], expected);
+    EXPECT_EQ(detector.isIntrusion(bboxes[i]), expected);
+    num_intrusions += expected;
+  }
+  EXPECT_GT(num_intrusions, 0);
+  EXPECT_LT(num_intrusions, (int)bboxes.size());
+
+  detector.clean();
+  detector.isIntrusion(bboxes, intrusions);
+  EXPECT_EQ(std::count(intrusions.begin(), intrusions.end(), true), 0);
+}
+
+TEST(IntrusionDetectTestSuite, TouchingBoxIsIntrusion) {
+  IntrusionDetection detector;
+  PointsInfo square;
+  square.x = {100, 200, 200, 100};
+  square.y = {100, 100, 200, 200};
+  ASSERT_EQ(detector.addRegion(square), 0);
+
+  ObjectBoxInfo touching;
+  touching.x1 = 200;
+  touching.y1 = 150;
+  touching.x2 = 260;
+  touching.y2 = 180;
+  EXPECT_TRUE(detector.isIntrusion(touching));
+
+  ObjectBoxInfo outside = touching;
+  outside.x1 = 201;
+  EXPECT_FALSE(detector.isIntrusion(outside));
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
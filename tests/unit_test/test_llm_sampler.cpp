@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <set>
+#include <vector>
+
+#include "utils/llm_sampler.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+TEST(LLMSamplerTestSuite, TokenWindowHoldsLastTokens) {
+  const int capacity = 16;
+  const int window_size = 5;
+  std::vector<int> tokens = {100, 101, 102};
+  TokenWindow window;
+  window.reset(capacity, window_size, tokens.data(), tokens.size());
+
+  for (int step = 0; step < 40; step++) {
+    std::set<int> expected(
+        tokens.end() - std::min<size_t>(tokens.size(), window_size),
+        tokens.end());
+    const std::vector<int> &buffer = window.buffer();
+    ASSERT_EQ(buffer.size(), (size_t)capacity);
+    std::set<int> actual(buffer.begin(), buffer.end());
+    ASSERT_EQ(actual, expected) << "step " << step;
+
+    int token = 200 + step % 7;
+    std::vector<int> before = buffer;
+    bool padding_changed = window.push(token);
+    tokens.push_back(token);
+    if (!padding_changed) {
+      // only the slot of the new token differs
+      for (int i = 0; i < capacity; i++) {
+        if (i != window.lastSlot()) {
+          ASSERT_EQ(window.buffer()[i], before[i]) << "step " << step;
+        }
+      }
+    }
+  }
+  EXPECT_EQ(window.size(), window_size);
+}
+
+TEST(LLMSamplerTestSuite, GreedyAndRepetitionPenalty) {
+  LLMSampler sampler(1);
+  std::vector<float> logits = {1.0f, 4.0f, 3.0f, -2.0f};
+  LLMSampleParam param;
+  param.temperature = 0;
+  EXPECT_EQ(sampler.sample(logits.data(), logits.size(), param, nullptr, 0),
+            1);
+
+  // repeated history entries are penalized once
+  param.repetition_penalty = 2.0f;
+  std::vector<int> history = {1, 1, 1, 3};
+  EXPECT_EQ(sampler.sample(logits.data(), logits.size(), param,
+                           history.data(), history.size()),
+            2);
+  EXPECT_FLOAT_EQ(logits[1], 2.0f);
+  EXPECT_FLOAT_EQ(logits[3], -4.0f);
+}
+
+TEST(LLMSamplerTestSuite, TopKTopPDistribution) {
+  LLMSampler sampler(123);
+  const int vocab_size = 1000;
+  std::vector<float> base_logits(vocab_size, 0.0f);
+  base_logits[7] = 10.0f;
+  base_logits[42] = 10.0f + std::log(3.0f);
+
+  LLMSampleParam param;
+  param.top_k = 2;
+  std::vector<int> counts(vocab_size, 0);
+  const int num_samples = 20000;
+  for (int i = 0; i < num_samples; i++) {
+    std::vector<float> logits = base_logits;
+    int token = sampler.sample(logits.data(), vocab_size, param, nullptr, 0);
+    ASSERT_TRUE(token == 7 || token == 42);
+    counts[token]++;
+  }
+  EXPECT_NEAR(counts[42] / (double)num_samples, 0.75, 0.02);
+
+  // the top token alone covers top_p
+  param.top_k = 0;
+  param.top_p = 0.5f;
+  for (int i = 0; i < 100; i++) {
+    std::vector<float> logits = base_logits;
+    EXPECT_EQ(sampler.sample(logits.data(), vocab_size, param, nullptr, 0),
+              42);
+  }
+}
+
+TEST(LLMSamplerTestSuite, SampleCandidates) {
+  LLMSampler sampler(7);
+  std::vector<float> probs = {0.0f, 0.25f, 0.0f, 0.75f};
+  std::vector<int> tokens = {10, 11, 12, 13};
+  int count_13 = 0;
+  for (int i = 0; i < 4000; i++) {
+    int token = sampler.sampleCandidates(probs.data(), tokens.data(),
+                                         tokens.size());
+    ASSERT_TRUE(token == 11 || token == 13);
+    count_13 += token == 13;
+  }
+  EXPECT_NEAR(count_13 / 4000.0, 0.75, 0.03);
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
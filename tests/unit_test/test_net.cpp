@@ -91,5 +91,44 @@ TEST_F(NetTestSuite, TestModelFileLoad) {
   }
 }
 
+TEST_F(NetTestSuite, TestSharedModelLoad) {
+  InferencePlatform platform = CommonUtils::getPlatform();
+  size_t shared_num = NetFactory::getSharedModelNum();
+  NetParam net_param;
+  net_param.platform = platform;
+  net_param.model_file_path = model_path_;
+  net_param.share_model = true;
+  std::shared_ptr<BaseNet> net1 = NetFactory::createNet(net_param, platform);
+  std::shared_ptr<BaseNet> net2 = NetFactory::createNet(net_param, platform);
+  ASSERT_NE(net1, nullptr);
+  ASSERT_NE(net2, nullptr);
+  EXPECT_EQ(net1->setup(), 0);
+  EXPECT_EQ(net2->setup(), 0);
+  // loaded once, each net still has its own input tensors
+  EXPECT_EQ(NetFactory::getSharedModelNum(), shared_num + 1);
+  std::string input_name = net1->getInputNames()[0];
+  EXPECT_NE(net1->getInputTensor(input_name), net2->getInputTensor(input_name));
+
+  net1 = nullptr;
+  EXPECT_EQ(NetFactory::getSharedModelNum(), shared_num + 1);
+  net2 = nullptr;
+  EXPECT_EQ(NetFactory::getSharedModelNum(), shared_num);
+}
+
+TEST_F(NetTestSuite, TestGetModels) {
+  std::vector<ModelLoadRequest> requests(3);
+  for (auto &request : requests) {
+    request.model_type = ModelType::SCRFD_DET_FACE;
+    request.model_path = model_path_;
+  }
+  std::vector<std::shared_ptr<BaseModel>> models =
+      TDLModelFactory::getInstance().getModels(requests, 3);
+  ASSERT_EQ(models.size(), requests.size());
+  for (auto &model : models) {
+    EXPECT_NE(model, nullptr);
+  }
+  EXPECT_NE(models[0], models[1]);
+}
+
 }  // namespace unitest
 }  // namespace cvitdl
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "cv/occlusion_detect/occlusion_detect.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+// 填充 BGR 图像, flat 为 true 时为纯色 (遮挡), 否则为随机纹理
+static void fillFrame(std::shared_ptr<BaseImage> image, bool flat,
+                      std::mt19937 &gen) {
+  uint8_t *data = image->getVirtualAddress()[0];
+  uint32_t stride = image->getStrides()[0];
+  for (uint32_t y = 0; y < image->getHeight(); y++) {
+    for (uint32_t x = 0; x < image->getWidth() * 3; x++) {
+      data[y * stride + x] = flat ? 60 : (uint8_t)(gen() & 0xff);
+    }
+  }
+}
+
+static cvtdl_occlusion_meta_t makeMeta(int sensitive_th) {
+  cvtdl_occlusion_meta_t meta;
+  meta.crop_bbox = {0.0f, 0.0f, 1.0f, 1.0f};
+  meta.laplacian_th = 30;
+  meta.occ_ratio_th = 0.5;
+  meta.sensitive_th = sensitive_th;
+  return meta;
+}
+
+TEST(OcclusionDetectTest, FlatFrameIsOccluded) {
+  std::mt19937 gen(1);
+  auto image = ImageFactory::createImage(1280, 720, ImageFormat::BGR_PACKED,
+                                         TDLDataType::UINT8, true);
+  ASSERT_NE(image, nullptr);
+  for (int level : {-1, 0, 2}) {
+    OcclusionDetector detector;
+    detector.setPyramidLevel(level);
+    cvtdl_occlusion_meta_t meta = makeMeta(1);
+
+    fillFrame(image, true, gen);
+    ASSERT_EQ(detector.detect(image, &meta), 0);
+    EXPECT_FLOAT_EQ(meta.occ_score, 1.0f) << "level " << level;
+    EXPECT_EQ(meta.occ_class, 1);
+
+    fillFrame(image, false, gen);
+    ASSERT_EQ(detector.detect(image, &meta), 0);
+    EXPECT_LT(meta.occ_score, 0.1f) << "level " << level;
+    EXPECT_EQ(meta.occ_class, 0);
+  }
+}
+
+TEST(OcclusionDetectTest, VoteAndInterval) {
+  std::mt19937 gen(2);
+  auto image = ImageFactory::createImage(320, 240, ImageFormat::BGR_PACKED,
+                                         TDLDataType::UINT8, true);
+  ASSERT_NE(image, nullptr);
+  OcclusionDetector detector;
+  cvtdl_occlusion_meta_t meta = makeMeta(3);
+  // 前 3 次直接输出单帧结果, 之后按最近 3 次的多数输出
+  const bool flats[6] = {true, false, true, false, false, true};
+  const int expected[6] = {1, 0, 1, 0, 0, 0};
+  for (int i = 0; i < 6; i++) {
+    fillFrame(image, flats[i], gen);
+    ASSERT_EQ(detector.detect(image, &meta), 0);
+    EXPECT_EQ(meta.occ_class, expected[i]) << "frame " << i;
+  }
+
+  // 每 2 帧检测一次, 跳过的帧沿用上一次的结果
+  detector.reset();
+  detector.setDetectInterval(2);
+  meta = makeMeta(1);
+  fillFrame(image, true, gen);
+  ASSERT_EQ(detector.detect(image, &meta), 0);
+  EXPECT_EQ(meta.occ_class, 1);
+  fillFrame(image, false, gen);
+  ASSERT_EQ(detector.detect(image, &meta), 0);
+  EXPECT_EQ(meta.occ_class, 1);
+  ASSERT_EQ(detector.detect(image, &meta), 0);
+  EXPECT_EQ(meta.occ_class, 0);
+
+  // sensitive_th 为 0 时沿用原实现的结果, 类别恒为 0
+  detector.reset();
+  detector.setDetectInterval(1);
+  meta = makeMeta(0);
+  fillFrame(image, true, gen);
+  ASSERT_EQ(detector.detect(image, &meta), 0);
+  EXPECT_FLOAT_EQ(meta.occ_score, 1.0f);
+  EXPECT_EQ(meta.occ_class, 0);
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
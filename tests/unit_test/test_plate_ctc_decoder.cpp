@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "license_plate_recognition/plate_ctc_decoder.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+// 逐步 argmax 后去重去空白, 与原 greedy_decode 相同
+template <typename T>
+static std::string referenceDecode(const T *logits,
+                                   const std::vector<std::string> &charset,
+                                   int num_steps) {
+  const int blank = charset.size() - 1;
+  std::string text;
+  int prev = blank;
+  for (int t = 0; t < num_steps; t++) {
+    int label = 0;
+    for (int c = 1; c <= blank; c++) {
+      if (logits[c * num_steps + t] > logits[label * num_steps + t]) {
+        label = c;
+      }
+    }
+    if (label != blank && label != prev) {
+      text += charset[label];
+    }
+    prev = label;
+  }
+  return text;
+}
+
+template <typename T>
+static void checkGreedy(PlateCtcDecoder &decoder, TDLDataType data_type,
+                        const std::vector<std::string> &charset,
+                        int num_steps, std::mt19937 &gen) {
+  const int batch_num = 5;
+  const int num_classes = charset.size();
+  std::vector<T> logits(batch_num * num_classes * num_steps);
+  // 取值范围小, 覆盖相等的情况; 空白占多数以产生重复和间隔
+  std::uniform_int_distribution<int> dist(0, 12);
+  for (size_t i = 0; i < logits.size(); i++) {
+    logits[i] = T(dist(gen));
+    if ((i / num_steps) % num_classes == (size_t)num_classes - 1) {
+      logits[i] = T(dist(gen) + 4);
+    }
+  }
+  ASSERT_EQ(decoder.decode(logits.data(), data_type, 0.1f, batch_num,
+                           num_classes, num_steps),
+            0);
+  ASSERT_EQ(decoder.getNum(), batch_num);
+  for (int b = 0; b < batch_num; b++) {
+    std::string expected = referenceDecode(
+        logits.data() + b * num_classes * num_steps, charset, num_steps);
+    EXPECT_EQ(std::string(decoder.getText(b)), expected);
+    EXPECT_EQ(decoder.getLength(b), expected.size());
+  }
+}
+
+TEST(PlateCtcDecoderTest, GreedyMatchesReference) {
+  std::vector<std::string> charset;
+  for (int i = 0; i < 79; i++) {
+    charset.push_back(i < 10 ? "粤" : std::string(1, char('0' + i % 43)));
+  }
+  charset.push_back("-");
+  std::mt19937 gen(3);
+  PlateCtcDecoder decoder(charset);
+  // 18 为车牌模型的步数, 37 覆盖向量化之后的尾部
+  for (int num_steps : {18, 37}) {
+    checkGreedy<float>(decoder, TDLDataType::FP32, charset, num_steps, gen);
+    checkGreedy<int8_t>(decoder, TDLDataType::INT8, charset, num_steps, gen);
+    checkGreedy<uint8_t>(decoder, TDLDataType::UINT8, charset, num_steps,
+                         gen);
+  }
+  EXPECT_EQ(decoder.decode(charset.data(), TDLDataType::FP16, 1.0f, 1, 80, 18),
+            -1);
+}
+
+TEST(PlateCtcDecoderTest, BeamSearchFollowsPlateFormat) {
+  // 格式: 字母 + 两位数字
+  const std::vector<std::string> charset = {"A", "B", "0", "1", "O", "-"};
+  std::bitset<PlateCtcDecoder::kMaxClasses> letter, digit;
+  letter.set(0).set(1);
+  digit.set(2).set(3);
+  PlateCtcDecoder decoder(charset);
+  ASSERT_EQ(decoder.setPlateFormats({{letter, digit, digit}}), 0);
+
+  // 各步的对数概率, 第 2 步 "O" 略高于 "0"
+  const int num_classes = 6, num_steps = 6;
+  const float step_logits[num_steps][num_classes] = {
+      {4, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 4}, {0, 0, 3.8f, 0, 4, 0},
+      {0, 0, 0, 0, 0, 4}, {0, 0, 0, 4, 0, 0}, {0, 0, 0, 0, 0, 4}};
+  std::vector<float> logits(num_classes * num_steps);
+  std::vector<int8_t> logits_int8(logits.size());
+  for (int t = 0; t < num_steps; t++) {
+    for (int c = 0; c < num_classes; c++) {
+      logits[c * num_steps + t] = step_logits[t][c];
+      logits_int8[c * num_steps + t] =
+          int8_t(std::round(step_logits[t][c] * 10));
+    }
+  }
+
+  ASSERT_EQ(decoder.decode(logits.data(), TDLDataType::FP32, 1.0f, 1,
+                           num_classes, num_steps),
+            0);
+  EXPECT_STREQ(decoder.getText(0), "AO1");
+
+  decoder.setBeamWidth(4);
+  ASSERT_EQ(decoder.decode(logits.data(), TDLDataType::FP32, 1.0f, 1,
+                           num_classes, num_steps),
+            0);
+  EXPECT_STREQ(decoder.getText(0), "A01");
+  ASSERT_EQ(decoder.decode(logits_int8.data(), TDLDataType::INT8, 0.1f, 1,
+                           num_classes, num_steps),
+            0);
+  EXPECT_STREQ(decoder.getText(0), "A01");
+
+  // 没有 beam 符合格式时保留贪心结果
+  for (int t = 1; t < num_steps; t++) {
+    for (int c = 0; c < num_classes; c++) {
+      logits[c * num_steps + t] = c == num_classes - 1 ? 4.0f : 0.0f;
+    }
+  }
+  ASSERT_EQ(decoder.decode(logits.data(), TDLDataType::FP32, 1.0f, 1,
+                           num_classes, num_steps),
+            0);
+  EXPECT_STREQ(decoder.getText(0), "A");
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
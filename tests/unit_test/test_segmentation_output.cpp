@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "common/model_output_types.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+static std::shared_ptr<const std::vector<int>> makeIndex(int out_size,
+                                                         int native_size) {
+  auto index = std::make_shared<std::vector<int>>(out_size);
+  for (int i = 0; i < out_size; i++) {
+    (*index)[i] = (i * native_size) / out_size;
+  }
+  return index;
+}
+
+static void fillLazySeg(ModelSegmentationInfo &seg, int native_w, int native_h,
+                        int out_w, int out_h) {
+  seg.native_width = native_w;
+  seg.native_height = native_h;
+  seg.output_width = out_w;
+  seg.output_height = out_h;
+  for (int i = 0; i < native_w * native_h; i++) {
+    seg.native_class_id.push_back(i % 19);
+    seg.native_class_conf.push_back((i * 7) % 256);
+  }
+  seg.row_index = makeIndex(out_h, native_h);
+  seg.col_index = makeIndex(out_w, native_w);
+}
+
+TEST(SegmentationOutputTestSuite, RoiMatchesFullUpsample) {
+  const int native_w = 11, native_h = 7, out_w = 37, out_h = 23;
+  ModelSegmentationInfo seg;
+  fillLazySeg(seg, native_w, native_h, out_w, out_h);
+
+  std::vector<uint8_t> full_id(out_w * out_h), full_conf(out_w * out_h);
+  ASSERT_EQ(seg.upsampleRoi(0, 0, out_w, out_h, full_id.data(),
+                            full_conf.data()),
+            0);
+  for (int y = 0; y < out_h; y++) {
+    for (int x = 0; x < out_w; x++) {
+      int src = (*seg.row_index)[y] * native_w + (*seg.col_index)[x];
+      ASSERT_EQ(full_id[y * out_w + x], seg.native_class_id[src]);
+      ASSERT_EQ(full_conf[y * out_w + x], seg.native_class_conf[src]);
+    }
+  }
+
+  const int rx = 5, ry = 3, rw = 17, rh = 12;
+  std::vector<uint8_t> roi_id(rw * rh);
+  ASSERT_EQ(seg.upsampleRoi(rx, ry, rw, rh, roi_id.data(), nullptr), 0);
+  for (int y = 0; y < rh; y++) {
+    for (int x = 0; x < rw; x++) {
+      ASSERT_EQ(roi_id[y * rw + x], full_id[(ry + y) * out_w + rx + x]);
+    }
+  }
+
+  // a materialized full resolution map is cropped directly
+  seg.class_id = (uint8_t *)malloc(full_id.size());
+  memcpy(seg.class_id, full_id.data(), full_id.size());
+  seg.native_class_id.clear();
+  std::vector<uint8_t> crop_id(rw * rh);
+  ASSERT_EQ(seg.upsampleRoi(rx, ry, rw, rh, crop_id.data(), nullptr), 0);
+  EXPECT_EQ(crop_id, roi_id);
+}
+
+TEST(SegmentationOutputTestSuite, RejectsInvalidRoi) {
+  ModelSegmentationInfo seg;
+  fillLazySeg(seg, 4, 4, 16, 16);
+  uint8_t buffer[16 * 16];
+  EXPECT_EQ(seg.upsampleRoi(8, 0, 9, 1, buffer, nullptr), -1);
+  EXPECT_EQ(seg.upsampleRoi(-1, 0, 1, 1, buffer, nullptr), -1);
+  EXPECT_EQ(seg.upsampleRoi(0, 0, 0, 1, buffer, nullptr), -1);
+
+  // no label map available
+  ModelSegmentationInfo empty;
+  empty.output_width = 16;
+  empty.output_height = 16;
+  EXPECT_EQ(empty.upsampleRoi(0, 0, 4, 4, buffer, nullptr), -1);
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "image/base_image.hpp"
+#include "snapshot/snapshot_encoder.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+static std::shared_ptr<BaseImage> createTestImage(uint32_t width,
+                                                  uint32_t height) {
+  std::shared_ptr<BaseImage> image = ImageFactory::createImage(
+      width, height, ImageFormat::YUV420SP_UV, TDLDataType::UINT8, true);
+  if (image != nullptr) {
+    image->randomFill();
+  }
+  return image;
+}
+
+TEST(SnapshotEncoderTestSuite, SameFrameIsEncodedOnce) {
+  auto image_encoder = std::make_shared<ImageEncoder>(1);
+  SnapshotEncoder encoder(image_encoder, 1);
+  std::shared_ptr<BaseImage> image = createTestImage(320, 240);
+  ASSERT_NE(image, nullptr);
+
+  std::shared_ptr<EncodeJob> job1 = encoder.submitFrame(image, 1, 60);
+  std::shared_ptr<EncodeJob> job2 = encoder.submitFrame(image, 1, 60);
+  EXPECT_EQ(job1, job2);
+
+  ASSERT_TRUE(job1->wait(5000));
+  ASSERT_EQ(job1->getState(), EncodeJob::State::DONE);
+  std::shared_ptr<const std::vector<uint8_t>> jpeg = job1->getEncoded(0);
+  ASSERT_NE(jpeg, nullptr);
+  ASSERT_GT(jpeg->size(), 2u);
+  EXPECT_EQ((*jpeg)[0], 0xFF);
+  EXPECT_EQ((*jpeg)[1], 0xD8);
+
+  // the encoded data outlives the job handle
+  job1 = nullptr;
+  job2 = nullptr;
+  EXPECT_EQ((*jpeg)[0], 0xFF);
+
+  SnapshotEncoderStats stats = encoder.getStats();
+  EXPECT_EQ(stats.submitted, 1u);
+  EXPECT_EQ(stats.encoded, 1u);
+}
+
+TEST(SnapshotEncoderTestSuite, BatchJob) {
+  auto image_encoder = std::make_shared<ImageEncoder>(1);
+  SnapshotEncoder encoder(image_encoder, 2);
+  std::vector<std::shared_ptr<BaseImage>> crops;
+  for (int i = 0; i < 3; i++) {
+    crops.push_back(createTestImage(64 + i * 16, 64));
+  }
+  std::shared_ptr<EncodeJob> job = encoder.submitBatch(crops, 7, 60);
+  ASSERT_TRUE(job->wait(5000));
+  ASSERT_EQ(job->size(), crops.size());
+  for (size_t i = 0; i < crops.size(); i++) {
+    EXPECT_NE(job->getEncoded(i), nullptr);
+  }
+  EXPECT_EQ(job->getEncoded(crops.size()), nullptr);
+}
+
+TEST(SnapshotEncoderTestSuite, ReleasedJobsAreCancelled) {
+  auto image_encoder = std::make_shared<ImageEncoder>(1);
+  SnapshotEncoder encoder(image_encoder, 1, 64);
+  std::shared_ptr<BaseImage> big_image = createTestImage(1920, 1080);
+  std::shared_ptr<BaseImage> image = createTestImage(320, 240);
+
+  // keep the worker busy, then supersede every later frame right away
+  std::shared_ptr<EncodeJob> busy_job = encoder.submitFrame(big_image, 0, 90);
+  const int num_frames = 20;
+  for (int i = 1; i <= num_frames; i++) {
+    encoder.submitFrame(image, i, 60);
+  }
+  encoder.waitIdle();
+  EXPECT_EQ(encoder.pendingJobs(), 0u);
+  EXPECT_EQ(busy_job->getState(), EncodeJob::State::DONE);
+
+  SnapshotEncoderStats stats = encoder.getStats();
+  EXPECT_EQ(stats.submitted, (uint64_t)num_frames + 1);
+  EXPECT_EQ(stats.encoded + stats.cancelled + stats.failed, stats.submitted);
+  EXPECT_GT(stats.cancelled, 0u);
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/tracer.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+TEST(TracerTestSuite, HistogramBucketPrecision) {
+  for (uint64_t value = 0; value < 64; value++) {
+    EXPECT_EQ(LatencyHistogram::bucketValue(
+                  LatencyHistogram::bucketIndex(value)),
+              value);
+  }
+  const uint64_t values[] = {100, 1000, 123456, 999999999, 1ULL << 40,
+                             UINT64_MAX};
+  for (uint64_t value : values) {
+    int index = LatencyHistogram::bucketIndex(value);
+    ASSERT_GE(index, 0);
+    ASSERT_LT(index, LatencyHistogram::kBucketNum);
+    double represent = (double)LatencyHistogram::bucketValue(index);
+    EXPECT_NEAR(represent, (double)value, value * 0.04);
+  }
+}
+
+TEST(TracerTestSuite, HistogramPercentile) {
+  LatencyHistogram histogram;
+  for (uint64_t i = 1; i <= 1000; i++) {
+    histogram.record(i * 1000);
+  }
+  EXPECT_EQ(histogram.count(), 1000u);
+  EXPECT_EQ(histogram.max(), 1000000u);
+  EXPECT_NEAR((double)histogram.valueAtPercentile(50), 500000.0, 500000 * 0.04);
+  EXPECT_NEAR((double)histogram.valueAtPercentile(99), 990000.0, 990000 * 0.04);
+  EXPECT_EQ(histogram.valueAtPercentile(100), 1000000u);
+}
+
+TEST(TracerTestSuite, DisabledRecordsNothing) {
+  Tracer::setEnabled(false);
+  uint32_t name_id = Tracer::registerName("unittest/disabled");
+  Tracer::reset();
+  { TraceScope scope(name_id); }
+  std::string text = Tracer::exportPrometheus();
+  EXPECT_EQ(text.find("unittest/disabled"), std::string::npos);
+}
+
+TEST(TracerTestSuite, ExportPrometheusAndChromeTrace) {
+  Tracer::setEnabled(true);
+  uint32_t name_id = Tracer::registerName("unittest/span");
+  EXPECT_EQ(Tracer::registerName("unittest/span"), name_id);
+  Tracer::reset();
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([name_id]() {
+      for (int i = 0; i < 100; i++) {
+        TraceScope scope(name_id);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  Tracer::setEnabled(false);
+  ASSERT_NE(Tracer::getHistogram(name_id), nullptr);
+  EXPECT_EQ(Tracer::getHistogram(name_id)->count(), 400u);
+  EXPECT_EQ(Tracer::getHistogram(Tracer::kMaxNames), nullptr);
+
+  std::string text = Tracer::exportPrometheus();
+  EXPECT_NE(text.find("tdl_span_duration_seconds_count{span=\"unittest/span\"} "
+                      "400"),
+            std::string::npos);
+  EXPECT_NE(text.find("quantile=\"0.99\""), std::string::npos);
+
+  std::string trace_file = "/tmp/tdl_unittest_trace.json";
+  ASSERT_EQ(Tracer::dumpChromeTrace(trace_file), 0);
+  std::ifstream ifs(trace_file);
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  std::string json = ss.str();
+  size_t num_events = 0;
+  for (size_t pos = json.find("\"unittest/span\""); pos != std::string::npos;
+       pos = json.find("\"unittest/span\"", pos + 1)) {
+    num_events++;
+  }
+  EXPECT_EQ(num_events, 400u);
+  std::remove(trace_file.c_str());
+}
+
+TEST(TracerTestSuite, ExitedThreadRingIsReused) {
+  Tracer::setEnabled(true);
+  uint32_t name_id = Tracer::registerName("unittest/short_thread");
+  Tracer::reset();
+  // 依次启动的线程复用已退出线程的 ring, 不会每个线程新分配一个
+  for (int t = 0; t < 16; t++) {
+    std::thread thread([name_id]() { TraceScope scope(name_id); });
+    thread.join();
+  }
+  Tracer::setEnabled(false);
+  EXPECT_EQ(Tracer::getHistogram(name_id)->count(), 16u);
+
+  std::string trace_file = "/tmp/tdl_unittest_trace_reuse.json";
+  ASSERT_EQ(Tracer::dumpChromeTrace(trace_file), 0);
+  std::ifstream ifs(trace_file);
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  std::string json = ss.str();
+  std::set<std::string> tids;
+  size_t num_events = 0;
+  for (size_t pos = json.find("\"unittest/short_thread\"");
+       pos != std::string::npos;
+       pos = json.find("\"unittest/short_thread\"", pos + 1)) {
+    num_events++;
+    size_t tid_pos = json.find("\"tid\":", pos);
+    tids.insert(json.substr(tid_pos, json.find('}', tid_pos) - tid_pos));
+  }
+  EXPECT_EQ(num_events, 16u);
+  EXPECT_EQ(tids.size(), 1u);
+  std::remove(trace_file.c_str());
+}
+
+TEST(TracerTestSuite, ChromeTraceWhileRecording) {
+  Tracer::setEnabled(true);
+  const uint32_t even_id = Tracer::registerName("unittest/concurrent_even");
+  const uint32_t odd_id = Tracer::registerName("unittest/concurrent_odd");
+  Tracer::reset();
+
+  // 第 k 个 span: ts=k us, dur=k%100+1 us, 名字由 k 的奇偶决定,
+  // 导出时读到写了一半的 span 会破坏三者的对应关系
+  std::atomic<bool> running(true);
+  std::thread writer([&]() {
+    for (uint64_t k = 1; running.load(); k++) {
+      uint64_t start_ns = k * 1000;
+      uint64_t end_ns = start_ns + (k % 100 + 1) * 1000;
+      Tracer::record(k % 2 ? odd_id : even_id, start_ns, end_ns);
+    }
+  });
+
+  std::string trace_file = "/tmp/tdl_unittest_trace_concurrent.json";
+  size_t num_events = 0;
+  for (int round = 0; round < 50; round++) {
+    ASSERT_EQ(Tracer::dumpChromeTrace(trace_file), 0);
+    std::ifstream ifs(trace_file);
+    std::string line;
+    while (std::getline(ifs, line)) {
+      bool is_odd = line.find("\"unittest/concurrent_odd\"") !=
+                    std::string::npos;
+      bool is_even = line.find("\"unittest/concurrent_even\"") !=
+                     std::string::npos;
+      if (!is_odd && !is_even) {
+        continue;
+      }
+      double ts = 0, dur = 0;
+      size_t ts_pos = line.find("\"ts\":");
+      ASSERT_NE(ts_pos, std::string::npos) << line;
+      ASSERT_EQ(sscanf(line.c_str() + ts_pos, "\"ts\":%lf,\"dur\":%lf", &ts,
+                       &dur),
+                2)
+          << line;
+      uint64_t k = static_cast<uint64_t>(ts + 0.5);
+      ASSERT_EQ(k % 2 == 1, is_odd) << line;
+      ASSERT_DOUBLE_EQ(dur, static_cast<double>(k % 100 + 1)) << line;
+      num_events++;
+    }
+  }
+  running.store(false);
+  writer.join();
+  Tracer::setEnabled(false);
+  EXPECT_GT(num_events, 0u);
+  std::remove(trace_file.c_str());
+}
+
+}  // namespace unitest
+}  // namespace cvitdl
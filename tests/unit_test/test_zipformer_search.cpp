@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "speech_recognition/zipformer_search.hpp"
+
+namespace cvitdl {
+namespace unitest {
+
+static const int kFeatureSize = 8;
+
+// token of a (encoder, decoder) pair, mostly blank
+static int32_t fakeJoin(const float *encoder_out, const float *decoder_out) {
+  int value = int(encoder_out[0] * 7 + decoder_out[0] * 3) % 10;
+  return value < 7 ? 0 : value;
+}
+
+static void fakeDecode(const int32_t *context, float *decoder_out) {
+  for (int i = 0; i < kFeatureSize; i++) {
+    decoder_out[i] = float((context[0] * 31 + context[1] * 17 + i) % 97);
+  }
+}
+
+// frame by frame greedy search, one symbol per frame
+static std::vector<int32_t> referenceSearch(
+    const std::vector<std::vector<float>> &chunks) {
+  std::vector<int32_t> hyp = {0};
+  int32_t context[2] = {0, 0};
+  std::vector<float> decoder_out(kFeatureSize);
+  fakeDecode(context, decoder_out.data());
+  for (const auto &chunk : chunks) {
+    int num_frames = chunk.size() / kFeatureSize;
+    for (int f = 0; f < num_frames; f++) {
+      int32_t token =
+          fakeJoin(chunk.data() + f * kFeatureSize, decoder_out.data());
+      if (token != 0) {
+        context[0] = hyp.back();
+        context[1] = token;
+        hyp.push_back(token);
+        fakeDecode(context, decoder_out.data());
+      }
+    }
+  }
+  return hyp;
+}
+
+TEST(ZipformerSearchTestSuite, BatchedSearchMatchesFrameByFrame) {
+  const int num_streams = 5;
+  const int num_chunks = 3;
+  const int num_frames = 16;
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> dist(0, 50);
+  std::vector<std::vector<std::vector<float>>> chunks(num_streams);
+  for (auto &stream_chunks : chunks) {
+    for (int c = 0; c < num_chunks; c++) {
+      std::vector<float> chunk(num_frames * kFeatureSize);
+      for (auto &v : chunk) v = float(dist(rng));
+      stream_chunks.push_back(chunk);
+    }
+  }
+
+  for (int joiner_batch : {1, 4, 64}) {
+    for (int decoder_batch : {1, 3}) {
+      uint64_t decoder_rows = 0;
+      ZipformerGreedySearch search(
+          kFeatureSize, joiner_batch, decoder_batch,
+          [joiner_batch](const float *encoder_out, const float *decoder_out,
+                         int num, int32_t *tokens) {
+            EXPECT_LE(num, joiner_batch);
+            for (int i = 0; i < num; i++) {
+              tokens[i] = fakeJoin(encoder_out + i * kFeatureSize,
+                                   decoder_out + i * kFeatureSize);
+            }
+            return 0;
+          },
+          [&decoder_rows, decoder_batch](const int32_t *contexts, int num,
+                                         float *decoder_out) {
+            EXPECT_LE(num, decoder_batch);
+            for (int i = 0; i < num; i++) {
+              fakeDecode(contexts + i * 2, decoder_out + i * kFeatureSize);
+            }
+            decoder_rows += num;
+            return 0;
+          });
+
+      std::vector<ZipformerSearchStream> streams(num_streams);
+      std::vector<ZipformerSearchStream *> stream_ptrs;
+      for (auto &stream : streams) {
+        ASSERT_EQ(search.initStream(stream), 0);
+        stream_ptrs.push_back(&stream);
+      }
+      for (int c = 0; c < num_chunks; c++) {
+        for (int s = 0; s < num_streams; s++) {
+          streams[s].encoder_out = chunks[s][c].data();
+          streams[s].num_frames = num_frames;
+        }
+        ASSERT_EQ(search.search(stream_ptrs), 0);
+      }
+
+      size_t num_tokens = 0;
+      for (int s = 0; s < num_streams; s++) {
+        EXPECT_EQ(streams[s].hyp, referenceSearch(chunks[s]))
+            << "joiner_batch " << joiner_batch << " stream " << s;
+        num_tokens += streams[s].hyp.size() - 1;
+      }
+      // the initial context is shared by all streams
+      EXPECT_GT(search.getDecoderCacheHits(), 0u);
+      EXPECT_LE(decoder_rows, num_tokens + 1);
+      if (joiner_batch == 1) {
+        EXPECT_EQ(search.getJoinerCalls(),
+                  uint64_t(num_streams * num_chunks * num_frames));
+      } else if (joiner_batch == 64) {
+        EXPECT_LT(search.getJoinerCalls(),
+                  uint64_t(num_streams * num_chunks * num_frames) / 4);
+      }
+    }
+  }
+}
+
+TEST(ZipformerSearchTestSuite, DecoderCacheEvictsLeastRecentlyUsed) {
+  ZipformerDecoderCache cache(2);
+  float a[2] = {1, 2};
+  float b[2] = {3, 4};
+  float c[2] = {5, 6};
+  cache.insert(0, 1, a, 2);
+  cache.insert(1, 2, b, 2);
+  ASSERT_NE(cache.find(0, 1), nullptr);  // (1, 2) is now the oldest
+  cache.insert(2, 3, c, 2);
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_EQ(cache.find(1, 2), nullptr);
+  ASSERT_NE(cache.find(0, 1), nullptr);
+  EXPECT_EQ((*cache.find(0, 1))[1], 2.0f);
+  ASSERT_NE(cache.find(2, 3), nullptr);
+  EXPECT_EQ((*cache.find(2, 3))[0], 5.0f);
+}
+
+}  // namespace unitest
+}  // namespace cvitdl